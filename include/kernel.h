@@ -160,6 +160,8 @@ extern void do_executa_new_task (void);
 //# /x
 #include <kernel/gramado/kdrivers/x/screen.h>
 #include <kernel/gramado/kdrivers/x/video.h>
+#include <kernel/gramado/kdrivers/x/damage.h>
+#include <kernel/gramado/kdrivers/x/sprite.h>
 
 
 
@@ -299,13 +301,16 @@ extern void do_executa_new_task (void);
 #include <kernel/gramado/mk/ps/process.h>
 #include <kernel/gramado/mk/ps/thread.h>
 #include <kernel/gramado/mk/ps/sched/sched.h>
+#include <kernel/gramado/mk/ps/sched/smp.h>
 #include <kernel/gramado/mk/ps/ipc/ipc.h>
 #include <kernel/gramado/mk/ps/ipc/ipccore.h>
 #include <kernel/gramado/mk/ps/ipc/sem.h>
+#include <kernel/gramado/mk/ps/ipc/msgq.h>
 #include <kernel/gramado/mk/ps/queue.h>
 #include <kernel/gramado/mk/ps/realtime.h>
 #include <kernel/gramado/mk/ps/dispatch.h>
 #include <kernel/gramado/mk/ps/event.h>
+#include <kernel/gramado/mk/ps/defer.h>
 #include <kernel/gramado/mk/ps/ps.h>
 #include <kernel/gramado/mk/mk.h>
 //--
@@ -319,10 +324,15 @@ extern void do_executa_new_task (void);
 #include <kernel/gramado/kservers/kgws/user/usession.h>
 #include <kernel/gramado/kservers/kgws/user/room.h>
 #include <kernel/gramado/kservers/kgws/user/desktop.h>
+#include <kernel/gramado/kservers/kgws/kgws/region.h>
 #include <kernel/gramado/kservers/kgws/kgws/window.h>
+#include <kernel/gramado/kservers/kgws/kgws/surface.h>
+#include <kernel/gramado/kservers/kgws/kgws/hit.h>
 #include <kernel/gramado/kservers/kgws/kgws/menu.h>
 #include <kernel/gramado/kservers/kgws/kgws/grid.h>
 #include <kernel/gramado/kservers/kgws/kgws/bmp.h>
+#include <kernel/gramado/kservers/kgws/kgws/bmpcache.h>
+#include <kernel/gramado/kservers/kgws/kgws/glyph.h>
 #include <kernel/gramado/kservers/kgws/terminal/line.h>
 #include <kernel/gramado/kservers/kgws/terminal/terminal.h>
 #include <kernel/gramado/kservers/kgws/kgws/guiconf.h>
@@ -358,6 +368,7 @@ extern void do_executa_new_task (void);
 
 
 #include <kernel/gramado/kservers/fs/fs.h>                  //fs.
+#include <kernel/gramado/kservers/fs/bcache.h>              //Buffer cache.
 
 #include <kernel/gramado/kservers/vfs/vfs.h>                //vfs.
 
@@ -373,7 +384,8 @@ extern void do_executa_new_task (void);
 #include <kernel/gramado/kdrivers/dd.h>
 
 
-#include <kernel/gramado/execve/execve.h>        
+#include <kernel/gramado/execve/execve.h>
+#include <kernel/gramado/execve/elf.h>        
 
 //
 // MICROKERNEL (3)
@@ -386,6 +398,8 @@ extern void do_executa_new_task (void);
 #include <kernel/gramado/mk/ps/mm/x86/dspace.h>        //Disk Space, (data base account).
 #include <kernel/gramado/mk/ps/mm/x86/bank.h>          //Bank. database
 #include <kernel/gramado/mk/ps/mm/x86/mm.h>            //mm, memory manager support.
+#include <kernel/gramado/mk/ps/mm/x86/slab.h>          //Slab allocator.
+#include <kernel/gramado/mk/ps/mm/x86/cow.h>           //Copy-on-write fork.
 
 
 //
@@ -66,6 +66,8 @@
 
 #define ENTRY_NIC1_PAGES 960 
 #define ENTRY_AHCI1_PAGES 961 
+#define ENTRY_LAPIC_PAGES 962 
+#define ENTRY_KMAP_PAGES 963 
 
 
 
@@ -74,8 +74,11 @@
 // Essas pagetable possuem endereço físico e lógico iguais.
 
 //#define PAGETABLE_RES7         0x00080000
-#define PAGETABLE_RES6         0x00081000
-#define PAGETABLE_RES5         0x00082000
+#define PAGETABLE_KMAP         0x00080000   //Janela kmap. (pages.c)
+//#define PAGETABLE_RES6         0x00081000
+#define SMP_TRAMPOLINE_PAGE    0x00081000   //SMP trampoline. (smp.h)
+//#define PAGETABLE_RES5         0x00082000
+#define PAGETABLE_LAPIC        0x00082000   //Local APIC
 
 //#test
 //tantando mapear alguma coisa para ahci
@@ -144,6 +144,8 @@
 
 #define NIC1_VA 0xF0000000  //
 #define AHCI1_VA 0xF0400000  //
+#define LAPIC_VA 0xF0800000  // Local APIC. (apic.c)
+#define KMAP_VA 0xF0C00000  // Janela para a memória alta. (pages.c)
 
 
 
@@ -0,0 +1,188 @@
+/*
+ * File: execve/elf.h
+ *
+ *     ELF loader with demand paging.
+ *
+ *     do_execve() used to load the whole file into the image of the
+ * process before checking it. Now elfLoad() reads only the headers,
+ * validates the program headers and marks the pages of the image as
+ * "demand" in the page table of the process. Each page comes from the
+ * file (or is zeroed) in the #PF handler, on the first touch.
+ *
+ *     The clean read-only pages (text, rodata) stay in the cache of
+ * the image and the same frame is mapped in every process running
+ * the same file. The writable pages (data, bss, stack) are private.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+//
+// ## ELF32 ##
+//
+
+#define ELF_ET_EXEC   2
+#define ELF_EM_386    3
+
+#define ELF_PT_LOAD   1
+
+#define ELF_PF_X  1
+#define ELF_PF_W  2
+#define ELF_PF_R  4
+
+struct elf32_ehdr_d
+{
+	unsigned char e_ident[16];
+	unsigned short e_type;
+	unsigned short e_machine;
+	unsigned long e_version;
+	unsigned long e_entry;
+	unsigned long e_phoff;
+	unsigned long e_shoff;
+	unsigned long e_flags;
+	unsigned short e_ehsize;
+	unsigned short e_phentsize;
+	unsigned short e_phnum;
+	unsigned short e_shentsize;
+	unsigned short e_shnum;
+	unsigned short e_shstrndx;
+};
+
+struct elf32_phdr_d
+{
+	unsigned long p_type;
+	unsigned long p_offset;
+	unsigned long p_vaddr;
+	unsigned long p_paddr;
+	unsigned long p_filesz;
+	unsigned long p_memsz;
+	unsigned long p_flags;
+	unsigned long p_align;
+};
+
+
+//
+// ## Images ##
+//
+
+// The region of the image of a process. The stack is at the top.
+// (see do_execve)
+#define ELF_IMAGE_SIZE   0x50000
+#define ELF_IMAGE_PAGES  (ELF_IMAGE_SIZE / 4096)
+
+// The page table of ENTRY_USERMODE_PAGES. (0x400000 ~ 0x7FFFFF)
+#define ELF_USER_START   0x00400000
+#define ELF_USER_END     0x00800000
+
+#define ELF_SEGMENT_MAX  8
+#define ELF_IMAGE_MAX    8
+
+// One cluster is one sector. (see fsLoadFile)
+#define ELF_SECTOR_SIZE    512
+#define ELF_CLUSTER_MAX    (ELF_IMAGE_SIZE / ELF_SECTOR_SIZE)
+
+// Page table entry bits available to the OS. (bit 9 is COW)
+// Not present + DEMAND: the page comes from the image on the #PF.
+// Present + DEMAND: private frame allocated by the loader.
+// Present + SHARED: frame of the cache of the image, read-only.
+#define ELF_PTE_DEMAND   0x400
+#define ELF_PTE_SHARED   0x800
+
+
+struct elf_segment_d
+{
+	unsigned long vaddr;
+	unsigned long memsz;
+	unsigned long offset;
+	unsigned long filesz;
+	unsigned long flags;
+};
+
+
+struct elf_image_d
+{
+	int used;
+	int magic;
+
+	// 8.3 name, as in the directory entry.
+	char name[12];
+
+	unsigned short first_cluster;
+	unsigned long file_size;
+
+	// Process->Image and entry point.
+	unsigned long base;
+	unsigned long entry;
+
+	int segment_count;
+	struct elf_segment_d segments[ELF_SEGMENT_MAX];
+
+	// The cluster chain of the file, taken from the FAT once.
+	unsigned short clusters[ELF_CLUSTER_MAX];
+	unsigned long cluster_count;
+
+	// Shared read-only pages. (PA) 0 = not read yet.
+	unsigned long frames[ELF_IMAGE_PAGES];
+
+	// Processes using the image.
+	int users;
+
+	// The file was saved again. Not used for new loads.
+	int stale;
+};
+
+
+//
+// Counters.
+//
+
+unsigned long elf_load_count;
+unsigned long elf_cache_hits;
+
+// Pages read from the disk into the cache, and pages mapped from it.
+unsigned long elf_pages_read;
+unsigned long elf_pages_shared;
+
+// Private pages. (data, bss, stack)
+unsigned long elf_pages_private;
+unsigned long elf_pages_zero;
+
+unsigned long elf_fault_fail;
+
+// Frames released on exit, disk reads done with the interrupts
+// enabled and images invalidated by a save.
+unsigned long elf_pages_released;
+unsigned long elf_fills_unlocked;
+unsigned long elf_images_stale;
+
+
+//
+// Prototypes.
+//
+
+// 0 = ok, 1 = file not found or read error, 2 = invalid ELF.
+int elfLoad ( struct process_d *process,
+              const char *name,
+              unsigned long *entry );
+
+// Called by cowPageFault for a not present page.
+// Returns 1 if the fault was resolved.
+int elfPageFault ( unsigned long error_code );
+
+void elfImageGet ( struct elf_image_d *image );
+void elfImagePut ( struct elf_image_d *image );
+
+// The file was saved. (8.3 name)
+void elfImageInvalidate ( const char *name );
+
+// Called by exit_process, before elfImagePut.
+void elfReleasePages ( struct process_d *process );
+
+void elfShowInfo (void);
+
+
+//
+// End.
+//
+
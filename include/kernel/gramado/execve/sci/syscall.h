@@ -614,6 +614,51 @@
 #define	SYS_SHOWKERNELINFO    255
 
 
+//
+// Message queue support. (ipc/msgq.c)
+//
+
+#define	SYS_GETMESSAGES   256  // Pega vrias mensagens da fila da thread.
+#define	SYS_WAITMESSAGE   257  // Dorme at chegar mensagem.
+
+
+//
+// stdio support. (libc02)
+// Um buffer inteiro por chamada e no um char.
+//
+
+#define	SYS_WRITEBUFFER   258  // Escreve um buffer no terminal ou num arquivo.
+#define	SYS_READBUFFER    259  // L de um arquivo aberto com fopen.
+
+
+//
+// Semforos e mutexes com fila de espera. (ipc/sem.c)
+// O argumento  um handle e no um ponteiro.
+//
+
+#define	SYS_SEMCREATE     260  // Cria. (count, tipo) Retorna o handle.
+#define	SYS_SEMDOWN       261  // 0 = pegou, 1 = bloqueada, chamar de novo.
+#define	SYS_SEMUP         262  // Libera e acorda uma thread da fila.
+#define	SYS_SEMDESTROY    263
+#define	SYS_SEMINFO       264  // Mostra os contadores.
+
+
+//
+// Sleep. A thread fica bloqueada e o timer dela fica na roda. (timer.c)
+//
+
+#define	SYS_NANOSLEEP     265  // (deadline em ticks) 0 = acordou, 1 = chamar de novo.
+
+// Relgio monotnico com o TSC, em ns. (timer.c)
+#define	SYS_CLOCKGETTIME  266  // (clock id, struct timespec *)
+
+// Mostra as cpus. (smp.c)
+#define	SYS_SMPINFO       267
+
+// glyphs/s com e sem o cache de glyphs. (glyph.c)
+#define	SYS_GLYPHBENCH    268
+
+
 //
 // Outros ...
 //
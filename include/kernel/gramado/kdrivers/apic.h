@@ -23,6 +23,81 @@ static inline void imcr_pic_to_apic(void);
 static inline void imcr_apic_to_pic(void);
 
 
+//
+// ## Local APIC ##
+//
+
+#define LAPIC_BASE_MSR     0x1B
+#define LAPIC_TSC_DEADLINE_MSR  0x6E0
+
+// Registradores. (offsets)
+#define LAPIC_REG_ID       0x020
+#define LAPIC_REG_VERSION  0x030
+#define LAPIC_REG_TPR      0x080
+#define LAPIC_REG_EOI      0x0B0
+#define LAPIC_REG_SVR      0x0F0
+#define LAPIC_REG_ICR_LOW  0x300
+#define LAPIC_REG_ICR_HIGH 0x310
+#define LAPIC_REG_LVT_TIMER     0x320
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE  0x3E0
+
+#define LAPIC_SVR_ENABLE   0x100
+#define LAPIC_LVT_MASKED   0x10000
+
+// ICR. (Inter-processor interrupts)
+#define LAPIC_ICR_INIT       0x00000500
+#define LAPIC_ICR_STARTUP    0x00000600
+#define LAPIC_ICR_PENDING    0x00001000
+#define LAPIC_ICR_ASSERT     0x00004000
+#define LAPIC_ICR_LEVEL      0x00008000
+
+// Modos do timer. (LVT bits 17~18)
+#define LAPIC_TIMER_ONESHOT      0x00000
+#define LAPIC_TIMER_PERIODIC     0x20000
+#define LAPIC_TIMER_TSC_DEADLINE 0x40000
+
+// Divide por 16.
+#define LAPIC_TIMER_DIVIDE_16    0x03
+
+// Vetores na IDT. (hw.asm)
+#define LAPIC_TIMER_VECTOR     0xF0
+#define LAPIC_SPURIOUS_VECTOR  0xFF
+
+
+// Ticks do timer do local APIC por ms. (divide 16) 0 = sem timer.
+unsigned long lapic_timer_khz;
+
+// A cpu tem o modo TSC-deadline.
+int lapic_tsc_deadline;
+
+// Quantas vezes o timer disparou.
+unsigned long lapic_timer_fired;
+
+
+int lapicInit (void);
+void lapicEOI (void);
+
+// One-shot em microsegundos, ou deadline absoluto no TSC. 
+// Sem o modo TSC-deadline o deadline vira um one-shot.
+int lapicTimerOneShot ( unsigned long us );
+int lapicTimerDeadline ( unsigned long long tsc );
+void lapicTimerStop (void);
+
+// Chamado pelo ISR. (hw.asm)
+void lapicTimerHandler (void);
+
+// Id do local APIC da cpu atual. -1 = não mapeado.
+int lapicId (void);
+
+// Manda um IPI e espera a entrega. 'command' vai no ICR low.
+int lapicSendIPI ( unsigned long apic_id, unsigned long command );
+
+// Liga o local APIC de um AP. (smp.c)
+void lapicApInit (void);
+
+
 //
 // End.
 //
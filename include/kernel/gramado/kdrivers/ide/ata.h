@@ -330,6 +330,16 @@ void ide_dma_stop (void);
 
 int ide_dma_read_status (void);
 
+void ide_dma_prd_reset (void);
+
+int ide_dma_prd_add ( unsigned long address, unsigned long len );
+
+int ide_dma_setup ( unsigned long bm, int write );
+
+void ide_dma_begin ( unsigned long bm );
+
+int ide_dma_end ( unsigned long bm );
+
 
 //ahci.c
 //deletar.
@@ -387,6 +397,10 @@ diskATADialog ( int msg,
 
 int disk_ata_wait_irq (void);
 
+int disk_get_ata_irq_invoked (void);
+
+void disk_reset_ata_irq_invoked (void);
+
 
 void show_ide_info (void);
 
@@ -445,6 +459,30 @@ struct {
 }ide_dma_prdt[4];
 
 
+/*
+ * ide_dma_prd_d:
+ *     Uma entrada da tabela PRD. (scatter/gather)
+ *     Cada entrada é um pedaço fisicamente contínuo do buffer, que
+ * não cruza um limite de 64KB. A última entrada tem IDE_DMA_PRD_EOT.
+ */
+
+struct ide_dma_prd_d
+{
+    uint32_t addr;     // Physical address.
+    uint16_t len;      // Bytes. (0 = 64KB)
+    uint16_t flags;
+};
+
+#define IDE_DMA_PRD_EOT  0x8000
+
+// 64 entradas de 8 bytes. A tabela inteira fica em 512 bytes.
+#define IDE_DMA_PRD_MAX  64
+
+// Bits do status do bus master.
+#define ide_dma_sr_active  0x01
+#define ide_dma_sr_irq     0x04
+
+
 //
 // pci support
 // #todo: Podemos mudar isso para pic.h, mas precisamos ver 
@@ -207,6 +207,58 @@ void my_write_hd_sector( unsigned long ax,
                          unsigned long bx, 
 						 unsigned long cx, 
 						 unsigned long dx );    //exec.
+
+
+//
+// Transferncias vetoriais.
+// Um comando para vrios setores, por DMA ou PIO.
+//
+
+// Setores por comando. (LBA28, count 0 = 256)
+#define HDD_SECTORS_MAX  256
+
+// Timeout de um comando, em ticks.
+#define HDD_TIMEOUT_TICKS  300
+
+
+/*
+ * hdd_iovec_d:
+ *     Um pedao de memria de uma transferncia vetorial.
+ *     'len'  mltiplo de 512.
+ */
+
+struct hdd_iovec_d
+{
+	void *base;
+	unsigned long len;
+};
+
+
+// Flag. O disco atual aceita DMA. (init_hdd)
+int hdd_dma_enabled;
+
+// Counters.
+unsigned long hddCommands;
+unsigned long hddDMACommands;
+unsigned long hddSectorsRead;
+unsigned long hddSectorsWritten;
+unsigned long hddFlushes;
+unsigned long hddErrors;
+
+
+int 
+hddReadWriteVector ( int write, 
+                     unsigned long lba, 
+                     struct hdd_iovec_d *iov, 
+                     int iovcnt );
+
+int hddReadSectors ( unsigned long buffer, unsigned long lba, int count );
+
+int hddWriteSectors ( unsigned long buffer, unsigned long lba, int count );
+
+int hddFlushCache (void);
+
+void hddShowInfo (void);
 				
 /* 
  * init_hdd:
@@ -91,6 +91,24 @@ Protocol addresses of the source and destination hosts
 #define TDESC_CMD_RS   0x08 /* requests status report */
 
 
+//
+// TX ring.
+//
+
+// Descritores no ring. (TDLEN = 64*16 = 1024, múltiplo de 128)
+#define E1000_TX_RING_SIZE  64
+
+// Buffer de cada descritor. (um frame ethernet cabe)
+#define E1000_TX_BUFFER_SIZE  0x800
+
+// EOP | IFCS | IC | RS
+#define E1000_TX_CMD  0x1B
+
+// ICR/IMS: Transmit Descriptor Written Back, Transmit Queue Empty.
+#define E1000_ICR_TXDW  0x01
+#define E1000_ICR_TXQE  0x02
+
+
 //intel defines
 /*
 #define CTRL_SLU	(1 << 6)  //Set Link Up 
@@ -159,6 +177,30 @@ struct e1000_tx_desc {
 //
 
 
+//
+// RX ring.
+//
+
+// Descritores no ring. (RDLEN = 128*16 = 2048, múltiplo de 128)
+#define E1000_RX_RING_SIZE  128
+
+// Buffer de cada pacote. (RCTL.BSIZE = 2048)
+#define E1000_RX_BUFFER_SIZE  0x800
+
+// Pacotes no pool. Os que sobram substituem os buffers dos descritores.
+#define E1000_RX_POOL_SIZE  (E1000_RX_RING_SIZE + 32)
+
+#define RDESC_STA_DD   0x01 /* descriptor done */
+#define RDESC_STA_EOP  0x02 /* end of packet */
+
+// ICR: Link Status Change, Rx Descriptor Minimum Threshold,
+// Receiver Overrun, Receiver Timer Interrupt.
+#define E1000_ICR_LSC     0x04
+#define E1000_ICR_RXDMT0  0x10
+#define E1000_ICR_RXO     0x40
+#define E1000_ICR_RXT0    0x80
+
+
 /* Receive Descriptor */
 
 struct legacy_rx_desc 
@@ -178,6 +220,22 @@ struct legacy_rx_desc
 
 
 
+//
+// Pacote recebido.
+// Um buffer do pool. Enquanto está num descritor, o controlador 
+// escreve nele, depois é entregue ao protocolo sem cópia.
+//
+
+struct e1000_packet_d
+{
+	unsigned char *data;   //va
+	uint32_t pa;
+	uint32_t len;
+
+	struct e1000_packet_d *next;
+};
+
+
 //
 // arp cache item
 //
@@ -234,10 +292,35 @@ struct intel_nic_info_d
 	uint32_t mem_base;
 	
 	struct legacy_rx_desc *legacy_rx_descs; //rx ring virtual address
-	uint32_t rx_descs_virt[32];	
+	
+	// Pacote de cada descritor.
+	struct e1000_packet_d *rx_packets[E1000_RX_RING_SIZE];
+	
+	// Pool de pacotes. (lista dos livres)
+	struct e1000_packet_d rx_pool[E1000_RX_POOL_SIZE];
+	struct e1000_packet_d *rx_pool_free;
+	int rx_pool_count;
+	
+	// RX counters.
+	unsigned long rx_frames;
+	unsigned long rx_bytes;
+	unsigned long rx_drops;      //Pool vazio, o frame foi descartado.
+	unsigned long rx_errors;     //Descritor com erro ou sem EOP.
+	unsigned long rx_ring_full;  //Overrun. (ICR.RXO)
+	unsigned long rx_batches;
+	unsigned long rx_max_batch;
 
 	struct legacy_tx_desc *legacy_tx_descs; //tx ring virtual address
-	uint32_t tx_descs_virt[8];
+	uint32_t tx_descs_virt[E1000_TX_RING_SIZE];    //buffer de cada descritor. (va)
+
+	// O frame do descritor reservado está pronto. (e1000TxCommit)
+	uint8_t tx_ready[E1000_TX_RING_SIZE];
+
+	// tx_cur:   próximo descritor livre. (reserva)
+	// tx_clean: descritor mais antigo ainda não recuperado.
+	// tx_tail:  último valor escrito no TDT.
+	uint16_t tx_clean;
+	uint16_t tx_tail;
 	
 	uint32_t rx_descs_phys;  //rx ring physical address
 	uint32_t tx_descs_phys;	 //tx ring physical address
@@ -272,6 +355,16 @@ int e1000_interrupt_flag;
 
 int e1000_irq_count;
 
+
+//
+// TX counters.
+//
+
+unsigned long e1000TxQueued;
+unsigned long e1000TxReclaimed;
+unsigned long e1000TxDoorbells;
+unsigned long e1000TxDropped;
+
 //
 // ## prototypes ##
 //
@@ -313,6 +406,29 @@ void NetSendEthPacket ( PNetworkDevice dev,
 void E1000Send ( void *ndev, uint32_t len, uint8_t *data);		
 
 
+// TX ring.
+
+int e1000TxReclaim ( struct intel_nic_info_d *dev );
+
+int e1000TxFreeCount ( struct intel_nic_info_d *dev );
+
+int 
+e1000TxGetBuffer ( struct intel_nic_info_d *dev, 
+                   unsigned char **buffer );
+
+int 
+e1000TxCommit ( struct intel_nic_info_d *dev, 
+                int slot, 
+                uint32_t len );
+
+int 
+e1000TxQueue ( struct intel_nic_info_d *dev, 
+               uint32_t len, 
+               uint8_t *data );
+
+void e1000TxFlush ( struct intel_nic_info_d *dev );
+
+
 void E1000WriteCommand ( struct intel_nic_info_d *d, uint16_t addr, uint32_t val );
 
 uint32_t E1000ReadCommand (struct intel_nic_info_d *d, uint16_t addr) ;	
@@ -329,6 +445,8 @@ uint32_t E1000ReadEEPROM ( struct intel_nic_info_d *d, uint8_t addr );
 
 void xxxe1000handler (void);
 
+int e1000RxDrain ( struct intel_nic_info_d *dev );
+
 
 //
 // End.
@@ -72,6 +72,12 @@ void show_network_info (void);
 void show_current_nic_info (void);
 
 
+//entrega um frame recebido ao protocolo. (ARP/IPv4/IPv6)
+int 
+network_handle_frame ( struct intel_nic_info_d *nic, 
+                       unsigned char *frame, 
+                       uint32_t len );
+
 //manipular o pacote ipv6 recebido pelo handle do e1000.
 int handle_ipv6 ( struct intel_nic_info_d *nic, struct ipv6_header_d *header );
 
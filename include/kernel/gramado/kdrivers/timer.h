@@ -125,13 +125,109 @@ struct timer_d
 	unsigned long error; //e
 	
 	//Navegação.
+	//next e prev ligam os timers do mesmo slot da roda.
 	struct timer_d *next;
+	struct timer_d *prev;
+
+	// Tick em que o timer se esgota. (sys_time_ticks_total)
+	unsigned long expires;
+
+	// Slot da roda onde o timer está. NULL = fora da roda.
+	struct timer_d **bucket;
 };
 //timer_t *Timer;
 
 
-//lista de timers.
-unsigned long timerList[32];
+// Tipos.
+#define TIMER_TYPE_ONESHOT   1
+#define TIMER_TYPE_PERIODIC  2
+#define TIMER_TYPE_SLEEP     3  // Uma thread dormindo. (nanosleep)
+
+
+//
+// ## timer wheel ##
+//
+// Os timers ficam numa roda hierárquica e não numa lista. 
+// O nível 0 tem um slot por tick, os outros níveis têm slots 
+// cada vez maiores e descem para o nível de baixo quando o nível 0 
+// dá a volta. Inserir e remover é O(1) e o tick só olha um slot.
+// 256 * 64 * 64 * 64 ticks, uns 7 dias a 100HZ. 
+// Deadlines mais longos são cortados, a thread dorme de novo.
+//
+
+#define TIMER_WHEEL_ROOT_BITS   8
+#define TIMER_WHEEL_LEVEL_BITS  6
+#define TIMER_WHEEL_LEVELS      3  // Além do nível 0.
+
+#define TIMER_WHEEL_ROOT_SIZE   (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_LEVEL_SIZE  (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_ROOT_MASK   (TIMER_WHEEL_ROOT_SIZE - 1)
+#define TIMER_WHEEL_LEVEL_MASK  (TIMER_WHEEL_LEVEL_SIZE - 1)
+
+#define TIMER_WHEEL_MAX_TICKS \
+    ( (1UL << (TIMER_WHEEL_ROOT_BITS + TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_BITS)) - 1 )
+
+
+//
+// ## TSC clock ##
+//
+// O relógio monotônico usa o TSC, calibrado com o canal 2 do PIT 
+// na inicialização. A resolução é de nanosegundos e não depende 
+// da irq0. Sem TSC ele volta a contar ticks.
+//
+
+// Frequência do TSC. 0 = sem TSC.
+unsigned long tsc_khz;
+
+// O TSC não muda com o clock da cpu. (cpuid 0x80000007)
+int tsc_invariant;
+
+
+// Relógios. (SYS_CLOCKGETTIME)
+#define CLOCK_REALTIME   0  // #todo: rtc.
+#define CLOCK_MONOTONIC  1
+
+struct timespec_d
+{
+	unsigned long tv_sec;
+	long tv_nsec;
+};
+
+
+// Contadores.
+unsigned long timerPending;
+unsigned long timerExpired;
+unsigned long timerCascaded;
+
+
+//
+// ## tickless idle ##
+//
+// Quando só a idle pode rodar, a irq0 é mascarada e o timer do 
+// local APIC acorda a cpu no próximo deadline da roda. Os ticks que 
+// passaram são contados na volta. Qualquer interrupção termina o 
+// modo tickless, a irq0 volta e o scheduler decide.
+//
+
+// No máximo 1 segundo sem ticks. (extra, bcache)
+#define TIMER_TICKLESS_MAX_TICKS  HZ
+
+// Menos que isso não vale a pena.
+#define TIMER_TICKLESS_MIN_TICKS  2
+
+// 1 = ligado.
+int timerTickless;
+
+// Ticks que não geraram irq0 e vezes que a idle dormiu sem ticks.
+// (get_systime_info 4 e 5)
+unsigned long timerTicksSkipped;
+unsigned long timerTicklessIdles;
+
+
+// O trabalho adiado do tick roda depois do EOI, com as interrupções
+// ligadas e a irq0 mascarada. Então o handler da irq0 não manda outro
+// EOI. (hw.asm)
+int timer_eoi_sent;
 
 
 /*
@@ -167,10 +263,26 @@ void timerDisableTextCursor (void);
 unsigned long get_systime_info (int n);
 
 struct timer_d *create_timer ( struct window_d *window, unsigned long ms, int type  );
-//#todo destroy timer.
+int destroy_timer ( struct timer_d *timer );
 
 int new_timer_id (void);
 
+// TSC clock.
+int timerCalibrateTSC (void);
+unsigned long long timerReadTSC (void);
+unsigned long long timerGetMonotonicNS (void);
+unsigned long timerGetMonotonicUS (void);
+int timerClockGetTime ( int clock_id, struct timespec_d *ts );
+
+// Chamada pela idle com as interrupções desabilitadas.
+// 1 = a cpu dormiu sem ticks, 0 = use o hlt normal.
+int timerTicklessIdle (void);
+
+// Threads dormindo.
+void timerInitThread ( struct thread_d *thread );
+void timerCancelSleep ( struct thread_d *thread );
+int timerSleepUntil ( unsigned long deadline );
+
 //
 // End.
 //
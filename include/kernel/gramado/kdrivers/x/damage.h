@@ -0,0 +1,91 @@
+/*
+ * File: x/damage.h
+ *
+ *     Dirty rectangles of the backbuffer.
+ *
+ *     The drawing routines of the kgws (rect, line, char, bmp ...)
+ * mark the area they painted with damageAdd(). refresh_screen()
+ * copies only these areas to the frontbuffer, with one vsync for
+ * all of them, and not the whole backbuffer.
+ *
+ *     Overlapping or touching rectangles are merged. When the list
+ * is full the new rectangle is merged with the one that grows less.
+ * When the dirty area is big the whole screen is copied.
+ *
+ *     Deadline: (optional) With damage_deadline_ticks > 0,
+ * refresh_screen() only copies when the first pending rectangle is
+ * that old, and the timer copies what is left. So many small updates
+ * in the same frame become one copy. damageFlush() always copies.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define DAMAGE_RECT_MAX  16
+
+// Dirty area, in percent of the screen, to copy the whole screen.
+#define DAMAGE_FULL_PERCENT  60
+
+// Default deadline. 0 = copy on every refresh_screen().
+#define DAMAGE_DEADLINE_DEFAULT  0
+
+
+/*
+ * damage_rect_d:
+ *     A dirty rectangle. right and bottom are not included.
+ */
+
+struct damage_rect_d
+{
+	unsigned long left;
+	unsigned long top;
+	unsigned long right;
+	unsigned long bottom;
+};
+
+struct damage_rect_d damageList[DAMAGE_RECT_MAX];
+
+int damage_count;
+
+// Flag. The whole screen is dirty.
+int damage_full;
+
+// Flag. Before this, refresh_screen() copies the whole screen.
+int damage_initialized;
+
+// Ticks to wait before copying. (timer)
+unsigned long damage_deadline_ticks;
+
+// Tick of the first pending rectangle.
+unsigned long damage_first_tick;
+
+
+//
+// Prototypes.
+//
+
+void damageInit (void);
+
+void
+damageAdd ( unsigned long x,
+            unsigned long y,
+            unsigned long width,
+            unsigned long height );
+
+void damageAddAll (void);
+
+int damagePending (void);
+
+void damageSetDeadline ( unsigned long ticks );
+
+void damageRefresh (void);
+
+void damageFlush (void);
+
+void damageTimer (void);
+
+
+//
+// End.
+//
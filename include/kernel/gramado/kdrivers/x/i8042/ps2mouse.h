@@ -131,6 +131,15 @@ int load_mouse_bmp (void);
 
 void mouseHandler (void); 
 
+// Trabalho adiado do mouse. (defer.h)
+void mouseBottomHalf (void);
+
+// Pacotes que a irq colocou na fila, pacotes perdidos com a fila
+// cheia, e eventos entregues pelo bottom half.
+unsigned long mouse_packets;
+unsigned long mouse_packets_dropped;
+unsigned long mouse_events;
+
 void ps2_mouse_initialize (void);
 
 int ps2_mouse_globals_initialize (void);
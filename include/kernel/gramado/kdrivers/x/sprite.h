@@ -0,0 +1,109 @@
+/*
+ * File: x/sprite.h
+ *
+ *     Sprites: the mouse pointer and the text cursor.
+ *
+ *     A sprite is decoded once from its BMP into the pixel format of
+ * the frontbuffer, with a mask for the transparent color. It is drawn
+ * only in the frontbuffer (LFB), never in the backbuffer, and what was
+ * under it is kept in its save-under buffer. Hiding the sprite is a
+ * copy of the save-under back to the LFB.
+ *
+ *     Moving a sprite only records the new position. The LFB is changed
+ * at most once per tick: by the caller, if nothing was changed in this
+ * tick yet, or by the timer. (spriteTimer)
+ *
+ *     The copies from the backbuffer to the LFB (refresh_rectangle_nosync)
+ * hide the sprites they touch, and show them again when they are done,
+ * so the save-under is always what the LFB has below the sprite.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define SPRITE_MAX  4
+
+// Stacking order, the higher id on top.
+#define SPRITE_TEXT_CURSOR  0
+#define SPRITE_POINTER      1
+
+// Pixels of one side.
+#define SPRITE_SIZE_MAX    32
+#define SPRITE_PIXELS_MAX  (SPRITE_SIZE_MAX * SPRITE_SIZE_MAX)
+
+
+struct sprite_d
+{
+	int used;
+	int magic;
+
+	unsigned long width;
+	unsigned long height;
+
+	// Frontbuffer format, width * bytes per pixel for each line.
+	unsigned char image[SPRITE_PIXELS_MAX * 4];
+
+	// 1 = opaque.
+	unsigned char mask[SPRITE_PIXELS_MAX];
+
+	// What we want.
+	int visible;
+	unsigned long x;
+	unsigned long y;
+
+	// What is on the LFB. (clipped to the screen)
+	int shown;
+	unsigned long shown_x;
+	unsigned long shown_y;
+	unsigned long shown_width;
+	unsigned long shown_height;
+
+	// The LFB below the sprite.
+	unsigned char save[SPRITE_PIXELS_MAX * 4];
+
+	// Moved or changed, not on the LFB yet.
+	int dirty;
+};
+
+
+// LFB updates, and the ones left to the timer.
+unsigned long sprite_updates;
+unsigned long sprite_deferred;
+
+
+//
+// Prototypes.
+//
+
+void spriteInit (void);
+
+// Decodes the BMP. key = transparent color. 0 = ok.
+int spriteLoadBMP ( int id, char *address, unsigned long key );
+
+int spriteIsReady ( int id );
+
+void spriteMove ( int id, unsigned long x, unsigned long y );
+void spriteShow ( int id, int visible );
+
+// Puts the changes on the LFB, if not done in this tick.
+void spriteUpdate (void);
+
+// Called by the timer, once per tick.
+void spriteTimer (void);
+
+int spritePending (void);
+
+// Around the copies from the backbuffer to the LFB.
+void
+spriteBeginCopy ( unsigned long x,
+                  unsigned long y,
+                  unsigned long width,
+                  unsigned long height );
+void spriteEndCopy (void);
+
+
+//
+// End.
+//
+
@@ -0,0 +1,134 @@
+/*
+ * File: fs/bcache.h
+ *
+ *     Buffer cache for the disk sectors.
+ *     The file system reads and writes sectors through the cache,
+ * and the cache calls the hdd driver. (my_read_hd_sector and
+ * my_write_hd_sector)
+ *
+ *     Sectors that are not in the cache are read in runs, one disk
+ * command for each run. The sync writes the dirty sectors in runs too,
+ * and asks the disk to flush its own cache at the end.
+ *
+ *     A sector is found by a hash of its lba. When all the buffers
+ * are in use the least recently used one is reused. The data of the
+ * files stays in at most BCACHE_FILE_MAX buffers, over that it only
+ * takes the place of other file data, so a big file doesn't take the
+ * FAT and the directories out of the cache. Writes only mark
+ * the buffer as dirty, the dirty buffers go to the disk by bcacheSync(),
+ * when they are reused, in the deferred work that the timer raises
+ * every BCACHE_SYNC_TICKS, and before a reboot or a shutdown.
+ *     A buffer is valid only if the read worked, and stays dirty if
+ * the write did not.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// 512 sectors. 256KB.
+#define BCACHE_COUNT  512
+
+#define BCACHE_SECTOR_SIZE  512
+
+// Power of 2.
+#define BCACHE_HASH_COUNT  128
+
+// Ask for a write-back every 5 seconds. (100Hz)
+#define BCACHE_SYNC_TICKS  500
+
+// Sectors in one disk command. (32KB)
+#define BCACHE_RUN_MAX  64
+
+// Buffers with file data. (bcacheReadBlocks keep = 0)
+// A read of more sectors than this goes straight to the disk.
+#define BCACHE_FILE_MAX  (BCACHE_COUNT / 2)
+
+
+/*
+ * bcache_d:
+ *     A buffer with the copy of a sector.
+ */
+
+struct bcache_d
+{
+	int used;
+	int magic;
+
+	unsigned long lba;
+
+	int valid;     //The data is the sector.
+	int dirty;     //The data is newer than the sector.
+	int file;      //Data of a file. (BCACHE_FILE_MAX)
+
+	char *data;
+
+	//Hash chain.
+	struct bcache_d *hash_next;
+
+	//LRU list.
+	struct bcache_d *lru_prev;
+	struct bcache_d *lru_next;
+};
+
+struct bcache_d bcacheList[BCACHE_COUNT];
+
+struct bcache_d *bcacheHash[BCACHE_HASH_COUNT];
+
+// Most recently used at the head, the next victim at the tail.
+struct bcache_d *bcacheLRUHead;
+struct bcache_d *bcacheLRUTail;
+
+
+//
+// Counters.
+//
+
+unsigned long bcacheHits;
+unsigned long bcacheMisses;
+unsigned long bcacheDiskReads;
+unsigned long bcacheDiskWrites;
+unsigned long bcacheCleanWrites;    //Writes with the same data. (skipped)
+unsigned long bcacheDirtyCount;
+unsigned long bcacheWriteErrors;
+unsigned long bcacheFileCount;      //Buffers with file data.
+
+
+// Flag. The cache is ready.
+int bcache_initialized;
+
+// Flag. The deferred write-back came in the middle of a call of the
+// cache, the call does it at the end.
+int bcache_sync_request;
+
+
+//
+// Prototypes.
+//
+
+int bcacheInit (void);
+
+// 0 = ok, -1 = disk error.
+int bcacheRead ( unsigned long address, unsigned long lba );
+
+int 
+bcacheReadBlocks ( unsigned long address, 
+                   unsigned long lba, 
+                   unsigned long count, 
+                   int keep );
+
+int bcacheWrite ( unsigned long address, unsigned long lba );
+
+// Sectors written, or -1 if some write failed.
+int bcacheSync (void);
+
+// The periodic write-back. (timer)
+void bcacheSyncRequest (void);
+
+void bcacheShowInfo (void);
+
+
+//
+// End.
+//
+
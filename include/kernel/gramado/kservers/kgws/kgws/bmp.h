@@ -81,6 +81,14 @@ int bmpDisplayMousePointerBMP( char *address,
 int bmpDisplayCursorBMP( char *address, 
                          unsigned long x, 
 				         unsigned long y );
+
+// Decodifica para pixels 0x00RRGGBB, de cima para baixo. 0 = ok.
+int
+bmpDecode ( char *address,
+            unsigned long *pixels,
+            unsigned long max,
+            unsigned long *width,
+            unsigned long *height );
 					
 						   
 //
@@ -0,0 +1,89 @@
+/*
+ * File: kgws/bmpcache.h
+ *
+ *     Decoded BMP cache.
+ *
+ *     A BMP that is already in memory (icons, wallpapers) is decoded
+ * once by bmpDecode(), into the pixel format of the backbuffer, and
+ * kept here keyed by its address. The next draws of the same image are
+ * a copy per line, or a color key compare for the transparent ones,
+ * into the backbuffer or into the surface being painted. (surface.h)
+ *
+ *     The entries come from the paged pool, within a budget. When a new
+ * image does not fit, the least recently drawn ones are evicted.
+ *
+ *     fsLoadFile() calls bmpCacheInvalidate() for its buffer, so a file
+ * loaded again is decoded again. The stamp of the header and of the
+ * first bytes of the pixels only catches the other rewrites.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define BMPCACHE_MAX  32
+
+// Pages of one image, and of all of them.
+#define BMPCACHE_PAGES_MAX        256
+#define BMPCACHE_TOTAL_PAGES_MAX  256
+
+
+struct bmpcache_d
+{
+	int used;
+	int magic;
+
+	// The BMP in memory, and its stamp.
+	char *address;
+	unsigned long stamp;
+
+	unsigned long width;
+	unsigned long height;
+
+	unsigned long bytes_per_pixel;
+	unsigned long pitch;
+
+	int pages;
+	unsigned char *buffer;
+
+	// LRU.
+	unsigned long last_use;
+};
+
+
+unsigned long bmpcache_count;
+unsigned long bmpcache_pages_used;
+
+unsigned long bmpcache_hits;
+unsigned long bmpcache_misses;
+unsigned long bmpcache_evictions;
+
+
+//
+// Prototypes.
+//
+
+void bmpCacheInit (void);
+
+// Decodes the BMP if it is not in the cache, and draws it. 0 = ok,
+// 1 = no budget or bad BMP.
+// mode: BMP_CHANGE_COLOR_NULL, _TRANSPARENT (key is not drawn) or
+// _SUBSTITUTE (key is drawn as substitute). Clipped to the target.
+int
+bmpCacheDraw ( char *address,
+               unsigned long x,
+               unsigned long y,
+               int mode,
+               unsigned long key,
+               unsigned long substitute );
+
+// The buffer was loaded again.
+void bmpCacheInvalidate ( char *address );
+
+void bmpCacheShowInfo (void);
+
+
+//
+// End.
+//
+
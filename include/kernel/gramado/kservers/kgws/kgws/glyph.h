@@ -0,0 +1,107 @@
+/*
+ * File: kgws/glyph.h
+ *
+ *     Glyph cache for the 8 pixel wide fonts.
+ *
+ *     A glyph line is one byte of the font, so the cache is keyed by the
+ * byte and not by the character: for each fg/bg pair there is a table
+ * with the 8 pixels of each of the 256 bytes, already in the pixel
+ * format of the backbuffer. An opaque glyph (draw_char) is one copy of
+ * 8 pixels per line, for any character and any font.
+ *
+ *     The transparent glyphs (drawchar_transparent, draw_string) use
+ * a table with the runs of set bits of each byte. Each run is a fill
+ * with the color.
+ *
+ *     A glyph that is not entirely inside the target, or is partly
+ * outside clip_region, goes through the old pixel by pixel path.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// fg/bg pairs with a table. (8KB each, LRU)
+#define GLYPH_PAIRS_MAX  8
+
+// glyphBenchmark()
+#define GLYPH_BENCH_GLYPHS  8192
+
+
+struct glyph_span_d
+{
+	unsigned char count;
+	unsigned char start[4];
+	unsigned char len[4];
+};
+
+
+struct glyph_pair_d
+{
+	int used;
+	int magic;
+
+	unsigned long fg;
+	unsigned long bg;
+	unsigned long bytes_per_pixel;
+
+	// 256 * 8 pixels.
+	unsigned char *rows;
+
+	// LRU.
+	unsigned long last_use;
+};
+
+
+// 0 = the pixel by pixel path. (glyphBenchmark)
+int glyph_cache_enabled;
+
+unsigned long glyph_hits;
+unsigned long glyph_misses;
+
+// Glyphs drawn by the cache, and by the old path.
+unsigned long glyph_fast;
+unsigned long glyph_slow;
+
+
+//
+// Prototypes.
+//
+
+void glyphInit (void);
+
+// bitmap = one byte per line. 0 = drawn, 1 = use the old path.
+int
+glyphDrawChar ( unsigned long x,
+                unsigned long y,
+                unsigned char *bitmap,
+                int width,
+                int height,
+                unsigned long fgcolor,
+                unsigned long bgcolor );
+
+int
+glyphDrawTransparent ( unsigned long x,
+                       unsigned long y,
+                       unsigned char *bitmap,
+                       int width,
+                       int height,
+                       unsigned long color );
+
+// The whole string, with the current font. 0 = drawn or clipped out.
+int
+glyphDrawString ( unsigned long x,
+                  unsigned long y,
+                  unsigned long color,
+                  unsigned char *string );
+
+// glyphs/s with and without the cache.
+void glyphBenchmark (void);
+
+void glyphShowInfo (void);
+
+
+//
+// End.
+//
+
@@ -0,0 +1,74 @@
+/*
+ * File: kgws/hit.h
+ *
+ *     Spatial index for the mouse hit test.
+ *
+ *     The screen is a grid of HIT_CELL_SIZE cells. Each cell has the
+ * windows that touch it, in the zorder, the top first. Controls
+ * (buttons and editboxes) are not in the grid, they are in the list
+ * of their parent window, also the top first, with coordinates
+ * relative to the parent. (see windowScan)
+ *
+ *     hitTest() takes the cell under the pointer and visits the
+ * windows there that have the point, the top first. The result is the
+ * highest control of those windows that has the point and is above the
+ * top window, so a covered control is never selected. The cost is the
+ * depth of the windows under the pointer, not the number of windows.
+ *
+ *     The index is changed by createw, replace_window, resize_window,
+ * MaximizeWindow and CloseWindow, and read by the mouse irq.
+ * A cell with more than HIT_CELL_MAX windows falls back to the
+ * zorderList[] for the points inside it, until it loses a window and
+ * is built again.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define HIT_CELL_SHIFT  6
+#define HIT_CELL_SIZE   (1 << HIT_CELL_SHIFT)
+
+// 2048x2048.
+#define HIT_GRID_COLS  32
+#define HIT_GRID_ROWS  32
+
+#define HIT_CELL_MAX   8
+
+
+struct hit_cell_d
+{
+	int count;
+
+	// Too many windows. Use the zorderList[].
+	int overflow;
+
+	struct window_d *windows[HIT_CELL_MAX];
+};
+
+
+// Tests, and tests that used the zorderList[].
+unsigned long hit_tests;
+unsigned long hit_fallbacks;
+
+
+//
+// Prototypes.
+//
+
+void hitInit (void);
+
+void hitInsert ( struct window_d *window );
+void hitRemove ( struct window_d *window );
+
+// The window moved or changed its size.
+void hitUpdate ( struct window_d *window );
+
+// Returns the id of the control under the point, or -1.
+int hitTest ( unsigned long x, unsigned long y );
+
+
+//
+// End.
+//
+
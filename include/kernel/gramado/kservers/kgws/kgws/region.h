@@ -0,0 +1,95 @@
+/*
+ * File: kgws/region.h
+ *
+ *     Regions: short lists of rectangles that do not overlap.
+ *
+ *     The visible region of a window is its rectangle minus the
+ * rectangles of the windows above it in the zorder. While clip_region
+ * is set, the drawing routines of the kgws (rect, line, char) paint
+ * only inside it. So redraw_screen() paints each pixel once and the
+ * invalidation after a move, resize or close repaints only what was
+ * exposed.
+ *
+ *     When a subtraction needs more than REGION_RECT_MAX rectangles the
+ * piece is kept whole, and when the list is full the last rectangles
+ * are merged. The region gets bigger, never smaller, so at worst some
+ * pixels are painted twice.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define REGION_RECT_MAX  32
+
+
+/*
+ * region_rect_d:
+ *     right and bottom are not included.
+ */
+
+struct region_rect_d
+{
+	unsigned long left;
+	unsigned long top;
+	unsigned long right;
+	unsigned long bottom;
+};
+
+
+struct region_d
+{
+	int count;
+	struct region_rect_d rects[REGION_RECT_MAX];
+};
+
+
+// Clip of the drawing routines. NULL = the whole screen.
+struct region_d *clip_region;
+
+
+// regionTestRect()
+#define REGION_OUT      0
+#define REGION_IN       1
+#define REGION_PARTIAL  2
+
+
+//
+// Prototypes.
+//
+
+void regionClear ( struct region_d *region );
+
+// One rectangle, clipped to the screen.
+void
+regionSetRect ( struct region_d *region,
+                unsigned long left,
+                unsigned long top,
+                unsigned long width,
+                unsigned long height );
+
+int regionIsEmpty ( struct region_d *region );
+
+void regionSubtractRect ( struct region_d *region, struct region_rect_d *rect );
+
+void regionIntersectRect ( struct region_d *region, struct region_rect_d *rect );
+
+void regionIntersect ( struct region_d *region, struct region_d *with );
+
+int
+regionTestRect ( struct region_d *region,
+                 unsigned long left,
+                 unsigned long top,
+                 unsigned long right,
+                 unsigned long bottom );
+
+int
+regionContains ( struct region_d *region,
+                 unsigned long x,
+                 unsigned long y );
+
+
+//
+// End.
+//
+
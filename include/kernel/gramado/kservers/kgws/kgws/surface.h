@@ -0,0 +1,118 @@
+/*
+ * File: kgws/surface.h
+ *
+ *     Window surfaces.
+ *
+ *     An overlapped window has its own offscreen buffer, with the same
+ * pixel format as the backbuffer. redraw_window() and draw_text() paint
+ * into it while draw_surface is set: backbuffer_putpixel() writes into
+ * the surface and damageAdd() marks the dirty rectangle of the surface.
+ *
+ *     The compositor copies the surfaces to the backbuffer, in the
+ * zorder, only inside the visible region of each window. (region.h)
+ * So moving a window, or exposing it after a close or a minimize, is
+ * a copy of its surface and not a new paint by its owner.
+ *
+ *     The surfaces come from the high memory, mapped in the kmap
+ * window of the kernel, so they have a budget.
+ * The windows without a surface (too big, no budget, not overlapped)
+ * are painted directly in the backbuffer, as before.
+ *
+ *     Drawing that goes straight to the backbuffer with screen
+ * coordinates (printf of the terminal, for example) does not reach the
+ * surface.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// Pages of one surface, and of all of them. (the window has 4MB)
+#define SURFACE_PAGES_MAX        128
+#define SURFACE_TOTAL_PAGES_MAX  384
+
+
+struct surface_d
+{
+	int used;
+	int magic;
+
+	struct window_d *window;
+
+	// Pixels. (width +2, height +2 of the window, see window_bounds)
+	unsigned long width;
+	unsigned long height;
+
+	unsigned long bytes_per_pixel;
+	unsigned long pitch;
+
+	int pages;
+	unsigned char *buffer;
+
+	// The surface has the whole window painted.
+	int valid;
+
+	// Dirty rectangle, in surface coordinates, not copied yet.
+	int dirty;
+	unsigned long dirty_left;
+	unsigned long dirty_top;
+	unsigned long dirty_right;
+	unsigned long dirty_bottom;
+};
+
+
+// Drawing target. NULL = backbuffer.
+// The origin is the screen position of the window when the paint began.
+struct surface_d *draw_surface;
+unsigned long draw_surface_left;
+unsigned long draw_surface_top;
+
+
+unsigned long surface_count;
+unsigned long surface_pages_used;
+
+// Window paints into surfaces, and copies from surfaces.
+unsigned long surface_paints;
+unsigned long surface_blits;
+
+
+//
+// Prototypes.
+//
+
+int surfaceCreate ( struct window_d *window );
+void surfaceDestroy ( struct window_d *window );
+
+// Drawing into the surface of the window.
+void surfaceBegin ( struct window_d *window );
+void surfaceEnd (void);
+
+// Called by backbuffer_putpixel and damageAdd while draw_surface is set.
+// Screen coordinates.
+void
+surfacePutPixel ( unsigned long color,
+                  unsigned long x,
+                  unsigned long y );
+
+void
+surfaceDamage ( unsigned long x,
+                unsigned long y,
+                unsigned long width,
+                unsigned long height );
+
+// The owner paints the whole window into its surface. (redraw_window)
+int surfacePaint ( struct window_d *window );
+
+// Copy the surface to the backbuffer inside the region. (screen)
+void surfaceBlit ( struct window_d *window, struct region_d *region );
+
+// Copy the dirty part that is visible.
+void surfaceFlush ( struct window_d *window );
+
+void surfaceShowInfo (void);
+
+
+//
+// End.
+//
+
@@ -1214,7 +1214,20 @@ struct window_d
 	// #suspenso.
 	//struct linkedlist_d *linkedlist;	
 	
-
+	// Surface da janela. (surface.h)
+	// DedicatedBuffer aponta para o buffer do surface.
+	struct surface_d *surface;
+	
+	// ndice do hit test do mouse. (hit.h)
+	// O retngulo que est no grid, a lista de controles 
+	// (se for uma janela me) e o prximo controle da lista da me.
+	int hit_indexed;
+	unsigned long hit_left;
+	unsigned long hit_top;
+	unsigned long hit_right;
+	unsigned long hit_bottom;
+	struct window_d *hit_controls;
+	struct window_d *hit_next;
 };
 struct window_d *CurrentWindow;    //Janela atual
 struct window_d *ActiveWindow;     //Janela atual.
@@ -2036,6 +2049,13 @@ void refresh_rectangle( unsigned long x,
 						unsigned long width, 
 						unsigned long height );	
 
+//o mesmo, sem vsync. (damageFlush)
+void 
+refresh_rectangle_nosync ( unsigned long x, 
+                           unsigned long y, 
+                           unsigned long width, 
+                           unsigned long height );
+
 //envia um retngulo de um buffer para outro.
 void 
 refresh_rectangle2 ( unsigned long x, 
@@ -2217,6 +2237,16 @@ int redraw_window (struct window_d *window, unsigned long flags );
 //redraw all windows.
 int redraw_screen (void);                          
 
+//regio visvel e invalidao. (region.h)
+int windowVisibleRegion ( struct window_d *window, struct region_d *region );
+int windowInvalidateRegion ( struct region_d *exposed );
+
+int 
+windowInvalidateRect ( unsigned long left, 
+                       unsigned long top, 
+                       unsigned long width, 
+                       unsigned long height );
+
 int is_window_full(struct window_d *window);
 int is_window_maximized(struct window_d *window);
 int is_window_minimized(struct window_d *window);
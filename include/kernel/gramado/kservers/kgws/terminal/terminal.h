@@ -150,6 +150,8 @@ void terminalPutChar ( int c );
 
 void kgws_terminal_putchar ( int c );
 
+int kgws_terminal_write ( const char *buffer, int len );
+
 void kgws_outbyte ( int c );
 
 
@@ -0,0 +1,73 @@
+/*
+ * File: ps/defer.h
+ *
+ *     Deferred work. (bottom halves)
+ *
+ *     An irq handler does only the minimum with the hardware, queues
+ * its data and raises its deferred work. The work runs later:
+ *
+ *     + In the ring 0 idle thread, with the interrupts enabled and the
+ *       task switch locked. (threadi.c)
+ *     + At the end of the timer tick, when the idle thread is not
+ *       running. After the EOI, with the interrupts enabled and the
+ *       irq0 masked. (timer.c)
+ *
+ *     So the work of many interrupts can be done in one run, and the
+ * other irqs are not delayed by it while the system is idle.
+ *     Only one cpu runs the deferred work at a time.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#define DEFER_MAX  32
+
+
+struct defer_d
+{
+	int used;
+	int magic;
+
+	char *name;
+
+	void (*handler) (void);
+
+	// Raised by the irqs, and runs of the handler.
+	unsigned long raised;
+	unsigned long runs;
+};
+
+
+// One bit for each work. Set by deferRaise, cleared by deferRun.
+volatile unsigned long defer_pending;
+
+// Runs from the idle thread and from the timer tick.
+unsigned long defer_idle_runs;
+unsigned long defer_tick_runs;
+
+
+//
+// Prototypes.
+//
+
+void deferInit (void);
+
+// Returns the id, or -1.
+int deferRegister ( char *name, void (*handler) (void) );
+
+// Called by the irq handlers.
+void deferRaise ( int id );
+
+int deferIsPending (void);
+
+// Runs all the pending work. 1 = called from the idle thread.
+void deferRun ( int idle );
+
+void deferShowInfo (void);
+
+
+//
+// End.
+//
+
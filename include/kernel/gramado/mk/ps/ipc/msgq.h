@@ -0,0 +1,74 @@
+/*
+ * File: ps/ipc/msgq.h
+ *
+ *     Fila de mensagens das threads.
+ *     Each thread has a bounded ring buffer of messages. (thread_d)
+ *
+ *     The drivers and the window server post with msgqPost(), the
+ * thread takes the messages with the service 111 (one message),
+ * SYS_GETMESSAGES (many messages in one call) and sleeps with
+ * SYS_WAITMESSAGE until a message is posted.
+ *
+ *     Only the thread reads its queue, so the consumer does not need
+ * a lock. The producers run with the interrupts disabled. When the
+ * queue is full the message is dropped and counted in msg_dropped.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// Words in a message given to the user. (SYS_GETMESSAGES)
+// window, msg, long1, long2, long3, long4, long5, long6.
+#define MSGQ_MESSAGE_WORDS  8
+
+
+//
+// Counters.
+//
+
+unsigned long msgqPosted;
+unsigned long msgqDropped;
+unsigned long msgqCoalesced;
+unsigned long msgqWakeups;
+
+
+//
+// Prototypes.
+//
+
+void msgqInit ( struct thread_d *t );
+
+int msgqPost ( struct thread_d *t, struct thread_msg_d *m );
+
+int 
+msgqPostMessage ( struct thread_d *t, 
+                  struct window_d *window, 
+                  int msg, 
+                  unsigned long long1, 
+                  unsigned long long2 );
+
+int msgqCount ( struct thread_d *t );
+
+int msgqPeek ( struct thread_d *t, struct thread_msg_d *m );
+
+int msgqGet ( struct thread_d *t, struct thread_msg_d *m );
+
+int 
+msgqGetMany ( struct thread_d *t, 
+              unsigned long *buffer, 
+              int max );
+
+int msgqPumpKeyboard (void);
+
+int msgqWait ( struct thread_d *t );
+
+void msgqWakeupFocus (void);
+
+void msgqShowInfo (void);
+
+
+//
+// End.
+//
+
@@ -19,6 +19,16 @@
 #define BASE_COUNT 0
 #define MAX_COUNT  8
 
+// Semforos do kernel, usados pelas syscalls. (handle = ndice)
+#define SEMAPHORE_COUNT_MAX  32
+
+// Tipos.
+#define SEMAPHORE_TYPE_COUNTING  1
+#define SEMAPHORE_TYPE_MUTEX     2
+
+// Down() no bloqueia, s tenta.
+#define SEMAPHORE_TRY  1
+
 
 /*
  * estruturas.
@@ -55,6 +65,25 @@ struct semaphore_d
 	int status;         //F Flag.
 	unsigned int count; //>=0   //E
    
+	// Counting ou mutex.
+	int type;
+	
+	// Mutex: a thread dona. (-1 = livre)
+	int owner;
+	
+	// Fila de espera. (FIFO)
+	// As threads bloqueadas em Down, ligadas por thread_d.sem_next.
+	// Up entrega o recurso direto para a primeira.
+	struct thread_d *wait_head;
+	struct thread_d *wait_tail;
+	int waiters;
+	
+	// Contadores. (locks quentes)
+	unsigned long acquires;      //Downs que pegaram o recurso.
+	unsigned long contended;     //Downs que tiveram que esperar.
+	unsigned long wakeups;       //Threads acordadas por Up.
+	unsigned long max_waiters;
+	
     //...
 	
     //@todo: corrigir o nome dessa estrututras.
@@ -66,6 +95,10 @@ semaphore_descriptor_t *current_semaphore;
 
 unsigned long semaphoreList[32+1];
 
+// Totais.
+unsigned long semaphoreContended;
+unsigned long semaphoreWakeups;
+
 
 //
 // Variveis.
@@ -120,6 +153,25 @@ void open_semaphore(struct semaphore_d *s);
 
 void close_semaphore(struct semaphore_d *s);
 
+
+//
+// Wait queue support.
+//
+
+void semInitThread ( struct thread_d *t );
+
+// Limpeza na morte da thread e do processo.
+void semExitThread ( struct thread_d *t );
+void semExitProcess ( int pid );
+
+// Syscalls. (handle = ndice em semaphoreList[])
+int semCreate ( unsigned int count, int type );
+int semDestroy ( int handle );
+int semDown ( int handle, int flags );
+int semUp ( int handle );
+
+void semShowInfo (void);
+
 //
 // End.
 //
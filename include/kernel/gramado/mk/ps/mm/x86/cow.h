@@ -0,0 +1,89 @@
+/*
+ * File: mm/x86/cow.h
+ *
+ *     Copy-on-write for fork().
+ *
+ *     The child gets its own page table for the image, but the entries
+ * point to the frames of the parent. The writable pages are marked
+ * read-only and COW in both tables, and each shared frame has a
+ * reference count in frameTable[]. (ref_count)
+ *
+ *     The first write to one of these pages is a #PF. The handler
+ * copies the page to a new frame, or, if nobody else uses the frame
+ * anymore, just makes it writable again.
+ *
+ *     When a process exits, its references are dropped. The last one
+ * frees the frame.
+ *
+ *     CR0.WP is set on the first fork, so the kernel also faults when
+ * it writes to a COW page of a process. (syscalls)
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// Page table entry flags.
+#define COW_PTE_PRESENT  0x001
+#define COW_PTE_WRITE    0x002
+#define COW_PTE_USER     0x004
+
+// Bit 9 is available to the OS. The page is shared by a fork.
+#define COW_PTE_COW      0x200
+
+#define COW_PTE_FRAME    0xFFFFF000
+
+
+//
+// Counters.
+//
+
+unsigned long cow_fork_count;
+
+// Fork latency, in TSC cycles.
+unsigned long cow_fork_last_cycles;
+unsigned long cow_fork_max_cycles;
+unsigned long cow_fork_total_cycles;
+
+// Pages shared by the forks.
+unsigned long cow_pages_shared;
+
+// Write faults. Pages copied and pages made writable without a copy.
+unsigned long cow_fault_count;
+unsigned long cow_pages_copied;
+unsigned long cow_pages_reused;
+
+// References dropped by the exits.
+unsigned long cow_pages_released;
+
+// No memory for the copy.
+unsigned long cow_fail_count;
+
+
+//
+// Prototypes.
+//
+
+int
+cowSharePageTable ( unsigned long parent_dir_va,
+                    unsigned long child_dir_va,
+                    int dir_index );
+
+// Called by the #PF stub. (hw.asm)
+// Returns 1 if the fault was resolved.
+int cowPageFault ( unsigned long error_code );
+
+// Exit. Drops the references of the COW pages of the table.
+void cowReleasePageTable ( unsigned long dir_va, int dir_index );
+
+unsigned long cowTimestamp (void);
+
+void cowForkDone ( unsigned long start );
+
+void cowShowInfo (void);
+
+
+//
+// End.
+//
+
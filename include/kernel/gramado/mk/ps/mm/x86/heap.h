@@ -39,6 +39,10 @@ unsigned long kernel_heap_end;      //End.
 unsigned long g_heap_pointer;       //Pointer.
 unsigned long g_available_heap;     //Available.
 
+// Large blocks freed and reused. (FreeHeap/heapAllocateMemory)
+unsigned long heapFreeBlocks;       //Blocks in the free list.
+unsigned long heapRecycledBlocks;   //Allocations served by the free list.
+
 
 /*
  * HeapPointer:
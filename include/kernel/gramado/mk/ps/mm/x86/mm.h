@@ -854,11 +854,97 @@ struct page_d
 };
  
 
-// #importante
-// Pool de memria paginvel usado para alocao.
-// Aqui ficam os ponteiros para estrutura do tipo page.
+//
+// ## Frame allocator ##
+//
+
+// Buddy allocator for the physical memory. (pages.c)
+// Each zone has a free list per order; a free block of order N
+// has 2^N contiguous frames. The descriptors live in frameTable[],
+// one per frame of the RAM, indexed by (pa/4096).
+
+// 2^10 frames = 4MB. The size of the paged pool.
+#define FRAME_ORDER_COUNT  11
+
+// Indexes are 16 bits. (256MB)
+#define FRAME_COUNT_MAX  0xFFFF
+#define FRAME_NULL       0xFFFF
+
+// frame_d flags.
+#define FRAME_FREE      1    //Head of a free block.
+#define FRAME_HEAD      2    //Head of an allocated block.
+#define FRAME_RESERVED  4    //Not managed by the allocator.
+#define FRAME_TAIL      8    //Other frame of an allocated block.
+
+// The frames below 32MB have fixed uses (see gpa.h), only the 
+// paged pool is given to the allocator.
+#define FRAME_HIGH_START  SMALLSYSTEM_SIZE
+
+
+/*
+ * frame_d:
+ *     Compact descriptor of a physical frame.
+ */
+
+struct frame_d
+{
+	//Free list. (Indexes in frameTable[])
+	//In an allocated block, prev is the head, and next of the head
+	//is the number of frames of the block still referenced.
+	unsigned short next;
+	unsigned short prev;
+
+	unsigned char order;       //Order of the block. (head only)
+	unsigned char flags;
+
+	unsigned short count;      //Frames allocated. (head only)
+	unsigned short ref_count;  //Each frame. (frameGet/framePut)
+};
+
+struct frame_d *frameTable;
+unsigned long frameTableCount;
+
+
+/*
+ * frame_zone_d:
+ *     A range of contiguous frames with its own free lists.
+ */
+
+struct frame_zone_d
+{
+	int used;
+	int magic;
+
+	char *name;
+
+	unsigned long base;        //First frame.
+	unsigned long count;       //Frames in the zone.
+
+	//Kernel virtual address of the first frame. 0 = not mapped.
+	unsigned long va;
+
+	unsigned short free_list[FRAME_ORDER_COUNT];
+
+	unsigned long free_count;  //Free frames.
+	unsigned long alloc_count;
+	unsigned long fail_count;
+};
 
-unsigned long pageAllocList[PAGE_COUNT_MAX];
+// Zones.
+#define FRAME_ZONE_POOL   0   //Paged pool, mapped in the kernel.
+#define FRAME_ZONE_HIGH   1   //Above 32MB, physical only.
+#define FRAME_ZONE_COUNT  2
+
+struct frame_zone_d frameZones[FRAME_ZONE_COUNT];
+
+
+// Kernel window for the high frames. (PAGETABLE_KMAP at KMAP_VA)
+// mapPhysicalFrames() gives a range of it, allocHighPages() gives
+// frames already mapped.
+#define KMAP_PAGES  1024
+
+unsigned long kmap_pages_used;
+unsigned long kmap_fail_count;
 
 
 /*
@@ -1186,6 +1272,9 @@ void SetCR3 (unsigned long address);
 unsigned long mapping_nic1_device_address( unsigned long address );
 unsigned long mapping_ahci1_device_address ( unsigned long address );
 
+// Os registradores do local APIC. S uma pgina.
+unsigned long mapping_lapic_device_address ( unsigned long address );
+
 
 //
 // Directory.
@@ -1208,25 +1297,28 @@ void *CreatePageTable ( unsigned long directory_address_va,
                         unsigned long region_address );
 
 
-int pEmpty (struct page_d *p);
-void freePage (struct page_d *p);
-void notfreePage (struct page_d *p);	
-
-int firstSlotForAList (int size);
-
 //?? Talvez tenha que mudar de nome.
 //checar se estamos lidando com pginas ou com frames.
 void initializeFramesAlloc (void);
 
-
-//construtur
-//cria uma estrutura vlida de pgina
-//cujo ponteiro ficar em uma lista.
-
-void *page (void);  	
+// Frame allocator. (buddy)
+long frameAllocate ( int zone, int count );
+void frameFree ( unsigned long frame );
+void frameGet ( unsigned long frame );
+void framePut ( unsigned long frame );
+unsigned long allocPhysicalFrames ( int count );
+void freePhysicalFrames ( unsigned long pa );
+void *mapPhysicalFrames ( unsigned long pa, int count );
+unsigned long unmapPhysicalFrames ( void *va );
+void *allocHighPages ( int count );
+void freeHighPages ( void *va );
+void frameShowInfo (void);
 
 void *allocPages (int size);
 
+//libera as pginas alocadas por allocPages ou newPage.
+void freePage (void *va);
+
  //aloca uma pgina e retorna seu endereo virtual inicial
 void *newPage (void);            
 
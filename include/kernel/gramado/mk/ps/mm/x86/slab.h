@@ -0,0 +1,130 @@
+/*
+ * File: mm/x86/slab.h
+ *
+ *     Slab allocator for the kernel heap.
+ *     Small allocations and the most used kernel structures
+ * (thread_d, process_d, window_d) are served from caches of
+ * fixed size objects. Freed objects go back to their cache and are
+ * reused, instead of being lost in the bump pointer heap.
+ *
+ *     The slab pages are 4KB pages carved from the kernel heap. Each
+ * page of the kernel heap has a compact descriptor in slabPageTable[],
+ * so free() finds the cache of an object in constant time.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+// Size classes used by malloc.
+// Bigger allocations go to the heap. (heapAllocateMemory)
+#define SLAB_SIZE_MIN  16
+#define SLAB_SIZE_MAX  2048
+#define SLAB_SIZE_CLASS_COUNT  8    //16,32,64,128,256,512,1024,2048
+
+#define SLAB_PAGE_SIZE  4096
+
+// How many pages we take from the heap each time a cache grows.
+#define SLAB_GROW_PAGES  16
+
+// How many pages there are in the kernel heap.
+#define SLAB_PAGE_COUNT_MAX  ( (KERNEL_HEAP_SIZE / SLAB_PAGE_SIZE) + 1 )
+
+#define SLAB_CACHE_COUNT_MAX  16
+
+
+/*
+ * slab_page_d:
+ *     Descriptor of a page of the kernel heap.
+ *     If 'cache' is NULL the page is not a slab page.
+ */
+
+struct slab_page_d
+{
+	struct slab_cache_d *cache;
+
+	unsigned long va;       //Page address.
+
+	void *freelist;         //Free objects in this page.
+	int inuse;              //Objects in use.
+
+	//Partial list of the cache or the list of free pages.
+	struct slab_page_d *prev;
+	struct slab_page_d *next;
+};
+
+struct slab_page_d slabPageTable[SLAB_PAGE_COUNT_MAX];
+
+
+/*
+ * slab_cache_d:
+ *     A cache of objects with the same size.
+ */
+
+struct slab_cache_d
+{
+	int used;
+	int magic;
+
+	char *name;
+
+	unsigned long objsize;      //Object size, aligned.
+	int objs_per_page;
+
+	//Pages with free objects.
+	struct slab_page_d *partial;
+
+	//
+	// Counters.
+	//
+
+	unsigned long pages;        //Pages owned by the cache.
+	unsigned long inuse;        //Objects in use.
+	unsigned long alloc_count;
+	unsigned long free_count;
+	unsigned long grow_count;   //Allocations that needed a new page. (miss)
+};
+
+unsigned long slabCacheList[SLAB_CACHE_COUNT_MAX];
+
+
+// Generic size caches, used by malloc.
+struct slab_cache_d *slabSizeCache[SLAB_SIZE_CLASS_COUNT];
+
+// Caches by object type.
+struct slab_cache_d *thread_cache;
+struct slab_cache_d *process_cache;
+struct slab_cache_d *window_cache;
+
+
+// Free pages, ready for any cache.
+struct slab_page_d *slabFreePages;
+unsigned long slabFreePagesCount;
+
+// Flag. The allocator is ready.
+int slab_initialized;
+
+
+//
+// Prototypes.
+//
+
+int slabInit (void);
+
+struct slab_cache_d *slabCreateCache ( char *name, unsigned long size );
+
+void *slabAllocate ( struct slab_cache_d *cache );
+
+void *slabAllocateSize ( unsigned long size );
+
+int slabOwns ( void *ptr );
+
+void slabFree ( void *ptr );
+
+void slabShowInfo (void);
+
+
+//
+// End.
+//
+
@@ -513,6 +513,10 @@ struct process_d
 	//see: pc/image.h
 	struct image_info_d *image_info;
 	
+	// Imagem ELF com paginao sob demanda. (execve/elf.c)
+	// NULL = imagem carregada inteira. (boot)
+	struct elf_image_d *elf_image;
+	
 	//#test
 	//struct page_control_t *page_list_head;
 
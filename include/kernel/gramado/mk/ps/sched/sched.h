@@ -48,6 +48,33 @@ int schedulerType;
 unsigned long schedulerQueue[4]; 
 
 
+//
+// ## Ready queues ##
+//
+
+// One queue per priority level, from 0 to PRIORITY_REALTIME.
+// Threads are linked through the rq_next/rq_prev fields of their own
+// structure, so insertion and removal never allocate memory.
+// Bit N of 'bitmap' says that queue N is not empty.
+// Maintained by do_thread_ready(), do_thread_sleeping() ... in schedi.c.
+// Only the BSP runs threads, so there is one set of queues. (smp.h)
+// The walkers take readyq_lock().
+
+#define READYQ_COUNT  (PRIORITY_REALTIME + 1)
+
+struct readyq_d
+{
+	struct thread_d *head[READYQ_COUNT];
+	struct thread_d *tail[READYQ_COUNT];
+
+	unsigned long bitmap;
+
+	// How many threads are queued.
+	int count;
+};
+
+struct readyq_d readyq;
+
 
 //
 // Prottipos:
@@ -148,6 +175,16 @@ void check_for_standby (void);
 int check_quantum (void);
 
 
+// Ready queues. (schedi.c)
+void readyq_init (void);
+unsigned long readyq_lock (void);
+void readyq_unlock ( unsigned long flags );
+void readyq_insert (struct thread_d *t);
+void readyq_remove (struct thread_d *t);
+void readyq_requeue (struct thread_d *t);
+struct thread_d *readyq_highest (void);
+
+
 //
 // End.
 //
@@ -0,0 +1,117 @@
+/*
+ * File: sched/smp.h
+ *
+ *     Multiprocessor support.
+ *
+ *     The processors are found in the MP configuration table of the
+ * BIOS. The BSP starts the others (APs) with INIT + SIPI, through the
+ * local APIC. The AP runs the real mode trampoline that is copied to
+ * SMP_TRAMPOLINE_PA, goes to protected mode with the kernel's cr3 and
+ * calls smpApMain(). (hwlib.asm)
+ *
+ *     This is bring-up only. The context save of the irq0 uses one 
+ * global context and the kernel has one current_thread, so the APs stay
+ * halted in their idle loop and only the BSP runs threads, from the
+ * single set of ready queues. (readyq in sched.h) The shared data is
+ * still protected by spinlocks, so the APs can join the scheduler
+ * later.
+ *
+ *     Not done: per-cpu run queues and work stealing. They need first a
+ * context save per cpu in the irq0, (hw.asm) a current_thread per cpu,
+ * a TSS and an irq0 stack per cpu, and a local APIC timer in the APs.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+//
+// ## Spinlocks ##
+//
+
+typedef struct spinlock_d
+{
+	volatile unsigned long locked;
+
+} spinlock_t;
+
+
+void spinLockInit ( spinlock_t *lock );
+void spinLock ( spinlock_t *lock );
+void spinUnlock ( spinlock_t *lock );
+int spinTryLock ( spinlock_t *lock );
+
+// cli + lock. Restaura o eflags no unlock.
+unsigned long spinLockIrqSave ( spinlock_t *lock );
+void spinUnlockIrqRestore ( spinlock_t *lock, unsigned long flags );
+
+
+//
+// ## CPUs ##
+//
+
+#define SMP_CPU_MAX  8
+
+// Trampoline page. SIPI vector = (SMP_TRAMPOLINE_PA >> 12)
+// It must be the same address used in hwlib.asm.
+#define SMP_TRAMPOLINE_PA  0x00081000
+
+#define SMP_AP_STACK_PAGES  2
+
+// cpu_d.state
+#define CPU_STATE_NONE      0
+#define CPU_STATE_STARTING  1
+#define CPU_STATE_ONLINE    2
+#define CPU_STATE_FAILED    3
+
+
+struct cpu_d
+{
+	int used;
+	int magic;
+
+	// Index in cpuList[].
+	int id;
+
+	unsigned long apic_id;
+
+	int bsp;
+	volatile int state;
+
+	// Idle loop of the AP.
+	volatile unsigned long idle_halts;
+
+	// Top of the stack of the AP.
+	unsigned long stack;
+};
+
+struct cpu_d cpuList[SMP_CPU_MAX];
+
+// Found in the MP table, and started.
+int smp_cpu_count;
+int smp_cpu_online;
+
+// Physical address of the MP floating pointer. 0 = not found.
+unsigned long smp_mp_table;
+
+
+//
+// Prototypes.
+//
+
+// Starts the APs. Called by init_hal after lapicInit.
+int smpInit (void);
+
+// Called by the trampoline, in the AP. (hwlib.asm)
+void smpApMain (void);
+
+// Index in cpuList[] of the cpu that is running this code.
+int smpCurrentCPU (void);
+
+void smpShowInfo (void);
+
+
+//
+// End.
+//
+
@@ -75,7 +75,9 @@ typedef enum {
 	WAIT_REASON_WAIT4TID,      
 	WAIT_REASON_WAIT4PID,
 	WAIT_REASON_EXIT,
-	WAIT_REASON_BLOCKED
+	WAIT_REASON_BLOCKED,
+	WAIT_REASON_SEMAPHORE,      //Na fila de um semforo. (ipc/sem.c)
+	WAIT_REASON_SLEEP           //Dormindo at um deadline. (timer.c)
 	
 	//continua... @todo
 }thread_wait_reason_t;
@@ -106,6 +108,28 @@ typedef enum {
 }thread_event_type_t;
  
  
+/*
+ * thread_msg_d:
+ *     Uma mensagem na fila de mensagens da thread.
+ *     O mesmo formato que o servio 111 entrega ao aplicativo.
+ */
+
+// Power of 2.
+#define THREAD_MSG_QUEUE_SIZE  32
+
+struct thread_msg_d
+{
+	struct window_d *window;
+	int msg;
+	unsigned long long1;
+	unsigned long long2;
+	unsigned long long3;
+	unsigned long long4;
+	unsigned long long5;
+	unsigned long long6;
+};
+
+
 /*
  * thread_type_t:
  *     Enumerando os tipos de threads:
@@ -530,7 +554,27 @@ struct thread_d
 	unsigned long long12;
 	//...
 	
-	int newmessageFlag;         //flag avisando que tem nova mensagem.
+	// Os campos acima guardam a ltima mensagem entregue  thread.
+	// As mensagens novas ficam na fila. (ipc/msgq.c)
+	
+	// Fila de mensagens. (ring buffer)
+	// Quem envia escreve em msg_tail, a thread consome em msg_head.
+	struct thread_msg_d msg_queue[THREAD_MSG_QUEUE_SIZE];
+	unsigned long msg_head;
+	unsigned long msg_tail;
+	unsigned long msg_dropped;    //Mensagens perdidas com a fila cheia.
+	int msg_waiting;              //A thread dorme esperando mensagem.
+	
+	// Semforo. (ipc/sem.c)
+	// A fila de espera do semforo usa sem_next.
+	// sem_granted = Up entregou o recurso para essa thread.
+	struct semaphore_d *sem_wait;
+	struct thread_d *sem_next;
+	int sem_granted;
+	
+	// Sleep. (kdrivers/timer.c)
+	// O timer da thread fica na roda at o deadline.
+	struct timer_d sleep_timer;
 	
 	
 	
@@ -589,6 +633,17 @@ struct thread_d
 	//Next: 
     //Um ponteiro para a prxima thread da lista linkada. 
 	struct thread_d *Next;
+
+	//
+	// ## Ready queue ##
+	//
+
+	// Links for the ready queue of the priority level 'rq_priority'.
+	// Only touched by the readyq_xxx routines in schedi.c.
+	struct thread_d *rq_next;
+	struct thread_d *rq_prev;
+	int rq_priority;
+	int rq_queued;    //flag, is in a ready queue.
 };
 
 /* Threads usadas na inicializao do kernel */
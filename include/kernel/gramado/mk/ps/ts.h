@@ -11,6 +11,9 @@ void taskswitch_lock (void);
 
 void taskswitch_unlock (void);
 
+// Troca de thread no retorno da syscall atual.
+void taskswitch_yield (void);
+
 
 //
 //
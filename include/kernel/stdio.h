@@ -829,6 +829,7 @@ int update_standard_stream ( int PID, FILE *stream1, FILE *stream2, FILE *stream
 
 // Escreve no arquivo uma certa quantidade de caracteres de uma dada string 
 int stdio_file_write ( FILE *stream, char *string, int len );
+int stdio_file_read ( FILE *stream, char *buffer, int len );
 
 int fputs ( const char *str, FILE *stream );
 int ungetc ( int c, FILE *stream );
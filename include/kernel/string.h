@@ -10,6 +10,8 @@ void *memset ( void *ptr, int value, int size );
 //@todo: void *memcpy(void *dst, const void *src, size_t c);  
 void *memcpy(void *v_dst, const void *v_src, unsigned long c);
 void *memcpy32(void *v_dst, const void *v_src, unsigned long c);
+void *memmove(void *dest, const void *src, size_t count);
+int memcmp(const void *s1, const void *s2, size_t n);
 
 //@todo: Deve ser const char.
 int strcmp(char *s1, char *s2);
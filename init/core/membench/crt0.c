@@ -0,0 +1,35 @@
+
+// crt0.c
+
+
+#include "membench.h"
+
+
+static char *argv[] = { "-membench", NULL };
+
+
+extern int main ( int argc, char *argv[] ); 
+
+//
+// # Entry point #
+//
+
+void crt0 (){
+	
+    int ExitCode;	
+	
+    //Inicializando o suporte a alocação dinâmica de memória.
+	//Inicializando o suporte ao fluxo padrão.
+
+	libcInitRT ();
+    stdioInitialize ();	
+		
+	ExitCode = (int) main ( 1, argv ); 
+	
+	exit ( ExitCode );
+	
+	while (1){
+		asm ("pause");
+	};
+}
+
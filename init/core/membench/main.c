@@ -0,0 +1,232 @@
+/*
+ * File: main.c
+ *
+ *     MEMBENCH.BIN
+ *     Micro-benchmark das rotinas de memória da libc.
+ *     Mostra MB/s de cada rotina para cada tamanho de bloco.
+ *
+ *     A cópia byte a byte é a referência, é o que a libc fazia antes.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include "membench.h"
+
+
+#define BENCH_MEMCPY   0
+#define BENCH_MEMMOVE  1
+#define BENCH_MEMSET   2
+#define BENCH_MEMCMP   3
+#define BENCH_STRLEN   4
+#define BENCH_STRCMP   5
+#define BENCH_BYTES    6
+#define BENCH_COUNT    7
+
+
+static char *bench_names[BENCH_COUNT] = {
+	"memcpy", "memmove", "memset", "memcmp", "strlen", "strcmp", "bytes"
+};
+
+static unsigned long bench_sizes[] = {
+	16, 64, 256, 1024, 4096, 16384, 65536, BENCH_MAX_SIZE, 0
+};
+
+
+static unsigned char *buffer_a;
+static unsigned char *buffer_b;
+
+// Evita que as chamadas pareçam inúteis.
+volatile unsigned long bench_sink;
+
+
+static unsigned long bench_ticks (void){
+
+	return (unsigned long) apiGetSysTimeInfo (3);
+}
+
+
+static void
+bench_byte_copy ( unsigned char *dst,
+                  const unsigned char *src,
+                  unsigned long n )
+{
+	while (n--){ *dst++ = *src++; };
+}
+
+
+// As strings ocupam o bloco inteiro.
+
+static void bench_prepare_strings ( unsigned long size ){
+
+	memset ( buffer_a, 'a', size );
+	memset ( buffer_b, 'a', size );
+
+	buffer_a[size -1] = 0;
+	buffer_b[size -1] = 0;
+}
+
+
+static void bench_run ( int op, unsigned long size, unsigned long reps ){
+
+	unsigned long i;
+
+	for ( i=0; i < reps; i++ )
+	{
+		switch (op)
+		{
+			case BENCH_MEMCPY:
+			    memcpy ( buffer_b, buffer_a, size );
+				break;
+
+			// Sobreposição, copia do fim para o começo.
+			case BENCH_MEMMOVE:
+			    memmove ( buffer_a + 8, buffer_a, size );
+				break;
+
+			case BENCH_MEMSET:
+			    memset ( buffer_b, (int) i, (int) size );
+				break;
+
+			case BENCH_MEMCMP:
+			    bench_sink += (unsigned long) memcmp ( buffer_a, buffer_b, size );
+				break;
+
+			case BENCH_STRLEN:
+			    bench_sink += (unsigned long) strlen ( (const char *) buffer_a );
+				break;
+
+			case BENCH_STRCMP:
+			    bench_sink += (unsigned long) strcmp ( (char *) buffer_a, (char *) buffer_b );
+				break;
+
+			case BENCH_BYTES:
+			    bench_byte_copy ( buffer_b, buffer_a, size );
+				break;
+		};
+	};
+}
+
+
+/*
+ * bench_measure:
+ *     Roda a rotina até passar BENCH_MIN_TICKS e retorna MB/s.
+ */
+
+static unsigned long bench_measure ( int op, unsigned long size, unsigned long hz ){
+
+	unsigned long reps;
+	unsigned long kb = 0;
+	unsigned long start;
+	unsigned long elapsed;
+
+	reps = ( BENCH_BATCH_BYTES / size );
+
+	if ( reps == 0 ){
+		reps = 1;
+	}
+
+	memset ( buffer_a, 0x5A, BENCH_MAX_SIZE + 64 );
+	memset ( buffer_b, 0x5A, BENCH_MAX_SIZE + 64 );
+
+	if ( op == BENCH_STRLEN || op == BENCH_STRCMP ){
+		bench_prepare_strings (size);
+	}
+
+	// Começa na virada de um tick.
+	start = bench_ticks ();
+	while ( bench_ticks () == start ){};
+	start = bench_ticks ();
+
+	do {
+		bench_run ( op, size, reps );
+
+		kb += ( (size * reps) / 1024 );
+
+		elapsed = bench_ticks () - start;
+
+	} while ( elapsed < BENCH_MIN_TICKS );
+
+	return (unsigned long) ( ( (kb / elapsed) * hz ) / 1024 );
+}
+
+
+static int bench_has_erms (void){
+
+	unsigned long a, b, c, d;
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0), "c" (0) );
+
+	if ( a < 7 ){
+		return 0;
+	}
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (7), "c" (0) );
+
+	return (int) ( (b >> 9) & 1 );
+}
+
+
+int main ( int argc, char *argv[] ){
+
+	unsigned long hz;
+	unsigned long size;
+	int op;
+	int i;
+
+
+	printf ("membench: libc memory routines, MB/s\n");
+
+	hz = (unsigned long) apiGetSysTimeInfo (1);
+
+	if ( hz == 0 )
+	{
+		printf ("membench: hz fail\n");
+		return (int) 1;
+	}
+
+	if ( bench_has_erms () == 1 ){
+		printf ("cpu: ERMS, rep movsb/stosb\n");
+	}else{
+		printf ("cpu: rep movsd/stosd\n");
+	};
+
+	buffer_a = (unsigned char *) malloc ( BENCH_MAX_SIZE + 64 );
+	buffer_b = (unsigned char *) malloc ( BENCH_MAX_SIZE + 64 );
+
+	if ( (void *) buffer_a == NULL || (void *) buffer_b == NULL )
+	{
+		printf ("membench: malloc fail\n");
+		return (int) 1;
+	}
+
+	printf ("size ");
+	for ( op=0; op < BENCH_COUNT; op++ ){
+		printf ("%s ", bench_names[op]);
+	};
+	printf ("\n");
+
+	for ( i=0; bench_sizes[i] != 0; i++ )
+	{
+		size = bench_sizes[i];
+
+		printf ("%d ", size);
+
+		for ( op=0; op < BENCH_COUNT; op++ ){
+			printf ("%d ", bench_measure ( op, size, hz ) );
+		};
+
+		printf ("\n");
+	};
+
+	free (buffer_a);
+	free (buffer_b);
+
+	printf ("membench: done\n");
+
+	return (int) 0;
+}
+
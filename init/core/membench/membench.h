@@ -0,0 +1,26 @@
+
+// membench.h 
+
+
+//api 
+#include "api.h"
+
+//libc 
+#include <types.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stubs/gramado.h>
+
+
+// Maior tamanho testado.
+#define BENCH_MAX_SIZE  (256*1024)
+
+// Bytes por rodada, para cada tamanho.
+#define BENCH_BATCH_BYTES  (4*1024*1024)
+
+// Tempo mínimo de cada medida. (ticks)
+#define BENCH_MIN_TICKS  25
+
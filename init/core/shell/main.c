@@ -97,6 +97,10 @@ struct window_d *hWindow;
 
 
 
+// Mensagens pegas de uma vez no loop principal.
+#define SHELL_MESSAGE_MAX  8
+
+
 // Input flags.
 #define SHELLFLAG_NULL 0
 #define SHELLFLAG_COMMANDLINE 1
@@ -1656,7 +1660,10 @@ noArgs:
 	// Na verdade essa rotina est pegando a mensagem na janela 
 	// com o foco de entrada. Esse argumento foi passado mas no foi usado.
 		
-	unsigned long message_buffer[5];	
+	unsigned long message_buffer[ MESSAGE_WORDS * SHELL_MESSAGE_MAX ];	
+	unsigned long *m;
+	int msg_Count;
+	int msg_i;
 		
 	
 read_and_execute:
@@ -1673,40 +1680,42 @@ read_and_execute:
 	// Esse aqui  outro loop.
 	// #todo: No futuro s teremos o loop no estilo bash, que  a funo acima.
 	
-	/* Nesse teste vamos enviar um ponteiro de array, pegarmos os quatro 
-	   elementos da mensagem e depois zerar o buffer */
+	/* Pegamos um lote de mensagens da fila da thread e chamamos o
+	   procedimento para cada uma delas. */
 	
 Mainloop:
 	
 	while (_running)
 	{
 		// #obs: 
-		// O retorno ser 1 se tiver mensagem e 0 se no tiver.
+		// Pegamos vrias mensagens da fila da thread de uma vez.
+		// O retorno  quantas mensagens foram pegas.
 		
 		enterCriticalSection(); 
-		system_call ( 111,
-		    (unsigned long) &message_buffer[0],
-			(unsigned long) &message_buffer[0],
-			(unsigned long) &message_buffer[0] );
+		msg_Count = gde_get_messages ( &message_buffer[0], SHELL_MESSAGE_MAX );
 		exitCriticalSection(); 
-			
-		if ( message_buffer[1] != 0 )
-        {
-            //printf(".");			
-		}	
 		
-		if ( message_buffer[1] != 0 )
+		// Fila vazia.
+		// Dormimos at chegar uma mensagem, ao invs de ficar perguntando.
+		
+		if ( msg_Count <= 0 )
+		{
+			gde_wait_message ();
+			continue;
+		}
+		
+		for ( msg_i=0; msg_i < msg_Count; msg_i++ )
 		{
-	        shellProcedure ( (struct window_d *) message_buffer[0], 
-		        (int) message_buffer[1], 
-		        (unsigned long) message_buffer[2], 
-		        (unsigned long) message_buffer[3] );
+			m = &message_buffer[ msg_i * MESSAGE_WORDS ];
 			
-			message_buffer[0] = 0;
-            message_buffer[1] = 0;
-            message_buffer[3] = 0;
-            message_buffer[4] = 0;	
-        };				
+			if ( m[1] != 0 )
+			{
+	            shellProcedure ( (struct window_d *) m[0], 
+		            (int) m[1], 
+		            (unsigned long) m[2], 
+		            (unsigned long) m[3] );
+			}
+		};
 	};
 	
 	//
@@ -3569,6 +3578,20 @@ do_compare:
         goto exit_cmp;
     };	
 	
+    // smp - cpus e filas de cada uma.
+	if ( strncmp( prompt, "smp", 3 ) == 0 )
+	{
+	    shellShowSMPInfo ();
+        goto exit_cmp;
+    };	
+	
+    // glyph-bench - glyphs/s do texto no kernel.
+	if ( strncmp( prompt, "glyph-bench", 11 ) == 0 )
+	{
+	    system_call ( SYSTEMCALL_GLYPHBENCH, 0, 0, 0 );
+        goto exit_cmp;
+    };	
+	
 	
     // puts - testing puts, from libc.
 	if ( strncmp( prompt, "puts", 4 ) == 0 )
@@ -6525,6 +6548,13 @@ void shellShowPCIInfo (){
 }
 
 
+//mostrar as cpus. (SMP)
+void shellShowSMPInfo (){
+	
+    system_call ( SYSTEMCALL_SMPINFO, 0, 0, 0 );
+}
+
+
 //mostrar informaes gerais sobre a memria.
 void shellShowKernelInfo (){
 	
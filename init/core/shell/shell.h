@@ -1140,6 +1140,7 @@ void shellShowVolumeInfo();
 
 void shellShowMemoryInfo();
 void shellShowPCIInfo();
+void shellShowSMPInfo();
 void shellShowKernelInfo();
 
 
@@ -27,6 +27,8 @@
 extern _KiTimer        
 ;extern _timer 
 extern _KiTaskSwitch   
+extern _taskswitch_yield_request
+extern _timer_eoi_sent
 ;extern _task_switch
 
 ;;;;
@@ -83,6 +85,16 @@ extern _current_process_pagedirectory_address
 ;; precisamos da pilha antes de chamarmos as rotinas em C.
 ;; #test: Vamos fazer um teste usando a pilha na sua posio inicial.
 
+;; _irq0_yield:
+;;     O retorno da int 0x80 (sw.asm) quando a thread bloqueou dentro da 
+;; syscall. A pilha tem o mesmo frame do irq0 (eip, cs, eflags, esp, ss) 
+;; e eax  o retorno da syscall. Salva o contexto e troca de thread, sem
+;; KiTimer e sem EOI.
+
+_irq0_yield:
+
+    mov dword [irq0_no_tick], 1
+
 global _irq0
 _irq0:
 
@@ -172,11 +184,15 @@ _irq0:
 	;Chamada ao mdulo interno.
 	;Para essa chamada as rotinas do timer esto dentro do kernel base.
 	;Rotinas de timer. #NO envolvendo task switch.
+	cmp dword [irq0_no_tick], 0
+	jne .irq0Switch
+
 	call _KiTimer             	
     
 ;;.TaskSwitchStuff:	
     ;Task switch. Troca a tarefa a ser executada.
 	;ts.c
+.irq0Switch:
 	call _KiTaskSwitch 	    
 
 
@@ -287,8 +303,17 @@ dummy_flush:
 	;
     ;EOI - sinal.
 	;Sinalizamos apenas o primeiro controlador.
+	;No teve interrupo se viemos da syscall.
+	;O trabalho adiado do tick j mandou o EOI. (timer.c)
+	cmp dword [irq0_no_tick], 0
+	jne .irq0NoEoi
+	cmp dword [_timer_eoi_sent], 0
+	jne .irq0NoEoi
     mov al, 20h
     out 20h, al  
+.irq0NoEoi:
+	mov dword [irq0_no_tick], 0
+	mov dword [_timer_eoi_sent], 0
  	
 	mov eax, dword [_contextEAX]    ;eax. (Acumulador).	
 	
@@ -301,6 +326,8 @@ dummy_flush:
     ;; "So that's why my page has to be always in the TLB."
     ;; 	
     iretd	
+
+irq0_no_tick: dd 0
 	
 	
 	
@@ -760,6 +787,39 @@ _irq15:
 	IRETD
 
 
+;;============================================================
+; Timer do local APIC.
+; Vetor 0xF0. (LAPIC_TIMER_VECTOR)
+; O EOI  feito no local APIC, pelo handler. (kdrivers/apic.c)
+;
+
+extern _lapicTimerHandler
+global _irq_lapic_timer
+_irq_lapic_timer:
+
+	cli
+	pushad
+	
+	push ds
+	push es
+	push fs
+	push gs
+	push ss
+	
+	call _lapicTimerHandler
+	
+	pop ss
+	pop gs
+	pop fs
+	pop es
+	pop ds
+	
+	popad
+	sti
+	
+	iretd
+
+
 ;========================================
 ; unhandled_irq:
 ;     Interrupo de hardware genrica. 
@@ -794,6 +854,7 @@ unhandled_irq:
 
 
 extern _faults
+extern _cowPageFault
 
 ;
 ; Obs: Enquanto tratamos uma excesso ou flaul, no desejamos
@@ -902,8 +963,42 @@ _fault_GP:
 
 ;
 ; int 14 - Page Fault (PF).
+;     Primeiro tentamos resolver a falta como copy-on-write. (cow.c)
+;     Se deu certo a thread continua, seno vai para all_faults.
+;     O cpu coloca um error code na pilha.
 global _fault_N14
 _fault_N14:
+	pushad
+	push ds
+	push es
+	push fs
+	push gs
+
+	mov ax, word 0x10
+	mov ds, ax
+	mov es, ax
+	mov fs, ax
+	mov gs, ax
+
+	;; error code. (4 segmentos + pushad)
+	push dword [esp+48]
+	call _cowPageFault
+	add esp, 4
+
+	pop gs
+	pop fs
+	pop es
+	pop ds
+
+	cmp eax, 1
+	popad
+	jne .fault
+
+	;; Tira o error code.
+	add esp, 4
+	iretd
+
+.fault:
 	mov dword [save_fault_number], dword 14
     jmp all_faults	
 	
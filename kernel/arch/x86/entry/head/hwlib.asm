@@ -103,6 +103,122 @@ _turn_task_switch_off:
 	mov dword [_task_switch_status], dword 0    ;LOCKED.	
 	ret
 
+
+;----------------------------------------------
+; _setup_lapic_vectors:
+;     Cria o vetor do timer do local APIC. (0xF0)
+;     O vetor spurious (0xFF) fica no unhandled_int, 
+;     ele no tem EOI.
+;     Chamada por lapicInit em kdrivers/apic.c
+;
+global _setup_lapic_vectors
+_setup_lapic_vectors:
+	push eax
+	push ebx
+	
+	mov eax, dword _irq_lapic_timer
+	mov ebx, dword 0xF0
+	call _setup_idt_vector
+	
+	pop ebx
+	pop eax
+	ret
+
+
+;----------------------------------------------
+; _smp_trampoline_start:
+;     Cdigo de partida dos APs. (SMP)
+;     smpInit copia de _smp_trampoline_start at _smp_trampoline_end
+; para SMP_TRAMPOLINE_PA e preenche _smp_trampoline_data.
+;     O SIPI comea em real mode, CS = (SMP_TRAMPOLINE_PA >> 4), IP = 0.
+;     Vai para protected mode com uma GDT prpria, liga a paginao
+; com o cr3 do kernel e pula para _smp_ap_entry, j na GDT e IDT
+; do kernel.
+;     Chamado por kernel/mk/ps/sched/smp.c
+;
+SMP_TRAMPOLINE_PA equ 0x00081000    ;o mesmo de smp.h
+
+[bits 16]
+global _smp_trampoline_start
+_smp_trampoline_start:
+	cli
+	cld
+
+	mov ax, cs
+	mov ds, ax
+
+	o32 lgdt [smp_trampoline_gdtr - _smp_trampoline_start]
+
+	mov eax, cr0
+	or eax, 1
+	mov cr0, eax
+
+	jmp dword 0x08:(SMP_TRAMPOLINE_PA + (smp_trampoline_pm - _smp_trampoline_start))
+
+[bits 32]
+smp_trampoline_pm:
+	mov ax, 0x10
+	mov ds, ax
+	mov es, ax
+	mov ss, ax
+
+	mov esi, dword (SMP_TRAMPOLINE_PA + (_smp_trampoline_data - _smp_trampoline_start))
+
+	mov eax, dword [esi+8]    ;cr4
+	mov cr4, eax
+	mov eax, dword [esi+4]    ;cr3
+	mov cr3, eax
+	mov eax, dword [esi+0]    ;cr0 (paginao)
+	mov cr0, eax
+
+	mov esp, dword [esi+12]
+
+	lgdt [_GDT_register]
+	lidt [_IDT_register]
+
+	jmp 0x08:_smp_ap_entry
+
+
+align 8
+smp_trampoline_gdt:
+	dd 0, 0
+	;0x08 code, flat.
+	dw 0xFFFF, 0
+	db 0, 0x9A, 0xCF, 0
+	;0x10 data, flat.
+	dw 0xFFFF, 0
+	db 0, 0x92, 0xCF, 0
+smp_trampoline_gdtr:
+	dw (smp_trampoline_gdtr - smp_trampoline_gdt - 1)
+	dd (SMP_TRAMPOLINE_PA + (smp_trampoline_gdt - _smp_trampoline_start))
+
+; cr0, cr3, cr4, esp. (struct smp_trampoline_data_d)
+global _smp_trampoline_data
+_smp_trampoline_data:
+	dd 0, 0, 0, 0
+global _smp_trampoline_end
+_smp_trampoline_end:
+
+
+;----------------------------------------------
+; _smp_ap_entry:
+;     O AP j est com o endereo virtual do kernel.
+;
+extern _smpApMain
+_smp_ap_entry:
+	mov ax, 0x10
+	mov ds, ax
+	mov es, ax
+	mov fs, ax
+	mov gs, ax
+	mov ss, ax
+
+	call _smpApMain
+.hang:
+	cli
+	hlt
+	jmp .hang
+
 	
 ;===================================	
 ; _os_read_sector:
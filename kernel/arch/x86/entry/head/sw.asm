@@ -300,10 +300,18 @@ _int128:
 	;; #importante
 	;; No pode ter eoi.
 
+	;; A thread bloqueou, (semforo) troca agora. (hw.asm)
+	cmp dword [_taskswitch_yield_request], 0
+	jne .int128Yield
+
 	;popad	
 	mov eax, dword [.int128Ret] 
 	sti
 	iretd
+.int128Yield:
+	mov dword [_taskswitch_yield_request], 0
+	mov eax, dword [.int128Ret] 
+	jmp _irq0_yield
 .int128Ret: dd 0
 ;--  
   
@@ -803,6 +803,9 @@ void scroll_screen_rect (void){
 		    p += (Width * bytes_count);
 	    };	
 	}
+
+	// A tela toda mudou.
+	damageAddAll ();
 }
 
 
@@ -1392,6 +1395,41 @@ int stdio_file_write ( FILE *stream, char *string, int len ){
 }
 
 
+/*
+ * stdio_file_read:
+ *     L at len bytes do arquivo para o buffer.
+ *     O arquivo j est todo na memria (fopen), ento  s uma cpia.
+ *     Retorna quantos bytes foram lidos, 0 no fim do arquivo.
+ */
+
+int stdio_file_read ( FILE *stream, char *buffer, int len ){
+	
+	if ( (void *) stream == NULL || (void *) buffer == NULL || len <= 0 )
+		return (int) 0;
+	
+	if ( stream->used != 1 || stream->magic != 1234 )
+		return (int) 0;
+	
+	if ( stream->_p == 0 || stream->_cnt <= 0 )
+	{
+		stream->_flags = (stream->_flags | _IOEOF);
+		stream->_cnt = 0;
+		return (int) 0;
+	}
+	
+	if ( len > stream->_cnt ){
+		len = stream->_cnt;
+	}
+	
+	memcpy ( (void *) buffer, (const void *) stream->_p, (unsigned long) len );
+	
+	stream->_p = stream->_p + len;
+	stream->_cnt = stream->_cnt - len;
+	
+	return (int) len;
+}
+
+
 /*
  ********************************
  * fputs:      
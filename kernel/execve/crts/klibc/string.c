@@ -16,21 +16,218 @@
 //#define toupper(c)  ((int)((c) | 0x20))
 
 
+//
+// Rotinas rápidas de memória.
+//
+//     memcpy/memset usam rep movsd/stosd com o destino alinhado.
+// Se o processador tem ERMS, (Enhanced REP MOVSB/STOSB, cpuid 7) 
+// usamos rep movsb/stosb direto, que nesses modelos é o mais rápido.
+// Pedaços pequenos vão byte a byte.
+//     memcmp, strlen e strcmp comparam 4 bytes por vez.
+//     Obs: Não usamos SSE aqui. Os registradores xmm não são 
+// salvos na troca de contexto.
+//     Obs: Nunca usar std aqui. As rotinas de interrupção não 
+// fazem cld.
+//
+
+#define STRING_SMALL  16
+
+// Leitura de 4 bytes sem problema de aliasing.
+typedef unsigned long __attribute__((__may_alias__)) string_word_t;
+
+// Algum byte da palavra é zero.
+#define STRING_HAS_ZERO(w)  ( ( (w) - 0x01010101UL ) & ~(w) & 0x80808080UL )
+
+static int string_cpu_checked;
+static int string_cpu_erms;
+
+
+static void string_check_cpu (void){
+	
+	unsigned long a, b, c, d;
+	unsigned long Max;
+
+	__asm__ __volatile__ ( "cpuid" 
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0), "c" (0) );
+	
+	Max = a;
+	
+	if ( Max >= 7 )
+	{
+		__asm__ __volatile__ ( "cpuid" 
+		    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (7), "c" (0) );
+		
+		// ebx bit 9 = ERMS.
+		if ( b & (1 << 9) ){
+			string_cpu_erms = 1;
+		}
+	}
+	
+	string_cpu_checked = 1;
+}
+
+
+static void 
+string_copy_forward ( unsigned char *dst, 
+                      const unsigned char *src, 
+                      unsigned long n )
+{
+	unsigned long d0, d1, d2;
+
+	if ( n < STRING_SMALL )
+	{
+		while (n--){ *dst++ = *src++; };
+		return;
+	}
+
+	if ( string_cpu_checked == 0 ){
+		string_check_cpu ();
+	}
+
+	if ( string_cpu_erms == 1 )
+	{
+		__asm__ __volatile__ ( "cld\n\t" 
+		                       "rep movsb"
+		    : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+		    : "0" (n), "1" (dst), "2" (src)
+		    : "memory" );
+		return;
+	}
+
+	// Alinha o destino.
+	while ( ( (unsigned long) dst & 3 ) != 0 )
+	{
+		*dst++ = *src++;
+		n--;
+	};
+
+	__asm__ __volatile__ ( "cld\n\t"
+	                       "rep movsl\n\t"
+	                       "movl %3, %%ecx\n\t"
+	                       "rep movsb"
+	    : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+	    : "g" (n & 3), "0" (n >> 2), "1" (dst), "2" (src)
+	    : "memory" );
+}
+
+
+// Para memmove com o destino depois da origem.
+// Palavra por palavra, do fim para o começo.
+
+static void 
+string_copy_backward ( unsigned char *dst, 
+                       const unsigned char *src, 
+                       unsigned long n )
+{
+	string_word_t *dw;
+	const string_word_t *sw;
+
+	dst += n;
+	src += n;
+
+	while ( (n & 3) != 0 )
+	{
+		*--dst = *--src;
+		n--;
+	};
+
+	dw = (string_word_t *) dst;
+	sw = (const string_word_t *) src;
+
+	n = (n >> 2);
+
+	while (n--){ *--dw = *--sw; };
+}
+
+
+static void 
+string_fill ( unsigned char *dst, 
+              int value, 
+              unsigned long n )
+{
+	unsigned long v;
+	unsigned long d0, d1;
+
+	if ( n < STRING_SMALL )
+	{
+		while (n--){ *dst++ = (unsigned char) value; };
+		return;
+	}
+
+	if ( string_cpu_checked == 0 ){
+		string_check_cpu ();
+	}
+
+	if ( string_cpu_erms == 1 )
+	{
+		__asm__ __volatile__ ( "cld\n\t" 
+		                       "rep stosb"
+		    : "=&c" (d0), "=&D" (d1)
+		    : "a" (value), "0" (n), "1" (dst)
+		    : "memory" );
+		return;
+	}
+
+	while ( ( (unsigned long) dst & 3 ) != 0 )
+	{
+		*dst++ = (unsigned char) value;
+		n--;
+	};
+
+	v = (unsigned long) ( value & 0xFF ) * 0x01010101UL;
+
+	__asm__ __volatile__ ( "cld\n\t"
+	                       "rep stosl\n\t"
+	                       "movl %3, %%ecx\n\t"
+	                       "rep stosb"
+	    : "=&c" (d0), "=&D" (d1)
+	    : "a" (v), "g" (n & 3), "0" (n >> 2), "1" (dst)
+	    : "memory" );
+}
+
+
 /* strcmp:
  *     Compara duas strings. */
 
 int strcmp (char * s1, char * s2){
 	
-	int i;
+	const unsigned char *p1 = (const unsigned char *) s1;
+	const unsigned char *p2 = (const unsigned char *) s2;
+	const string_word_t *w1;
+	const string_word_t *w2;
 
-	for ( i=0; s1[i] == s2[i]; i++ )
+	while ( ( (unsigned long) p1 & 3 ) != 0 )
 	{
-		if( s1[i] == '\0' ){
-			return (0);
+		if ( *p1 != *p2 || *p1 == '\0' ){
+			return (int) ( *p1 - *p2 );
 		}
+		p1++;
+		p2++;
 	};
-	
-	return ((int) (s1[i] - s2[i]));
+
+	// As duas alinhadas, 4 bytes por vez.
+	if ( ( (unsigned long) p2 & 3 ) == 0 )
+	{
+		w1 = (const string_word_t *) p1;
+		w2 = (const string_word_t *) p2;
+
+		while ( *w1 == *w2 && STRING_HAS_ZERO (*w1) == 0 )
+		{
+			w1++;
+			w2++;
+		};
+
+		p1 = (const unsigned char *) w1;
+		p2 = (const unsigned char *) w2;
+	}
+
+	while ( *p1 == *p2 && *p1 != '\0' )
+	{
+		p1++;
+		p2++;
+	};
+
+	return (int) ( *p1 - *p2 );
 }
 
 
@@ -106,33 +303,91 @@ int str_cmp(unsigned char *str1, unsigned char *str2)
 
 void *memcpy ( void *v_dst, const void *v_src, unsigned long c ){
 	
-	const char *src = v_src;
-	char *dst = v_dst;
-
-	/* Simple, byte oriented memcpy. */
-	while (c--)
-		*dst++ = *src++;
+	string_copy_forward ( (unsigned char *) v_dst, 
+	    (const unsigned char *) v_src, c );
 
 	return v_dst;
 }
 
 
+/*
+ * memcpy32: 
+ *     c = número de dwords. */
+
 void *memcpy32 ( void *v_dst, const void *v_src, unsigned long c ){
 	
-	//const char *src = v_src;
-	//char *dst = v_dst;
+	unsigned long d0, d1, d2;
 
-	long *src = (long *) v_src;
-	long *dst = (long *) v_dst;
-	
-	/* Simple, byte oriented memcpy. */
-	while (c--)
-		*dst++ = *src++;
+	__asm__ __volatile__ ( "cld\n\t"
+	                       "rep movsl"
+	    : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+	    : "0" (c), "1" (v_dst), "2" (v_src)
+	    : "memory" );
 
 	return v_dst;
 }
 
 
+/*
+ * memmove:
+ *     Copia com sobreposição.
+ */
+
+void *memmove ( void *dest, const void *src, size_t count ){
+	
+	unsigned char *d = (unsigned char *) dest;
+	const unsigned char *s = (const unsigned char *) src;
+
+	if ( d == s || count == 0 ){
+		return dest;
+	}
+
+	// Destino antes da origem, ou sem sobreposição.
+	if ( d < s || d >= s + count )
+	{
+		string_copy_forward ( d, s, count );
+	}else{
+		string_copy_backward ( d, s, count );
+	};
+
+	return dest;
+}
+
+
+/*
+ * memcmp:
+ *     Compara duas regiões de memória.
+ *     4 bytes por vez enquanto forem iguais.
+ */
+
+int memcmp ( const void *s1, const void *s2, size_t n ){
+	
+	const unsigned char *p1 = s1;
+	const unsigned char *p2 = s2;
+
+	while ( n >= 4 && 
+	        *(const string_word_t *) p1 == *(const string_word_t *) p2 )
+	{
+		p1 += 4;
+		p2 += 4;
+		n -= 4;
+	};
+
+	while ( n > 0 )
+	{
+		if ( *p1 != *p2 ){
+			return (int) ( *p1 - *p2 );
+		}
+		
+		p1++;
+		p2++;
+		n--;
+	};
+	
+	return (int) 0;
+}
+
+
 /*
  * strcpy - copia uma string */
 
@@ -185,11 +440,9 @@ char *strcat (char *to, const char *from){
 
 void bcopy (char *from, char *to, int len){
 	
-	while(len--) 
-	{
-		*to++ = *from++;
-	};
-    //return;
+	if ( len > 0 ){
+		memmove ( (void *) to, (const void *) from, (size_t) len );
+	}
 }
 
 
@@ -199,11 +452,7 @@ void bcopy (char *from, char *to, int len){
 
 void bzero (char *cp, int len){
 	
-	while(len--)
-	{
-		*(cp + len) = 0;
-	};
-    //return;
+	memset ( (void *) cp, 0, len );
 }
 
 
@@ -211,16 +460,30 @@ void bzero (char *cp, int len){
  * strlen:
  *     Calcula o tamanho de uma string. */
 
-size_t strlen (const char *s){
-	
-    size_t i = 0;
+size_t strlen ( const char *s ){
 	
-	for (i = 0; s[i] != '\0'; ++i){
-	    ;
+	const char *p = s;
+	const string_word_t *w;
+
+	// Até alinhar. Uma leitura alinhada de 4 bytes nunca 
+	// passa do fim da página.
+	while ( ( (unsigned long) p & 3 ) != 0 )
+	{
+		if ( *p == '\0' ){
+			return (size_t) ( p - s );
+		}
+		p++;
 	};
-	
-//done:
-	return ( (size_t) i );
+
+	w = (const string_word_t *) p;
+
+	while ( STRING_HAS_ZERO (*w) == 0 ){ w++; };
+
+	p = (const char *) w;
+
+	while ( *p != '\0' ){ p++; };
+
+	return (size_t) ( p - s );
 }
 
 
@@ -420,27 +683,15 @@ int strcmp(const char *a, const char *b)
 
 
 
-//#bugbug:
-//Isso ainda não foi testado.
-
 void *memset ( void *ptr, int value, int size ){
 	
-    if( ptr != NULL && size > 0 )
-    {
-        unsigned char *temp = ptr;
-
-        int i = 0;
-
-        for ( i = 0; i < size; i++ )
-        {
-            *temp++ = (unsigned char)value;
-        }
-
-    };
-		
-    return (void *) ptr;
-};
- 
+	if ( ptr != NULL && size > 0 )
+	{
+		string_fill ( (unsigned char *) ptr, value, (unsigned long) size );
+	};
+	
+	return (void *) ptr;
+}
 
 
 
@@ -0,0 +1,1084 @@
+/*
+ * File: execve/elf.c
+ *
+ *     ELF loader with demand paging.
+ *
+ *     elfLoad() only reads the ELF header and the program headers.
+ * The pages of the image are marked ELF_PTE_DEMAND in the page table
+ * of the process, and elfPageFault() brings each one when it is
+ * touched for the first time:
+ *
+ *     + Read-only pages with file data: one frame in the cache of the
+ *       image, mapped read-only in all the processes. (shared text)
+ *     + Writable pages: a private frame with a copy of the file data.
+ *     + Pages out of the segments (bss, stack): a private zeroed frame.
+ *
+ *     The image stays in the cache after the last process exits, so
+ * launching the same program again does not read the text again.
+ * An unused image is dropped when we need the slot. When the file is
+ * saved again the image goes stale: new loads read the file again, and
+ * the old image is dropped when its last process exits.
+ *
+ *     A #PF from user mode reads the disk without the lock and with the
+ * interrupts enabled, then checks the entry again.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long get_page_fault_adr (void);
+
+
+static struct elf_image_d elf_images[ELF_IMAGE_MAX];
+
+// Headers of the file being loaded.
+static unsigned char elf_header_buffer[4096];
+
+// One sector, for the parts of the sectors.
+static unsigned char elf_sector_buffer[ELF_SECTOR_SIZE];
+
+static spinlock_t elf_spinlock;
+
+
+static unsigned long elf_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &elf_spinlock );
+}
+
+
+static void elf_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &elf_spinlock, flags );
+}
+
+
+static void elf_invlpg ( unsigned long address ){
+
+	__asm__ __volatile__ ( "invlpg (%0)" : : "r" (address) : "memory" );
+}
+
+
+static void elf_flush_tlb (void){
+
+	unsigned long Value;
+
+	__asm__ __volatile__ ( "movl %%cr3, %0" : "=r" (Value) );
+	__asm__ __volatile__ ( "movl %0, %%cr3" : : "r" (Value) : "memory" );
+}
+
+
+//
+// ## Frames ##
+//
+
+// A frame of the high memory, mapped in the kmap window while the
+// page is filled. (elf_frame_unmap)
+
+static void *elf_frame_alloc ( unsigned long *pa ){
+
+	void *Page;
+
+	*pa = (unsigned long) allocPhysicalFrames (1);
+
+	if ( *pa == 0 ){
+		return NULL;
+	}
+
+	Page = (void *) mapPhysicalFrames ( *pa, 1 );
+
+	if ( (void *) Page == NULL )
+	{
+		freePhysicalFrames (*pa);
+		return NULL;
+	}
+
+	return (void *) Page;
+}
+
+
+static void elf_frame_unmap ( void *page ){
+
+	unmapPhysicalFrames (page);
+}
+
+
+/*
+ * elf_frame_release:
+ *     A frame that the loader gave to a process.
+ *     After a fork it can be shared (COW), then only the count goes down.
+ */
+
+static void elf_frame_release ( unsigned long pa ){
+
+	framePut ( pa / PAGE_SIZE );
+}
+
+
+//
+// ## File ##
+//
+
+/*
+ * elf_read:
+ *     Read 'len' bytes at 'offset' of the file.
+ *     The whole sectors go straight to the buffer, one disk command
+ * for the clusters that follow each other in the FAT.
+ */
+
+static int
+elf_read ( struct elf_image_d *image,
+           unsigned long offset,
+           unsigned char *buffer,
+           unsigned long len )
+{
+	unsigned long Sector;
+	unsigned long Within;
+	unsigned long Part;
+	unsigned long Count;
+
+	while ( len > 0 )
+	{
+		Sector = (offset / ELF_SECTOR_SIZE);
+		Within = (offset % ELF_SECTOR_SIZE);
+
+		if ( Sector >= image->cluster_count ){
+			return (int) -1;
+		}
+
+		if ( Within == 0 && len >= ELF_SECTOR_SIZE )
+		{
+			Count = 1;
+
+			while ( Count < BCACHE_RUN_MAX &&
+			        Count < (len / ELF_SECTOR_SIZE) &&
+			        (Sector + Count) < image->cluster_count &&
+			        image->clusters[Sector + Count] == image->clusters[Sector] + Count )
+			{
+				Count++;
+			};
+
+			if ( bcacheReadBlocks ( (unsigned long) buffer,
+			         VOLUME1_DATAAREA_LBA + image->clusters[Sector] -2, Count, 0 ) != 0 )
+			{
+				return (int) -1;
+			}
+
+			Part = (Count * ELF_SECTOR_SIZE);
+
+		}else{
+
+			if ( bcacheReadBlocks ( (unsigned long) elf_sector_buffer,
+			         VOLUME1_DATAAREA_LBA + image->clusters[Sector] -2, 1, 0 ) != 0 )
+			{
+				return (int) -1;
+			}
+
+			Part = (ELF_SECTOR_SIZE - Within);
+
+			if ( Part > len ){
+				Part = len;
+			}
+
+			memcpy ( buffer, &elf_sector_buffer[Within], Part );
+		};
+
+		offset += Part;
+		buffer += Part;
+		len -= Part;
+	};
+
+	return 0;
+}
+
+
+/*
+ * elf_find_file:
+ *     The entry of the file in the root directory.
+ *     The name is already in the 8.3 format. (read_fntos)
+ */
+
+static unsigned char *elf_find_file ( const char *name ){
+
+	unsigned char *Entry = (unsigned char *) VOLUME1_ROOTDIR_ADDRESS;
+	unsigned long Max;
+	size_t Size;
+	unsigned long i;
+
+	if ( (void *) filesystem == NULL ){
+		return NULL;
+	}
+
+	Max = filesystem->rootdir_entries;
+
+	Size = (size_t) strlen ( (char *) name );
+
+	if ( Size > 11 ){
+		Size = 11;
+	}
+
+	for ( i=0; i < Max; i++ )
+	{
+		if ( Entry[0] != 0 && Entry[0] != 0xE5 &&
+		     strncmp ( (char *) name, (char *) Entry, Size ) == 0 )
+		{
+			return (unsigned char *) Entry;
+		}
+
+		Entry += 32;
+	};
+
+	return NULL;
+}
+
+
+//
+// ## Image cache ##
+//
+
+static void elf_image_drop ( struct elf_image_d *image ){
+
+	int i;
+
+	for ( i=0; i < ELF_IMAGE_PAGES; i++ )
+	{
+		if ( image->frames[i] != 0 )
+		{
+			elf_frame_release ( image->frames[i] );
+			image->frames[i] = 0;
+		}
+	};
+
+	image->used = 0;
+	image->magic = 0;
+}
+
+
+/* A free slot, or an image that nobody uses. */
+
+static struct elf_image_d *elf_image_slot (void){
+
+	int i;
+
+	for ( i=0; i < ELF_IMAGE_MAX; i++ )
+	{
+		if ( elf_images[i].used != 1 ){
+			return (struct elf_image_d *) &elf_images[i];
+		}
+	};
+
+	for ( i=0; i < ELF_IMAGE_MAX; i++ )
+	{
+		if ( elf_images[i].users <= 0 )
+		{
+			elf_image_drop ( &elf_images[i] );
+			return (struct elf_image_d *) &elf_images[i];
+		}
+	};
+
+	return NULL;
+}
+
+
+/*
+ * elf_image_parse:
+ *     Headers, program headers and the cluster chain.
+ *     All the PT_LOAD segments must be inside the region of the image.
+ */
+
+static int elf_image_parse ( struct elf_image_d *image ){
+
+	struct elf32_ehdr_d *Header = (struct elf32_ehdr_d *) elf_header_buffer;
+	struct elf32_phdr_d *Ph;
+	struct elf_segment_d *s;
+	unsigned short *fat = (unsigned short *) VOLUME1_FAT_ADDRESS;
+	unsigned short Cluster;
+	unsigned long Len;
+	unsigned long Base = 0;
+	int i;
+
+	// The cluster chain. The FAT stays in the cache. (bcache)
+	fs_load_fatEx ();
+
+	image->cluster_count = 0;
+	Cluster = image->first_cluster;
+
+	while ( Cluster >= 2 && Cluster < 0xFFF0 )
+	{
+		if ( image->cluster_count >= ELF_CLUSTER_MAX ){
+			return (int) 2;
+		}
+
+		image->clusters[image->cluster_count++] = Cluster;
+		Cluster = fat[Cluster];
+	};
+
+	if ( image->cluster_count == 0 ){
+		return (int) 1;
+	}
+
+	Len = image->file_size;
+
+	if ( Len > sizeof (elf_header_buffer) ){
+		Len = sizeof (elf_header_buffer);
+	}
+
+	if ( Len < sizeof (struct elf32_ehdr_d) ){
+		return (int) 2;
+	}
+
+	if ( elf_read ( image, 0, elf_header_buffer, Len ) != 0 ){
+		return (int) 1;
+	}
+
+	// Check ELF signature.
+	if ( fsCheckELFFile ( (unsigned long) elf_header_buffer ) != 0 ){
+		return (int) 2;
+	}
+
+	// 32bit, little endian, i386 executable.
+	if ( Header->e_ident[4] != 1 || Header->e_ident[5] != 1 ||
+	     Header->e_type != ELF_ET_EXEC || Header->e_machine != ELF_EM_386 )
+	{
+		return (int) 2;
+	}
+
+	if ( Header->e_phentsize != sizeof (struct elf32_phdr_d) ||
+	     Header->e_phnum == 0 ||
+	     ( Header->e_phoff + (Header->e_phnum * sizeof (struct elf32_phdr_d)) ) > Len )
+	{
+		return (int) 2;
+	}
+
+	image->segment_count = 0;
+
+	for ( i=0; i < Header->e_phnum; i++ )
+	{
+		Ph = (struct elf32_phdr_d *) &elf_header_buffer[ Header->e_phoff + (i * sizeof (struct elf32_phdr_d)) ];
+
+		if ( Ph->p_type != ELF_PT_LOAD || Ph->p_memsz == 0 ){
+			continue;
+		}
+
+		if ( image->segment_count >= ELF_SEGMENT_MAX ||
+		     Ph->p_filesz > Ph->p_memsz ||
+		     ( Ph->p_offset + Ph->p_filesz ) > image->file_size )
+		{
+			return (int) 2;
+		}
+
+		// The first segment says where the file starts in memory.
+		if ( image->segment_count == 0 ){
+			Base = ( (Ph->p_vaddr - Ph->p_offset) & ~(PAGE_SIZE -1) );
+		}
+
+		s = &image->segments[image->segment_count++];
+
+		s->vaddr = Ph->p_vaddr;
+		s->memsz = Ph->p_memsz;
+		s->offset = Ph->p_offset;
+		s->filesz = Ph->p_filesz;
+		s->flags = Ph->p_flags;
+	};
+
+	if ( image->segment_count == 0 ){
+		return (int) 2;
+	}
+
+	if ( Base < ELF_USER_START || (Base + ELF_IMAGE_SIZE) > ELF_USER_END ){
+		return (int) 2;
+	}
+
+	for ( i=0; i < image->segment_count; i++ )
+	{
+		s = &image->segments[i];
+
+		if ( s->vaddr < Base || (s->vaddr + s->memsz) > (Base + ELF_IMAGE_SIZE) ){
+			return (int) 2;
+		}
+	};
+
+	if ( Header->e_entry < Base || Header->e_entry >= (Base + ELF_IMAGE_SIZE) ){
+		return (int) 2;
+	}
+
+	image->base = Base;
+	image->entry = Header->e_entry;
+
+	return 0;
+}
+
+
+/*
+ * elf_image_open:
+ *     The image in the cache or a new one.
+ *     The same name, first cluster and size is the same file, unless
+ * the file was saved after the image was read. (stale)
+ */
+
+static int
+elf_image_open ( const char *name,
+                 struct elf_image_d **out )
+{
+	struct elf_image_d *Image;
+	unsigned char *Entry;
+	unsigned short Cluster;
+	unsigned long Size;
+	int Status;
+	int i;
+
+	Entry = elf_find_file (name);
+
+	if ( (void *) Entry == NULL ){
+		return (int) 1;
+	}
+
+	Cluster = *( (unsigned short *) (Entry + 26) );
+	Size = *( (unsigned long *) (Entry + 28) );
+
+	for ( i=0; i < ELF_IMAGE_MAX; i++ )
+	{
+		Image = &elf_images[i];
+
+		if ( Image->used == 1 && Image->magic == 1234 &&
+		     Image->stale == 0 &&
+		     Image->first_cluster == Cluster &&
+			 Image->file_size == Size &&
+			 strncmp ( Image->name, (char *) Entry, 11 ) == 0 )
+		{
+			elf_cache_hits++;
+			*out = Image;
+			return 0;
+		}
+	};
+
+	Image = elf_image_slot ();
+
+	if ( (void *) Image == NULL ){
+		return (int) 1;
+	}
+
+	memset ( Image, 0, sizeof (struct elf_image_d) );
+
+	memcpy ( Image->name, Entry, 11 );
+	Image->name[11] = 0;
+	Image->first_cluster = Cluster;
+	Image->file_size = Size;
+
+	Status = elf_image_parse (Image);
+
+	if ( Status != 0 ){
+		return (int) Status;
+	}
+
+	Image->users = 0;
+	Image->used = 1;
+	Image->magic = 1234;
+
+	*out = Image;
+
+	return 0;
+}
+
+
+void elfImageGet ( struct elf_image_d *image ){
+
+	if ( (void *) image != NULL && image->used == 1 ){
+		image->users++;
+	}
+}
+
+
+void elfImagePut ( struct elf_image_d *image ){
+
+	if ( (void *) image != NULL && image->used == 1 && image->users > 0 )
+	{
+		image->users--;
+
+		if ( image->users == 0 && image->stale == 1 ){
+			elf_image_drop (image);
+		}
+	}
+}
+
+
+/*
+ * elfImageInvalidate:
+ *     The file was saved. (fsSaveFile)
+ *     The cached pages can be old now. An image without processes is
+ * dropped, the others are dropped by the last elfImagePut.
+ */
+
+void elfImageInvalidate ( const char *name ){
+
+	struct elf_image_d *Image;
+	unsigned long Flags;
+	int i;
+
+	if ( (void *) name == NULL ){
+		return;
+	}
+
+	Flags = elf_lock ();
+
+	for ( i=0; i < ELF_IMAGE_MAX; i++ )
+	{
+		Image = &elf_images[i];
+
+		if ( Image->used != 1 || Image->magic != 1234 ){
+			continue;
+		}
+
+		if ( strncmp ( Image->name, (char *) name, 11 ) != 0 ){
+			continue;
+		}
+
+		Image->stale = 1;
+		elf_images_stale++;
+
+		if ( Image->users <= 0 ){
+			elf_image_drop (Image);
+		}
+	};
+
+	elf_unlock (Flags);
+}
+
+
+//
+// ## Pages ##
+//
+
+/*
+ * elf_page_flags:
+ *     Segments that touch the page.
+ *     0 = none (zero page), else the ELF_PF_ flags of all of them.
+ */
+
+static unsigned long elf_page_flags ( struct elf_image_d *image, unsigned long page ){
+
+	struct elf_segment_d *s;
+	unsigned long Flags = 0;
+	int i;
+
+	for ( i=0; i < image->segment_count; i++ )
+	{
+		s = &image->segments[i];
+
+		if ( s->vaddr < (page + PAGE_SIZE) && (s->vaddr + s->memsz) > page ){
+			Flags |= (s->flags | ELF_PF_R);
+		}
+	};
+
+	return (unsigned long) Flags;
+}
+
+
+/* Zeroes and the file data of all the segments in the page. */
+
+static int
+elf_fill_page ( struct elf_image_d *image,
+                unsigned long page,
+                unsigned char *buffer )
+{
+	struct elf_segment_d *s;
+	unsigned long Start;
+	unsigned long End;
+	int i;
+
+	memset ( buffer, 0, PAGE_SIZE );
+
+	for ( i=0; i < image->segment_count; i++ )
+	{
+		s = &image->segments[i];
+
+		Start = (s->vaddr > page) ? s->vaddr : page;
+		End = ( (s->vaddr + s->filesz) < (page + PAGE_SIZE) ) ? (s->vaddr + s->filesz) : (page + PAGE_SIZE);
+
+		if ( Start >= End ){
+			continue;
+		}
+
+		if ( elf_read ( image, s->offset + (Start - s->vaddr),
+		         &buffer[Start - page], End - Start ) != 0 )
+		{
+			return (int) -1;
+		}
+	};
+
+	return 0;
+}
+
+
+/*
+ * elf_private_table:
+ *     The page table of the image must be only ours.
+ *     A process created by the kernel still uses the page table of the
+ * kernel process. (as cowSharePageTable)
+ */
+
+static unsigned long *elf_private_table ( unsigned long *dir ){
+
+	unsigned long *KernelDir = (unsigned long *) gKernelPageDirectoryAddress;
+	unsigned long *Old;
+	unsigned long *New;
+	unsigned long PhysicalAddress;
+	int i;
+
+	if ( (dir[ENTRY_USERMODE_PAGES] & 1) == 0 ){
+		return NULL;
+	}
+
+	Old = (unsigned long *) ( dir[ENTRY_USERMODE_PAGES] & 0xFFFFF000 );
+
+	if ( dir[ENTRY_USERMODE_PAGES] != KernelDir[ENTRY_USERMODE_PAGES] ){
+		return (unsigned long *) Old;
+	}
+
+	New = (unsigned long *) get_table_pointer ();
+
+	for ( i=0; i < 1024; i++ ){
+		New[i] = Old[i];
+	};
+
+	PhysicalAddress = (unsigned long) virtual_to_physical ( (unsigned long) New,
+	                                      gKernelPageDirectoryAddress );
+
+	dir[ENTRY_USERMODE_PAGES] = ( PhysicalAddress | (dir[ENTRY_USERMODE_PAGES] & 0xFFF) );
+
+	return (unsigned long *) New;
+}
+
+
+/* The old page of the region. */
+
+static void elf_release_entry ( unsigned long entry ){
+
+	if ( (entry & 1) == 0 ){
+		return;
+	}
+
+	// The cache of the image owns it.
+	if ( entry & ELF_PTE_SHARED ){
+		return;
+	}
+
+	// Our frames, and the frames shared by a fork.
+	if ( entry & (ELF_PTE_DEMAND | COW_PTE_COW) ){
+		elf_frame_release ( entry & 0xFFFFF000 );
+	}
+}
+
+
+/*
+ * elfReleasePages:
+ *     The process is exiting. The private frames of its image, and the
+ * ones shared by a fork, lose this reference. The entries are cleared,
+ * so cowReleasePageTable does not see them again.
+ */
+
+void elfReleasePages ( struct process_d *process ){
+
+	struct elf_image_d *Image;
+	unsigned long *KernelDir = (unsigned long *) gKernelPageDirectoryAddress;
+	unsigned long *Dir;
+	unsigned long *PT;
+	unsigned long Flags;
+	int First;
+	int i;
+
+	if ( (void *) process == NULL ){
+		return;
+	}
+
+	Image = process->elf_image;
+
+	if ( (void *) Image == NULL || Image->used != 1 || Image->magic != 1234 ){
+		return;
+	}
+
+	Dir = (unsigned long *) process->DirectoryVA;
+
+	if ( (void *) Dir == NULL ){
+		return;
+	}
+
+	// The table of the kernel process is not ours.
+	if ( (Dir[ENTRY_USERMODE_PAGES] & 1) == 0 ||
+	     Dir[ENTRY_USERMODE_PAGES] == KernelDir[ENTRY_USERMODE_PAGES] )
+	{
+		return;
+	}
+
+	PT = (unsigned long *) ( Dir[ENTRY_USERMODE_PAGES] & 0xFFFFF000 );
+
+	First = (int) ( (Image->base >> 12) & 0x3FF );
+
+	Flags = elf_lock ();
+
+	for ( i=0; i < ELF_IMAGE_PAGES; i++ )
+	{
+		if ( (PT[First + i] & 1) && (PT[First + i] & ELF_PTE_SHARED) == 0 ){
+			elf_pages_released++;
+		}
+
+		elf_release_entry ( PT[First + i] );
+		PT[First + i] = 0;
+	};
+
+	elf_flush_tlb ();
+
+	elf_unlock (Flags);
+}
+
+
+/*
+ * elfLoad:
+ *     Prepares the image of the current process for the file.
+ *     Nothing is changed if the file is not a valid ELF.
+ *     The name must be in the 8.3 format. (read_fntos)
+ */
+
+int
+elfLoad ( struct process_d *process,
+          const char *name,
+          unsigned long *entry )
+{
+	struct elf_image_d *Image = NULL;
+	struct elf_image_d *Old;
+	unsigned long *PT;
+	unsigned long Flags;
+	char Name[12];
+	int First;
+	int Status;
+	int i;
+
+	if ( (void *) process == NULL || (void *) name == NULL ){
+		return (int) 1;
+	}
+
+	// The name is in the image that we will drop.
+	// And a #PF with the lock would not return.
+	for ( i=0; i < 11 && name[i] != 0; i++ ){
+		Name[i] = name[i];
+	};
+	Name[i] = 0;
+
+	Flags = elf_lock ();
+
+	Status = elf_image_open ( Name, &Image );
+
+	if ( Status != 0 )
+	{
+		elf_unlock (Flags);
+		return (int) Status;
+	}
+
+	PT = elf_private_table ( (unsigned long *) process->DirectoryVA );
+
+	if ( (void *) PT == NULL )
+	{
+		elf_unlock (Flags);
+		return (int) 1;
+	}
+
+	// Nothing is read now. Every page faults on the first touch.
+	First = (int) ( (Image->base >> 12) & 0x3FF );
+
+	for ( i=0; i < ELF_IMAGE_PAGES; i++ )
+	{
+		elf_release_entry ( PT[First + i] );
+		PT[First + i] = ELF_PTE_DEMAND;
+	};
+
+	Old = process->elf_image;
+
+	elfImageGet (Image);
+	process->elf_image = Image;
+	elfImagePut (Old);
+
+	process->Image = Image->base;
+	process->ImageSize = Image->file_size;
+
+	*entry = Image->entry;
+
+	elf_load_count++;
+
+	elf_flush_tlb ();
+
+	elf_unlock (Flags);
+
+	return 0;
+}
+
+
+/*
+ * elf_fill_frame:
+ *     Fill the page of a #PF. Called with the lock.
+ *     From user mode the disk is read without the lock and with the
+ * interrupts enabled. The irq0 stays masked: it would reload the stack
+ * of the fault (esp0) and no other thread may run in the middle of the
+ * fault. The caller checks the entry again after this.
+ *     From the kernel (a syscall with a buffer of the process) we keep
+ * the lock, the syscall may hold other locks that an irq would take.
+ */
+
+static int
+elf_fill_frame ( struct elf_image_d *image,
+                 unsigned long page,
+                 unsigned char *buffer,
+                 unsigned long error_code,
+                 unsigned long *flags )
+{
+	unsigned char Mask;
+	int Status;
+
+	if ( (error_code & 4) == 0 ){
+		return (int) elf_fill_page ( image, page, buffer );
+	}
+
+	elf_unlock (*flags);
+
+	Mask = (unsigned char) inportb (0x21);
+	outportb ( 0x21, Mask | 0x01 );
+
+	__asm__ __volatile__ ( "sti" : : : "memory" );
+
+	Status = elf_fill_page ( image, page, buffer );
+
+	__asm__ __volatile__ ( "cli" : : : "memory" );
+
+	outportb ( 0x21, Mask );
+
+	*flags = elf_lock ();
+
+	elf_fills_unlocked++;
+
+	return (int) Status;
+}
+
+
+/*
+ * elfPageFault:
+ *     A page of the image that was not touched yet.
+ *     The kernel can fault here too, in a syscall with a buffer of
+ * the process.
+ */
+
+int elfPageFault ( unsigned long error_code ){
+
+	struct process_d *Process;
+	struct elf_image_d *Image;
+	unsigned long *Dir;
+	unsigned long *PT;
+	unsigned long Address;
+	unsigned long Page;
+	unsigned long Segments;
+	unsigned long PA;
+	unsigned long Flags;
+	void *New;
+	int Index;
+	int d;
+	int t;
+
+	// Present. (protection)
+	if ( error_code & 1 ){
+		return 0;
+	}
+
+	Address = (unsigned long) get_page_fault_adr ();
+	Page = ( Address & 0xFFFFF000 );
+
+	__asm__ __volatile__ ( "movl %%cr3, %0" : "=r" (PA) );
+	Dir = (unsigned long *) ( PA & 0xFFFFF000 );
+
+	d = (int) ( (Address >> 22) & 0x3FF );
+	t = (int) ( (Address >> 12) & 0x3FF );
+
+	if ( (Dir[d] & 1) == 0 ){
+		return 0;
+	}
+
+	PT = (unsigned long *) ( Dir[d] & 0xFFFFF000 );
+
+	if ( (PT[t] & ELF_PTE_DEMAND) == 0 ){
+		return 0;
+	}
+
+	if ( current_process < 0 || current_process >= PROCESS_COUNT_MAX ){
+		return 0;
+	}
+
+	Process = (struct process_d *) processList[current_process];
+
+	if ( (void *) Process == NULL ){
+		return 0;
+	}
+
+	Image = Process->elf_image;
+
+	if ( (void *) Image == NULL || Image->used != 1 || Image->magic != 1234 ){
+		return 0;
+	}
+
+	if ( Page < Image->base || Page >= (Image->base + ELF_IMAGE_SIZE) ){
+		return 0;
+	}
+
+	Index = (int) ( (Page - Image->base) / PAGE_SIZE );
+
+	Flags = elf_lock ();
+
+	// Another path already brought it.
+	if ( PT[t] & 1 )
+	{
+		elf_unlock (Flags);
+		return (int) 1;
+	}
+
+	Segments = elf_page_flags ( Image, Page );
+
+	// Text and rodata. One frame for all the processes.
+	if ( Segments != 0 && (Segments & ELF_PF_W) == 0 )
+	{
+		if ( Image->frames[Index] == 0 )
+		{
+			New = elf_frame_alloc (&PA);
+
+			if ( (void *) New == NULL ){
+				goto fail;
+			}
+
+			if ( elf_fill_frame ( Image, Page, New, error_code, &Flags ) != 0 )
+			{
+				freeHighPages (New);
+				goto fail;
+			}
+
+			elf_frame_unmap (New);
+
+			// The image was dropped, or the page is there now.
+			if ( Image->used != 1 || Image->magic != 1234 ||
+			     Process->elf_image != Image || (PT[t] & ELF_PTE_DEMAND) == 0 )
+			{
+				freePhysicalFrames (PA);
+				goto fail;
+			}
+
+			if ( Image->frames[Index] == 0 )
+			{
+				Image->frames[Index] = PA;
+				elf_pages_read++;
+
+			}else{
+				freePhysicalFrames (PA);
+				elf_pages_shared++;
+			};
+
+			if ( PT[t] & 1 )
+			{
+				elf_unlock (Flags);
+				return (int) 1;
+			}
+
+		}else{
+			elf_pages_shared++;
+		};
+
+		PT[t] = ( Image->frames[Index] | ELF_PTE_SHARED | 5 );
+		elf_invlpg (Page);
+
+		elf_unlock (Flags);
+		return (int) 1;
+	}
+
+	// Data, bss and stack. Only ours.
+	New = elf_frame_alloc (&PA);
+
+	if ( (void *) New == NULL ){
+		goto fail;
+	}
+
+	if ( Segments != 0 )
+	{
+		if ( elf_fill_frame ( Image, Page, New, error_code, &Flags ) != 0 )
+		{
+			freeHighPages (New);
+			goto fail;
+		}
+
+		elf_frame_unmap (New);
+
+		if ( (PT[t] & ELF_PTE_DEMAND) == 0 )
+		{
+			freePhysicalFrames (PA);
+			goto fail;
+		}
+
+		// Another path already brought it.
+		if ( PT[t] & 1 )
+		{
+			freePhysicalFrames (PA);
+			elf_unlock (Flags);
+			return (int) 1;
+		}
+
+		elf_pages_private++;
+
+	}else{
+
+		memset ( New, 0, PAGE_SIZE );
+		elf_frame_unmap (New);
+
+		elf_pages_zero++;
+	};
+
+	PT[t] = ( PA | ELF_PTE_DEMAND | 7 );
+	elf_invlpg (Page);
+
+	elf_unlock (Flags);
+
+	return (int) 1;
+
+fail:
+
+	elf_fault_fail++;
+	elf_unlock (Flags);
+
+	return 0;
+}
+
+
+void elfShowInfo (void){
+
+	int i;
+
+	printf ("\n[ELF loader:]\n");
+
+	printf ("loads={%d} cache hits={%d} read={%d} shared={%d} private={%d} zero={%d} fails={%d}\n",
+	    elf_load_count, elf_cache_hits, elf_pages_read, elf_pages_shared,
+		elf_pages_private, elf_pages_zero, elf_fault_fail );
+
+	printf ("released={%d} unlocked fills={%d} stale images={%d}\n",
+	    elf_pages_released, elf_fills_unlocked, elf_images_stale );
+
+	for ( i=0; i < ELF_IMAGE_MAX; i++ )
+	{
+		if ( elf_images[i].used == 1 )
+		{
+			printf ("%s base={%x} size={%d} users={%d}%s\n",
+			    elf_images[i].name, elf_images[i].base,
+				elf_images[i].file_size, elf_images[i].users,
+				( elf_images[i].stale ? " stale" : "" ) );
+		}
+	};
+}
+
+
+//
+// End.
+//
+
@@ -358,6 +358,7 @@ format_ok:
 		// INITIALIZED >> STANDBY >> READY >> RUNNING ...
 
         Thread->state = INITIALIZED;
+        readyq_remove (Thread);
 
 		// '0'. Significa que o contexto nunca foi salvo, pois o spawn 
 		// no funciona em thread com o contexto salvo.
@@ -648,15 +649,25 @@ do_execve ( int i,
 	
 	unsigned long base;
 	
+	// Entry point do ELF.
+	unsigned long Entry = 0;
+	
 	struct process_d *process;
 	process = (struct process_d *) processList[current_process];
 
 
     //Status = (int) fsLoadFile ( VOLUME1_FAT_ADDRESS, VOLUME1_ROOTDIR_ADDRESS, 
-    //                   (unsigned char *) arg1, (unsigned long) 0x00400000 );
+    //                   (unsigned char *) arg1, (unsigned long) process->Image );
+	
+	// #importante
+	// O arquivo no  mais carregado inteiro aqui.
+	// O loader l s os headers do ELF e marca as pginas da imagem 
+	// como 'sob demanda'. Cada pgina vem do disco no primeiro acesso, 
+	// no #PF, e as pginas de cdigo so compartilhadas pelos processos 
+	// que rodam o mesmo arquivo. (execve/elf.c)
+	// Se o arquivo no  um ELF vlido, nada muda no processo.
 	
-    Status = (int) fsLoadFile ( VOLUME1_FAT_ADDRESS, VOLUME1_ROOTDIR_ADDRESS, 
-                       (unsigned char *) arg1, (unsigned long) process->Image );
+	Status = (int) elfLoad ( process, (const char *) arg1, &Entry );
 
 	if ( Status == 1 )
 	{
@@ -664,23 +675,11 @@ do_execve ( int i,
 		goto fail;
 	}
 
-	    // Check ELF signature.
-	    // OK. O comando existe e o arquivo foi carregado, mas 
-	    // precisamos saber se a assinatura de ELF  vlida.
-		
-	 //Status = (int) fsCheckELFFile ( (unsigned long) 0x00400000 );	
-	 Status = (int) fsCheckELFFile ( (unsigned long) process->Image );		
-
-	if ( Status == 0 )
+	if ( Status != 0 )
 	{
-		goto format_ok;	
-	}else{
-		
-		// #debug
 		printf ("do_execve: #debug It's not a valid ELF file\n");
-		die ();
-		//goto fail;
-	};
+		goto fail;
+	}
 	
 	//
 	// ELF Signature OK
@@ -845,6 +844,7 @@ format_ok:
 		// INITIALIZED >> STANDBY >> READY >> RUNNING ...
 
         Thread->state = INITIALIZED;
+        readyq_remove (Thread);
 
 		// '0'. Significa que o contexto nunca foi salvo, pois o spawn 
 		// no funciona em thread com o contexto salvo.
@@ -906,7 +906,8 @@ format_ok:
         Thread->eflags = 0x3200; 
         Thread->cs = 0x1B; 
         //Thread->eip = (unsigned long) 0x00401000; 
-        Thread->eip = (unsigned long) process->Image + 0x1000;
+        //Thread->eip = (unsigned long) process->Image + 0x1000;
+        Thread->eip = (unsigned long) Entry;
 		// Registradores de segmento.
 
         Thread->ds = 0x23; 
@@ -1019,6 +1020,9 @@ void sys_showkernelinfo (void){
 
 void sys_reboot (void){
 
+	// Os setores sujos do cache vo para o disco. (bcache.c)
+	bcacheSync ();
+
     hal_reboot ();
 }
 
@@ -1030,6 +1034,8 @@ void sys_reboot (void){
 
 void sys_shutdown (void){
 
+	bcacheSync ();
+
     hal_shutdown ();
 }
 
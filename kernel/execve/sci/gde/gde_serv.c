@@ -210,7 +210,6 @@ void *gde_services ( unsigned long number,
 	//usaremos para enviar uma mensagem com 4 elementos.
 	unsigned long *message_address = (unsigned long *) arg2;
 	
-	unsigned char SC;
 	//struct window_d *wFocus;
 	
 	int desktopID;
@@ -285,6 +284,120 @@ void *gde_services ( unsigned long number,
 		                    (unsigned char *) arg4 );
 	}
 	
+	//
+	// Message queue support.
+	//
+	
+	// 256 - Pega at arg3 mensagens da fila da thread atual.
+	// MSGQ_MESSAGE_WORDS longs por mensagem no buffer arg2.
+	// Retorna quantas mensagens foram copiadas.
+	if ( number == SYS_GETMESSAGES )
+	{
+		t = (void *) threadList[current_thread];
+		
+		msgqPumpKeyboard ();
+		
+	    return (void *) msgqGetMany ( t, (unsigned long *) arg2, (int) arg3 );
+	}
+	
+	// 257 - Dorme at chegar uma mensagem.
+	// Retorna 1 se j tinha mensagem.
+	if ( number == SYS_WAITMESSAGE )
+	{
+		t = (void *) threadList[current_thread];
+		
+	    return (void *) msgqWait (t);
+	}
+	
+	//
+	// stdio support.
+	//
+	
+	// 258 - Escreve arg4 bytes do buffer arg3.
+	// arg2 = NULL, terminal. Seno  um arquivo aberto com fopen.
+	if ( number == SYS_WRITEBUFFER )
+	{
+		if ( (void *) arg2 == NULL ){
+		    return (void *) kgws_terminal_write ( (const char *) arg3, (int) arg4 );
+		}
+		
+	    return (void *) stdio_file_write ( (FILE *) arg2, (char *) arg3, (int) arg4 );
+	}
+	
+	// 259 - L at arg4 bytes do arquivo arg2 para o buffer arg3.
+	// Retorna quantos bytes foram lidos.
+	if ( number == SYS_READBUFFER )
+	{
+	    return (void *) stdio_file_read ( (FILE *) arg2, (char *) arg3, (int) arg4 );
+	}
+	
+	//
+	// Semforos.
+	//
+	
+	// 260 - arg2 = count, arg3 = tipo. Retorna o handle ou -1.
+	if ( number == SYS_SEMCREATE )
+	{
+	    return (void *) semCreate ( (unsigned int) arg2, (int) arg3 );
+	}
+	
+	// 261 - arg2 = handle, arg3 = flags. (SEMAPHORE_TRY)
+	// Se bloquear, a troca de thread acontece no retorno. (sw.asm)
+	// Retorna 1 quando ela acorda, e ela chama de novo.
+	if ( number == SYS_SEMDOWN )
+	{
+	    return (void *) semDown ( (int) arg2, (int) arg3 );
+	}
+	
+	// 262
+	if ( number == SYS_SEMUP )
+	{
+	    return (void *) semUp ( (int) arg2 );
+	}
+	
+	// 263
+	if ( number == SYS_SEMDESTROY )
+	{
+	    return (void *) semDestroy ( (int) arg2 );
+	}
+	
+	// 264
+	if ( number == SYS_SEMINFO )
+	{
+		semShowInfo ();
+		refresh_screen ();
+	    return NULL;
+	}
+	
+	// 265 - A thread dorme at o deadline, em ticks. (timer.c)
+	// 0 = o deadline passou, 1 = bloqueada, chamar de novo.
+	if ( number == SYS_NANOSLEEP )
+	{
+	    return (void *) timerSleepUntil ( (unsigned long) arg2 );
+	}
+	
+	// 266 - clock_gettime. (timer.c)
+	if ( number == SYS_CLOCKGETTIME )
+	{
+	    return (void *) timerClockGetTime ( (int) arg2, (struct timespec_d *) arg3 );
+	}
+	
+	// 267 - Mostra as cpus e as filas de cada uma. (smp.c)
+	if ( number == SYS_SMPINFO )
+	{
+		smpShowInfo ();
+		refresh_screen ();
+	    return NULL;
+	}
+	
+	// 268 - Benchmark do texto. (glyph.c)
+	if ( number == SYS_GLYPHBENCH )
+	{
+		glyphBenchmark ();
+		refresh_screen ();
+	    return NULL;
+	}
+	
 	//
 	// x server and wm support
 	//
@@ -568,14 +681,12 @@ void *gde_services ( unsigned long number,
 		
 		//1 (i/o) Essa rotina pode ser usada por um driver em user mode.
 		case SYS_READ_LBA: 
-			sys_my_read_hd_sector ( (unsigned long) arg2, 
-			    (unsigned long) arg3, 0 , 0 ); 
+			bcacheRead ( (unsigned long) arg2, (unsigned long) arg3 ); 
 			break;
 			
 		//2 (i/o) Essa rotina pode ser usada por um driver em user mode.
 		case SYS_WRITE_LBA: 
-			sys_my_write_hd_sector ( (unsigned long) arg2, 
-			    (unsigned long) arg3, 0 , 0 ); 
+			bcacheWrite ( (unsigned long) arg2, (unsigned long) arg3 ); 
 		    break;
 
 		//3 fopen (i/o)
@@ -627,6 +738,7 @@ void *gde_services ( unsigned long number,
         case SYS_BUFFER_PUTPIXEL:		
             sys_backbuffer_putpixel ( (unsigned long) a2, 
 			    (unsigned long) a3, (unsigned long) a4, 0 );   		
+			damageAdd ( (unsigned long) a3, (unsigned long) a4, 1, 1 );
 			break;
 
 		// 7
@@ -685,6 +797,9 @@ void *gde_services ( unsigned long number,
 			
 		//11, Coloca o contedo do backbuffer no LFB.
         case SYS_REFRESHSCREEN: 
+			// O backbuffer  mapeado em user mode, o servidor
+			// pode pintar sem passar pelo kernel.
+			damageAddAll ();
 			sys_refresh_screen ();
 			break;			
 			
@@ -1114,43 +1229,18 @@ void *gde_services ( unsigned long number,
 			    
 	            if ( (void *) t == NULL ){ return NULL; }
 				
-				// Se no existe uma mensagem na thread, ento vamos
-				// pegar uma mensagem de teclado no buffer de teclado (stdin).
-				// Mas e se retornar o valor zero, pois no tem nada no buffer?
-				// Nesse caso vamos retornar essa funo dizendo que no temos mensagem
-				// ou tentaremos pegar mensagens em outro arquivo de input.
-				// #teste Do mesmo modo, se o scancode for um prefixo, podemos
-				// pegar o prximo scancode para termos uma mensagem.
+				// Se no existe uma mensagem na fila da thread, ento vamos
+				// transformar os scancodes do buffer de teclado (stdin) em
+				// mensagens. O prefixo 0xE0/0xE1  tratado l. (ipc/msgq.c)
+				// Se mesmo assim a fila estiver vazia, retornamos dizendo
+				// que no temos mensagem.
 				
-				if ( t->newmessageFlag != 1 )
-				{
-					sc_again:
-					
-					SC = (unsigned char) get_scancode ();
-					
-					if ( SC == 0 ){ return NULL; }
-					
-                    // teclas do teclado extendido.
-					
-					if ( SC == 0xE0 )
-					{
-						ke0 = 1;
-						goto sc_again;
-					}
-					
-				    if ( SC == 0xE1 )
-					{
-						ke0 = 2;
-						goto sc_again;
-					}					
-					
-					//#obs:
-					//o scancode  enviado para a rotina,
-					//mas ela precisa conferir ke0 antes de construir a mensagem,
-					//para assim usar o array certo.
-	                KEYBOARD_SEND_MESSAGE (SC);
-					
-					ke0 = 0;
+				if ( msgqCount (t) == 0 ){
+					msgqPumpKeyboard ();
+				}
+				
+				if ( msgqGet ( t, NULL ) != 1 ){ 
+				    return NULL; 
 				}
 	
 				//pegando a mensagem.
@@ -1167,10 +1257,6 @@ void *gde_services ( unsigned long number,
 				message_address[6] = (unsigned long) t->long5;
 				message_address[7] = (unsigned long) t->long6;
 				//...	
-                    
-				//sinalizamos que a mensagem foi consumida.
-				//#todo: nese momento a estrutura da thread tambm precisa ser limpa.
-                t->newmessageFlag = 0; 					
 				    
 				//sinaliza que h mensagem
 				return (void *) 1; 
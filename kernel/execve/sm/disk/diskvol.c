@@ -28,6 +28,12 @@ void diskShowCurrentDiskInfo (void)
 {	
 	printf ("The current disk is %d\n", current_disk );
 	diskShowDiskInfo(current_disk);
+	
+	//Estatsticas do cache de setores.
+	bcacheShowInfo ();
+	
+	//Contadores do driver de hd.
+	hddShowInfo ();
 }
 
 
@@ -709,6 +709,9 @@ void systemReboot (void){
 	//struct window_d *hWnd;
 	//struct window_d *hWindow;	
 	
+	// Os setores sujos do cache vo para o disco. (bcache.c)
+	bcacheSync ();
+	
 	asm ("cli");
 	
 	//No graphics.	
@@ -887,6 +890,7 @@ void systemReboot (void){
 #endif
                 if( T->used == 1 ){
                     T->state = BLOCKED; //?? ZOMBIE ??   
+                    readyq_remove (T);
 		            //block_thread(i, 0);
 				}
 		    };
@@ -970,6 +974,9 @@ void systemShutdown (void){
 	 
 	//@todo ...
 
+	// Os setores sujos do cache vo para o disco. (bcache.c)
+	bcacheSync ();
+
 	printf ("systemShutdown: It's safe to turnoff your computer");
 	refresh_screen ();
 	
@@ -1107,9 +1114,10 @@ void die (void){
 	//*Bullet.
     printf ("die: * System Halted\n");      
 	
+	// Sem deadline, copia agora.
 	if ( VideoBlock.useGui == 1 )
 	{
-	    refresh_screen ();
+	    damageFlush ();
 	}
 	
 //halt:
@@ -669,6 +669,19 @@ int init_hal (void){
 #endif    
 	timerInit();	
 	
+	// LAPIC - Timer one-shot, calibrado com o TSC. 
+	// O PIT continua sendo o tick.
+#ifdef HAL_VERBOSE	
+	printf("init_hal: LAPIC\n");
+#endif    
+	lapicInit ();
+	
+	// SMP - Acorda os APs com INIT/SIPI. (sched/smp.c)
+#ifdef HAL_VERBOSE	
+	printf("init_hal: SMP\n");
+#endif    
+	smpInit ();
+	
 
 	//Mouse components
 
@@ -70,6 +70,328 @@ static inline void imcr_apic_to_pic(void)
 };
 
 
+//
+// ## Local APIC ##
+//
+
+// hwlib.asm
+extern void setup_lapic_vectors (void);
+
+
+// Registradores mapeados em LAPIC_VA. 0 = não mapeado.
+static unsigned long lapic_base;
+
+// O timer está no modo TSC-deadline.
+static int lapic_deadline_armed;
+
+
+static unsigned long lapic_read ( unsigned long reg ){
+
+	return (unsigned long) *( (volatile unsigned long *) (lapic_base + reg) );
+}
+
+
+static void lapic_write ( unsigned long reg, unsigned long value ){
+
+	*( (volatile unsigned long *) (lapic_base + reg) ) = value;
+}
+
+
+static unsigned long long lapic_rdmsr ( unsigned long msr ){
+
+	unsigned long Low;
+	unsigned long High;
+
+	__asm__ __volatile__ ( "rdmsr" : "=a" (Low), "=d" (High) : "c" (msr) );
+
+	return (unsigned long long) ( ( (unsigned long long) High << 32 ) | Low );
+}
+
+
+static void lapic_wrmsr ( unsigned long msr, unsigned long long value ){
+
+	__asm__ __volatile__ ( "wrmsr" 
+	    : : "c" (msr), "a" ( (unsigned long) value ), 
+	        "d" ( (unsigned long) (value >> 32) ) : "memory" );
+}
+
+
+/*
+ * lapic_cpu_features:
+ *     cpuid 1. edx bit 9 = APIC, ecx bit 24 = TSC-deadline.
+ */
+
+static int lapic_cpu_features ( int *deadline ){
+
+	unsigned long a, b, c, d;
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (1), "c" (0) );
+
+	*deadline = (int) ( (c >> 24) & 1 );
+
+	return (int) ( (d >> 9) & 1 );
+}
+
+
+/*
+ * lapic_timer_calibrate:
+ *     Ticks do timer por ms, medidos com o TSC. (timer.c)
+ *     O TSC já foi calibrado contra o PIT.
+ */
+
+static unsigned long lapic_timer_calibrate (void){
+
+	unsigned long long Start;
+	unsigned long long Wait;
+	unsigned long Current;
+
+	if ( tsc_khz == 0 ){
+		return 0;
+	}
+
+	lapic_write ( LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR );
+	lapic_write ( LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16 );
+
+	// 10ms.
+	Wait = (unsigned long long) tsc_khz * 10;
+
+	Start = timerReadTSC ();
+	lapic_write ( LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFF );
+
+	while ( ( timerReadTSC () - Start ) < Wait ){};
+
+	Current = lapic_read ( LAPIC_REG_TIMER_CURRENT );
+	lapic_write ( LAPIC_REG_TIMER_INITIAL, 0 );
+
+	return (unsigned long) ( (0xFFFFFFFF - Current) / 10 );
+}
+
+
+/*
+ * lapicInit:
+ *     Liga o local APIC do BSP e prepara o timer dele.
+ *     O 8259 continua entregando as irqs, o IMCR não muda.
+ *     O timer fica parado até alguém armar um one-shot.
+ */
+
+int lapicInit (void){
+
+	unsigned long long Base;
+	int Deadline = 0;
+
+	lapic_timer_khz = 0;
+	lapic_tsc_deadline = 0;
+	lapic_timer_fired = 0;
+	lapic_deadline_armed = 0;
+
+	if ( lapic_cpu_features ( &Deadline ) == 0 ){
+		return (int) -1;
+	}
+
+	// Bit 11 = APIC global enable.
+	Base = lapic_rdmsr ( LAPIC_BASE_MSR );
+
+	if ( (Base & 0x800) == 0 )
+	{
+		Base |= 0x800;
+		lapic_wrmsr ( LAPIC_BASE_MSR, Base );
+	}
+
+	lapic_base = mapping_lapic_device_address ( (unsigned long) Base & 0xFFFFF000 );
+
+	setup_lapic_vectors ();
+
+	lapic_write ( LAPIC_REG_TPR, 0 );
+	lapic_write ( LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR );
+
+	lapic_timer_khz = lapic_timer_calibrate ();
+
+	// O TSC-deadline só serve com o TSC calibrado.
+	if ( tsc_khz != 0 ){
+		lapic_tsc_deadline = Deadline;
+	}
+
+	g_driver_apic_initialized = (int) 1;
+
+	return 0;
+}
+
+
+void lapicEOI (void){
+
+	if ( lapic_base != 0 ){
+		lapic_write ( LAPIC_REG_EOI, 0 );
+	}
+}
+
+
+void lapicTimerStop (void){
+
+	if ( lapic_base == 0 ){
+		return;
+	}
+
+	if ( lapic_deadline_armed == 1 )
+	{
+		lapic_wrmsr ( LAPIC_TSC_DEADLINE_MSR, 0 );
+		lapic_deadline_armed = 0;
+	}
+
+	lapic_write ( LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR );
+	lapic_write ( LAPIC_REG_TIMER_INITIAL, 0 );
+}
+
+
+/*
+ * lapicTimerOneShot:
+ *     Uma interrupção depois de 'us' microsegundos.
+ */
+
+int lapicTimerOneShot ( unsigned long us ){
+
+	unsigned long Count;
+
+	if ( lapic_base == 0 || lapic_timer_khz == 0 ){
+		return (int) -1;
+	}
+
+	lapicTimerStop ();
+
+	Count = ( (us / 1000) * lapic_timer_khz ) + 
+	        ( ( (us % 1000) * lapic_timer_khz ) / 1000 );
+
+	if ( Count == 0 ){
+		Count = 1;
+	}
+
+	lapic_write ( LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16 );
+	lapic_write ( LAPIC_REG_LVT_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_VECTOR );
+	lapic_write ( LAPIC_REG_TIMER_INITIAL, Count );
+
+	return 0;
+}
+
+
+/*
+ * lapicTimerDeadline:
+ *     Uma interrupção quando o TSC chegar em 'tsc'.
+ */
+
+int lapicTimerDeadline ( unsigned long long tsc ){
+
+	unsigned long long Now;
+	unsigned long long Delta;
+
+	if ( lapic_base == 0 ){
+		return (int) -1;
+	}
+
+	if ( lapic_tsc_deadline == 0 )
+	{
+		if ( tsc_khz == 0 ){
+			return (int) -1;
+		}
+
+		Now = timerReadTSC ();
+		Delta = ( tsc > Now ) ? (tsc - Now) : 0;
+
+		// Longe demais. Dispara antes e quem armou arma de novo.
+		if ( (Delta >> 32) != 0 ){
+			Delta = 0xFFFFFFFF;
+		}
+
+		// ciclos / MHz = us.
+		return (int) lapicTimerOneShot ( 
+		    (unsigned long) Delta / ( (tsc_khz / 1000) ? (tsc_khz / 1000) : 1 ) );
+	}
+
+	lapicTimerStop ();
+
+	lapic_write ( LAPIC_REG_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | LAPIC_TIMER_VECTOR );
+
+	// O wrmsr tem que vir depois do LVT.
+	__asm__ __volatile__ ( "mfence" : : : "memory" );
+
+	lapic_deadline_armed = 1;
+	lapic_wrmsr ( LAPIC_TSC_DEADLINE_MSR, tsc );
+
+	return 0;
+}
+
+
+/*
+ * lapicTimerHandler:
+ *     O timer disparou. (vetor LAPIC_TIMER_VECTOR)
+ *     O EOI é no local APIC e não no 8259.
+ */
+
+void lapicTimerHandler (void){
+
+	lapic_timer_fired++;
+	lapic_deadline_armed = 0;
+
+	lapicEOI ();
+}
+
+
+int lapicId (void){
+
+	if ( lapic_base == 0 ){
+		return (int) -1;
+	}
+
+	return (int) ( lapic_read ( LAPIC_REG_ID ) >> 24 );
+}
+
+
+/*
+ * lapicSendIPI:
+ *     O destino vai no ICR high, a escrita no ICR low envia.
+ */
+
+int lapicSendIPI ( unsigned long apic_id, unsigned long command ){
+
+	int Timeout = 100000;
+
+	if ( lapic_base == 0 ){
+		return (int) -1;
+	}
+
+	lapic_write ( LAPIC_REG_ICR_HIGH, (apic_id << 24) );
+	lapic_write ( LAPIC_REG_ICR_LOW, command );
+
+	while ( lapic_read ( LAPIC_REG_ICR_LOW ) & LAPIC_ICR_PENDING )
+	{
+		if ( --Timeout == 0 ){
+			return (int) -1;
+		}
+
+		asm ("pause");
+	};
+
+	return 0;
+}
+
+
+/*
+ * lapicApInit:
+ *     O AP usa o mesmo endereço do BSP. (LAPIC_VA)
+ *     Só liga o local APIC, o timer fica mascarado.
+ */
+
+void lapicApInit (void){
+
+	if ( lapic_base == 0 ){
+		return;
+	}
+
+	lapic_write ( LAPIC_REG_TPR, 0 );
+	lapic_write ( LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR );
+	lapic_write ( LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR );
+}
+
+
 /*
 int init_apic();
 int init_apic()
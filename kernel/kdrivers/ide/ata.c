@@ -989,6 +989,10 @@ int diskATAInitialize ( int ataflag ){
 	    {
             ide_dev_init (port);
 	    };		
+
+        // O driver de hd escolhe entre DMA e PIO de acordo
+        // com o disco atual.
+        init_hdd ();
 		
 			
 		//
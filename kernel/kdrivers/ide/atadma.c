@@ -195,6 +195,184 @@ int ide_dma_read_status (void){
     return inb ( ata.bus_master_base_address + ide_dma_reg_status );
 }
 
+
+
+/*
+ * Tabela PRD usada pelas transferências vetoriais do hdd.
+ * 512 bytes alinhados em 512, então a tabela nunca cruza
+ * um limite de 64KB.
+ */
+
+static struct ide_dma_prd_d ide_dma_prd_table[IDE_DMA_PRD_MAX] __attribute__ ((aligned (512)));
+
+static int ide_dma_prd_count = 0;
+
+
+/*
+ * ide_dma_prd_reset:
+ *     Começa uma nova tabela PRD.
+ */
+
+void ide_dma_prd_reset (void){
+
+	ide_dma_prd_count = 0;
+}
+
+
+/*
+ ***************************************
+ * ide_dma_prd_add:
+ *     Coloca um buffer na tabela PRD.
+ *     O buffer é virtual, então cada página é traduzida. Páginas
+ * fisicamente contínuas ficam na mesma entrada, até o limite de 64KB.
+ *     Retorna -1 se a tabela ficou cheia.
+ */
+
+int ide_dma_prd_add ( unsigned long address, unsigned long len ){
+
+	struct ide_dma_prd_d *prd;
+	unsigned long pa;
+	unsigned long piece;
+	unsigned long last;
+
+	while ( len > 0 )
+	{
+		pa = (unsigned long) virtual_to_physical ( address, 
+		                         gKernelPageDirectoryAddress );
+
+		// Até o fim da página.
+		piece = 4096 - (address & 0xFFF);
+
+		if ( piece > len ){
+			piece = len;
+		}
+
+		prd = NULL;
+
+		if ( ide_dma_prd_count > 0 )
+		{
+			prd = &ide_dma_prd_table[ide_dma_prd_count -1];
+
+			if ( prd->len == 0 ){
+				last = prd->addr + 0x10000;
+			}else{
+				last = prd->addr + prd->len;
+			};
+
+			// Continua a entrada anterior se for contínuo e
+			// ficar dentro do mesmo bloco de 64KB.
+			if ( last != pa || 
+			     ( (pa + piece -1) & ~0xFFFF ) != ( prd->addr & ~0xFFFF ) )
+			{
+				prd = NULL;
+			}
+		}
+
+		if ( (void *) prd != NULL )
+		{
+			prd->len = (uint16_t) ( (last - prd->addr) + piece );
+
+		}else{
+
+			if ( ide_dma_prd_count >= IDE_DMA_PRD_MAX ){
+				return (int) -1;
+			}
+
+			prd = &ide_dma_prd_table[ide_dma_prd_count];
+			prd->addr = (uint32_t) pa;
+			prd->len = (uint16_t) piece;
+			prd->flags = 0;
+
+			ide_dma_prd_count++;
+		};
+
+		address = address + piece;
+		len = len - piece;
+	};
+
+	return (int) 0;
+}
+
+
+/*
+ ***************************************
+ * ide_dma_setup:
+ *     Programa o bus master com a tabela PRD.
+ *     'bm' é o bus master base address do canal.
+ *     write = 1, memória para o disco.
+ */
+
+int ide_dma_setup ( unsigned long bm, int write ){
+
+	unsigned char data;
+	unsigned long phy;
+
+	if ( bm == 0 || ide_dma_prd_count == 0 ){
+		return (int) -1;
+	}
+
+	ide_dma_prd_table[ide_dma_prd_count -1].flags = IDE_DMA_PRD_EOT;
+
+	phy = (unsigned long) virtual_to_physical ( (unsigned long) &ide_dma_prd_table[0], 
+	                          gKernelPageDirectoryAddress );
+
+	// Parado.
+	outb ( bm + ide_dma_reg_cmd, 0 );
+
+	// prds physical.
+	outportl ( bm + ide_dma_reg_addr, phy );
+
+	// (bit 3 read/write)
+	// 0 = Memory reads. (disk write)
+	// 1 = Memory writes. (disk read)
+
+	if ( write == 1 ){
+		outb ( bm + ide_dma_reg_cmd, 0 );
+	}else{
+		outb ( bm + ide_dma_reg_cmd, 8 );
+	};
+
+	// Limpar o bit de interrupção e o bit de erro.
+	data = inb ( bm + ide_dma_reg_status );
+	outb ( bm + ide_dma_reg_status, data | ide_dma_sr_irq | ide_dma_sr_err );
+
+	return (int) 0;
+}
+
+
+/*
+ * ide_dma_begin:
+ *     Start. Chamado depois de enviar o comando ao disco.
+ */
+
+void ide_dma_begin ( unsigned long bm ){
+
+	unsigned char data = inb ( bm + ide_dma_reg_cmd );
+
+	outb ( bm + ide_dma_reg_cmd, data | dma_bus_start );
+}
+
+
+/*
+ * ide_dma_end:
+ *     Stop. Retorna o status do bus master antes de limpar os bits.
+ */
+
+int ide_dma_end ( unsigned long bm ){
+
+	unsigned char data;
+	unsigned char status;
+
+	data = inb ( bm + ide_dma_reg_cmd );
+	outb ( bm + ide_dma_reg_cmd, data & ~dma_bus_start );
+
+	status = inb ( bm + ide_dma_reg_status );
+	outb ( bm + ide_dma_reg_status, status | ide_dma_sr_irq | ide_dma_sr_err );
+
+	return (int) status;
+}
+
+
 //
 // End.
 //
@@ -58,6 +58,9 @@
 extern unsigned long hd_buffer;
 extern unsigned long hd_lba;
 
+// Lista de dispositivos. (ata.c)
+extern st_dev_t *ready_queue_dev;
+
 
 
 //Variveis internas
@@ -265,15 +268,8 @@ again:
 		case 0x30:
 		    hdd_ata_pio_write ( (int) port, (void *) buffer, (int) 512 );
 			
-            //Flush Cache
-    
-	        //ata_cmd_write(p,ATA_CMD_FLUSH_CACHE);
-	        hdd_ata_cmd_write( (int) port, (int) ATA_CMD_FLUSH_CACHE );
-            hdd_ata_wait_not_busy(port);
-            if ( hdd_ata_wait_no_drq(port) != 0)
-	        {
-                return -1;
-            }	
+            // O flush no  mais feito a cada setor.
+            // Ele  feito no sync. (hddFlushCache)
 			break;
         
 		//fail
@@ -287,6 +283,509 @@ again:
 }
 
 
+/*
+ * hdd_bm_base:
+ *     Bus master base address do canal. 0 se no h DMA.
+ */
+
+static unsigned long hdd_bm_base ( int port ){
+
+	unsigned long Base;
+
+	if ( (void *) ata_pci == NULL ){
+		return (unsigned long) 0;
+	}
+
+	Base = (unsigned long) ( ata_pci->BAR4 & ~0xF );
+
+	if ( Base == 0 ){
+		return (unsigned long) 0;
+	}
+
+	// Canal secundrio.
+	if ( port == 2 ){
+		Base = Base + 8;
+	}
+
+	return (unsigned long) Base;
+}
+
+
+/*
+ * hdd_ata_set_lba:
+ *     Dispositivo, lba e nmero de setores. (LBA28)
+ *     count = 256 vai como 0.
+ */
+
+static void 
+hdd_ata_set_lba ( int port, 
+                  int slave, 
+                  unsigned long lba, 
+                  int count )
+{
+	int Base = (int) ide_ports[port].base_port;
+	unsigned long Dev = 0xE0;    //1110 0000b; master
+
+	if ( slave == 1 ){
+		Dev = 0xF0;              //1111 0000b; slave
+	}
+
+	outportb ( Base + 6, (int) ( Dev | ( (lba >> 24) & 0x0F ) ) );
+	outportb ( Base + 2, (int) ( count & 0xFF ) );
+	outportb ( Base + 3, (int) ( lba & 0xFF ) );
+	outportb ( Base + 4, (int) ( (lba >> 8) & 0xFF ) );
+	outportb ( Base + 5, (int) ( (lba >> 16) & 0xFF ) );
+}
+
+
+/*
+ * hdd_ata_poll:
+ *     Espera BSY=0. Com drq=1 espera tambm DRQ=1.
+ *     0 = ok, -1 = erro do disco, -3 = timeout.
+ */
+
+static int hdd_ata_poll ( int port, int drq ){
+
+	unsigned long timeout = 4444*512;
+	unsigned char c;
+
+	while (1)
+	{
+		c = hdd_ata_status_read (port);
+
+		if ( (c & ATA_SR_BSY) == 0 )
+		{
+			if ( c & (ATA_SR_ERR | ATA_SR_DF) ){
+				return (int) -1;
+			}
+
+			if ( drq == 0 || (c & ATA_SR_DRQ) ){
+				return (int) 0;
+			}
+		}
+
+		timeout--;
+		if ( timeout == 0 ){
+			return (int) -3;
+		}
+	};
+}
+
+
+/*
+ * hdd_wait_irq:
+ *     Espera a interrupo do fim do comando DMA. (atairq.c)
+ *     Com as interrupes ligadas e o timer funcionando, o processador
+ * fica parado em hlt at a prxima interrupo, a do disco ou a do timer.
+ *     0 = ok, -3 = timeout.
+ */
+
+static int hdd_wait_irq ( unsigned long bm ){
+
+	unsigned long Start = sys_time_ticks_total;
+	unsigned long Flags;
+	unsigned long Spin = 0;
+
+	while ( disk_get_ata_irq_invoked () == 0 )
+	{
+		// O bus master tambm marca o fim.
+		if ( inb ( bm + ide_dma_reg_status ) & (ide_dma_sr_irq | ide_dma_sr_err) ){
+			break;
+		}
+
+		__asm__ __volatile__ ( "pushfl; popl %0" : "=r" (Flags) );
+
+		// Com a irq0 mascarada no tem tick para o timeout. 
+		// (trabalho adiado do tick, #PF do elf.c)
+		if ( (Flags & 0x200) && g_driver_timer_initialized == 1 &&
+		     ( inportb (0x21) & 0x01 ) == 0 )
+		{
+			__asm__ __volatile__ ("hlt");
+
+			if ( (sys_time_ticks_total - Start) > HDD_TIMEOUT_TICKS ){
+				return (int) -3;
+			}
+
+		}else{
+
+			Spin++;
+			if ( Spin > (4444*512) ){
+				return (int) -3;
+			}
+		};
+	};
+
+	disk_reset_ata_irq_invoked ();
+
+	return (int) 0;
+}
+
+
+/*
+ * hdd_pio_transfer:
+ *     Um comando READ SECTORS ou WRITE SECTORS para 'count' setores.
+ *     O disco pede cada setor com DRQ.
+ */
+
+static int 
+hdd_pio_transfer ( int port, 
+                   int slave, 
+                   int write, 
+                   unsigned long lba, 
+                   struct hdd_iovec_d *iov, 
+                   int count )
+{
+	char *p = (char *) iov[0].base;
+	unsigned long Left = iov[0].len;
+	int Status;
+	int i;
+
+	hdd_ata_wait_not_busy (port);
+
+	hdd_ata_set_lba ( port, slave, lba, count );
+
+	disk_reset_ata_irq_invoked ();
+
+	if ( write == 1 ){
+		outportb ( (int) ide_ports[port].base_port + 7, (int) ATA_CMD_WRITE_SECTORS );
+	}else{
+		outportb ( (int) ide_ports[port].base_port + 7, (int) ATA_CMD_READ_SECTORS );
+	};
+
+	ata_wait (400);
+
+	for ( i=0; i < count; i++ )
+	{
+		// Prximo pedao do vetor.
+		if ( Left == 0 )
+		{
+			iov++;
+			p = (char *) iov->base;
+			Left = iov->len;
+		}
+
+		Status = hdd_ata_poll ( port, 1 );
+
+		if ( Status != 0 ){
+			return (int) Status;
+		}
+
+		if ( write == 1 ){
+			hdd_ata_pio_write ( port, (void *) p, 512 );
+		}else{
+			hdd_ata_pio_read ( port, (void *) p, 512 );
+		};
+
+		p = p + 512;
+		Left = Left - 512;
+	};
+
+	// O ltimo setor ainda est sendo gravado.
+	if ( write == 1 )
+	{
+		ata_wait (400);
+
+		Status = hdd_ata_poll ( port, 0 );
+
+		if ( Status != 0 ){
+			return (int) Status;
+		}
+	}
+
+	disk_reset_ata_irq_invoked ();
+
+	return (int) 0;
+}
+
+
+/*
+ * hdd_dma_transfer:
+ *     Um comando READ DMA ou WRITE DMA para 'count' setores.
+ *     Cada pedao do vetor vai para a tabela PRD.
+ *     -2 = no d pra fazer por DMA, use PIO.
+ */
+
+static int 
+hdd_dma_transfer ( int port, 
+                   int slave, 
+                   int write, 
+                   unsigned long lba, 
+                   struct hdd_iovec_d *iov, 
+                   int iovcnt, 
+                   int count )
+{
+	unsigned long bm;
+	int Status;
+	int BMStatus;
+	int i;
+
+	bm = hdd_bm_base (port);
+
+	if ( bm == 0 ){
+		return (int) -2;
+	}
+
+	ide_dma_prd_reset ();
+
+	for ( i=0; i < iovcnt; i++ )
+	{
+		// S os buffers do kernel esto no diretrio do kernel.
+		if ( (unsigned long) iov[i].base < KERNEL_IMAGE_BASE ){
+			return (int) -2;
+		}
+
+		if ( ide_dma_prd_add ( (unsigned long) iov[i].base, iov[i].len ) != 0 ){
+			return (int) -2;
+		}
+	};
+
+	if ( ide_dma_setup ( bm, write ) != 0 ){
+		return (int) -2;
+	}
+
+	hdd_ata_wait_not_busy (port);
+
+	hdd_ata_set_lba ( port, slave, lba, count );
+
+	disk_reset_ata_irq_invoked ();
+
+	if ( write == 1 ){
+		outportb ( (int) ide_ports[port].base_port + 7, (int) ATA_CMD_WRITE_DMA );
+	}else{
+		outportb ( (int) ide_ports[port].base_port + 7, (int) ATA_CMD_READ_DMA );
+	};
+
+	ide_dma_begin (bm);
+
+	Status = hdd_wait_irq (bm);
+
+	BMStatus = ide_dma_end (bm);
+
+	// Lendo o status o disco desliga a interrupo.
+	if ( hdd_ata_poll ( port, 0 ) != 0 ){
+		return (int) -1;
+	}
+
+	if ( Status != 0 || (BMStatus & ide_dma_sr_err) ){
+		return (int) -1;
+	}
+
+	return (int) 0;
+}
+
+
+/*
+ ******************************************************************
+ * hddReadWriteVector:
+ *     L ou grava setores contnuos do disco atual usando um vetor
+ * de buffers. (scatter/gather)
+ *     Um nico comando para todos os setores, at HDD_SECTORS_MAX.
+ *     Usa DMA quando o disco aceita, se o DMA falhar fica no PIO.
+ *     No faz flush, isso  feito por hddFlushCache.
+ *
+ * IN:
+ *     write  - 1 = gravar, 0 = ler.
+ *     lba    - Primeiro setor.
+ *     iov    - Os buffers, cada um com tamanho mltiplo de 512.
+ *     iovcnt - Quantos buffers.
+ */
+
+int 
+hddReadWriteVector ( int write, 
+                     unsigned long lba, 
+                     struct hdd_iovec_d *iov, 
+                     int iovcnt )
+{
+	int port = (int) g_current_ide_channel;
+	int slave = (int) g_current_ide_device;
+	unsigned long Bytes = 0;
+	int Count;
+	int Status = -2;
+	int i;
+
+	if ( (void *) iov == NULL || iovcnt <= 0 ){
+		return (int) -1;
+	}
+
+	if ( port < 0 || port >= 4 ){
+		return (int) -1;
+	}
+
+	for ( i=0; i < iovcnt; i++ )
+	{
+		if ( (void *) iov[i].base == NULL || 
+		     iov[i].len == 0 || 
+			 (iov[i].len % 512) != 0 )
+		{
+			return (int) -1;
+		}
+
+		Bytes = Bytes + iov[i].len;
+	};
+
+	Count = (int) (Bytes / 512);
+
+	if ( Count > HDD_SECTORS_MAX ){
+		return (int) -1;
+	}
+
+	if ( hdd_dma_enabled == 1 )
+	{
+		Status = hdd_dma_transfer ( port, slave, write, lba, iov, iovcnt, Count );
+
+		if ( Status == 0 ){
+			hddDMACommands++;
+		}
+
+		if ( Status == -1 || Status == -3 )
+		{
+			printf ("hddReadWriteVector: DMA fail, using PIO\n");
+			hdd_dma_enabled = 0;
+		}
+	}
+
+	if ( Status != 0 ){
+		Status = hdd_pio_transfer ( port, slave, write, lba, iov, Count );
+	}
+
+	if ( Status != 0 )
+	{
+		printf ("hddReadWriteVector: fail lba=%d count=%d\n", lba, Count );
+		hddErrors++;
+		return (int) -1;
+	}
+
+	hddCommands++;
+
+	if ( write == 1 ){
+		hddSectorsWritten = hddSectorsWritten + Count;
+	}else{
+		hddSectorsRead = hddSectorsRead + Count;
+	};
+
+	return (int) 0;
+}
+
+
+/* Setores contnuos em um buffer contnuo. */
+
+static int 
+hdd_rw_sectors ( int write, 
+                 unsigned long buffer, 
+                 unsigned long lba, 
+                 int count )
+{
+	struct hdd_iovec_d v;
+	int n;
+
+	while ( count > 0 )
+	{
+		n = count;
+
+		if ( n > HDD_SECTORS_MAX ){
+			n = HDD_SECTORS_MAX;
+		}
+
+		v.base = (void *) buffer;
+		v.len = (unsigned long) (n * 512);
+
+		if ( hddReadWriteVector ( write, lba, &v, 1 ) != 0 ){
+			return (int) -1;
+		}
+
+		buffer = buffer + (n * 512);
+		lba = lba + n;
+		count = count - n;
+	};
+
+	return (int) 0;
+}
+
+
+/*
+ * hddReadSectors:
+ *     L 'count' setores a partir de 'lba' para o buffer.
+ */
+
+int hddReadSectors ( unsigned long buffer, unsigned long lba, int count ){
+
+	return (int) hdd_rw_sectors ( 0, buffer, lba, count );
+}
+
+
+/*
+ * hddWriteSectors:
+ *     Grava 'count' setores do buffer a partir de 'lba'.
+ */
+
+int hddWriteSectors ( unsigned long buffer, unsigned long lba, int count ){
+
+	return (int) hdd_rw_sectors ( 1, buffer, lba, count );
+}
+
+
+/*
+ ******************************************************************
+ * hddFlushCache:
+ *     Manda o disco gravar o cache dele.
+ *     As gravaes no fazem flush, isso  feito aqui, no sync.
+ */
+
+int hddFlushCache (void){
+
+	int port = (int) g_current_ide_channel;
+
+	if ( port < 0 || port >= 4 ){
+		return (int) -1;
+	}
+
+	hdd_ata_wait_not_busy (port);
+
+	if ( g_current_ide_device == 1 ){
+		outportb ( (int) ide_ports[port].base_port + 6, (int) 0xF0 );
+	}else{
+		outportb ( (int) ide_ports[port].base_port + 6, (int) 0xE0 );
+	};
+
+	hdd_ata_cmd_write ( port, ATA_CMD_FLUSH_CACHE );
+
+	if ( hdd_ata_poll ( port, 0 ) != 0 )
+	{
+		hddErrors++;
+		return (int) -1;
+	}
+
+	disk_reset_ata_irq_invoked ();
+
+	hddFlushes++;
+
+	return (int) 0;
+}
+
+
+/*
+ * hddShowInfo:
+ *     Contadores do driver.
+ */
+
+void hddShowInfo (void){
+
+	printf ("\n[hdd:]\n");
+
+	if ( hdd_dma_enabled == 1 ){
+		printf ("mode={DMA} ");
+	}else{
+		printf ("mode={PIO} ");
+	};
+
+	printf ("commands={%d} dma={%d} flushes={%d} errors={%d}\n",
+	    hddCommands, hddDMACommands, hddFlushes, hddErrors );
+
+	printf ("sectors read={%d} sectors written={%d}\n",
+	    hddSectorsRead, hddSectorsWritten );
+}
+
+
 /*
  *****************************************
  * my_read_hd_sector:
@@ -309,12 +808,9 @@ my_read_hd_sector ( unsigned long ax,
     //#todo
 	//s'o falta conseguirmos as variaveis que indicam o canal e se 'e master ou slave.
 
-	// (buffer, lba, rw flag, port number, master )
-	pio_rw_sector ( (unsigned long) ax, 
-					(unsigned long) bx, 
-					(int) 0x20, 
-					(int) g_current_ide_channel,   //0 ... channel
-					(int) g_current_ide_device );  //1 ... master=1 slave=0
+	// (buffer, lba, count)
+	// O canal e o dispositivo so g_current_ide_channel e g_current_ide_device.
+	hddReadSectors ( (unsigned long) ax, (unsigned long) bx, 1 );
 
 	/*
 	 // #antigo.
@@ -356,12 +852,9 @@ my_write_hd_sector ( unsigned long ax,
     //#todo
 	//s'o falta conseguirmos as variaveis que indicam o canal e se 'e master ou slave.
 	
-	// (buffer, lba, rw flag, port number, master )
-	pio_rw_sector ( (unsigned long) ax, 
-					(unsigned long) bx, 
-					(int) 0x30, 
-					(int) g_current_ide_channel,     //0 ... channel
-					(int) g_current_ide_device );    //1 ... master=1 slave=0
+	// (buffer, lba, count)
+	// O canal e o dispositivo so g_current_ide_channel e g_current_ide_device.
+	hddWriteSectors ( (unsigned long) ax, (unsigned long) bx, 1 );
 
 /*
 	//antigo.
@@ -390,10 +883,42 @@ my_write_hd_sector ( unsigned long ax,
 
 int init_hdd (void){
 
-	//
-	// @todo: We need to do something here.
-	//	
+	st_dev_t *d;
+	int Channel;
 
+	hddCommands = 0;
+	hddDMACommands = 0;
+	hddSectorsRead = 0;
+	hddSectorsWritten = 0;
+	hddFlushes = 0;
+	hddErrors = 0;
+
+	// DMA se o disco atual aceita e se o driver no est em FORCEPIO.
+	// (ide_dev_init)
+	hdd_dma_enabled = 0;
+
+	// g_current_ide_channel  a porta do canal, (__CHANNEL0 ou __CHANNEL1)
+	// e dev_channel  o ndice dele, 0 ou 1.
+	Channel = ( g_current_ide_channel == __CHANNEL1 ) ? 1 : 0;
+
+	if ( ATAFlag != FORCEPIO && hdd_bm_base ( g_current_ide_channel ) != 0 )
+	{
+		d = (st_dev_t *) ready_queue_dev;
+
+		while ( (void *) d != NULL )
+		{
+			if ( d->dev_channel == Channel &&
+			     d->dev_num == g_current_ide_device &&
+			     d->dev_type == ATA_DEVICE_TYPE && 
+				 d->dev_modo_transfere == ATA_DMA_MODO )
+			{
+				hdd_dma_enabled = 1;
+				break;
+			}
+
+			d = d->next;
+		};
+	}
 
 	g_driver_hdd_initialized = (int) 1;
 
@@ -286,6 +286,18 @@ void show_current_nic_info (void){
         printf ("int_line={%d} int_pin={%d}\n",
 		    currentNIC->pci->irq_line,     //irq
 			currentNIC->pci->irq_pin );    //shared INTA#			
+
+		//
+		// ## RX ##
+		//
+		
+		printf ("rx frames={%d} bytes={%d} drops={%d} errors={%d} ring_full={%d}\n",
+		    currentNIC->rx_frames, currentNIC->rx_bytes, currentNIC->rx_drops, 
+			currentNIC->rx_errors, currentNIC->rx_ring_full );
+		
+		printf ("rx batches={%d} max_batch={%d} pool_free={%d}\n",
+		    currentNIC->rx_batches, currentNIC->rx_max_batch, 
+			currentNIC->rx_pool_count );
 			
 		//...
 		
@@ -346,6 +358,107 @@ handle_ipv6 ( struct intel_nic_info_d *nic,
 }
 
 
+/*
+ * network_handle_frame:
+ *     Demux dos frames recebidos pelo e1000. (ARP/IPv4/IPv6)
+ *     O frame est no buffer do pool do driver e s vale durante 
+ * essa chamada. No tem cpia. Quem precisar guardar, copia.
+ *     Chamada pelo handler de interrupo, ento sem printf aqui.
+ */
+
+int 
+network_handle_frame ( struct intel_nic_info_d *nic, 
+                       unsigned char *frame, 
+                       uint32_t len )
+{
+	struct ether_header *eh;
+	struct ether_arp *arp_h;
+	struct ipv6_header_d *ipv6_h;
+	
+	uint16_t type;
+	int i;
+
+
+	if ( (void *) nic == NULL || (void *) frame == NULL )
+		return -1;
+
+	if ( len < ETHERNET_HEADER_LENGHT )
+		return -1;
+
+	//ethernet header
+	eh = (void *) &frame[0];
+	
+	type = FromNetByteOrder16 (eh->type);
+	
+	switch ( (uint16_t) type )
+	{
+		//0x0800	Internet Protocol version 4 (IPv4)
+		case 0x0800:
+		    //#todo
+		    return 0;
+		    break;
+		   
+		//0x0806	Address Resolution Protocol (ARP)
+		case 0x0806:
+		
+		    if ( len < ETHERNET_HEADER_LENGHT + ARP_HEADER_LENGHT )
+				return -1;
+			
+			arp_h = (void *) &frame[ETHERNET_HEADER_LENGHT];
+			
+			if ( arp_h->op == ToNetByteOrder16(ARP_OPC_REPLY) )
+			{
+				return 0;
+			}
+			
+			if ( arp_h->op == ToNetByteOrder16(ARP_OPC_REQUEST) )
+			{
+				//cache
+				for ( i=0; i<32; i++ )
+				{
+					if ( nic->arp_cache[i].used == 1 && nic->arp_cache[i].magic == 1234 )
+					{
+						//compara o ip
+						if ( strncmp ( (char *) &nic->arp_cache[i].ipv4_address[0], (char *) &arp_h->arp_spa[0], 4 ) == 0 )
+						{
+							memcpy ( (void *) &nic->arp_cache[i].mac_address[0], (const void *) &eh->src[0], 6 );
+							
+							//sinaliza que est em uso.
+							nic->arp_cache[i].magic = 4321;
+						}
+					}
+				};
+				
+				//muda para REPLAY.
+				arp_h->op = ToNetByteOrder16(ARP_OPC_REPLY);
+
+				//reenvia os mesmos dados, mas modificados para replay.
+				//E1000Send copia o frame para o ring de tx, ento o 
+				//buffer pode voltar para o pool.
+				E1000Send ( (void *) nic, 
+				    (uint32_t) (ETHERNET_HEADER_LENGHT + ARP_HEADER_LENGHT), 
+				    (uint8_t *) &frame[0] );
+				
+				return 0;
+			} 
+			return 0;
+			break;
+
+		//0x86DD	Internet Protocol Version 6 (IPv6)
+		case 0x86DD:
+		    ipv6_h = (void *) &frame[ETHERNET_HEADER_LENGHT];
+			return (int) handle_ipv6 ( nic, ipv6_h );
+		    break;
+
+		default:
+			return 0;
+			break;
+	};
+	
+	return 0;
+}
+
+
 
 // #IMPORTANTE
 // Chamada por F6 no procedimento de janela do sistema.
@@ -518,69 +631,42 @@ SendIPV4 ( uint8_t source_ip[4],
 	
 		
 	// ## quem ? ##
-	uint16_t old = currentNIC->tx_cur;
+	// Um descritor livre do ring e o seu buffer.
 	
-
-	// ## Copiando o pacote no buffer ##
+	unsigned char *buffer;
+	int slot = e1000TxGetBuffer ( currentNIC, &buffer );
 	
-	//pegando o endereo virtual do buffer na estrutura do dispositivo.	
-	unsigned char *buffer = (unsigned char *) currentNIC->tx_descs_virt[old];	
-		
-	unsigned char *src_ethernet = (unsigned char *) eh; 
-	unsigned char *src_ipv4 = (unsigned char *) ipv4; 
-	unsigned char *src_udp = (unsigned char *) udp; 
-	
-	int j=0;
-	
-	//copia o header ethernet
-	for ( j=0; j<ETHERNET_HEADER_LENGHT; j++ )
-	{
-		buffer[j] = src_ethernet[j];
-	}
-		
-	//copia o ipv4
-	for ( j=0; j<IPV4_HEADER_LENGHT; j++ )
+	if ( slot < 0 )
 	{
-		buffer[j + ETHERNET_HEADER_LENGHT] = src_ipv4[j];
+		printf ("SendIPV4: tx ring full\n");
+		goto done;
 	}
 
-	//copia o udp
-	for ( j=0; j<UDP_HEADER_LENGHT; j++ )
-	{
-		buffer[j + ETHERNET_HEADER_LENGHT +IPV4_HEADER_LENGHT] = src_udp[j];
-	}
-		
-	//copia o xxxdata
-	for ( j=0; j<32; j++ )
-	{
-		buffer[j + ETHERNET_HEADER_LENGHT +IPV4_HEADER_LENGHT + UDP_HEADER_LENGHT] = data[j];
-	}		
-	
-	
-	//len;
-	currentNIC->legacy_tx_descs[old].length = (ETHERNET_HEADER_LENGHT + IPV4_HEADER_LENGHT + UDP_HEADER_LENGHT + 32);		
-	
-	
-	currentNIC->legacy_tx_descs[old].cmd = 0x1B;
-	currentNIC->legacy_tx_descs[old].status = 0;	
+	// ## Copiando o pacote no buffer ##
 	
-	currentNIC->tx_cur = ( currentNIC->tx_cur + 1 ) % 8;
+	memcpy ( (void *) &buffer[0], 
+	    (const void *) eh, ETHERNET_HEADER_LENGHT );
 	
-	*( (volatile unsigned int *)(currentNIC->mem_base + 0x3818)) = currentNIC->tx_cur;	
+	memcpy ( (void *) &buffer[ETHERNET_HEADER_LENGHT], 
+	    (const void *) ipv4, IPV4_HEADER_LENGHT );
 	
+	memcpy ( (void *) &buffer[ETHERNET_HEADER_LENGHT + IPV4_HEADER_LENGHT], 
+	    (const void *) udp, UDP_HEADER_LENGHT );
 	
-	// #debug
-	printf ("sending ipv4 (while)\n");
-	refresh_screen ();	
+	memcpy ( (void *) &buffer[ETHERNET_HEADER_LENGHT + IPV4_HEADER_LENGHT + UDP_HEADER_LENGHT], 
+	    (const void *) data, 32 );
 	
-	//checamos o status do old pra ver se ele foi enviado.
-	//fica travado aqui at que seja envidao.
-	//poderia ter um timemout??.
+	//len;
+	e1000TxCommit ( currentNIC, slot, 
+	    (ETHERNET_HEADER_LENGHT + IPV4_HEADER_LENGHT + UDP_HEADER_LENGHT + 32) );
 	
-	while ( !(currentNIC->legacy_tx_descs[old].status & 0xFF) )
-	{
-		//nothing
-	}
+	// No espera o envio, o descritor  recuperado depois.
+	e1000TxFlush ( currentNIC );
+
+done:
+	free (eh);
+	free (ipv4);
+	free (udp);
 }
 	
 	
@@ -613,14 +699,20 @@ SendARP ( uint8_t source_ip[4],
 	// ====================== ## ETH HEADER ## ====================
 	//
 	
-	eh = (void *) malloc ( sizeof(struct ether_header ) );
+	// ## quem ? ##
+	// Um descritor livre do ring. O frame  montado no buffer dele.
+	
+	unsigned char *buffer;
+	int slot = e1000TxGetBuffer ( currentNIC, &buffer );
 	
-	if ( (void *) eh == NULL)
+	if ( slot < 0 )
 	{
-		printf ("struct eh fail");
-		die ();
+		printf ("SendARP: tx ring full\n");
+		return;
 	}
 	
+	eh = (struct ether_header *) &buffer[0];
+	
 	for( i=0; i<6; i++)
 	{
 		eh->src[i] = currentNIC->mac_address[i];    //source ok
@@ -660,13 +752,7 @@ SendARP ( uint8_t source_ip[4],
 	// ==================== ## ARP ## ==========================
 	//
 
-	h = (void *) malloc ( sizeof(struct  ether_arp) );
-	
-	if ( (void *) h == NULL)
-	{
-		printf ("struct h fail");
-		die ();
-	}
+	h = (struct ether_arp *) &buffer[ETHERNET_HEADER_LENGHT];
 	
     // Hardware type (HTYPE) // (00 01)
 	// Protocol type (PTYPE) //(08 00)	
@@ -726,37 +812,10 @@ SendARP ( uint8_t source_ip[4],
 	//==================================
 	
 	
-	// ## quem ? ##
-	uint16_t old = currentNIC->tx_cur;
-	
-
-	// ## Copiando o pacote no buffer ##
-	
-	//pegando o endereo virtual do buffer na estrutura do dispositivo.	
-	unsigned char *buffer = (unsigned char *) currentNIC->tx_descs_virt[old];
-	
-	unsigned char *src_ethernet = (unsigned char *) eh; 
-	unsigned char *src_arp      = (unsigned char *) h;
-	
-	//copiando o header ethernet
-	//copiando o arp logo aps do header ethernet
-	
-	for (i=0; i<14;i++)
-	{
-		buffer[i] = src_ethernet[i];
-	}
-
-	for (i=0; i<28;i++)
-	{
-		buffer[i + 14] = src_arp[i];
-	}
-	
-
     // Ethernet frame length = ethernet header (MAC + MAC + ethernet type) + ethernet data (ARP header)
 	//O comprimento deve ser o tamanho do header etherne + o tamanho do arp.
 	
 	//len;
-	currentNIC->legacy_tx_descs[old].length = (ETHERNET_HEADER_LENGHT + ARP_HEADER_LENGHT);	
 	//currentNIC->legacy_tx_descs[old].length = 14 + 28;
 	
 	//??
@@ -766,10 +825,8 @@ SendARP ( uint8_t source_ip[4],
 	//currentNIC->legacy_tx_descs[0].cmd = TDESC_CMD_IFCS | TDESC_CMD_RS | TDESC_CMD_EOP;
 	//currentNIC->legacy_tx_descs[0].cmd = TDESC_EOP | TDESC_RS; //intel code
 	
-	currentNIC->legacy_tx_descs[old].cmd = 0x1B;
-	currentNIC->legacy_tx_descs[old].status = 0;	
-	
-	currentNIC->tx_cur = ( currentNIC->tx_cur + 1 ) % 8;
+	e1000TxCommit ( currentNIC, slot, 
+	    (ETHERNET_HEADER_LENGHT + ARP_HEADER_LENGHT) );
 	
 	//??
 	//currentNIC->legacy_tx_descs[0].css
@@ -805,19 +862,10 @@ SendARP ( uint8_t source_ip[4],
 	//*( (volatile unsigned int *)(currentNIC->mem_base + 0x3810)) = 0;
 	//TDT	= 0x3818,	/* Tx Descriptor Tail */
 	
-	*( (volatile unsigned int *)(currentNIC->mem_base + 0x3818)) = currentNIC->tx_cur;	
-
-	//#debug
-	printf ("Sending broadcast arp. (while)\n");
-	refresh_screen ();	
+	//TDT, com e1000TxFlush.
+	//No espera o envio, o descritor  recuperado depois.
 	
-	//checamos o status do old pra ver se ele foi enviado.
-	//fica travado aqui at que seja envidao.
-	//poderia ter um timemout??.
-	while ( !(currentNIC->legacy_tx_descs[old].status & 0xFF) )
-	{
-		//nothing
-	}
+	e1000TxFlush ( currentNIC );
 }
 
 
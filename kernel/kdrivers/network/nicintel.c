@@ -344,6 +344,131 @@ e1000_init_nic ( unsigned char bus,
 }
 
 
+static struct e1000_packet_d *e1000_rx_pool_get ( struct intel_nic_info_d *dev ){
+
+	struct e1000_packet_d *p;
+
+	p = dev->rx_pool_free;
+
+	if ( (void *) p != NULL )
+	{
+		dev->rx_pool_free = p->next;
+		dev->rx_pool_count--;
+		p->next = NULL;
+	}
+
+	return (struct e1000_packet_d *) p;
+}
+
+
+static void 
+e1000_rx_pool_put ( struct intel_nic_info_d *dev, 
+                    struct e1000_packet_d *p )
+{
+	p->len = 0;
+	p->next = dev->rx_pool_free;
+	dev->rx_pool_free = p;
+	dev->rx_pool_count++;
+}
+
+
+/*
+ *******************************************
+ * e1000RxDrain:
+ *     Pega todos os descritores prontos numa passada.
+ *     O pacote de cada descritor é trocado por um pacote livre do 
+ * pool, o RDT é escrito uma vez só para todos, e depois os pacotes 
+ * são entregues ao protocolo (network.c) sem cópia e voltam ao pool.
+ *     Sem pacote livre o frame é descartado e o descritor fica com
+ * o mesmo buffer.
+ *     Retorna quantos frames foram entregues.
+ */
+
+int e1000RxDrain ( struct intel_nic_info_d *dev ){
+
+	struct e1000_packet_d *batch[E1000_RX_RING_SIZE];
+	struct e1000_packet_d *p;
+	struct e1000_packet_d *fresh;
+	struct legacy_rx_desc *d;
+
+	int Count = 0;
+	int Last = -1;
+	int i;
+
+	if ( (void *) dev == NULL )
+		return 0;
+
+	while ( Count < E1000_RX_RING_SIZE )
+	{
+		i = dev->rx_cur;
+		d = &dev->legacy_rx_descs[i];
+
+		if ( (d->status & RDESC_STA_DD) == 0 )
+			break;
+
+		p = dev->rx_packets[i];
+
+		// Frames que ocupam mais de um buffer não são suportados.
+		if ( (d->status & RDESC_STA_EOP) == 0 || d->errors != 0 || d->length == 0 )
+		{
+			dev->rx_errors++;
+
+		}else{
+
+			fresh = e1000_rx_pool_get (dev);
+
+			if ( (void *) fresh == NULL )
+			{
+				dev->rx_drops++;
+
+			}else{
+
+				p->len = d->length;
+				batch[Count] = p;
+				Count++;
+
+				dev->rx_packets[i] = fresh;
+				d->addr = fresh->pa;
+			};
+		};
+
+		d->status = 0;
+		Last = i;
+
+		dev->rx_cur = (uint16_t) ( (i + 1) % E1000_RX_RING_SIZE );
+	};
+
+	// Devolve os descritores ao controlador de uma vez.
+	if ( Last >= 0 )
+	{
+		E1000WriteCommand ( dev, 0x2818, Last );
+	}
+
+	if ( Count > 0 )
+	{
+		dev->rx_batches++;
+
+		if ( Count > dev->rx_max_batch ){
+			dev->rx_max_batch = Count;
+		}
+	}
+
+	for ( i=0; i < Count; i++ )
+	{
+		p = batch[i];
+
+		dev->rx_frames++;
+		dev->rx_bytes += p->len;
+
+		network_handle_frame ( dev, p->data, p->len );
+
+		e1000_rx_pool_put ( dev, p );
+	};
+
+	return (int) Count;
+}
+
+
 /*
  *******************************************
  * xxxe1000handler:
@@ -352,14 +477,6 @@ e1000_init_nic ( unsigned char bus,
 
 void xxxe1000handler (void){
 
-    int i;	
-	
-	//structs
-	struct ipv6_header_d *ipv6_h;
-	struct ether_header *eh;
-	struct ether_arp *arp_h;
-	
-	
 	// #flag !!
 	// Essa flag precisa ser acionada para a rotina funcionar.
 	// F6 tem acionado essa flag.
@@ -380,182 +497,30 @@ void xxxe1000handler (void){
 	//status
 	uint32_t status = E1000ReadCommand ( currentNIC, 0xC0 ); 
 
+	// TX
+	// Recupera os descritores que já foram enviados.
+	if ( status & (E1000_ICR_TXDW | E1000_ICR_TXQE) )
+	{
+		e1000TxReclaim ( currentNIC );
+	}
+
 	// Linkup
-	if (status & 0x04) 
+	if ( status & E1000_ICR_LSC ) 
 	{
 		uint32_t val = E1000ReadCommand ( currentNIC, 0 );
 		
 		E1000WriteCommand ( currentNIC, 0, val | 0x40 );
-		
-		return;
-	
-	} else if (status & 0x80){
-		
-	    //printf("xxxe1000handler: handler for NIC e1000");
-		//printf("e1000 handler ");
-	    //refresh_screen();
-		
-		
-		while ( (currentNIC->legacy_rx_descs[currentNIC->rx_cur].status & 0x01) == 0x01 ) 
-		{
-			uint16_t old = currentNIC->rx_cur;
-			uint32_t len = currentNIC->legacy_rx_descs[old].length;
-			
-			// Our Net layer should handle it
-			//NetHandlePacket(dev->ndev, len, (PUInt8)dev->rx_descs_virt[old]);
-
-			//printf(">"); 
-
-			currentNIC->legacy_rx_descs[old].status = 0;
-			currentNIC->rx_cur = (currentNIC->rx_cur + 1) % 32;
-
-			//??
-			E1000WriteCommand ( currentNIC, 0x2818, old );
-		}
-    };
-
-	//
-	// =================== ## Reagir ## ================================
-	//
-
-
-	//pega o buffer 0 de rx 
-	//unsigned char *buffer = (unsigned char *) currentNIC->rx_descs_virt[0];
-	
-	//#esse funcionou.
-	//unsigned char *buffer = (unsigned char *) currentNIC->rx_descs_virt[1];
+	}
 
-	//#todo
-	//mas vamos tentar ler o rx current
-	unsigned char *buffer = (unsigned char *) currentNIC->rx_descs_virt[old];
-	
-	//
-	// ## eth header ##
-	//
-	
-	//ethernet header
-	eh = (void *) &buffer[0];
-	
-	if ( (void *) eh == NULL )
+	// O ring encheu e o controlador perdeu frames.
+	if ( status & E1000_ICR_RXO )
 	{
-		printf ("nicintel-xxxe1000handler: eh");
-		die ();
+		currentNIC->rx_ring_full++;
 	}
-	
-	//printf("src: ");
-    //for( i=0; i<6; i++)
-	//	printf("%x ",eh->src[i]);
-	
-	//printf("dst: ");
-    //for( i=0; i<6; i++)
-	//	printf("%x ",eh->dst[i]);
-	
-	//printf("type={%x} ",eh->type);
-	
-	//
-	// ## type ##
-	//
-		
-	//printf("+");
-	//refresh_screen();
-	
-	uint16_t type = FromNetByteOrder16(eh->type);
-	
-	switch ( (uint16_t) type)
-	{
-		//0x0800	Internet Protocol version 4 (IPv4)
-		case 0x0800:
-		   //printf("todo: Internet Protocol version 4 (IPv4)\n");
-		   //printf("IPv4 ");
-		   //refresh_screen();
-		   return;
-		   break;
-		   
-		//0x0806	Address Resolution Protocol (ARP)
-		case 0x0806:
-		    //printf("\nARP ");
-			arp_h = (void *) &buffer[14];
-		    //printf("todo: Address Resolution Protocol (ARP) ");
-			if ( arp_h->op == ToNetByteOrder16(ARP_OPC_REPLY) )
-			{
-				//#debug
-				//printf("REPLY received\n");
-	            //printf("src: ");
-                //for( i=0; i<4; i++)
-	            //	printf("%x ",arp_h->arp_spa[i]);
-				//refresh_screen();
-                return;				
-			}
-			if ( arp_h->op == ToNetByteOrder16(ARP_OPC_REQUEST) )
-			{
-				//#debug
-				printf("REQUEST received ");
-                for( i=0; i<6; i++){ printf("%x ",eh->src[i]); }
-                printf(" | ");
-				for( i=0; i<6; i++){ printf("%x ",eh->dst[i]); }
-                printf(" | ");
-				for( i=0; i<4; i++){ printf("%d ",arp_h->arp_spa[i]); }
-				 printf(" | ");
-				for( i=0; i<4; i++){ printf("%d ",arp_h->arp_tpa[i]); }
-				//refresh_screen();
-				//cache
-				for (i=0; i<32; i++)
-				{
-				    //livre
-					if ( currentNIC->arp_cache[i].used == 1 && currentNIC->arp_cache[i].magic == 1234 )
-					{
-						//compara o ip
-					    if ( strncmp( (char *) &currentNIC->arp_cache[i].ipv4_address[0], (char *) &arp_h->arp_spa[0], 4 ) == 0 )
-						{
-							memcpy ( (void*) &currentNIC->arp_cache[i].mac_address[0] , (const void *) &eh->src[0], 6);
-							
-							//sinaliza que está em uso.
-							currentNIC->arp_cache[i].magic = 4321;
-						}
-							
-					}
-				}
-				
-				uint16_t arp_tx_old = currentNIC->tx_cur;
-			    uint32_t arp_tx_len = currentNIC->legacy_tx_descs[arp_tx_old].length;
-			
-				//muda para REPLAY.
-				arp_h->op = ToNetByteOrder16(ARP_OPC_REPLY);
-
-				//reenvia os mesmos dados, mas modificados para replay.
-				//essa rotina vai copiar de um buffer para outro.
-			    E1000Send ( (void *) currentNIC, (uint32_t) arp_tx_len, (uint8_t *) &buffer[0]);
-
-				printf("\n");
-				refresh_screen();
-				return;
-			} 
-		    return;
-			break;
 
-		//0x86DD	Internet Protocol Version 6 (IPv6)
-		case 0x86DD:
-			//printf("IPv6 ");
-		    ipv6_h = (void *) &buffer[14];
-		    //
-			handle_ipv6 ( (struct intel_nic_info_d *) currentNIC, 
-			    (struct ipv6_header_d *) ipv6_h );
-			//refresh_screen();
-			return;	
-		    break;
-
-		default:
-		    //printf("default ethernet type\n");
-		    //refresh_screen();
-			return;
-			break;
-	};
-
-	//printf("\n");
-	//refresh_screen();
-	//while(1){}
-	
-	return;
+	// RX
+	// Mesmo sem a causa, descritores prontos são recolhidos.
+	e1000RxDrain ( currentNIC );
 }
 
 
@@ -697,14 +662,16 @@ int e1000_reset_controller (void){
 	//tx
 	//i já foi declarado
 	
-	for ( i=0; i < 8; i++ ) 
+	for ( i=0; i < E1000_TX_RING_SIZE; i++ ) 
 	{
 		// Alloc the phys/virt address of this transmit desc
 		// alocamos memória para o buffer, salvamos o endereço físico do buffer e 
         //obtemos o endereço virtual do buffer.		
-		currentNIC->legacy_tx_descs[i].addr = E1000AllocCont ( 0x3000, &currentNIC->tx_descs_virt[i] );		
+		currentNIC->legacy_tx_descs[i].addr = E1000AllocCont ( E1000_TX_BUFFER_SIZE, &currentNIC->tx_descs_virt[i] );		
 		currentNIC->legacy_tx_descs[i].addr2 = 0;
 		
+		currentNIC->tx_ready[i] = 0;
+		
 		// We failed, unmap everything
 		
 		if (currentNIC->legacy_tx_descs[i].addr == 0) 
@@ -727,12 +694,12 @@ int e1000_reset_controller (void){
         //IFCS (bit 1) - Insert FCS (CRC)
         //EOP (bit 0) - End of packet		
 		currentNIC->legacy_tx_descs[i].cmd = 0;
-		currentNIC->legacy_tx_descs[i].status = 1;
+		currentNIC->legacy_tx_descs[i].status = TDESC_STA_DD;
 	};	
 
 	//#debug 
 	//Vamos imprimir os endereços usados pelos buffers para teste.	
-	//for ( i=0; i < 8; i++ )
+	//for ( i=0; i < E1000_TX_RING_SIZE; i++ )
     //    printf ("PA={%x} VA={%x} \n",currentNIC->legacy_tx_descs[i].addr, currentNIC->tx_descs_virt[i]);
 	
 	
@@ -762,30 +729,46 @@ int e1000_reset_controller (void){
 	//rx
 	//i já foi declarado
 	
-	for ( i=0; i < 32; i++ ) 
+	// Pool de pacotes.
+	
+	currentNIC->rx_pool_free = NULL;
+	currentNIC->rx_pool_count = 0;
+	
+	for ( i=0; i < E1000_RX_POOL_SIZE; i++ ) 
 	{
-		// Alloc the phys/virt address of this transmit desc
-		currentNIC->legacy_rx_descs[i].addr = E1000AllocCont ( 0x3000, (uint32_t *) &currentNIC->rx_descs_virt[i] );		
-		currentNIC->legacy_rx_descs[i].addr2 = 0;
+		uint32_t pool_va;
 		
-		// We failed, unmap everything
-		if (currentNIC->legacy_rx_descs[i].addr == 0) 
-		{
-			
-		    printf ("e1000_reset_controller: dev->rx_descs[i].addr fail");
-			
-		    refresh_screen ();
-		    while (1){};	
-		}
+		currentNIC->rx_pool[i].pa = E1000AllocCont ( E1000_RX_BUFFER_SIZE, &pool_va );
+		currentNIC->rx_pool[i].data = (unsigned char *) pool_va;
+		
+		e1000_rx_pool_put ( currentNIC, &currentNIC->rx_pool[i] );
+	};
+	
+	// Um pacote para cada descritor.
+	
+	for ( i=0; i < E1000_RX_RING_SIZE; i++ ) 
+	{
+		currentNIC->rx_packets[i] = e1000_rx_pool_get (currentNIC);
+		
+		currentNIC->legacy_rx_descs[i].addr = currentNIC->rx_packets[i]->pa;		
+		currentNIC->legacy_rx_descs[i].addr2 = 0;
 		
 		currentNIC->legacy_rx_descs[i].status = 0;
 	};	
 
+	currentNIC->rx_frames = 0;
+	currentNIC->rx_bytes = 0;
+	currentNIC->rx_drops = 0;
+	currentNIC->rx_errors = 0;
+	currentNIC->rx_ring_full = 0;
+	currentNIC->rx_batches = 0;
+	currentNIC->rx_max_batch = 0;
+
 	//#debug 
 	//Vamos imprimir os endereços edereços físicos dos buffers 
 	//e os edereços virtuais dos descritores.
-	//for ( i=0; i < 32; i++ )
-    //    printf ("PA={%x} VA={%x} \n",currentNIC->legacy_rx_descs[i].addr, currentNIC->rx_descs_virt[i]);
+	//for ( i=0; i < E1000_RX_RING_SIZE; i++ )
+    //    printf ("PA={%x} VA={%x} \n",currentNIC->legacy_rx_descs[i].addr, currentNIC->rx_packets[i]->data);
 	
 	
 	//
@@ -800,6 +783,7 @@ int e1000_reset_controller (void){
 	}
 	
 	currentNIC->rx_cur = currentNIC->tx_cur = 0;
+	currentNIC->tx_clean = currentNIC->tx_tail = 0;
 	
 	//irq #todo
 	//PCIRegisterIRQHandler ( bus, dev, fun, (unsigned long) E1000Handler, currentNIC );
@@ -841,7 +825,8 @@ int e1000_reset_controller (void){
 	//0xD0 Message Control (0x0080) Next Pointer (0xE0) Capability ID (0x05)
 	//    0000 0001  1111 0111  0000   0010  1101   0111
 	//0x1F6DC, 1f72d7
-	E1000WriteCommand (currentNIC, 0xD0, 0x1F6DC);
+	// + TXDW, os descritores enviados são recuperados na interrupção.
+	E1000WriteCommand (currentNIC, 0xD0, 0x1F6DC | E1000_ICR_TXDW);
 	
 	//?
 	//E1000WriteCommand(currentNIC, 0xD0, 0xFB);
@@ -857,10 +842,13 @@ int e1000_reset_controller (void){
 	
 	E1000WriteCommand (currentNIC, 0x2800, currentNIC->rx_descs_phys );  // low
 	E1000WriteCommand (currentNIC, 0x2804, 0);                           // high 
-	E1000WriteCommand (currentNIC, 0x2808, 512);                         // 32*16
-	E1000WriteCommand (currentNIC, 0x2810, 0);         // head
-	E1000WriteCommand (currentNIC, 0x2818, 31);        // tail
-	E1000WriteCommand (currentNIC, 0x100, 0x602801E);  // RCTL	= 0x0100,	/* Receive Control */
+	E1000WriteCommand (currentNIC, 0x2808, E1000_RX_RING_SIZE * 16);     // 128*16
+	E1000WriteCommand (currentNIC, 0x2810, 0);                           // head
+	E1000WriteCommand (currentNIC, 0x2818, E1000_RX_RING_SIZE -1);       // tail
+	
+	// RCTL	= 0x0100,	/* Receive Control */
+	// EN SBP UPE MPE BAM SECRC, BSIZE = 2048. (era 0x602801E, 4096)
+	E1000WriteCommand (currentNIC, 0x100, 0x400801E);
 	
 	
 	// ## TX ##
@@ -875,7 +863,7 @@ int e1000_reset_controller (void){
 	E1000WriteCommand (currentNIC, 0x3800, currentNIC->tx_descs_phys );	//low (endereço do ring)							
 	E1000WriteCommand (currentNIC, 0x3804, 0);                           //high
 	
-	E1000WriteCommand (currentNIC, 0x3808, 128);                         //8*16
+	E1000WriteCommand (currentNIC, 0x3808, E1000_TX_RING_SIZE * 16);     //64*16
 	E1000WriteCommand (currentNIC, 0x3810, 0);  //head
 	E1000WriteCommand (currentNIC, 0x3818, 0);  //tail
 	
@@ -1072,74 +1060,239 @@ void NetSendEthPacket ( PNetworkDevice dev,
 */
 
  
-//dispositivo, tamanho, dados a serem copiados no buffer.
-void E1000Send ( void *ndev, uint32_t len, uint8_t *data ){
-	
-	//printf("E1000Send: GO!!! \n");
-	//refresh_screen();	
-	
-	//
-	// ## dev ##
-	//
-	
-	struct intel_nic_info_d *dev = (struct intel_nic_info_d *) ndev;
-	
+static spinlock_t e1000_tx_spinlock;
+
+
+static unsigned long e1000_tx_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &e1000_tx_spinlock );
+}
+
+
+static void e1000_tx_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &e1000_tx_spinlock, flags );
+}
+
+
+static int e1000_tx_next ( int i ){
+
+	return (int) ( (i + 1) % E1000_TX_RING_SIZE );
+}
+
+
+/*
+ * e1000TxReclaim:
+ *     Recupera os descritores que o controlador já enviou. (DD)
+ *     É chamada na interrupção e quando o ring está cheio.
+ *     Retorna quantos descritores foram recuperados.
+ */
+
+int e1000TxReclaim ( struct intel_nic_info_d *dev ){
+
+	unsigned long Flags;
+	int i;
+	int Count = 0;
+
 	if ( (void *) dev == NULL )
-		return;
-	
-	//
-	// ## quem ? ##
-	//
-	
-	uint16_t old = dev->tx_cur;
-	
-	
-	// ## Copiando o pacote no buffer ##
-	//com base no comprimento indicado no argmento.
-	//pegando o endereço virtual do buffer na estrutura do dispositivo.	
+		return 0;
 
-	unsigned char *buffer = (unsigned char *) currentNIC->tx_descs_virt[old];
-	unsigned char *src_data = (unsigned char *) data; 	
+	Flags = e1000_tx_lock ();
 
-	if(len==0)
-		return;	
-	
-	uint32_t i;
-	
-	//copiando o header ethernet
-	for (i=0; i<len; i++)
+	while ( dev->tx_clean != dev->tx_tail )
 	{
-		buffer[i] = src_data[i];
-	}	
-	
-	
-	
-	//void *memcpy(void *v_dst, const void *v_src, unsigned long c);
-	//StrCopyMemory((PUInt8)(dev->tx_descs_virt[old]), data, len);
-	
-	//memcpy( (void *)(dev->tx_descs_virt[old]), (const void *) data, (unsigned long) len);
-	
-	
-    dev->legacy_tx_descs[old].length = len;
+		i = dev->tx_clean;
 
-	dev->legacy_tx_descs[old].cmd = 0x1B;
-	dev->legacy_tx_descs[old].status = 0;	
-	
-	dev->tx_cur = ( dev->tx_cur + 1 ) % 8;
-	
-	*( (volatile unsigned int *)(dev->mem_base + 0x3818)) = dev->tx_cur;	
+		if ( (dev->legacy_tx_descs[i].status & TDESC_STA_DD) == 0 )
+			break;
 
-	//#debug
-	printf("sending broadcast arp(while)\n");
-	refresh_screen();	
-		
-	while ( !(dev->legacy_tx_descs[old].status & 0xFF) )
+		dev->tx_ready[i] = 0;
+		dev->tx_clean = (uint16_t) e1000_tx_next (i);
+
+		Count++;
+	};
+
+	e1000TxReclaimed += Count;
+
+	e1000_tx_unlock (Flags);
+
+	return (int) Count;
+}
+
+
+/* Descritores livres no ring. Um fica sempre vazio. */
+
+int e1000TxFreeCount ( struct intel_nic_info_d *dev ){
+
+	int Used;
+
+	if ( (void *) dev == NULL )
+		return 0;
+
+	Used = ( dev->tx_cur - dev->tx_clean + E1000_TX_RING_SIZE ) % E1000_TX_RING_SIZE;
+
+	return (int) ( E1000_TX_RING_SIZE - 1 - Used );
+}
+
+
+/*
+ * e1000TxGetBuffer:
+ *     Reserva um descritor e entrega o seu buffer, o chamador
+ * monta o frame nele, sem cópia, e chama e1000TxCommit().
+ *     Retorna o descritor ou -1 se o ring está cheio.
+ */
+
+int 
+e1000TxGetBuffer ( struct intel_nic_info_d *dev, 
+                   unsigned char **buffer )
+{
+	unsigned long Flags;
+	int Slot;
+
+	if ( (void *) dev == NULL || (void *) buffer == NULL )
+		return -1;
+
+	// Recupera só quando precisa.
+	if ( e1000TxFreeCount (dev) == 0 )
 	{
-		//nothing
+		e1000TxReclaim (dev);
 	}
+
+	Flags = e1000_tx_lock ();
+
+	if ( e1000TxFreeCount (dev) == 0 )
+	{
+		e1000TxDropped++;
+		e1000_tx_unlock (Flags);
+		return -1;
+	}
+
+	Slot = dev->tx_cur;
+
+	dev->tx_ready[Slot] = 0;
+	dev->tx_cur = (uint16_t) e1000_tx_next (Slot);
+
+	e1000_tx_unlock (Flags);
+
+	*buffer = (unsigned char *) dev->tx_descs_virt[Slot];
+
+	return (int) Slot;
+}
+
+
+/*
+ * e1000TxCommit:
+ *     O frame do descritor reservado está pronto.
+ *     Ele só vai para o controlador no próximo e1000TxFlush(), 
+ * assim vários frames usam uma só escrita no TDT.
+ */
+
+int 
+e1000TxCommit ( struct intel_nic_info_d *dev, 
+                int slot, 
+                uint32_t len )
+{
+	if ( (void *) dev == NULL )
+		return -1;
+
+	if ( slot < 0 || slot >= E1000_TX_RING_SIZE )
+		return -1;
+
+	dev->legacy_tx_descs[slot].length = (uint16_t) len;
+	dev->legacy_tx_descs[slot].cmd = E1000_TX_CMD;
+	dev->legacy_tx_descs[slot].status = 0;
+
+	dev->tx_ready[slot] = 1;
+
+	e1000TxQueued++;
+
+	return 0;
+}
+
+
+/*
+ * e1000TxFlush:
+ *     Entrega ao controlador os frames prontos, com uma escrita no TDT.
+ *     Para no primeiro descritor reservado que ainda não está pronto.
+ */
+
+void e1000TxFlush ( struct intel_nic_info_d *dev ){
+
+	unsigned long Flags;
+	uint16_t Tail;
+
+	if ( (void *) dev == NULL )
+		return;
+
+	Flags = e1000_tx_lock ();
+
+	Tail = dev->tx_tail;
+
+	while ( Tail != dev->tx_cur && dev->tx_ready[Tail] == 1 )
+	{
+		Tail = (uint16_t) e1000_tx_next (Tail);
+	};
+
+	if ( Tail != dev->tx_tail )
+	{
+		dev->tx_tail = Tail;
+
+		*( (volatile unsigned int *)(dev->mem_base + 0x3818)) = Tail;
+
+		e1000TxDoorbells++;
+	}
+
+	e1000_tx_unlock (Flags);
+}
+
+
+/*
+ * e1000TxQueue:
+ *     Copia o frame para o buffer de um descritor.
+ *     Não escreve no TDT. (e1000TxFlush)
+ */
+
+int 
+e1000TxQueue ( struct intel_nic_info_d *dev, 
+               uint32_t len, 
+               uint8_t *data )
+{
+	unsigned char *buffer;
+	int Slot;
+
+	if ( len == 0 || len > E1000_TX_BUFFER_SIZE )
+		return -1;
+
+	Slot = e1000TxGetBuffer ( dev, &buffer );
+
+	if ( Slot < 0 )
+		return -1;
+
+	memcpy ( (void *) buffer, (const void *) data, (unsigned long) len );
+
+	return (int) e1000TxCommit ( dev, Slot, len );
+}
+
+
+/*
+ * E1000Send:
+ *     Dispositivo, tamanho, dados a serem copiados no buffer.
+ *     Coloca o frame no ring e escreve no TDT. Não espera o envio,
+ * o descritor é recuperado depois. Se o ring está cheio o frame 
+ * é descartado.
+ */
+
+void E1000Send ( void *ndev, uint32_t len, uint8_t *data ){
+	
+	struct intel_nic_info_d *dev = (struct intel_nic_info_d *) ndev;
+	
+	if ( (void *) dev == NULL )
+		return;
 	
-	printf ("E1000Send: done\n");
-	refresh_screen ();	
+	if ( e1000TxQueue ( dev, len, data ) < 0 )
+		return;
+
+	e1000TxFlush (dev);
 }
 
 
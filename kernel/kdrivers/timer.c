@@ -149,344 +149,1244 @@ void timerDisableTextCursor (void){
 }
 	
 
+//
+// ## timer wheel ##
+//
+
+// Nvel 0, um slot por tick.
+static struct timer_d *timer_wheel_root[TIMER_WHEEL_ROOT_SIZE];
+
+// Nveis 1~3.
+static struct timer_d *timer_wheel_levels[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE];
+
+// O prximo tick que a roda vai processar.
+static unsigned long timer_wheel_ticks;
+
+// Os timers do slot que est sendo processado. (timer_wheel_run)
+static struct timer_d *timer_wheel_expiring;
+
+static int timer_next_id;
+
+
+// A roda  compartilhada pelas cpus. (smp.h)
+static spinlock_t timer_spinlock;
+
+
+static unsigned long timer_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &timer_spinlock );
+}
+
+
+static void timer_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &timer_spinlock, flags );
+}
+
+
+/*
+ * timer_wheel_add:
+ *     Coloca o timer no slot do seu deadline.
+ *     Quanto mais longe o deadline, mais alto o nvel.
+ */
+
+static void timer_wheel_add ( struct timer_d *t ){
+
+	struct timer_d **Bucket;
+	unsigned long Expires;
+	unsigned long Delta;
+	int Shift;
+	int Level;
+
+	Expires = t->expires;
+	Delta = ( Expires - timer_wheel_ticks );
+
+	// J passou. Vai no prximo tick.
+	if ( (long) Delta < 0 )
+	{
+		Expires = timer_wheel_ticks;
+		Delta = 0;
+	}
+
+	if ( Delta > TIMER_WHEEL_MAX_TICKS )
+	{
+		Delta = TIMER_WHEEL_MAX_TICKS;
+		Expires = ( timer_wheel_ticks + Delta );
+	}
+
+	if ( Delta < TIMER_WHEEL_ROOT_SIZE )
+	{
+		Bucket = &timer_wheel_root[ Expires & TIMER_WHEEL_ROOT_MASK ];
+
+	}else{
+
+		Level = 0;
+		Shift = TIMER_WHEEL_ROOT_BITS;
+
+		while ( Level < (TIMER_WHEEL_LEVELS -1) && 
+		        Delta >= (1UL << (Shift + TIMER_WHEEL_LEVEL_BITS)) )
+		{
+			Level++;
+			Shift += TIMER_WHEEL_LEVEL_BITS;
+		};
+
+		Bucket = &timer_wheel_levels[Level][ (Expires >> Shift) & TIMER_WHEEL_LEVEL_MASK ];
+	};
+
+	t->prev = NULL;
+	t->next = *Bucket;
+
+	if ( (void *) t->next != NULL ){
+		t->next->prev = t;
+	}
+
+	*Bucket = t;
+	t->bucket = Bucket;
+
+	timerPending++;
+}
+
+
+static void timer_wheel_remove ( struct timer_d *t ){
+
+	if ( (void *) t->bucket == NULL ){
+		return;
+	}
+
+	if ( (void *) t->prev != NULL ){
+		t->prev->next = t->next;
+	}else{
+		*(t->bucket) = t->next;
+	};
+
+	if ( (void *) t->next != NULL ){
+		t->next->prev = t->prev;
+	}
+
+	t->next = NULL;
+	t->prev = NULL;
+	t->bucket = NULL;
+
+	timerPending--;
+}
+
+
+/*
+ * timer_wheel_cascade:
+ *     Redistribui um slot de um nvel alto. Os timers descem 
+ * para os nveis de baixo.
+ *     Retorna o ndice do slot, 0 = o nvel tambm deu a volta.
+ */
+
+static int timer_wheel_cascade ( int level ){
+
+	struct timer_d *List;
+	struct timer_d *t;
+	int Index;
+
+	Index = (int) ( ( timer_wheel_ticks >> (TIMER_WHEEL_ROOT_BITS + level * TIMER_WHEEL_LEVEL_BITS) ) 
+	                & TIMER_WHEEL_LEVEL_MASK );
+
+	List = timer_wheel_levels[level][Index];
+	timer_wheel_levels[level][Index] = NULL;
+
+	while ( (void *) List != NULL )
+	{
+		t = List;
+		List = t->next;
+
+		t->bucket = NULL;
+		timerPending--;
+
+		timer_wheel_add (t);
+		timerCascaded++;
+	};
+
+	return (int) Index;
+}
+
+
+// O que a thread dona recebe. Copiado com o lock, entregue sem ele.
+struct timer_event_d
+{
+	int type;
+	struct thread_d *thread;
+	struct window_d *window;
+	unsigned long times;
+	int status;
+};
+
+
+/*
+ * timer_expire:
+ *     O deadline chegou. Com o lock.
+ *     Tira o timer da roda, o intermitente volta para ela, e copia 
+ * o evento. Retorna 0 se no tem o que entregar.
+ */
+
+static int timer_expire ( struct timer_d *t, struct timer_event_d *event ){
+
+	timer_wheel_remove (t);
+
+	timerExpired++;
+
+	if ( (void *) t->thread == NULL ){
+		return 0;
+	}
+
+	if ( t->thread->used != 1 || t->thread->magic != 1234 ){
+		return 0;
+	}
+
+	event->type = t->type;
+	event->thread = t->thread;
+	event->window = t->window;
+
+	if ( t->type == TIMER_TYPE_SLEEP ){
+		return (int) 1;
+	}
+
+	t->times++;
+
+	// long1: quantas vezes esse timer se esgotou.
+	event->times = t->times;
+	event->status = t->status;
+
+	// Intermitente, volta para a roda.
+	if ( t->type == TIMER_TYPE_PERIODIC )
+	{
+		t->expires += (unsigned long) t->initial_count_down;
+		timer_wheel_add (t);
+	}
+
+	return (int) 1;
+}
+
+
+/*
+ * timer_deliver:
+ *     Sem o lock. A thread acorda se estava dormindo, ou recebe 
+ * MSG_TIMER.
+ */
+
+static void timer_deliver ( struct timer_event_d *event ){
+
+	if ( event->type == TIMER_TYPE_SLEEP )
+	{
+		wakeup_thread_reason ( event->thread->tid, WAIT_REASON_SLEEP );
+		return;
+	}
+
+	msgqPostMessage ( event->thread, event->window, MSG_TIMER,
+	    event->times, event->status );
+}
+
+
+/*
+ * timer_wheel_run:
+ *     Processa os ticks que passaram.
+ *     S o slot do tick atual  visitado, os nveis altos s 
+ * quando o nvel 0 d a volta.
+ *     A roda muda com o lock. O slot vai para a lista 
+ * timer_wheel_expiring e os timers saem dela um por vez. O evento 
+ *  entregue sem o lock. Um timer ainda na lista pode ser removido 
+ * por outro caminho, (destroy_timer) o bucket dele aponta para ela.
+ */
+
+static void timer_wheel_run (void){
+
+	struct timer_event_d Event;
+	struct timer_d *t;
+	unsigned long Flags;
+	int Index;
+	int Level;
+
+	Flags = timer_lock ();
+
+	while ( (long) (sys_time_ticks_total - timer_wheel_ticks) >= 0 )
+	{
+		Index = (int) ( timer_wheel_ticks & TIMER_WHEEL_ROOT_MASK );
+
+		if ( Index == 0 )
+		{
+			for ( Level=0; Level < TIMER_WHEEL_LEVELS; Level++ )
+			{
+				if ( timer_wheel_cascade (Level) != 0 ){
+					break;
+				}
+			};
+		}
+
+		timer_wheel_ticks++;
+
+		timer_wheel_expiring = timer_wheel_root[Index];
+		timer_wheel_root[Index] = NULL;
+
+		for ( t = timer_wheel_expiring; (void *) t != NULL; t = t->next ){
+			t->bucket = &timer_wheel_expiring;
+		};
+
+		while ( (void *) timer_wheel_expiring != NULL )
+		{
+			if ( timer_expire ( timer_wheel_expiring, &Event ) == 0 ){
+				continue;
+			}
+
+			timer_unlock (Flags);
+
+			timer_deliver (&Event);
+
+			Flags = timer_lock ();
+		};
+	};
+
+	timer_unlock (Flags);
+}
+
+
+/*
+ * timer_bottom_half:
+ *     O trabalho adiado das irqs no fim do tick. (defer.c)
+ *     Mandamos o EOI antes, ento o mouse, o teclado e o disco podem
+ * interromper o trabalho. A irq0 fica mascarada, ela recarrega a pilha
+ * em que estamos (hw.asm) e a troca de tarefa no pode acontecer aqui.
+ */
+
+static void timer_bottom_half (void){
+
+	unsigned char Mask;
+
+	if ( deferIsPending () == 0 ){
+		return;
+	}
+
+	Mask = (unsigned char) inportb (0x21);
+	outportb ( 0x21, Mask | 0x01 );
+
+	outportb ( 0x20, 0x20 );
+	timer_eoi_sent = 1;
+
+	__asm__ __volatile__ ( "sti" : : : "memory" );
+
+	deferRun (0);
+
+	__asm__ __volatile__ ( "cli" : : : "memory" );
+
+	outportb ( 0x21, Mask );
+}
+
+
+/*
+ *****************************************************
+ * timer: 
+ *     Handler chamado pelo ISR do timer (IRQ 0).
+ *     (Contagem de tempo, tempo das tarefas, 
+ * quantum ...).
+ *     (tick tick tick)
+ */
+
+void timer (void){
+	
+	//
+	// ## ticks total ##
+	//
+	
+    //Contador de ticks.
+	//Incrementa o Tempo total de funcionamento do kernel.
+	
+    sys_time_ticks_total++;	
+
+	//
+	// ## sys time ##
+	//
+	
+	//Mais 10ms para um sistema funcionando a 100HZ
+    //sys_time_ms = sys_time_ms + 10;
+	
+	sys_time_ms = (unsigned long) sys_time_ms + (1000/sys_time_hz);	
+
+	
+	//
+	// ## threads time ##
+	//
+
+	//Atribui um nmero de request a ser atendido futuramente.
+	//Tratar o tempo das tarefas de acordo com o tipo.
+	//#obs: Isso poderia ser usado para atualizar o time dos processos.
+	
+	//#suspenso
+	//estou repensando isso.
+	
+	//kernel_request = KR_TIME;  
+	
+	
+	//
+	//  ## extra ## 
+	//
+	
+	// Aciona uma flag para que o ts.c realize atividades extras,
+	// como gc, dead thread collector, request.
+	
+	if ( sys_time_ticks_total % 100 == 0 )
+	{
+		extra = 1;
+	}
+
+	
+	//
+	// ## buffer cache ##
+	//
+	
+	// Pede a gravao dos setores sujos do cache.
+	// A gravao  trabalho adiado, fora da interrupo. (bcache.c)
+	
+	if ( sys_time_ticks_total % BCACHE_SYNC_TICKS == 0 )
+	{
+		bcacheSyncRequest ();
+	}
+
+
+	//
+	// ## screen ##
+	//
+	
+	// Trabalho adiado das irqs, se a idle no fez. (defer.c)
+	// Antes da tela, para o que ele pintar sair neste tick.
+	
+	timer_bottom_half ();
+	
+	// Copia os retngulos sujos que esperam pelo deadline. (damage.c)
+	
+	damageTimer ();
+
+
+	//
+	// ## mouse blink ##
+	//
+		
+	//#todo rever isso.
+	//de tempos em tempos atualiza o cursor
+	//a cada segundo. sendo ele 100 ou 1000 ... tanto faz.
+	//#todo: mas poderia ser exatamente o hz configurado par ao mouse
+	//if ( sys_time_ticks_total % mouse_cursor_hz == 0 )
+	//if ( sys_time_ticks_total % sys_time_hz == 0 )	
+	if ( sys_time_ticks_total % 70 == 0 )
+	{
+		//Se o cursor piscante est habilitado.
+		//Essa flag  acionada pelo aplicativo.
+		if (timerShowTextCursor == 1)
+		{
+			// O cursor de texto  um sprite, o LFB muda em spriteTimer.
+			// Assim o ponteiro do mouse no  apagado. (sprite.h)
+			if ( spriteIsReady (SPRITE_TEXT_CURSOR) == 1 )
+			{
+				spriteMove ( SPRITE_TEXT_CURSOR, (g_cursor_x + 1) * 8, g_cursor_y*8 );
+
+				if ( timerTextCursorStatus != 1 ){
+					spriteShow ( SPRITE_TEXT_CURSOR, 0 );
+					timerTextCursorStatus = 1;
+				}else{
+					spriteShow ( SPRITE_TEXT_CURSOR, 1 );
+					timerTextCursorStatus = 0;
+				};
+
+				goto mouseExit;
+			}
+
+		    if ( timerTextCursorStatus != 1 )
+		    { 
+	            //apaga
+	            refresh_rectangle ( (g_cursor_x + 1)  *8, g_cursor_y*8, 16, 16 );	
+                timerTextCursorStatus = 1;
+		        goto mouseExit;
+		    }
+	
+		    if ( timerTextCursorStatus == 1 )
+            {			
+		        //acende
+                bmpDisplayCursorBMP ( cursorIconBuffer, (g_cursor_x + 1) * 8, g_cursor_y*8 );		
+		        timerTextCursorStatus = 0;
+			    goto mouseExit;
+		    }
+		};
+	};
+
+	// Desabilitado pelo aplicativo.
+	if ( timerShowTextCursor != 1 ){
+		spriteShow ( SPRITE_TEXT_CURSOR, 0 );
+	}
+	
+mouseExit:	
+
+	// Os sprites que esperavam pelo tick. (sprite.c)
+	
+	spriteTimer ();
+
+	//
+	// ## timers ##
+	//
+	
+	// Os timers que se esgotaram neste tick mandam uma mensagem 
+	// para a thread de input da janela  qual pertencem, ou acordam 
+	// a thread que dormia. No percorremos mais todos os timers.
+	
+	timer_wheel_run ();
+	
+
+done:
+    	
+	//#todo
+	//if(time_out > 0){
+	//	time_out--;
+	//};
+	
+	return;
+};
+
+
+
+// Os timers no ficam mais numa lista de 32, 
+// o id  s um nmero.
+
+int new_timer_id (void){
+	
+    unsigned long Flags;
+	int ID;
+	
+	Flags = timer_lock ();
+	
+	ID = timer_next_id++;
+	
+	if ( timer_next_id < 0 ){
+		timer_next_id = 0;
+	}
+	
+	timer_unlock (Flags);
+	
+	return (int) ID;
+}
+
+
+/*
+ * create_timer:
+ *     O timer vai para a roda e manda MSG_TIMER para a thread de 
+ * controle da janela quando se esgota.
+ *     1 = one shot, 2 = intermitente.
+ */
+
+struct timer_d *create_timer ( struct window_d *window, 
+                               unsigned long ms, 
+							   int type  )
+{
+    struct timer_d *t;	
+	unsigned long Ticks;
+	unsigned long Flags;
+	
+	//limits
+	//limite de 1 tick.
+	
+	if (ms < (1000/sys_time_hz) )
+	{
+		printf("create_timer: ajust ms\n");
+		ms = (1000/sys_time_hz);
+	}
+	
+	if ( type < 1 || type > 10 || type == TIMER_TYPE_SLEEP )
+	{
+		printf("create_timer: type fail\n");
+		
+		//#debug
+		refresh_screen();
+		
+		return NULL;
+	}
+	
+	//thread.
+		
+	if ( (void *) window == NULL )
+	{
+	    printf("create_timer: window fail \n");
+	    //#debug
+	    refresh_screen();
+		
+		return NULL;	
+	}
+	
+	if ( window->used != 1 || window->magic != 1234 )
+	{
+	    printf("create_timer: window validation fail \n");
+	    //#debug
+	    refresh_screen();
+		
+		return NULL;	
+	}
+	
+	if ( (void *) window->control == NULL )
+	{
+	    printf("create_timer: thread fail \n");
+	    //#debug
+	    refresh_screen();
+		
+		return NULL;
+	}
+	
+	if ( window->control->used != 1 || window->control->magic != 1234 )
+	{
+	    printf("create_timer: thread validation fail \n");
+	    //#debug
+	    refresh_screen();
+		
+		return NULL;	
+	}
+	
+	
+	t = (void *) malloc ( sizeof(struct timer_d) );
+	
+	if ( (void *) t == NULL )
+	{
+		printf("create_timer: t fail \n");
+		//#debug
+		refresh_screen();
+		
+		return NULL; 
+	}
+	
+	
+	t->id = new_timer_id ();
+	
+	t->used = 1;
+	t->magic = 1234;
+	
+	// ms/(ms por tick)
+	Ticks = (unsigned long) ( ms / (1000/sys_time_hz) );
+	
+	t->initial_count_down = (int) Ticks;
+	t->count_down = (int) Ticks;
+	
+	//1 = one shot 
+	//2 = intermitent
+	t->type = (int) type;
+	
+	t->process = NULL;
+	t->times = 0;
+	t->status = 0;
+	t->flag = 0;
+	t->error = 0;
+	
+	//#importante 
+	//agora o timer tem uma thread para enviar mensagens.
+	//quando o tempo se esgotar.
+	
+	t->window = window;
+	t->thread = (struct thread_d *) window->control;	
+	
+	t->next = NULL;
+	t->prev = NULL;
+	t->bucket = NULL;
+	
+	Flags = timer_lock ();
+	
+	t->expires = ( sys_time_ticks_total + Ticks );
+	timer_wheel_add (t);
+	
+	timer_unlock (Flags);
+	
+	
+    printf("create_timer: done \n");
+	//#debug
+	refresh_screen();	
+	
+    return (struct timer_d *) t;	
+};
+
+
+/*
+ * destroy_timer:
+ *     Tira o timer da roda e libera a estrutura.
+ */
+
+int destroy_timer ( struct timer_d *timer ){
+	
+	unsigned long Flags;
+	
+	if ( (void *) timer == NULL ){
+		return (int) -1;
+	}
+	
+	if ( timer->used != 1 || timer->magic != 1234 ){
+		return (int) -1;
+	}
+	
+	if ( timer->type == TIMER_TYPE_SLEEP ){
+		return (int) -1;
+	}
+	
+	Flags = timer_lock ();
+	
+	timer_wheel_remove (timer);
+	
+	timer->used = 0;
+	timer->magic = 0;
+	
+	timer_unlock (Flags);
+	
+	free (timer);
+	
+	return 0;
+}
+
+
+//
+// ## sleep ##
+//
+
+
+/*
+ * timerInitThread:
+ *     O timer de sleep da thread comea fora da roda.
+ */
+
+void timerInitThread ( struct thread_d *thread ){
+	
+	struct timer_d *t;
+	
+	if ( (void *) thread == NULL ){
+		return;
+	}
+	
+	t = &thread->sleep_timer;
+	
+	t->id = -1;
+	t->used = 1;
+	t->magic = 1234;
+	t->type = TIMER_TYPE_SLEEP;
+	
+	t->process = NULL;
+	t->thread = thread;
+	t->window = NULL;
+	
+	t->count_down = 0;
+	t->initial_count_down = 0;
+	t->times = 0;
+	t->status = 0;
+	t->flag = 0;
+	t->error = 0;
+	
+	t->next = NULL;
+	t->prev = NULL;
+	t->expires = 0;
+	t->bucket = NULL;
+}
+
+
+/* A thread vai morrer. O timer dela no pode ficar na roda. */
+
+void timerCancelSleep ( struct thread_d *thread ){
+	
+	unsigned long Flags;
+	
+	if ( (void *) thread == NULL ){
+		return;
+	}
+	
+	Flags = timer_lock ();
+	
+	timer_wheel_remove ( &thread->sleep_timer );
+	
+	timer_unlock (Flags);
+}
+
+
+/*
+ * timerSleepUntil:
+ *     A thread atual dorme at o deadline, em ticks. (sys_time_ticks_total)
+ *     A thread fica bloqueada e o timer dela fica na roda, ela no 
+ * gasta o quantum num loop.
+ *
+ *     Retorna 0 se o deadline passou e 1 se a thread est bloqueada.
+ * Nesse caso o retorno da int 0x80 j troca de thread, (taskswitch_yield)
+ * ela s volta a rodar quando o timer acordar ela e ento chama de novo.
+ * (SYS_NANOSLEEP)
+ */
+
+int timerSleepUntil ( unsigned long deadline ){
+	
+	struct thread_d *t;
+	unsigned long Flags;
+	
+	if ( current_thread < 0 || current_thread >= THREAD_COUNT_MAX ){
+		return (int) -1;
+	}
+	
+	t = (struct thread_d *) threadList[current_thread];
+	
+	if ( (void *) t == NULL ){
+		return (int) -1;
+	}
+	
+	if ( t->used != 1 || t->magic != 1234 ){
+		return (int) -1;
+	}
+	
+	Flags = timer_lock ();
+	
+	if ( (long) (deadline - sys_time_ticks_total) <= 0 )
+	{
+		timer_wheel_remove ( &t->sleep_timer );
+		t->wait_reason[WAIT_REASON_SLEEP] = 0;
+		
+		timer_unlock (Flags);
+		return 0;
+	}
+	
+	if ( (void *) t->sleep_timer.bucket != NULL && 
+	     t->sleep_timer.expires != deadline )
+	{
+		timer_wheel_remove ( &t->sleep_timer );
+	}
+	
+	if ( (void *) t->sleep_timer.bucket == NULL )
+	{
+		t->sleep_timer.expires = deadline;
+		timer_wheel_add ( &t->sleep_timer );
+	}
+	
+	block_for_a_reason ( t->tid, WAIT_REASON_SLEEP );
+	
+	t->runningCount = t->quantum;
+	
+	timer_unlock (Flags);
+	
+	// No volta para o loop do aplicativo. (ts.c)
+	taskswitch_yield ();
+	
+	return (int) 1;
+}
+
+
+//
+// ## TSC clock ##
+//
+
+// ns = (tsc * tsc_mult) >> TSC_SHIFT
+#define TSC_SHIFT  22
+
+// PIT, 1193182 Hz. 50ms no canal 2.
+#define TSC_CALIBRATE_MS     50
+#define TSC_CALIBRATE_COUNT  59659
+
+static unsigned long long tsc_base;
+static unsigned long tsc_mult;
+
+
+unsigned long long timerReadTSC (void){
+
+	unsigned long Low;
+	unsigned long High;
+
+	__asm__ __volatile__ ( "rdtsc" : "=a" (Low), "=d" (High) );
+
+	return (unsigned long long) ( ( (unsigned long long) High << 32 ) | Low );
+}
+
+
+/*
+ * timer_div64:
+ *     64 / 32 sem a libgcc. (__udivdi3)
+ */
+
+static unsigned long long timer_div64 ( unsigned long long n, unsigned long base ){
+
+	unsigned long High = (unsigned long) ( n >> 32 );
+	unsigned long Low = (unsigned long) n;
+	unsigned long QHigh = 0;
+	unsigned long QLow;
+	unsigned long Rem;
+
+	if ( High >= base )
+	{
+		QHigh = ( High / base );
+		High = ( High % base );
+	}
+
+	__asm__ ( "divl %4" 
+	    : "=a" (QLow), "=d" (Rem) 
+	    : "a" (Low), "d" (High), "rm" (base) );
+
+	return (unsigned long long) ( ( (unsigned long long) QHigh << 32 ) | QLow );
+}
+
+
+// (a * mult) >> shift, sem perder a parte alta de a.
+
+static unsigned long long timer_mul_shr ( unsigned long long a, unsigned long mult ){
+
+	unsigned long High = (unsigned long) ( a >> 32 );
+	unsigned long Low = (unsigned long) a;
+	unsigned long long Ret;
+
+	Ret = ( ( (unsigned long long) Low * mult ) >> TSC_SHIFT );
+
+	if ( High != 0 ){
+		Ret += ( ( (unsigned long long) High * mult ) << (32 - TSC_SHIFT) );
+	}
+
+	return (unsigned long long) Ret;
+}
+
+
+static int timer_has_tsc (void){
+
+	unsigned long a, b, c, d;
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (1), "c" (0) );
+
+	return (int) ( (d >> 4) & 1 );
+}
+
+
+static int timer_tsc_is_invariant (void){
+
+	unsigned long a, b, c, d;
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0x80000000), "c" (0) );
+
+	if ( a < 0x80000007 ){
+		return 0;
+	}
+
+	__asm__ __volatile__ ( "cpuid"
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0x80000007), "c" (0) );
+
+	return (int) ( (d >> 8) & 1 );
+}
+
+
+/*
+ * timer_pit_tsc_delta:
+ *     Quantos ciclos do TSC em TSC_CALIBRATE_MS.
+ *     O canal 2 do PIT conta no modo 0 e o bit 5 da porta 0x61 
+ * sobe quando chega a 0. O canal 0, (irq0) no  tocado.
+ */
+
+static unsigned long timer_pit_tsc_delta (void){
+
+	unsigned long long Start;
+	unsigned long long End;
+	unsigned long Loops = 0;
+	unsigned char Value;
+
+	// Gate do canal 2 ligado, speaker desligado.
+	Value = (unsigned char) inportb (0x61);
+	outportb ( 0x61, (Value & ~0x02) | 0x01 );
+
+	// Canal 2, LSB/MSB, modo 0, binrio.
+	outportb ( 0x43, 0xB0 );
+	outportb ( 0x42, TSC_CALIBRATE_COUNT & 0xFF );
+	outportb ( 0x42, TSC_CALIBRATE_COUNT >> 8 );
+
+	Start = timerReadTSC ();
+
+	while ( ( inportb (0x61) & 0x20 ) == 0 )
+	{
+		// O PIT no respondeu.
+		if ( ++Loops > 0x10000000 ){
+			return 0;
+		}
+	};
+
+	End = timerReadTSC ();
+
+	return (unsigned long) ( End - Start );
+}
+
+
+/*
+ * timerCalibrateTSC:
+ *     Mede o TSC contra o PIT. A menor de trs medidas, 
+ * as outras podem ter sido atrasadas por SMIs.
+ *     Retorna 0 se o relgio pode usar o TSC.
+ */
+
+int timerCalibrateTSC (void){
+
+	unsigned long Delta;
+	unsigned long Best = 0;
+	int i;
+
+	tsc_khz = 0;
+	tsc_mult = 0;
+	tsc_invariant = 0;
+
+	if ( timer_has_tsc () == 0 ){
+		return (int) -1;
+	}
+
+	for ( i=0; i < 3; i++ )
+	{
+		Delta = timer_pit_tsc_delta ();
+
+		if ( Delta != 0 && ( Best == 0 || Delta < Best ) ){
+			Best = Delta;
+		}
+	};
+
+	// Menos de 1MHz no faz sentido.
+	if ( Best < (1000 * TSC_CALIBRATE_MS) ){
+		return (int) -1;
+	}
+
+	tsc_invariant = timer_tsc_is_invariant ();
+
+	tsc_mult = (unsigned long) timer_div64 ( (unsigned long long) 1000000 << TSC_SHIFT, 
+	                               ( Best / TSC_CALIBRATE_MS ) );
+
+	tsc_base = timerReadTSC ();
+
+	// Por ltimo, os leitores olham o tsc_khz.
+	tsc_khz = ( Best / TSC_CALIBRATE_MS );
+
+	return 0;
+}
+
+
+/*
+ * timerGetMonotonicNS:
+ *     Nanosegundos desde a calibrao. No volta para trs.
+ */
+
+unsigned long long timerGetMonotonicNS (void){
+
+	if ( tsc_khz == 0 )
+	{
+		return (unsigned long long) sys_time_ticks_total * 
+		       (unsigned long) ( 1000000000 / (sys_time_hz ? sys_time_hz : HZ) );
+	}
+
+	return (unsigned long long) timer_mul_shr ( timerReadTSC () - tsc_base, tsc_mult );
+}
+
+
+// Microsegundos. D a volta depois de uns 71 minutos.
+
+unsigned long timerGetMonotonicUS (void){
+
+	return (unsigned long) timer_div64 ( timerGetMonotonicNS (), 1000 );
+}
+
+
+/*
+ * timerClockGetTime:
+ *     clock_gettime. (SYS_CLOCKGETTIME)
+ */
+
+int timerClockGetTime ( int clock_id, struct timespec_d *ts ){
+
+	unsigned long long NS;
+	unsigned long Seconds;
+
+	if ( (void *) ts == NULL ){
+		return (int) -1;
+	}
+
+	if ( clock_id != CLOCK_MONOTONIC ){
+		return (int) -1;
+	}
+
+	NS = timerGetMonotonicNS ();
+
+	Seconds = (unsigned long) timer_div64 ( NS, 1000000000 );
+
+	ts->tv_sec = Seconds;
+	ts->tv_nsec = (long) ( NS - ( (unsigned long long) Seconds * 1000000000 ) );
+
+	return 0;
+}
+
+
+//
+// ## tickless idle ##
+//
+
+
+/*
+ * timer_wheel_next_event:
+ *     Quantos ticks at o prximo slot ocupado do nvel 0, ou at 
+ * o nvel 0 dar a volta, quando os nveis altos descem.
+ */
+
+static unsigned long timer_wheel_next_event (void){
+
+	unsigned long i;
+	unsigned long Index;
+
+	for ( i=0; i < TIMER_WHEEL_ROOT_SIZE; i++ )
+	{
+		Index = ( (timer_wheel_ticks + i) & TIMER_WHEEL_ROOT_MASK );
+
+		if ( Index == 0 && i != 0 ){
+			break;
+		}
+
+		if ( (void *) timer_wheel_root[Index] != NULL ){
+			break;
+		}
+	};
+
+	// O slot i  processado no tick timer_wheel_ticks + i.
+	return (unsigned long) ( (timer_wheel_ticks + i) - sys_time_ticks_total );
+}
+
+
 /*
- *****************************************************
- * timer: 
- *     Handler chamado pelo ISR do timer (IRQ 0).
- *     (Contagem de tempo, tempo das tarefas, 
- * quantum ...).
- *     (tick tick tick)
+ * timer_catch_up:
+ *     Conta os ticks que no geraram irq0 e faz o que o timer() 
+ * faria neles.
  */
 
-void timer (void){
-	
-	//timers.
-	int i;
-	
-	struct timer_d *t;
-	
-	//
-	// ## ticks total ##
-	//
-	
-    //Contador de ticks.
-	//Incrementa o Tempo total de funcionamento do kernel.
-	
-    sys_time_ticks_total++;	
+static void timer_catch_up ( unsigned long ticks ){
 
-	//
-	// ## sys time ##
-	//
-	
-	//Mais 10ms para um sistema funcionando a 100HZ
-    //sys_time_ms = sys_time_ms + 10;
-	
-	sys_time_ms = (unsigned long) sys_time_ms + (1000/sys_time_hz);	
+	unsigned long Old;
 
-	
-	//
-	// ## threads time ##
-	//
+	if ( ticks == 0 ){
+		return;
+	}
 
-	//Atribui um nmero de request a ser atendido futuramente.
-	//Tratar o tempo das tarefas de acordo com o tipo.
-	//#obs: Isso poderia ser usado para atualizar o time dos processos.
-	
-	//#suspenso
-	//estou repensando isso.
-	
-	//kernel_request = KR_TIME;  
-	
-	
-	//
-	//  ## extra ## 
-	//
-	
-	// Aciona uma flag para que o ts.c realize atividades extras,
-	// como gc, dead thread collector, request.
-	
-	if ( sys_time_ticks_total % 100 == 0 )
-	{
+	Old = sys_time_ticks_total;
+
+	sys_time_ticks_total += ticks;
+	sys_time_ms = (unsigned long) sys_time_ms + ( ticks * (1000/sys_time_hz) );
+
+	if ( (Old / 100) != (sys_time_ticks_total / 100) ){
 		extra = 1;
 	}
 
+	if ( (Old / BCACHE_SYNC_TICKS) != (sys_time_ticks_total / BCACHE_SYNC_TICKS) ){
+		bcacheSyncRequest ();
+	}
 
-	//
-	// ## mouse blink ##
-	//
-		
-	//#todo rever isso.
-	//de tempos em tempos atualiza o cursor
-	//a cada segundo. sendo ele 100 ou 1000 ... tanto faz.
-	//#todo: mas poderia ser exatamente o hz configurado par ao mouse
-	//if ( sys_time_ticks_total % mouse_cursor_hz == 0 )
-	//if ( sys_time_ticks_total % sys_time_hz == 0 )	
-	if ( sys_time_ticks_total % 70 == 0 )
-	{
-		//Se o cursor piscante est habilitado.
-		//Essa flag  acionada pelo aplicativo.
-		if (timerShowTextCursor == 1)
-		{
-		    if ( timerTextCursorStatus != 1 )
-		    { 
-	            //apaga
-	            refresh_rectangle ( (g_cursor_x + 1)  *8, g_cursor_y*8, 16, 16 );	
-                timerTextCursorStatus = 1;
-		        goto mouseExit;
-		    }
-	
-		    if ( timerTextCursorStatus == 1 )
-            {			
-		        //acende
-                bmpDisplayCursorBMP ( cursorIconBuffer, (g_cursor_x + 1) * 8, g_cursor_y*8 );		
-		        timerTextCursorStatus = 0;
-			    goto mouseExit;
-		    }
-		};
-	};
-	
-mouseExit:	
+	timerTicksSkipped += ticks;
 
-    //podemos percorrer a lista de timer e decrementar,
-	//quando um timer chegar a 0, mandamos uma mensagem
-	//para a thread de input da janela  qual ele pertence.
-	
-	for ( i=0; i<32; i++ )
-	{
-		//pega um da lista
-	    t = (struct timer_d *) timerList[i];
-
-        //checa
-        if ( (void *) t != NULL )
-        {
-			//validao.
-			if ( t->used == 1 && t->magic == 1234 )
-			{
-				if ( t->count_down > 0 )
-				{
-				    t->count_down--;
-                    
-                    //Chegamos ao 0.
-                    if ( t->count_down == 0 )
-                    {
-						//enviamos a mensagem para a thread que  dona do timer.
-						//#todo: podemos usar uma funo para isso.
-						
-						//se a thread for vlida.
-						if ( (void *) t->thread != NULL )
-						{
-							if ( t->thread->used == 1 && t->thread->magic == 1234 )
-							{
-								
-		                        t->thread->window = t->window;
-		                        t->thread->msg = (int) MSG_TIMER;    
-		                        t->thread->long1 = t->times;   //quantas vezes esse timer se esgotou.      
-		                        t->thread->long2 = t->status;  //?/status.     
-		
-		                        t->thread->newmessageFlag = 1;													
-								
-							}
-							
-						}
-						
-						//analisando o tipo.
-						//dependendo do tipo, devemos parar ou recomear.
-						
-						//one shot
-						if ( t->type == 1 )
-						{
-						   t->count_down = 0;	
-						}
-						
-						//intermitente
-						if ( t->type == 2 )
-						{
-						   t->count_down = t->initial_count_down;	
-						}
-						
-                        //...						
-					}						
-				}
-			    
-			};
-		};			
-		
-		//nothing
-	};
-	
-	
+	timer_wheel_run ();
+}
 
-done:
-    	
-	//#todo
-	//if(time_out > 0){
-	//	time_out--;
-	//};
-	
-	return;
-};
 
+// A frao de tick que sobrou do ltimo hlt. (ns)
+// Entra na prxima conta, seno o relgio atrasa a cada idle.
+static unsigned long timer_tickless_rest_ns;
 
 
-int new_timer_id (void){
-	
-    int i;
-    unsigned long new;
-	
-    for ( i=0; i<32; i++ )
-    {
-		new = (unsigned long) timerList[i];
-		
-		if ( new == 0 )
-		{
-			return (int) i;
-		}
-	}		
-	
-	//fail
-	return (int) -1;
-}
+/*
+ * timerTicklessIdle:
+ *     A idle vai dar hlt. Se nenhuma outra thread est pronta, 
+ * mascara a irq0 e arma o timer do local APIC para o prximo 
+ * deadline. Qualquer interrupo acorda a cpu, a irq0 volta e 
+ * os ticks perdidos so contados. 
+ *     Chamada com as interrupes desabilitadas e retorna com elas 
+ * desabilitadas.
+ */
 
+int timerTicklessIdle (void){
 
-//#todo 
-//precisamos pegar um slot na lista de timers.
+	unsigned long long EnterNS;
+	unsigned long long Elapsed;
+	unsigned long TickNS;
+	unsigned long Ticks;
+	unsigned long Skipped;
+	unsigned long Pending;
+	unsigned char Mask;
 
-struct timer_d *create_timer ( struct window_d *window, 
-                               unsigned long ms, 
-							   int type  )
-{
-    struct timer_d *t;	
-	
-	int ID = -1;  //erro;
-	
-	//limits
-	//limite de 1 tick.
-	
-	if (ms < (1000/sys_time_hz) )
-	{
-		printf("create_timer: ajust ms\n");
-		ms = (1000/sys_time_hz);
+	if ( timerTickless != 1 ){
+		return 0;
 	}
-	
-	if ( type < 1 || type > 10 )
-	{
-		printf("create_timer: type fail\n");
-		
-		//#debug
-		refresh_screen();
-		
-		return NULL;
+
+	// Precisamos do TSC para contar e do local APIC para acordar.
+	if ( tsc_khz == 0 || lapic_timer_khz == 0 ){
+		return 0;
 	}
-	
-	
-	t = (void *) malloc ( sizeof(struct timer_d) );
-	
-	if ( (void *) t == NULL )
+
+	if ( task_switch_status != UNLOCKED ){
+		return 0;
+	}
+
+	// Tem outra thread pronta.
+	if ( (void *) readyq_highest () != NULL ){
+		return 0;
+	}
+
+	// Retngulos esperando o deadline. (damage.c)
+	if ( damagePending () == 1 ){
+		return 0;
+	}
+
+	// Trabalho adiado das irqs. (defer.c)
+	if ( deferIsPending () == 1 ){
+		return 0;
+	}
+
+	// Sprites esperando o tick. (sprite.c)
+	if ( spritePending () == 1 ){
+		return 0;
+	}
+
+	Ticks = timer_wheel_next_event ();
+
+	if ( Ticks > TIMER_TICKLESS_MAX_TICKS ){
+		Ticks = TIMER_TICKLESS_MAX_TICKS;
+	}
+
+	// O cursor pisca a cada 70 ticks.
+	if ( timerShowTextCursor == 1 )
 	{
-		
-		printf("create_timer: t fail \n");
-		//#debug
-		refresh_screen();
-		
-		return NULL; 
-	}else{
-		
-		
-		ID = (int) new_timer_id();
-		
-		//erro ao obter um novo id.
-		if (  ID < 0 || ID > 32 )
-		{
+		if ( Ticks > ( 70 - (sys_time_ticks_total % 70) ) ){
+			Ticks = ( 70 - (sys_time_ticks_total % 70) );
+		}
+	}
 
-		    printf("create_timer: ID fail \n");
-		    //#debug
-		    refresh_screen();
-	
-			
-		    return NULL;	
-		}else{
-			
-			t->id = ID; 	
-		
-		    t->used = 1;
-		    t->magic = 1234;
-		
-		    // ms/(ms por tick)
-		    t->initial_count_down = (unsigned long) ( ms / (1000/sys_time_hz) );
-	 	    t->count_down = t->initial_count_down;
-		
-	        //1 = one shot 
-	        //2 = intermitent
-		    t->type = (int) type;
-		
-		
-		    //colca na lista.
-		    timerList[ID] = (unsigned long) t;
-		};
-		
-		
-	    //thread.
-		
-		if ( (void *) window == NULL)
-		{
-			
-		    printf("create_timer: window fail \n");
-		    //#debug
-		    refresh_screen();
-			
-			
-		   return NULL;	
-		}else{
-			
-			if ( window->used != 1 || window->magic != 1234 )
-			{
-				
-		        printf("create_timer: window validation fail \n");
-		        //#debug
-		        refresh_screen();
-				
-			    return NULL;	
-			}
-			
-			//temos uma janela vlida 
-			t->window = window;
-			
-			if ( (void *) window->control == NULL )
-			{
-		        printf("create_timer: thread fail \n");
-		        //#debug
-		        refresh_screen();
-				
-				return NULL;
-			}
-			
-			if ( window->control->used != 1 || window->control->magic != 1234 )
-			{
-				
-		        printf("create_timer: thread validation fail \n");
-		        //#debug
-		        refresh_screen();
-				
-			    return NULL;	
-			}
-			
-			//#importante 
-			//agora o timer tem uma thread para enviar mensagens.
-			//quancdo o tempo se esgotar.
-			
-		    t->thread = (struct thread_d *) window->control;	
-		 	
-		};
-		
+	if ( Ticks < TIMER_TICKLESS_MIN_TICKS ){
+		return 0;
+	}
+
+	TickNS = ( 1000000000 / sys_time_hz );
+
+	EnterNS = timerGetMonotonicNS ();
+
+	if ( lapicTimerOneShot ( Ticks * (TickNS / 1000) ) != 0 ){
+		return 0;
+	}
+
+	// Mascara a irq0 no 8259.
+	Mask = (unsigned char) inportb (0x21);
+	outportb ( 0x21, Mask | 0x01 );
+
+	timerTicklessIdles++;
+
+	// O sti s vale depois do hlt, no perdemos a interrupo.
+	asm volatile ( "sti; hlt; cli" : : : "memory" );
+
+	lapicTimerStop ();
+
+	// Uma borda do PIT pode estar esperando no IRR. 
+	// Ela vira o prximo tick quando a irq0 voltar.
+	outportb ( 0x20, 0x0A );
+	Pending = (unsigned long) ( inportb (0x20) & 0x01 );
+
+	outportb ( 0x21, Mask );
+
+	Elapsed = ( timerGetMonotonicNS () - EnterNS ) + timer_tickless_rest_ns;
+	Skipped = (unsigned long) timer_div64 ( Elapsed, TickNS );
+
+	timer_tickless_rest_ns = 
+	    (unsigned long) ( Elapsed - ( (unsigned long long) Skipped * TickNS ) );
+
+	if ( Skipped > Pending ){
+		timer_catch_up ( Skipped - Pending );
 	}
-	
-	
-    printf("create_timer: done \n");
-	//#debug
-	refresh_screen();	
-	
-    return (struct timer_d *) t;	
-};
+
+	return (int) 1;
+}
 
 
 /*
@@ -597,9 +1497,16 @@ unsigned long get_systime_hz (void){
 }
 
 
-/* systime in ms */
+/* 
+ * systime in ms 
+ *     Com o TSC no acumulamos o erro do perodo do PIT.
+ */
 unsigned long get_systime_ms (void){
 	
+	if ( tsc_khz != 0 ){
+	    return (unsigned long) timer_div64 ( timerGetMonotonicNS (), 1000000 );
+	}
+	
     return (unsigned long) sys_time_ms;
 }
 
@@ -634,6 +1541,15 @@ unsigned long get_systime_info (int n){
 		    return (unsigned long) get_systime_totalticks ();
 			break;
 		
+		// tickless idle.
+		case 4:
+		    return (unsigned long) timerTicksSkipped;
+			break;
+			
+		case 5:
+		    return (unsigned long) timerTicklessIdles;
+			break;
+		
 		//...
 		
 		default:
@@ -645,11 +1561,13 @@ unsigned long get_systime_info (int n){
 
 /*
  ***************************************
- * sleep: #todo
+ * sleep:
  *     Apenas uma espera, um delay.
  *     Essa no  a funo que coloca uma 
- * tarefa pra dormir no caso de evento.
- *   #todo: Usar o ms do contador do sys_time
+ * tarefa pra dormir. Para isso use timerSleepUntil. (SYS_NANOSLEEP)
+ *     Usada pelos drivers na inicializao, muitas vezes sem 
+ * interrupes, ento no d para esperar pelos ticks. 
+ * O 'ms' no  calibrado.
  */
 
 void sleep (unsigned long ms){
@@ -719,10 +1637,26 @@ int timerInit (void){
 	timerTimer();
 	
 	
-	for ( i=0; i<32; i++ ){
-		timerList[i] = (unsigned long) 0;
+	// A roda comea vazia.
+	for ( i=0; i < TIMER_WHEEL_ROOT_SIZE; i++ ){
+		timer_wheel_root[i] = NULL;
+	}
+	
+	for ( i=0; i < (TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_SIZE); i++ ){
+		timer_wheel_levels[i / TIMER_WHEEL_LEVEL_SIZE][i % TIMER_WHEEL_LEVEL_SIZE] = NULL;
 	}
 	
+	timer_wheel_ticks = ( sys_time_ticks_total + 1 );
+	timer_next_id = 0;
+	
+	timerPending = 0;
+	timerExpired = 0;
+	timerCascaded = 0;
+	
+	timerTickless = 1;
+	timerTicksSkipped = 0;
+	timerTicklessIdles = 0;
+	
 	
     // timerLock = 0;
 
@@ -745,6 +1679,9 @@ int timerInit (void){
 	sys_time_hz = (unsigned long) HZ;
 	
 	timerInit8253 ( sys_time_hz );
+	
+	// Relgio de alta resoluo.
+	timerCalibrateTSC ();
    
    
     /*
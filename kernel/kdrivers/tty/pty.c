@@ -141,13 +141,8 @@ void pty_send_message_to_thread ( unsigned long msg_buffer, int tid ){
 		        return;	
 			}
 
-            t->window = (struct window_d *) buffer[0];
-			t->msg = (int) buffer[1];
-			t->long1 = (unsigned long) buffer[2];
-			t->long2 = (unsigned long) buffer[3];
-				
-			//sinalizando que temos uma mensagem.
-			t->newmessageFlag = 1; 
+            msgqPostMessage ( t, (struct window_d *) buffer[0], (int) buffer[1],
+                (unsigned long) buffer[2], (unsigned long) buffer[3] );
 		};
 	};
 }
@@ -0,0 +1,359 @@
+/*
+ * File: x/damage.c
+ *
+ *     Dirty rectangles of the backbuffer.
+ *
+ *     The drawing routines mark what they painted and refresh_screen()
+ * copies only the dirty rectangles to the frontbuffer. (LFB)
+ * One vsync for all the rectangles.
+ *
+ *     The timer can also run this, (deadline) so the list is changed
+ * with the interrupts disabled.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+
+
+static spinlock_t damage_spinlock;
+
+
+static unsigned long damage_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &damage_spinlock );
+}
+
+
+static void damage_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &damage_spinlock, flags );
+}
+
+
+static unsigned long damage_area ( struct damage_rect_d *r ){
+
+	return (unsigned long) ( (r->right - r->left) * (r->bottom - r->top) );
+}
+
+
+/* The rectangles overlap or touch. */
+
+static int damage_touch ( struct damage_rect_d *a, struct damage_rect_d *b ){
+
+	if ( a->left > b->right || b->left > a->right ||
+	     a->top > b->bottom || b->top > a->bottom )
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+
+static void damage_union ( struct damage_rect_d *a, struct damage_rect_d *b ){
+
+	if ( b->left < a->left ){ a->left = b->left; }
+	if ( b->top < a->top ){ a->top = b->top; }
+	if ( b->right > a->right ){ a->right = b->right; }
+	if ( b->bottom > a->bottom ){ a->bottom = b->bottom; }
+}
+
+
+static void damage_remove ( int i ){
+
+	damage_count--;
+	damageList[i] = damageList[damage_count];
+}
+
+
+/*
+ * damage_insert:
+ *     Put a clipped rectangle in the list, merging it with the
+ * rectangles it touches.
+ */
+
+static void damage_insert ( struct damage_rect_d *r ){
+
+	struct damage_rect_d New;
+	struct damage_rect_d Tmp;
+
+	unsigned long Total = 0;
+	unsigned long Grow;
+	unsigned long Best = 0;
+	int BestIndex = -1;
+	int i;
+
+	New = *r;
+
+again:
+
+	for ( i=0; i < damage_count; i++ )
+	{
+		// Already dirty.
+		if ( New.left >= damageList[i].left &&
+		     New.right <= damageList[i].right &&
+		     New.top >= damageList[i].top &&
+		     New.bottom <= damageList[i].bottom )
+		{
+			return;
+		}
+
+		if ( damage_touch ( &New, &damageList[i] ) == 1 )
+		{
+			damage_union ( &New, &damageList[i] );
+			damage_remove (i);
+			goto again;
+		}
+	};
+
+	// Full. Merge with the rectangle that grows less.
+	if ( damage_count >= DAMAGE_RECT_MAX )
+	{
+		for ( i=0; i < damage_count; i++ )
+		{
+			Tmp = damageList[i];
+			damage_union ( &Tmp, &New );
+
+			Grow = damage_area (&Tmp) - damage_area (&damageList[i]);
+
+			if ( BestIndex < 0 || Grow < Best )
+			{
+				Best = Grow;
+				BestIndex = i;
+			}
+		};
+
+		damage_union ( &New, &damageList[BestIndex] );
+		damage_remove (BestIndex);
+		goto again;
+	}
+
+	damageList[damage_count] = New;
+	damage_count++;
+
+	// Big dirty area, copy the whole screen.
+	for ( i=0; i < damage_count; i++ ){
+		Total += damage_area ( &damageList[i] );
+	};
+
+	if ( Total >= ( (SavedX * SavedY) / 100 ) * DAMAGE_FULL_PERCENT )
+	{
+		damage_full = 1;
+		damage_count = 0;
+	}
+}
+
+
+/*
+ * damageAdd:
+ *     Mark a rectangle of the backbuffer as dirty.
+ */
+
+void
+damageAdd ( unsigned long x,
+            unsigned long y,
+            unsigned long width,
+            unsigned long height )
+{
+	struct damage_rect_d r;
+	unsigned long Flags;
+
+	// Painting into a window surface. (surface.h)
+	if ( (void *) draw_surface != NULL )
+	{
+		surfaceDamage ( x, y, width, height );
+		return;
+	}
+
+	if ( damage_full == 1 ){
+		return;
+	}
+
+	if ( width == 0 || height == 0 || x >= SavedX || y >= SavedY ){
+		return;
+	}
+
+	r.left = x;
+	r.top = y;
+	r.right = x + width;
+	r.bottom = y + height;
+
+	if ( r.right > SavedX || r.right < x ){ r.right = SavedX; }
+	if ( r.bottom > SavedY || r.bottom < y ){ r.bottom = SavedY; }
+
+	Flags = damage_lock ();
+
+	if ( damage_full != 1 )
+	{
+		if ( damage_count == 0 ){
+			damage_first_tick = sys_time_ticks_total;
+		}
+
+		damage_insert (&r);
+	}
+
+	damage_unlock (Flags);
+}
+
+
+/* The whole backbuffer is dirty. (scroll, background) */
+
+void damageAddAll (void){
+
+	unsigned long Flags;
+
+	Flags = damage_lock ();
+
+	if ( damage_full != 1 && damage_count == 0 ){
+		damage_first_tick = sys_time_ticks_total;
+	}
+
+	damage_full = 1;
+	damage_count = 0;
+
+	damage_unlock (Flags);
+}
+
+
+int damagePending (void){
+
+	if ( damage_full == 1 || damage_count > 0 ){
+		return (int) 1;
+	}
+
+	return (int) 0;
+}
+
+
+/* 0 = copy on every refresh_screen(). */
+
+void damageSetDeadline ( unsigned long ticks ){
+
+	damage_deadline_ticks = (unsigned long) ticks;
+}
+
+
+/*
+ * damageFlush:
+ *     Copy the dirty rectangles to the frontbuffer, now.
+ */
+
+void damageFlush (void){
+
+	struct damage_rect_d List[DAMAGE_RECT_MAX];
+	unsigned long Flags;
+	int Full;
+	int Count;
+	int i;
+
+	// Take the list, so the interrupts can mark new rectangles
+	// while we copy.
+
+	Flags = damage_lock ();
+
+	Full = damage_full;
+	Count = damage_count;
+
+	for ( i=0; i < Count; i++ ){
+		List[i] = damageList[i];
+	};
+
+	damage_full = 0;
+	damage_count = 0;
+
+	damage_unlock (Flags);
+
+	if ( Full != 1 && Count == 0 ){
+		return;
+	}
+
+	vsync ();
+
+	if ( Full == 1 )
+	{
+		refresh_rectangle_nosync ( 0, 0, SavedX, SavedY );
+		return;
+	}
+
+	for ( i=0; i < Count; i++ )
+	{
+		refresh_rectangle_nosync ( List[i].left, List[i].top,
+		    List[i].right - List[i].left, List[i].bottom - List[i].top );
+	};
+}
+
+
+/*
+ * damageRefresh:
+ *     refresh_screen().
+ *     With a deadline, wait until the first rectangle is that old.
+ */
+
+void damageRefresh (void){
+
+	// Early boot, nothing is marked yet.
+	if ( damage_initialized != 1 )
+	{
+		vsync ();
+		refresh_rectangle_nosync ( 0, 0, SavedX, SavedY );
+		return;
+	}
+
+	if ( damage_deadline_ticks != 0 )
+	{
+		if ( ( sys_time_ticks_total - damage_first_tick ) < damage_deadline_ticks ){
+			return;
+		}
+	}
+
+	damageFlush ();
+}
+
+
+/* Called by the timer. Copy what waits for too long. */
+
+void damageTimer (void){
+
+	if ( damage_deadline_ticks == 0 ){
+		return;
+	}
+
+	if ( damagePending () != 1 ){
+		return;
+	}
+
+	if ( ( sys_time_ticks_total - damage_first_tick ) >= damage_deadline_ticks ){
+		damageFlush ();
+	}
+}
+
+
+/*
+ * damageInit:
+ *     The first refresh copies the whole screen.
+ */
+
+void damageInit (void){
+
+	spinLockInit (&damage_spinlock);
+
+	damage_count = 0;
+	damage_full = 1;
+
+	damage_deadline_ticks = DAMAGE_DEADLINE_DEFAULT;
+	damage_first_tick = sys_time_ticks_total;
+
+	damage_initialized = 1;
+}
+
+
+//
+// End.
+//
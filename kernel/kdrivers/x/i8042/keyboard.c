@@ -110,6 +110,11 @@ void abnt2_keyboard_handler (void){
 	{
 		keybuffer_tail = 0;
 	}
+	
+	// Acorda a thread da janela com o foco de entrada, 
+	// se ela estiver esperando mensagem. (ipc/msgq.c)
+	
+	msgqWakeupFocus ();
 }
 
 
@@ -127,6 +132,11 @@ unsigned long get_scancode (void){
 	
 	unsigned long SC = 0;
 	
+	// Buffer vazio.
+	if ( keybuffer_head == keybuffer_tail ){
+		return (unsigned long) 0;
+	}
+	
 	SC = (unsigned char) current_stdin->_base[keybuffer_head];
 					
 	current_stdin->_base[keybuffer_head] = 0;
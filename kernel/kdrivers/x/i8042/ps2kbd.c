@@ -540,12 +540,8 @@ check_WindowWithFocus:
 		tmp = (unsigned long) scancode;
 		tmp = (unsigned long) ( tmp & 0x000000FF );
 		
-		t->window = w;
-		t->msg = message;
-		t->long1 = ch;     // Key.
-		t->long2 = tmp;    // Scan code.
-			
-		t->newmessageFlag = 1;
+		msgqPostMessage ( t, w, (int) message,
+		    (unsigned long) ch, (unsigned long) tmp );
 
 		// F5 F6 F7 F8		
 		// Teclas para teste.
@@ -1197,6 +1193,9 @@ void reboot (void){
 	sleep(1000);
 	printf("turning off ...\n");
     
+	// Os setores sujos do cache vão para o disco. (bcache.c)
+	bcacheSync ();
+	
 	
 	refresh_screen();
 	
@@ -278,6 +278,11 @@ int load_mouse_bmp (void){
 
 	//Isso funcionou ...
 	//refresh_rectangle( 20, 20, 16, 16 );
+
+	// Decodificado uma vez, o branco  transparente. (sprite.h)
+	// Se falhar, o ponteiro continua sendo pintado a partir do BMP.
+	spriteLoadBMP ( SPRITE_POINTER, mouseBMPBuffer, COLOR_WHITE );
+
 	Status = (int) 0;
 	goto done;
 	
@@ -400,19 +405,6 @@ quit:
 }
 
 
-/*
- ********************************************************
- * mouseHandler:
- *     Handler de mouse. 
- *
- * *Importante: 
- *     Se estamos aqui  porque os dados disponveis no 
- * controlador 8042 pertencem ao mouse.
- *
- * @todo: Essa rotina no pertence ao line discipline.
- * Obs: Temos externs no incio desse arquivo.
- */
- 
 #define MOUSE_DATA_BIT 1
 #define MOUSE_SIG_BIT  2
 #define MOUSE_F_BIT  0x20
@@ -428,152 +420,265 @@ static char buffer_mouse[3];
 int flagRefreshMouseOver;
 
 
-void mouseHandler (void)
-{	
-    // #importante:
-	// Essa ser a thread que receber a mensagem
-	
-	struct thread_d *t;
-	
-	
-	// #importante:
-	// Essa ser a janela afetada por qualquer evento de mouse.
-	// ID de janela.
-	
-    struct window_d *Window;
-	int wID; 	
-	
-	
-	// Coordenadas do mouse.
-    // Obs: Isso pode ser global.
-    // O tratador em assembly tem as variveis globais do posicionamento.
-    
-	int posX = 0;
-    int posY = 0;	
+//
+// ## Fila de pacotes ##
+//
+
+// A irq s monta o pacote de trs bytes e coloca na fila.
+// O movimento, o ponteiro e as mensagens so feitos depois,
+// pelo trabalho adiado. (defer.h)
+
+// Potncia de 2.
+#define MOUSE_RING_SIZE  64
+
+struct mouse_packet_d
+{
+	char data;
+	char x;
+	char y;
+};
+
+static struct mouse_packet_d mouse_ring[MOUSE_RING_SIZE];
+
+// head: s a irq escreve. tail: s o bottom half escreve.
+static volatile unsigned long mouse_ring_head = 0;
+static volatile unsigned long mouse_ring_tail = 0;
+
+// -1 = ainda no registrado, o bottom half roda na irq, como antes.
+static int mouse_defer_id = -1;
+
+
+static void mouse_ring_put (void){
+
+	struct mouse_packet_d *p;
+
+	// Cheia. Perdemos o pacote novo.
+	if ( (mouse_ring_head - mouse_ring_tail) >= MOUSE_RING_SIZE )
+	{
+		mouse_packets_dropped++;
+
+	}else{
+
+		p = &mouse_ring[mouse_ring_head & (MOUSE_RING_SIZE -1)];
 
-    //Char para o cursor provisrio.
-	//#todo: Isso foi subtituido por uma bmp. Podemos deletar.
-    //static char mouse_char[] = "T";
+		p->data = buffer_mouse[0];
+		p->x = buffer_mouse[1];
+		p->y = buffer_mouse[2];
 
-	char *_byte;
+		// O pacote antes do head.
+		__asm__ __volatile__ ( "" : : : "memory" );
 
+		mouse_ring_head++;
+		mouse_packets++;
+	};
+
+	if ( mouse_defer_id < 0 )
+	{
+		mouseBottomHalf ();
+		return;
+	}
+
+	deferRaise (mouse_defer_id);
+}
+
+
+/*
+ ********************************************************
+ * mouseHandler:
+ *     Handler de mouse. (top half)
+ *
+ * *Importante:
+ *     Se estamos aqui  porque os dados disponveis no
+ * controlador 8042 pertencem ao mouse.
+ *
+ *     S lemos o byte e montamos o pacote. Nada de pintar ou
+ * escanear janelas com as interrupes desabilitadas.
+ * (mouseBottomHalf)
+ */
+
+void mouseHandler (void)
+{
+	char _byte;
 
 	// Lendo um char no controlador.
-	
-	*_byte = (char) mouse_read ();
-	
-	
+
+	_byte = (char) mouse_read ();
+
+
 	// #importante:
 	// Contagem de interrues:
 	// Obs: Precisamos esperar 3 interrupes.
-	
-	//#bugbug essa varivel est inicializando toda vez que 
-	//se chama o handler porque ela  interna. ??
-	
+
 	switch ( count_mouse )
 	{
-		// Essa foi a primeira interrupo.
+		// Essa foi a primeira interruo.
 		case 0:
 		    //Pegamos o primeiro char.
-		    buffer_mouse[0] = (char) *_byte;
-            if(*_byte & MOUSE_V_BIT)
+		    buffer_mouse[0] = (char) _byte;
+            if(_byte & MOUSE_V_BIT)
                 count_mouse++;
 		    break;
-			
-		// Essa foi a segunda interrupo.	
+
+		// Essa foi a segunda interruo.
 		case 1:
 		    //Pegamos o segundo char.
-		    buffer_mouse[1] = (char) *_byte;
+		    buffer_mouse[1] = (char) _byte;
 			count_mouse++;
 		    break;
-			
+
 		//#importante.
-		// Essa foi a terceira interrupo.	
+		// Essa foi a terceira interruo.
 		case 2:
 		    //Pegamos o terceiro char.
-            buffer_mouse[2] = (char) *_byte;
+            buffer_mouse[2] = (char) _byte;
 			count_mouse = 0;
-			
-			//#importante:
-			//A partir de agora j temos os trs chars.
-			
-			//??
-			//Colocando os trs chars em variveis globais.
-            //Isso ficar assim caso no haja overflow ...
-			
-			mouse_packet_data = buffer_mouse[0];
-	 	    mouse_packet_x = buffer_mouse[1];       
-		    mouse_packet_y = buffer_mouse[2];
-            
-			// #importante:
-			// #todo: Isso est em Assembly, l em hwlib.inc, 
-			// mas queremos que seja feito em C.
-			// #obs: Uma rotina interna aqui nesse arquivo est tentando isso.
-			
-			//#importante.
-		    //salvando antes de atualizar.
-			//paga poder apagar daqui a pouco.
-			saved_mouse_x = mouse_x;
-		    saved_mouse_y = mouse_y;			
-			
-			update_mouse();			
-			
-		    // #importante:
-			// Agora vamos manipular os valores obtidos atravs da 
-			// funo de atualizao dos valores.
-		
-			mouse_x = (mouse_x & 0x000003FF ); 
-		    mouse_y = (mouse_y & 0x000003FF );		
-		    
-			// Checando limites.
-            // #todo: Os valores foram determinados. 
-			// Precisamos usar variveis.
-			
-			if ( mouse_x < 1 ){ mouse_x = 1; }	
-		    if ( mouse_y < 1 ){ mouse_y = 1; }
-			
-		    if(	mouse_x > (SavedX-16) )
-			{ 
-				mouse_x = (SavedX-16); 
-		    }
-		    
-			if(	mouse_y > (SavedY-16) )
-			{ 
-				mouse_y = (SavedY-16); 
-			}
-			
-			//
-			// # Draw BMP #
-		    //
-			
-            //nova tcnica.
-			// Isso est funcionando bem.			
-            //+ copia no LFB um retngulo do backbuffer para apagar o ponteiro antigo.
-            //+ decodifica o mouse diretamente no LFB.				
-			//copiar para o lfb o antigo retngulo. 
-			//Para apagar o ponteiro que est no lfb.
-			
-			refresh_rectangle ( saved_mouse_x, saved_mouse_y, 20, 20 );	      //apaga o antigo
-			bmpDisplayMousePointerBMP ( mouseBMPBuffer, mouse_x, mouse_y );   //acende o novo.
-          
-            //#debug		  
-		    //draw_text ( gui->main, mouse_x, mouse_y, COLOR_YELLOW, "+" );
-		    //refresh_rectangle ( mouse_x, mouse_y, 8, 8 );					
-			
-			//#bugbug:
-			//testando .... na vamos exibir o ponteiro ..
-			//se no falhar  porque o problema est na exibio do ponteiro.
-			//teste feito, falhou mesmo sem exibir o ponteiro, ento o problema 
-			//na est na exibio do ponteiro.
-			
+
+			// O pacote est completo.
+			mouse_ring_put ();
             break;
 
         default:
 		    count_mouse = 0;
-            break;		
+            break;
 	};
-	
-	
+}
+
+
+/*
+ * mouse_move:
+ *     Aplica o pacote atual na posio do ponteiro.
+ */
+
+static void mouse_move (void){
+
+	update_mouse ();
+
+	mouse_x = (mouse_x & 0x000003FF );
+	mouse_y = (mouse_y & 0x000003FF );
+
+	// Checando limites.
+
+	if ( mouse_x < 1 ){ mouse_x = 1; }
+	if ( mouse_y < 1 ){ mouse_y = 1; }
+
+	if ( mouse_x > (SavedX-16) ){ mouse_x = (SavedX-16); }
+	if ( mouse_y > (SavedY-16) ){ mouse_y = (SavedY-16); }
+}
+
+
+/*
+ * mouse_draw_pointer:
+ *     O ponteiro  um sprite, s mudamos a posio. O LFB 
+ * atualizado no mximo uma vez por tick. (sprite.h)
+ *     Sem o sprite:
+ *     + copia no LFB um retngulo do backbuffer para apagar o ponteiro antigo.
+ *     + decodifica o mouse diretamente no LFB.
+ *     saved_mouse_x/y  onde o ponteiro foi pintado pela ltima vez.
+ */
+
+static void mouse_draw_pointer (void){
+
+	if ( spriteIsReady (SPRITE_POINTER) == 1 )
+	{
+		spriteMove ( SPRITE_POINTER, mouse_x, mouse_y );
+		spriteShow ( SPRITE_POINTER, 1 );
+		spriteUpdate ();
+
+		saved_mouse_x = mouse_x;
+		saved_mouse_y = mouse_y;
+		return;
+	}
+
+	refresh_rectangle ( saved_mouse_x, saved_mouse_y, 20, 20 );	      //apaga o antigo
+	bmpDisplayMousePointerBMP ( mouseBMPBuffer, mouse_x, mouse_y );   //acende o novo.
+
+	saved_mouse_x = mouse_x;
+	saved_mouse_y = mouse_y;
+}
+
+
+static void mouse_dispatch (void);
+
+
+/*
+ ********************************************************
+ * mouseBottomHalf:
+ *     Esvazia a fila de pacotes. (trabalho adiado)
+ *
+ *     Os pacotes de movimento seguidos viram um s evento: o ponteiro
+ *  pintado e as janelas so escaneadas uma vez, na posio final.
+ *     Um pacote que muda o estado dos botes  entregue na hora, com
+ * a sua posio, para o clique no mudar de lugar.
+ */
+
+void mouseBottomHalf (void){
+
+	struct mouse_packet_d *p;
+	int Changed;
+	int Pending = 0;
+
+	while ( mouse_ring_tail != mouse_ring_head )
+	{
+		p = &mouse_ring[mouse_ring_tail & (MOUSE_RING_SIZE -1)];
+
+		// mouse_packet_data ainda  o pacote anterior.
+		Changed = ( ( (p->data ^ mouse_packet_data) & 0x07 ) != 0 );
+
+		mouse_packet_data = p->data;
+		mouse_packet_x = p->x;
+		mouse_packet_y = p->y;
+
+		__asm__ __volatile__ ( "" : : : "memory" );
+
+		mouse_ring_tail++;
+
+		mouse_move ();
+
+		if ( Changed == 1 )
+		{
+			mouse_draw_pointer ();
+			mouse_dispatch ();
+			mouse_events++;
+			Pending = 0;
+
+		}else{
+
+			Pending = 1;
+		};
+	};
+
+	if ( Pending == 1 )
+	{
+		mouse_draw_pointer ();
+		mouse_dispatch ();
+		mouse_events++;
+	}
+}
+
+
+/*
+ ********************************************************
+ * mouse_dispatch:
+ *     Estado dos botes, escaneamento das janelas e mensagens
+ * para a thread da janela sob o ponteiro.
+ *     Obs: Temos externs no incio desse arquivo.
+ */
+
+static void mouse_dispatch (void){
+
+    // #importante:
+	// Essa ser a thread que receber a mensagem
+
+	struct thread_d *t;
+
+	// #importante:
+	// Essa ser a janela afetada por qualquer evento de mouse.
+	// ID de janela.
+
+    struct window_d *Window;
+	int wID;
+
+
 	// #importante 
 	// Por outro lado o mouse deve confrontar seu posicionamento com 
 	// todas as janelas, para saber se as coordenadas atuais esto passando 
@@ -814,12 +919,7 @@ void mouseHandler (void)
 						
 						if ( (void *) Window != NULL ){
 						
-                            t->window = Window;
-						    t->msg = MSG_MOUSEKEYDOWN;
-							t->long1 = 1;
-							t->long2 = 0;
-							
-							t->newmessageFlag = 1;
+                            msgqPostMessage ( t, Window, MSG_MOUSEKEYDOWN, 1, 0 );
 						}
 										    
 					    //atualiza o estado anterior.
@@ -835,12 +935,7 @@ void mouseHandler (void)
 						
 					if ( (void *) Window != NULL ){
 						
-                        t->window = Window;
-					    t->msg = MSG_MOUSEKEYUP;
-						t->long1 = 1;
-						t->long2 = 0;
-							
-						t->newmessageFlag = 1;
+                        msgqPostMessage ( t, Window, MSG_MOUSEKEYUP, 1, 0 );
 					}						
 						
 					old_mouse_buttom_1 = 0;	
@@ -867,12 +962,7 @@ void mouseHandler (void)
 						
 						if ( (void *) Window != NULL ){
 						
-                            t->window = Window;
-						    t->msg = MSG_MOUSEKEYDOWN;
-							t->long1 = 2;
-							t->long2 = 0;
-							
-							t->newmessageFlag = 1;
+                            msgqPostMessage ( t, Window, MSG_MOUSEKEYDOWN, 2, 0 );
 						}						
 				    
 					    //atualiza o estado anterior.
@@ -884,12 +974,7 @@ void mouseHandler (void)
 					//up
 					if ( (void *) Window != NULL ){
 						
-                        t->window = Window;
-					    t->msg = MSG_MOUSEKEYUP;
-						t->long1 = 2;
-						t->long2 = 0;
-							
-						t->newmessageFlag = 1;
+                        msgqPostMessage ( t, Window, MSG_MOUSEKEYUP, 2, 0 );
 					}	
 						
 					old_mouse_buttom_2 = 0;
@@ -916,12 +1001,7 @@ void mouseHandler (void)
 						
 						if ( (void *) Window != NULL ){
 						
-                            t->window = Window;
-						    t->msg = MSG_MOUSEKEYDOWN;
-							t->long1 = 3;
-							t->long2 = 0;
-							
-							t->newmessageFlag = 1;
+                            msgqPostMessage ( t, Window, MSG_MOUSEKEYDOWN, 3, 0 );
 						}	 						
 				    
 					    //atualiza o estado anterior.
@@ -933,12 +1013,7 @@ void mouseHandler (void)
 					//up
 					if ( (void *) Window != NULL ){
 						
-                        t->window = Window;
-					    t->msg = MSG_MOUSEKEYUP;
-						t->long1 = 3;
-						t->long2 = 0;
-							
-						t->newmessageFlag = 1;
+                        msgqPostMessage ( t, Window, MSG_MOUSEKEYUP, 3, 0 );
 					}	
 						
 					old_mouse_buttom_3 = 0;
@@ -979,12 +1054,8 @@ void mouseHandler (void)
 					
 					    //if ( (void *) Window != NULL ){
 						
-                        t->window = (struct window_d *) windowList[mouseover_window];
-					    t->msg = MSG_MOUSEEXITED;
-						t->long1 = 0;
-						t->long2 = 0;
-						
-						t->newmessageFlag = 1;
+                        msgqPostMessage ( t, (struct window_d *) windowList[mouseover_window], MSG_MOUSEEXITED,
+                            0, 0 );
 					    //}	
 				    };
 				
@@ -992,12 +1063,7 @@ void mouseHandler (void)
 				    //Agora enviamos uma mensagem pra a nova janela que o mouse 
 				    //est passando por cima.
 						
-                    t->window = Window;
-					t->msg = MSG_MOUSEOVER;
-					t->long1 = 0;
-					t->long2 = 0;
-						
-					t->newmessageFlag = 1;
+                    msgqPostMessage ( t, Window, MSG_MOUSEOVER, 0, 0 );
 				
 			
 			        //ja que entramos em uma nova janela, vamos mostra isso.
@@ -1329,6 +1395,11 @@ int ps2_mouse_globals_initialize (void){
 		die ();
 	}
 	
+	// A partir daqui os pacotes so tratados fora da irq.
+	// (mouseBottomHalf)
+	
+	mouse_defer_id = (int) deferRegister ( "mouse", mouseBottomHalf );
+	
 	//printf("ps2_mouse_globals_initialize: done\n");
 	//refresh_screen();	
 
@@ -87,28 +87,17 @@ void screenSetSize( unsigned long width, unsigned long height )
 /*
  * refresh_screen:
  *     Coloca o conteúdo do BackBuffer no LFB da memória de vídeo.
+ *     Somente os retângulos sujos. (damage.c)
  */
 
 void refresh_screen (void){
 	
-	unsigned long *backbuffer = (unsigned long *) BACKBUFFER_VA;
-	unsigned long *frontbuffer = (unsigned long *) FRONTBUFFER_VA;
+	//antigo.
+	//Copiava SavedX*SavedY pixels a cada chamada.
+	//for ( i=0; i< SavedX*SavedY; i++ )
+	//	frontbuffer[i] = backbuffer[i];	
 	
-	int i=0;
-	
-	 vsync ();	
-	
-	//#test velocidade?
-	for ( i=0; i< SavedX*SavedY; i++ )
-		frontbuffer[i] = backbuffer[i];	
-	
-    //antigo.
-	//isso funciona.
-	//screenRefresh();
-
-	//teste
-	//isso funciona.
-    //refresh_rectangle ( 0, 0, SavedX, SavedY );
+	damageRefresh ();
 }
 
 
@@ -138,6 +127,9 @@ int screenInit (void){
 	
 	screenSetSize ( (unsigned long) SavedX, (unsigned long) SavedY );
 	
+	// Retângulos sujos do backbuffer.
+	damageInit ();
+	
 	// Setup Screen structure.
 	
     Screen = (void *) malloc( sizeof(struct screen_d) );
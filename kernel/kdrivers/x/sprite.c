@@ -0,0 +1,506 @@
+/*
+ * File: x/sprite.c
+ *
+ *     Sprites on the frontbuffer, with save-under. (see sprite.h)
+ *
+ *     The sprites are stacked by id, the higher id on top. When one
+ * changes, the ones above it are hidden and shown again too.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+extern unsigned long SavedBPP;
+
+
+static struct sprite_d sprite_list[SPRITE_MAX];
+
+// Decoding buffer. (bmpDecode)
+static unsigned long sprite_pixels[SPRITE_PIXELS_MAX];
+
+static spinlock_t sprite_spinlock;
+
+static unsigned long sprite_bpp = 3;
+
+// Tick of the last LFB update.
+static int sprite_tick_valid = 0;
+static unsigned long sprite_last_tick;
+
+// Copies from the backbuffer in progress, and the lowest sprite
+// they have hidden.
+static int sprite_copying = 0;
+static int sprite_copy_low = SPRITE_MAX;
+
+
+static int sprite_valid ( int id ){
+
+	if ( id < 0 || id >= SPRITE_MAX ){
+		return 0;
+	}
+
+	if ( sprite_list[id].used != 1 || sprite_list[id].magic != 1234 ){
+		return 0;
+	}
+
+	return 1;
+}
+
+
+static unsigned char *sprite_lfb ( unsigned long x, unsigned long y ){
+
+	return (unsigned char *) FRONTBUFFER_VA + ( ( (y * SavedX) + x ) * sprite_bpp );
+}
+
+
+/* Put the save-under back. */
+
+static void sprite_hide ( struct sprite_d *s ){
+
+	unsigned long Line;
+	unsigned long i;
+
+	if ( s->shown != 1 ){
+		return;
+	}
+
+	Line = s->shown_width * sprite_bpp;
+
+	for ( i=0; i < s->shown_height; i++ )
+	{
+		memcpy ( (void *) sprite_lfb ( s->shown_x, s->shown_y + i ),
+		    (const void *) &s->save[i * Line], Line );
+	};
+
+	s->shown = 0;
+}
+
+
+/* Save what is below and draw the opaque pixels. */
+
+static void sprite_show ( struct sprite_d *s ){
+
+	unsigned char *Dst;
+	unsigned char *Src;
+	unsigned char *Mask;
+	unsigned long Width, Height;
+	unsigned long Line;
+	unsigned long i, j, k;
+
+	if ( s->visible != 1 || s->shown == 1 ){
+		return;
+	}
+
+	if ( s->x >= SavedX || s->y >= SavedY ){
+		return;
+	}
+
+	Width = s->width;
+	Height = s->height;
+
+	if ( Width > SavedX - s->x ){ Width = SavedX - s->x; }
+	if ( Height > SavedY - s->y ){ Height = SavedY - s->y; }
+
+	Line = Width * sprite_bpp;
+
+	for ( i=0; i < Height; i++ )
+	{
+		Dst = sprite_lfb ( s->x, s->y + i );
+		Src = &s->image[i * s->width * sprite_bpp];
+		Mask = &s->mask[i * s->width];
+
+		memcpy ( (void *) &s->save[i * Line], (const void *) Dst, Line );
+
+		for ( j=0; j < Width; j++ )
+		{
+			if ( Mask[j] == 0 ){
+				continue;
+			}
+
+			for ( k=0; k < sprite_bpp; k++ ){
+				Dst[(j * sprite_bpp) + k] = Src[(j * sprite_bpp) + k];
+			};
+		};
+	};
+
+	s->shown_x = s->x;
+	s->shown_y = s->y;
+	s->shown_width = Width;
+	s->shown_height = Height;
+	s->shown = 1;
+}
+
+
+/* The sprites from low up, the top first. */
+
+static void sprite_hide_from ( int low ){
+
+	int i;
+
+	for ( i = SPRITE_MAX -1; i >= low; i-- )
+	{
+		if ( sprite_valid (i) == 1 ){
+			sprite_hide ( &sprite_list[i] );
+		}
+	};
+}
+
+
+static void sprite_show_from ( int low ){
+
+	int i;
+
+	for ( i = low; i < SPRITE_MAX; i++ )
+	{
+		if ( sprite_valid (i) == 1 ){
+			sprite_show ( &sprite_list[i] );
+		}
+	};
+}
+
+
+/* Lowest dirty sprite, or SPRITE_MAX. */
+
+static int sprite_dirty_low (void){
+
+	int i;
+
+	for ( i=0; i < SPRITE_MAX; i++ )
+	{
+		if ( sprite_valid (i) == 1 && sprite_list[i].dirty == 1 ){
+			return (int) i;
+		}
+	};
+
+	return (int) SPRITE_MAX;
+}
+
+
+/*
+ * sprite_flush:
+ *     The changes go to the LFB, once per tick.
+ *     With the lock.
+ */
+
+static int sprite_flush (void){
+
+	int Low;
+	int i;
+
+	Low = sprite_dirty_low ();
+
+	if ( Low == SPRITE_MAX ){
+		return 0;
+	}
+
+	if ( sprite_copying > 0 ){
+		return (int) 1;
+	}
+
+	if ( sprite_tick_valid == 1 && sprite_last_tick == sys_time_ticks_total ){
+		return (int) 1;
+	}
+
+	sprite_hide_from (Low);
+
+	for ( i = Low; i < SPRITE_MAX; i++ ){
+		sprite_list[i].dirty = 0;
+	};
+
+	sprite_show_from (Low);
+
+	sprite_last_tick = sys_time_ticks_total;
+	sprite_tick_valid = 1;
+
+	sprite_updates++;
+
+	return 0;
+}
+
+
+void spriteInit (void){
+
+	int i;
+
+	for ( i=0; i < SPRITE_MAX; i++ )
+	{
+		sprite_list[i].used = 0;
+		sprite_list[i].magic = 0;
+		sprite_list[i].visible = 0;
+		sprite_list[i].shown = 0;
+		sprite_list[i].dirty = 0;
+	};
+
+	spinLockInit (&sprite_spinlock);
+
+	sprite_tick_valid = 0;
+	sprite_copying = 0;
+	sprite_copy_low = SPRITE_MAX;
+
+	sprite_updates = 0;
+	sprite_deferred = 0;
+}
+
+
+/*
+ * spriteLoadBMP:
+ *     Decode the BMP once. The pixels with the key color are
+ * transparent.
+ */
+
+int spriteLoadBMP ( int id, char *address, unsigned long key ){
+
+	struct sprite_d *s;
+	unsigned char *p;
+	unsigned long Width, Height;
+	unsigned long Color;
+	unsigned long Flags;
+	unsigned long i;
+	int Status;
+
+	if ( id < 0 || id >= SPRITE_MAX ){
+		return (int) 1;
+	}
+
+	s = &sprite_list[id];
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	Status = (int) bmpDecode ( address, sprite_pixels, SPRITE_PIXELS_MAX,
+	                   &Width, &Height );
+
+	if ( Status != 0 || Width > SPRITE_SIZE_MAX || Height > SPRITE_SIZE_MAX )
+	{
+		spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+		return (int) 1;
+	}
+
+	if ( s->used == 1 ){
+		sprite_hide_from (id);
+	}
+
+	if ( SavedBPP == 32 ){
+		sprite_bpp = 4;
+	}else{
+		sprite_bpp = 3;
+	};
+
+	for ( i=0; i < (Width * Height); i++ )
+	{
+		Color = sprite_pixels[i];
+
+		p = &s->image[i * sprite_bpp];
+
+		p[0] = (Color & 0xFF);
+		p[1] = (Color >> 8) & 0xFF;
+		p[2] = (Color >> 16) & 0xFF;
+
+		if ( sprite_bpp == 4 ){
+			p[3] = (Color >> 24) + 1;
+		}
+
+		s->mask[i] = ( Color != (key & 0x00FFFFFF) );
+	};
+
+	s->width = Width;
+	s->height = Height;
+
+	if ( s->used != 1 )
+	{
+		s->visible = 0;
+		s->shown = 0;
+		s->x = 0;
+		s->y = 0;
+	}
+
+	s->dirty = 0;
+	s->used = 1;
+	s->magic = 1234;
+
+	if ( sprite_copying == 0 ){
+		sprite_show_from (id);
+	}
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+
+	return 0;
+}
+
+
+int spriteIsReady ( int id ){
+
+	return (int) sprite_valid (id);
+}
+
+
+void spriteMove ( int id, unsigned long x, unsigned long y ){
+
+	struct sprite_d *s;
+	unsigned long Flags;
+
+	if ( sprite_valid (id) == 0 ){
+		return;
+	}
+
+	s = &sprite_list[id];
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	if ( s->x != x || s->y != y )
+	{
+		s->x = x;
+		s->y = y;
+		s->dirty = 1;
+	}
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+void spriteShow ( int id, int visible ){
+
+	struct sprite_d *s;
+	unsigned long Flags;
+
+	if ( sprite_valid (id) == 0 ){
+		return;
+	}
+
+	s = &sprite_list[id];
+
+	if ( visible != 0 ){
+		visible = 1;
+	}
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	if ( s->visible != visible )
+	{
+		s->visible = visible;
+		s->dirty = 1;
+	}
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+void spriteUpdate (void){
+
+	unsigned long Flags;
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	if ( sprite_flush () != 0 ){
+		sprite_deferred++;
+	}
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+void spriteTimer (void){
+
+	unsigned long Flags;
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	sprite_flush ();
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+int spritePending (void){
+
+	return (int) ( sprite_dirty_low () != SPRITE_MAX );
+}
+
+
+/*
+ * spriteBeginCopy:
+ *     A copy from the backbuffer will write this rectangle of the LFB.
+ *     The sprites it touches, and the ones above them, are hidden
+ * until the copy is done. The copy runs without the lock.
+ */
+
+void
+spriteBeginCopy ( unsigned long x,
+                  unsigned long y,
+                  unsigned long width,
+                  unsigned long height )
+{
+	struct sprite_d *s;
+	unsigned long Flags;
+	int i;
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	sprite_copying++;
+
+	for ( i=0; i < SPRITE_MAX; i++ )
+	{
+		if ( sprite_valid (i) == 0 ){
+			continue;
+		}
+
+		s = &sprite_list[i];
+
+		if ( s->shown != 1 ){
+			continue;
+		}
+
+		if ( x >= s->shown_x + s->shown_width || s->shown_x >= x + width ||
+		     y >= s->shown_y + s->shown_height || s->shown_y >= y + height )
+		{
+			continue;
+		}
+
+		sprite_hide_from (i);
+
+		if ( i < sprite_copy_low ){
+			sprite_copy_low = i;
+		}
+
+		break;
+	};
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+void spriteEndCopy (void){
+
+	unsigned long Flags;
+	int i;
+
+	Flags = spinLockIrqSave (&sprite_spinlock);
+
+	if ( sprite_copying > 0 ){
+		sprite_copying--;
+	}
+
+	if ( sprite_copying == 0 && sprite_copy_low < SPRITE_MAX )
+	{
+		// The pending moves go together.
+		for ( i = sprite_copy_low; i < SPRITE_MAX; i++ ){
+			sprite_list[i].dirty = 0;
+		};
+
+		sprite_show_from (sprite_copy_low);
+
+		sprite_copy_low = SPRITE_MAX;
+	}
+
+	spinUnlockIrqRestore ( &sprite_spinlock, Flags );
+}
+
+
+//
+// End.
+//
+
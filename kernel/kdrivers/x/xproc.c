@@ -159,12 +159,7 @@ XPROC_SEND_MESSAGE ( struct window_d *window,
 		//??
 		//ja o input de mouse deve ir para a thread de qualquer janela.
 		
-		t->window = window;
-		t->msg = (int) msg;
-		t->long1 = long1;
-		t->long2 = long2;
-		
-		t->newmessageFlag = 1;
+		msgqPostMessage ( t, window, msg, long1, long2 );
 		
 	};	
  	
@@ -190,6 +185,7 @@ void xxxtestSHELLServer (void){
 	//no caso o server shell/gws.
 
     struct thread_d *t;
+    struct thread_msg_d m;
     
 	t = (void *) threadList[current_thread];
 	
@@ -198,19 +194,18 @@ void xxxtestSHELLServer (void){
 	//draw horizontal line
 	//x1, y , x2, color
     
-	t->window = 0;
-	t->msg = 9004;  
-	t->long1 = 100; //x
-	t->long2 = 100; //y
-	
-	t->long3 = 200; //width
-	t->long4 = COLOR_YELLOW;
-	t->long5 = 0;
-	t->long6 = 0;
+	m.window = 0;
+	m.msg = 9004;  
+	m.long1 = 100; //x
+	m.long2 = 100; //y
+	
+	m.long3 = 200; //width
+	m.long4 = COLOR_YELLOW;
+	m.long5 = 0;
+	m.long6 = 0;
 	// ... 
     
-	//sinalizamos que temos uma mensagem.
-	t->newmessageFlag = 1; 
+	msgqPost ( t, &m );
 }
 
 
@@ -0,0 +1,766 @@
+/*
+ * File: fs/bcache.c
+ *
+ *     Buffer cache for the disk sectors.
+ *
+ *     read_lba, write_lba, the FAT, the directories and the data of
+ * the files use the cache, so the FAT and the root dir, loaded again
+ * for every file, and a program or an image loaded again, come from the
+ * memory after the first time.
+ *     The sectors that are not in the cache are read in runs, with one
+ * disk command for each run, and the sync writes the dirty sectors
+ * in runs too. (hddReadWriteVector)
+ *     The data of the buffers is taken from the paged pool.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+// Deferred work of the periodic write-back. (defer.c)
+static int bcache_defer_id = -1;
+
+// A public function is running. The deferred write-back waits for the
+// next call, as an irq can come in the middle of a disk command.
+static int bcache_busy;
+
+
+/* Hash of a lba. */
+
+static struct bcache_d **bcache_bucket ( unsigned long lba ){
+
+	return (struct bcache_d **) &bcacheHash[ lba & (BCACHE_HASH_COUNT -1) ];
+}
+
+
+/* Find a sector in the cache. */
+
+static struct bcache_d *bcache_lookup ( unsigned long lba ){
+
+	struct bcache_d *b;
+
+	b = *bcache_bucket (lba);
+
+	while ( (void *) b != NULL )
+	{
+		if ( b->valid == 1 && b->lba == lba ){
+			return (struct bcache_d *) b;
+		}
+
+		b = b->hash_next;
+	};
+
+	return NULL;
+}
+
+
+static void bcache_hash_remove ( struct bcache_d *b ){
+
+	struct bcache_d **p;
+
+	p = bcache_bucket (b->lba);
+
+	while ( (void *) *p != NULL )
+	{
+		if ( *p == b )
+		{
+			*p = b->hash_next;
+			b->hash_next = NULL;
+			return;
+		}
+
+		p = &(*p)->hash_next;
+	};
+}
+
+
+/* Move the buffer to the head of the LRU list. */
+
+static void bcache_touch ( struct bcache_d *b ){
+
+	if ( bcacheLRUHead == b ){
+		return;
+	}
+
+	//Remove.
+	if ( (void *) b->lru_prev != NULL ){
+		b->lru_prev->lru_next = b->lru_next;
+	}
+
+	if ( (void *) b->lru_next != NULL ){
+		b->lru_next->lru_prev = b->lru_prev;
+	}else{
+		bcacheLRUTail = b->lru_prev;
+	};
+
+	//Insert at the head.
+	b->lru_prev = NULL;
+	b->lru_next = bcacheLRUHead;
+
+	if ( (void *) bcacheLRUHead != NULL ){
+		bcacheLRUHead->lru_prev = b;
+	}
+
+	bcacheLRUHead = b;
+
+	if ( (void *) bcacheLRUTail == NULL ){
+		bcacheLRUTail = b;
+	}
+}
+
+
+/*
+ * bcache_write_back:
+ *     Send a dirty buffer to the disk.
+ *     If the write fails the buffer stays dirty. Return -1.
+ */
+
+static int bcache_write_back ( struct bcache_d *b ){
+
+	if ( b->valid != 1 || b->dirty != 1 ){
+		return 0;
+	}
+
+	if ( hddWriteSectors ( (unsigned long) b->data, b->lba, 1 ) != 0 )
+	{
+		bcacheWriteErrors++;
+		return (int) -1;
+	}
+
+	b->dirty = 0;
+
+	bcacheDirtyCount--;
+	bcacheDiskWrites++;
+
+	return 0;
+}
+
+
+/*
+ * bcache_get:
+ *     The buffer of the sector.
+ *     If the sector is not in the cache, we reuse the least recently
+ * used buffer. The new buffer is not valid yet.
+ *     A dirty buffer that can not be written is not reused.
+ *     file = 1: data of a file. When BCACHE_FILE_MAX buffers have file
+ * data, only the least recently used of them is reused.
+ * NULL if all of them are like that.
+ */
+
+static struct bcache_d *bcache_get ( unsigned long lba, int file ){
+
+	struct bcache_d *b;
+
+	b = bcache_lookup (lba);
+
+	if ( (void *) b != NULL )
+	{
+		// The FAT or a directory now.
+		if ( file == 0 && b->file == 1 )
+		{
+			b->file = 0;
+			bcacheFileCount--;
+		}
+
+		bcache_touch (b);
+		return (struct bcache_d *) b;
+	}
+
+	b = bcacheLRUTail;
+
+	while ( (void *) b != NULL )
+	{
+		if ( ( file == 0 || b->file == 1 || bcacheFileCount < BCACHE_FILE_MAX ) &&
+		     bcache_write_back (b) == 0 )
+		{
+			break;
+		}
+
+		b = b->lru_prev;
+	};
+
+	if ( (void *) b == NULL ){
+		return NULL;
+	}
+
+	if ( b->file == 1 ){
+		bcacheFileCount--;
+	}
+
+	b->file = file;
+
+	if ( file == 1 ){
+		bcacheFileCount++;
+	}
+
+	// A failed read can leave a buffer in the hash that is not valid.
+	bcache_hash_remove (b);
+
+	b->lba = lba;
+	b->valid = 0;
+	b->dirty = 0;
+
+	b->hash_next = *bcache_bucket (lba);
+	*bcache_bucket (lba) = b;
+
+	bcache_touch (b);
+
+	return (struct bcache_d *) b;
+}
+
+
+/* 1 if the buffer has the same data. */
+
+static int bcache_same ( struct bcache_d *b, unsigned long address ){
+
+	unsigned long *a = (unsigned long *) b->data;
+	unsigned long *c = (unsigned long *) address;
+	int i;
+
+	for ( i=0; i < (BCACHE_SECTOR_SIZE / 4); i++ )
+	{
+		if ( a[i] != c[i] ){
+			return (int) 0;
+		}
+	};
+
+	return (int) 1;
+}
+
+
+static int bcache_sync (void);
+
+
+/*
+ **************************************************
+ * bcacheRead:
+ *     Copy a sector to 'address'.
+ *     From the cache if it is there, from the disk if it is not.
+ *     Return -1 if the read failed. The buffer is not valid then.
+ */
+
+int bcacheRead ( unsigned long address, unsigned long lba ){
+
+	struct bcache_d *b;
+	int Status = 0;
+
+	if ( bcache_initialized != 1 ){
+		return (int) hddReadSectors ( address, lba, 1 );
+	}
+
+	bcache_busy++;
+
+	if ( bcache_sync_request == 1 ){
+		bcache_sync ();
+	}
+
+	b = bcache_get ( lba, 0 );
+
+	if ( (void *) b == NULL )
+	{
+		bcacheMisses++;
+
+		if ( hddReadSectors ( address, lba, 1 ) != 0 ){
+			Status = -1;
+		}
+
+		bcacheDiskReads++;
+
+	}else if ( b->valid == 1 ){
+
+		bcacheHits++;
+
+		memcpy ( (void *) address, (const void *) b->data, BCACHE_SECTOR_SIZE );
+
+	}else{
+
+		bcacheMisses++;
+		bcacheDiskReads++;
+
+		if ( hddReadSectors ( (unsigned long) b->data, lba, 1 ) != 0 )
+		{
+			bcache_hash_remove (b);
+			Status = -1;
+
+		}else{
+
+			b->valid = 1;
+
+			memcpy ( (void *) address, (const void *) b->data, BCACHE_SECTOR_SIZE );
+		};
+	};
+
+	bcache_busy--;
+
+	return (int) Status;
+}
+
+
+/*
+ * bcache_read_missing:
+ *     Read 'count' sectors that are not in the cache, with one disk
+ * command.
+ *     The sectors go to buffers of the cache and then to 'address'.
+ *     keep = 1: The FAT and the directories.
+ *     keep = 0: Data of a file. (BCACHE_FILE_MAX)
+ *     keep = -1: The sectors go straight to 'address'.
+ */
+
+static int 
+bcache_read_missing ( unsigned long address, 
+                      unsigned long lba, 
+                      int count, 
+                      int keep )
+{
+	struct bcache_d *run[BCACHE_RUN_MAX];
+	struct hdd_iovec_d iov[BCACHE_RUN_MAX];
+	int i;
+
+	if ( keep == -1 )
+	{
+		if ( hddReadSectors ( address, lba, count ) != 0 ){
+			return (int) -1;
+		}
+
+		bcacheDiskReads = bcacheDiskReads + count;
+
+		return (int) 0;
+	}
+
+	for ( i=0; i < count; i++ )
+	{
+		run[i] = bcache_get ( lba + i, ( keep == 0 ) );
+
+		// No buffer. The run goes straight to 'address'.
+		if ( (void *) run[i] == NULL )
+		{
+			while ( i > 0 )
+			{
+				i--;
+				bcache_hash_remove ( run[i] );
+			};
+
+			return (int) bcache_read_missing ( address, lba, count, -1 );
+		}
+
+		iov[i].base = (void *) run[i]->data;
+		iov[i].len = BCACHE_SECTOR_SIZE;
+	};
+
+	if ( hddReadWriteVector ( 0, lba, iov, count ) != 0 )
+	{
+		for ( i=0; i < count; i++ ){
+			bcache_hash_remove ( run[i] );
+		};
+
+		return (int) -1;
+	}
+
+	for ( i=0; i < count; i++ )
+	{
+		run[i]->valid = 1;
+
+		memcpy ( (void *) ( address + (i * BCACHE_SECTOR_SIZE) ), 
+		    (const void *) run[i]->data, BCACHE_SECTOR_SIZE );
+	};
+
+	bcacheDiskReads = bcacheDiskReads + count;
+
+	return (int) 0;
+}
+
+
+/*
+ **************************************************
+ * bcacheReadBlocks:
+ *     Copy 'count' sectors to 'address'.
+ *     The sectors that are in the cache come from the cache, the others
+ * are read in runs of up to BCACHE_RUN_MAX sectors.
+ *     keep = 1 for the FAT and the directories. keep = 0 for the data
+ * of the files, they stay in at most BCACHE_FILE_MAX buffers, so a big
+ * file doesn't take the FAT out of the cache. A read of more than
+ * BCACHE_FILE_MAX sectors doesn't go to the cache.
+ *     Return -1 if some read failed.
+ */
+
+int 
+bcacheReadBlocks ( unsigned long address, 
+                   unsigned long lba, 
+                   unsigned long count, 
+                   int keep )
+{
+	struct bcache_d *b;
+	unsigned long n;
+	int Status = 0;
+
+	if ( bcache_initialized != 1 ){
+		return (int) hddReadSectors ( address, lba, (int) count );
+	}
+
+	bcache_busy++;
+
+	if ( bcache_sync_request == 1 ){
+		bcache_sync ();
+	}
+
+	if ( keep == 0 && count > BCACHE_FILE_MAX ){
+		keep = -1;
+	}
+
+	while ( count > 0 )
+	{
+		b = bcache_lookup (lba);
+
+		if ( (void *) b != NULL )
+		{
+			bcacheHits++;
+			bcache_touch (b);
+
+			memcpy ( (void *) address, (const void *) b->data, BCACHE_SECTOR_SIZE );
+
+			n = 1;
+
+		}else{
+
+			// The run ends at the next sector that is in the cache.
+			n = 1;
+			while ( n < count && n < BCACHE_RUN_MAX && 
+			        (void *) bcache_lookup ( lba + n ) == NULL )
+			{
+				n++;
+			};
+
+			bcacheMisses = bcacheMisses + n;
+
+			if ( bcache_read_missing ( address, lba, (int) n, keep ) != 0 ){
+				Status = -1;
+			}
+		};
+
+		address = address + (n * BCACHE_SECTOR_SIZE);
+		lba = lba + n;
+		count = count - n;
+	};
+
+	bcache_busy--;
+
+	return (int) Status;
+}
+
+
+/*
+ **************************************************
+ * bcacheWrite:
+ *     Copy 'address' to the buffer of the sector and mark it as dirty.
+ *     Nothing changes if the buffer has the same data.
+ *     Without a buffer the sector goes straight to the disk.
+ *     Return -1 if that write failed.
+ */
+
+int bcacheWrite ( unsigned long address, unsigned long lba ){
+
+	struct bcache_d *b;
+	int Status = 0;
+
+	if ( bcache_initialized != 1 ){
+		return (int) hddWriteSectors ( address, lba, 1 );
+	}
+
+	bcache_busy++;
+
+	if ( bcache_sync_request == 1 ){
+		bcache_sync ();
+	}
+
+	b = bcache_get ( lba, 0 );
+
+	if ( (void *) b == NULL )
+	{
+		if ( hddWriteSectors ( address, lba, 1 ) != 0 )
+		{
+			bcacheWriteErrors++;
+			Status = -1;
+
+		}else{
+
+			bcacheDiskWrites++;
+		};
+
+	}else if ( b->valid == 1 && bcache_same ( b, address ) == 1 ){
+
+		bcacheCleanWrites++;
+
+	}else{
+
+		memcpy ( (void *) b->data, (const void *) address, BCACHE_SECTOR_SIZE );
+		b->valid = 1;
+
+		if ( b->dirty != 1 )
+		{
+			b->dirty = 1;
+			bcacheDirtyCount++;
+		}
+	};
+
+	bcache_busy--;
+
+	return (int) Status;
+}
+
+
+/*
+ * bcache_sync:
+ *     Send all the dirty buffers to the disk and flush the cache
+ * of the disk.
+ *     Dirty sectors that follow each other go in the same disk command.
+ *     The sectors of a command that failed stay dirty.
+ *     Return the number of sectors written, or -1 if some write failed.
+ */
+
+static int bcache_sync (void){
+
+	struct bcache_d *run[BCACHE_RUN_MAX];
+	struct hdd_iovec_d iov[BCACHE_RUN_MAX];
+	struct bcache_d *b;
+	struct bcache_d *p;
+	int Status = 0;
+	int Count = 0;
+	int Last;
+	int n;
+	int i;
+
+	bcache_sync_request = 0;
+
+	if ( bcache_initialized != 1 || bcacheDirtyCount == 0 ){
+		return (int) 0;
+	}
+
+	// A run that was cut at BCACHE_RUN_MAX goes on in the next pass.
+	do {
+		Last = Count;
+
+		for ( i=0; i < BCACHE_COUNT; i++ )
+		{
+			b = &bcacheList[i];
+
+			if ( b->valid != 1 || b->dirty != 1 ){
+				continue;
+			}
+
+			// Only the first dirty sector of a run starts it.
+			if ( b->lba > 0 )
+			{
+				p = bcache_lookup ( b->lba -1 );
+
+				if ( (void *) p != NULL && p->dirty == 1 ){
+					continue;
+				}
+			}
+
+			n = 0;
+
+			while ( (void *) b != NULL && b->dirty == 1 && n < BCACHE_RUN_MAX )
+			{
+				run[n] = b;
+				iov[n].base = (void *) b->data;
+				iov[n].len = BCACHE_SECTOR_SIZE;
+				n++;
+
+				b = bcache_lookup ( run[0]->lba + n );
+			};
+
+			if ( hddReadWriteVector ( 1, run[0]->lba, iov, n ) != 0 )
+			{
+				bcacheWriteErrors++;
+				Status = -1;
+				continue;
+			}
+
+			while ( n > 0 )
+			{
+				n--;
+				run[n]->dirty = 0;
+				bcacheDirtyCount--;
+				bcacheDiskWrites++;
+				Count++;
+			};
+		};
+
+	} while ( bcacheDirtyCount > 0 && Count != Last );
+
+	if ( Count > 0 && hddFlushCache () != 0 ){
+		Status = -1;
+	}
+
+	if ( Status != 0 ){
+		return (int) Status;
+	}
+
+	return (int) Count;
+}
+
+
+int bcacheSync (void){
+
+	int Status;
+
+	bcache_busy++;
+	Status = (int) bcache_sync ();
+	bcache_busy--;
+
+	return (int) Status;
+}
+
+
+/*
+ * bcache_sync_work:
+ *     The periodic write-back. (BCACHE_SYNC_TICKS)
+ *     Deferred work, raised by the timer. If the irq came in the middle
+ * of a call of the cache, that call does the sync when it is done.
+ */
+
+static void bcache_sync_work (void){
+
+	if ( bcache_busy != 0 )
+	{
+		bcache_sync_request = 1;
+		return;
+	}
+
+	bcacheSync ();
+}
+
+
+/* Called by the timer. */
+
+void bcacheSyncRequest (void){
+
+	if ( bcache_initialized != 1 || bcacheDirtyCount == 0 ){
+		return;
+	}
+
+	if ( bcache_defer_id == -1 )
+	{
+		bcache_sync_request = 1;
+		return;
+	}
+
+	deferRaise (bcache_defer_id);
+}
+
+
+/*
+ * bcacheShowInfo:
+ *     Show the counters of the cache.
+ */
+
+void bcacheShowInfo (void){
+
+	unsigned long Total;
+	unsigned long Hit = 0;
+
+	printf ("\n[Buffer cache:]\n");
+
+	if ( bcache_initialized != 1 )
+	{
+		printf ("Not initialized\n");
+		return;
+	}
+
+	Total = (bcacheHits + bcacheMisses);
+
+	if ( Total != 0 ){
+		Hit = ( (bcacheHits * 100) / Total );
+	}
+
+	printf ("buffers={%d} file data={%d}/{%d} hits={%d} misses={%d} hit={%d%%}\n",
+	    BCACHE_COUNT, bcacheFileCount, BCACHE_FILE_MAX, bcacheHits, 
+		bcacheMisses, Hit );
+
+	printf ("disk reads={%d} disk writes={%d} clean writes={%d} dirty={%d} write errors={%d}\n",
+	    bcacheDiskReads, bcacheDiskWrites, bcacheCleanWrites,
+		bcacheDirtyCount, bcacheWriteErrors );
+}
+
+
+/*
+ **************************************************
+ * bcacheInit:
+ *     Get the memory for the buffers and build the LRU list.
+ *     Called by fsInit.
+ */
+
+int bcacheInit (void){
+
+	char *Data;
+	int i;
+
+	bcache_initialized = 0;
+	bcache_sync_request = 0;
+
+	Data = (char *) allocPages ( (BCACHE_COUNT * BCACHE_SECTOR_SIZE) / 4096 );
+
+	if ( (void *) Data == NULL )
+	{
+		printf ("bcacheInit: Data\n");
+		return (int) 1;
+	}
+
+	for ( i=0; i < BCACHE_HASH_COUNT; i++ ){
+		bcacheHash[i] = NULL;
+	};
+
+	for ( i=0; i < BCACHE_COUNT; i++ )
+	{
+		bcacheList[i].used = 1;
+		bcacheList[i].magic = 1234;
+
+		bcacheList[i].lba = 0;
+		bcacheList[i].valid = 0;
+		bcacheList[i].dirty = 0;
+		bcacheList[i].file = 0;
+
+		bcacheList[i].data = (char *) ( Data + (i * BCACHE_SECTOR_SIZE) );
+
+		bcacheList[i].hash_next = NULL;
+
+		bcacheList[i].lru_prev = NULL;
+		bcacheList[i].lru_next = NULL;
+
+		if ( i > 0 ){
+			bcacheList[i].lru_prev = &bcacheList[i-1];
+		}
+
+		if ( i < (BCACHE_COUNT -1) ){
+			bcacheList[i].lru_next = &bcacheList[i+1];
+		}
+	};
+
+	bcacheLRUHead = &bcacheList[0];
+	bcacheLRUTail = &bcacheList[BCACHE_COUNT -1];
+
+	bcacheHits = 0;
+	bcacheMisses = 0;
+	bcacheDiskReads = 0;
+	bcacheDiskWrites = 0;
+	bcacheCleanWrites = 0;
+	bcacheDirtyCount = 0;
+	bcacheWriteErrors = 0;
+	bcacheFileCount = 0;
+
+	bcache_busy = 0;
+	bcache_defer_id = (int) deferRegister ( "bcache", bcache_sync_work );
+
+	bcache_initialized = 1;
+
+	return (int) 0;
+}
+
+
+//
+// End.
+//
+
@@ -776,6 +776,12 @@ int fsInit (void){
 	
 	set_spc (1);
 	
+	
+	// Buffer cache. 
+	// Os setores lidos a partir daqui ficam no cache.
+	
+	bcacheInit ();
+	
 
 	// ## initialize currents ##
 
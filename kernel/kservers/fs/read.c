@@ -243,14 +243,8 @@ fatLoadCluster ( unsigned long sector,
                  unsigned long address, 
 				 unsigned long spc )
 {
-	unsigned long i;
-	
-	for ( i=0; i < spc; i++ )
-	{	
-        read_lba ( address, sector + i );
-        
-		address = address + 512; 
-	}
+	// Um comando de disco para o cluster inteiro.
+	bcacheReadBlocks ( address, sector, spc, 0 );
 }
 
 
@@ -274,8 +268,8 @@ void read_lba ( unsigned long address, unsigned long lba ){
 			break;		
 			
 	    case 16:
-		    //hdd.c
-	        my_read_hd_sector ( address, lba, 0, 0 );	    
+		    //bcache.c
+	        bcacheRead ( address, lba );	    
             return;
 			break;		
 			
@@ -339,6 +333,9 @@ fsLoadFile ( unsigned long fat_address,
     int Status;		
 	int i;
     unsigned short next;
+	
+	// O incio do buffer, para o cache de BMP.
+	unsigned long Start = file_address;
 
     unsigned long max = 64;    //?? @todo: rever. Nmero mximo de entradas.
     unsigned long z = 0;       //Deslocamento do rootdir 
@@ -356,6 +353,9 @@ fsLoadFile ( unsigned long fat_address,
 	//?? Primeiro setor do cluster.
 	unsigned long S;  
 	
+	//Clusters seguidos na FAT.
+	unsigned long Count;
+	
 	int Spc;
 	
 	// Updating fat address and root address.
@@ -605,15 +605,27 @@ next_entry:
     };
 	*/
 	
-	read_lba ( file_address, VOLUME1_DATAAREA_LBA + cluster -2 ); 
+	// Os clusters seguidos na FAT so carregados juntos,
+	// um comando de disco para cada trecho do arquivo.
+	// Um cluster  um setor.
+	
+	Count = 1;
+	
+	while ( Count < BCACHE_RUN_MAX && 
+	        fat[cluster + Count -1] == (unsigned short) (cluster + Count) )
+	{
+		Count++;
+	};
+	
+	bcacheReadBlocks ( file_address, VOLUME1_DATAAREA_LBA + cluster -2, Count, 0 ); 
 	
-	//Incrementa o buffer. +512;
+	//Incrementa o buffer. +512 por setor.
 	//SECTOR_SIZE;
-	file_address = (unsigned long) file_address + 512;    	
+	file_address = (unsigned long) file_address + (Count * 512);    	
 	
 	
 	//Pega o prximo cluster na FAT.
-	next = (unsigned short) fat[cluster];		
+	next = (unsigned short) fat[cluster + Count -1];		
 	
 	//Configura o cluster atual.
 	cluster = (unsigned short) next;	
@@ -645,6 +657,10 @@ done:
 	//#debug support
 	//printf("fsLoadFile: done\n");
 	//refresh_screen(); 
+	
+	// Se tinha um BMP decodificado nesse buffer, ele no vale mais.
+	// (kgws/comp/bmpcache.c)
+	bmpCacheInvalidate ( (char *) Start );
     
 	return (unsigned long) 0;
 }
@@ -668,9 +684,6 @@ done:
 
 void fs_load_fatEx (void){
 	
-	unsigned long i;
-	unsigned long b = 0;
-	
 	//#bugbug 
 	//Estamos atribuindo um tamanho, mas tem que calcular.
 	unsigned long szFat = 128;
@@ -686,13 +699,7 @@ void fs_load_fatEx (void){
 	
 	//Carregar fat na memria.
 	
-	for ( i=0; i < szFat; i++ )
-	{
-		my_read_hd_sector( VOLUME1_FAT_ADDRESS + b, VOLUME1_FAT_LBA + i, 0 , 0 );
-		
-		//Incrementa buffer.
-		b = b+512;    
-	};
+	bcacheReadBlocks ( VOLUME1_FAT_ADDRESS, VOLUME1_FAT_LBA, szFat, 1 );
 }
 
 
@@ -709,15 +716,7 @@ load_directory ( unsigned long address,
                  unsigned long lba, 
 				 unsigned long sectors )
 {
-	unsigned long i;
-	unsigned long b = 0;
-	
-	for ( i=0; i < sectors; i++ )
-	{
-        my_read_hd_sector ( address + b, lba + i, 0, 0 );
-		
-		b = b+512;    
-	}
+	bcacheReadBlocks ( address, lba, sectors, 1 );
 };
 
 
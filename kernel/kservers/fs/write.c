@@ -143,8 +143,8 @@ void write_lba ( unsigned long address, unsigned long lba ){
 			break;		
 			
 	    case 16:
-		    //unb/hdd.c
-            my_write_hd_sector ( address, lba, 0, 0 );
+		    //bcache.c
+            bcacheWrite ( address, lba );
             goto done;			
 			break;		
 			
@@ -239,6 +239,11 @@ fsSaveFile ( char *file_name,
 	//printf("fsSaveFile:\n"); 
 	
 	
+	// A imagem desse programa no cache do loader no vale mais.
+	// Os clusters livres podem ser os mesmos. (elf.c)
+	elfImageInvalidate ( (const char *) file_name );
+	
+	
 	//file_size
 	//#todo: precisamos implementar um limite para o tamanho do arquivo,
 	//principamente nessa fase de teste.
@@ -498,12 +503,10 @@ save_file:
 			//printf("write_lba\n");
             //refresh_screen();
 			
-			disk_ata_wait_irq ();
-			
             //grava - aqui next esta certo!!!			
             //write_lba ( (unsigned long) address, VOLUME1_DATAAREA_LBA + next -2 );
-            my_write_hd_sector ( (unsigned long) address, 
-			    (unsigned long) ( VOLUME1_DATAAREA_LBA + next -2), 0, 0  );
+            bcacheWrite ( (unsigned long) address, 
+			    (unsigned long) ( VOLUME1_DATAAREA_LBA + next -2) );
 			
             address += 512; 
         }; 
@@ -558,15 +561,14 @@ done:
 		//printf("write_lba n={%d} \n",r);      
         //refresh_screen();		
 	    
-		//Wait interrupt!
-		//Isso funcionou.
-		disk_ata_wait_irq ();
-		
 		//#bugbug: No podemos determinar os valores. 
 		// Precisamos de estruturas.
+		
+		// O cache s grava os setores que mudaram.
+		// A espera pela interrupo  feita em bcacheSync.
 					
-		my_write_hd_sector ( (unsigned long) VOLUME1_ROOTDIR_ADDRESS + roff, 
-		    (unsigned long) ( VOLUME1_ROOTDIR_LBA     + rlbaoff ), 0, 0  );			
+		bcacheWrite ( (unsigned long) VOLUME1_ROOTDIR_ADDRESS + roff, 
+		    (unsigned long) ( VOLUME1_ROOTDIR_LBA     + rlbaoff ) );			
 				  
         roff = roff + 0x200;
         rlbaoff = rlbaoff + 1;	  		
@@ -621,18 +623,19 @@ done:
 	   //printf("write_lba n={%d} \n",f);      
        //refresh_screen();		
 	
-	    disk_ata_wait_irq ();
-		
 	    //write_lba ( VOLUME1_FAT_ADDRESS + off, 
 	    //            VOLUME1_FAT_LBA     + lbaoff );
 		
-        my_write_hd_sector ( (unsigned long) VOLUME1_FAT_ADDRESS + off, 
-		    (unsigned long) ( VOLUME1_FAT_LBA     + lbaoff ), 0, 0  );		
+        bcacheWrite ( (unsigned long) VOLUME1_FAT_ADDRESS + off, 
+		    (unsigned long) ( VOLUME1_FAT_LBA     + lbaoff ) );		
 				  
        off = off + 0x200;
        lbaoff = lbaoff + 1;	   
 	};
 	
+	// Grava no disco os setores sujos.
+	bcacheSync ();
+	
 	
     //#debug
     printf("fsSaveFile: done hang \n"); 
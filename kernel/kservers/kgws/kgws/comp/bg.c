@@ -119,6 +119,8 @@ int backgroundInit (void){
 	for ( i=0; i< 800*600; i++ )
 		lfb[i] = COLOR_BLACK;
 	
+	damageAddAll ();
+	
 	// #todo:
 	// Ainda no implementada.
 	
@@ -582,6 +582,18 @@ bmpDisplayBMP ( char *address,
 	top = y; 
 	bottom = ( top + bi->bmpHeight );
 
+	// Pintamos de baixo (bottom) para cima (top+1).
+	damageAdd ( left, top, bi->bmpWidth, bi->bmpHeight +1 );
+
+	// Decodificado uma vez, depois  uma cpia por linha. (bmpcache.h)
+	// A imagem comea em top+1, como aqui embaixo.
+	// Sem lugar no cache, decodificamos como antes.
+	if ( bmpCacheDraw ( address, left, top +1, bmp_change_color_flag,
+	         bmp_selected_color, bmp_substitute_color ) == 0 )
+	{
+		goto done;
+	}
+
 	// Incio da rea de dados do BMP.
 	
 	//#importante:
@@ -921,6 +933,147 @@ bmpDisplayCursorBMP ( char *address,
 
 
 
+/*
+ ********************************************************
+ * bmpDecode:
+ *     Decodifica o BMP uma vez, para pixels 0x00RRGGBB,
+ * linha por linha, de cima para baixo. (sprite.c)
+ *     1, 4, 8, 16 (5:5:5), 24 e 32 bpp, sem compresso.
+ *     As linhas do arquivo so alinhadas em 4 bytes.
+ *
+ * IN:
+ *     address = endereo base do arquivo
+ *     pixels  = destino
+ *     max     = quantos pixels cabem no destino
+ *
+ * OUT:
+ *     width e height, 0 = ok.
+ */
+
+int
+bmpDecode ( char *address,
+            unsigned long *pixels,
+            unsigned long max,
+            unsigned long *width,
+            unsigned long *height )
+{
+	unsigned char *bmp = (unsigned char *) address;
+	unsigned char *Row;
+	unsigned long *Palette;
+
+	unsigned long Offset, InfoSize, Pitch;
+	unsigned long Compression;
+	unsigned long W, H;
+	long SignedHeight;
+	unsigned short Bpp;
+
+	unsigned long x, y, Line;
+	unsigned long Value, Color;
+	unsigned long r, g, b;
+	int TopDown = 0;
+
+	if ( (void *) bmp == NULL || (void *) pixels == NULL ){
+		return (int) 1;
+	}
+
+	if ( *( unsigned short * ) &bmp[0] != BMP_TYPE ){
+		return (int) 1;
+	}
+
+	Offset = *( unsigned long * ) &bmp[10];
+	InfoSize = *( unsigned long * ) &bmp[14];
+	W = *( unsigned long * ) &bmp[18];
+	SignedHeight = *( long * ) &bmp[22];
+	Bpp = *( unsigned short * ) &bmp[28];
+	Compression = *( unsigned long * ) &bmp[30];
+
+	// 3 = bitfields, aceito com as mscaras padro.
+	if ( Compression != 0 && Compression != 3 ){
+		return (int) 1;
+	}
+
+	// Altura negativa, de cima para baixo.
+	if ( SignedHeight < 0 )
+	{
+		TopDown = 1;
+		H = (unsigned long) ( -SignedHeight );
+	}else{
+		H = (unsigned long) SignedHeight;
+	};
+
+	if ( W == 0 || H == 0 || W > max || H > (max / W) ){
+		return (int) 1;
+	}
+
+	Palette = (unsigned long *) &bmp[14 + InfoSize];
+	Pitch = ( ( (W * Bpp) + 31 ) / 32 ) * 4;
+
+	for ( y=0; y < H; y++ )
+	{
+		Row = bmp + Offset + (y * Pitch);
+
+		if ( TopDown == 1 ){
+			Line = y;
+		}else{
+			Line = (H -1) - y;
+		};
+
+		for ( x=0; x < W; x++ )
+		{
+			switch (Bpp)
+			{
+				case 1:
+				    Value = ( Row[x >> 3] >> ( 7 - (x & 7) ) ) & 1;
+				    Color = Palette[Value];
+				    break;
+
+				case 4:
+				    Value = Row[x >> 1];
+				    if ( x & 1 ){
+					    Value = (Value & 0x0F);
+				    }else{
+					    Value = (Value >> 4) & 0x0F;
+				    };
+				    Color = Palette[Value];
+				    break;
+
+				case 8:
+				    Color = Palette[ Row[x] ];
+				    break;
+
+				case 16:
+				    Value = Row[x*2] | ( Row[x*2 +1] << 8 );
+				    r = (Value >> 10) & 0x1F;
+				    g = (Value >> 5) & 0x1F;
+				    b = Value & 0x1F;
+				    Color = ( ( (r << 3) | (r >> 2) ) << 16 ) |
+				            ( ( (g << 3) | (g >> 2) ) << 8 ) |
+				            ( (b << 3) | (b >> 2) );
+				    break;
+
+				case 24:
+				    Color = Row[x*3] | ( Row[x*3 +1] << 8 ) | ( Row[x*3 +2] << 16 );
+				    break;
+
+				case 32:
+				    Color = Row[x*4] | ( Row[x*4 +1] << 8 ) | ( Row[x*4 +2] << 16 );
+				    break;
+
+				default:
+				    return (int) 1;
+			};
+
+			pixels[ (Line * W) + x ] = (Color & 0x00FFFFFF);
+		};
+	};
+
+	*width = W;
+	*height = H;
+
+	return 0;
+}
+
+
 //
 // End.
 //
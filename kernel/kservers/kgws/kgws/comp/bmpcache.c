@@ -0,0 +1,590 @@
+/*
+ * File: kgws/comp/bmpcache.c
+ *
+ *     Decoded BMP cache. (see bmpcache.h)
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+extern unsigned long SavedBPP;
+
+
+static struct bmpcache_d bmpcache_list[BMPCACHE_MAX];
+
+static spinlock_t bmpcache_spinlock;
+
+// LRU clock.
+static unsigned long bmpcache_clock = 0;
+
+
+/*
+ * Where the blit goes: the backbuffer or the surface being painted.
+ * left and top are the screen position of the buffer.
+ */
+
+struct bmpcache_target_d
+{
+	unsigned char *buffer;
+	unsigned long pitch;
+	unsigned long width;
+	unsigned long height;
+	unsigned long left;
+	unsigned long top;
+};
+
+
+static unsigned long bmpcache_bytes_per_pixel (void){
+
+	if ( SavedBPP == 32 ){
+		return 4;
+	}
+
+	return 3;
+}
+
+
+static int bmpcache_valid ( struct bmpcache_d *image ){
+
+	if ( (void *) image == NULL ){
+		return 0;
+	}
+
+	if ( image->used != 1 || image->magic != 1234 ){
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/*
+ * bmpcache_stamp:
+ *     The header and the first bytes of the pixels.
+ *     0 = not a BMP we can decode.
+ */
+
+static unsigned long bmpcache_stamp ( char *address ){
+
+	unsigned char *bmp = (unsigned char *) address;
+	unsigned long Offset;
+	unsigned long Size;
+	unsigned long Stamp = 5381;
+	unsigned long i;
+
+	if ( (void *) bmp == NULL ){
+		return 0;
+	}
+
+	if ( *( unsigned short * ) &bmp[0] != BMP_TYPE ){
+		return 0;
+	}
+
+	for ( i=0; i < 54; i++ ){
+		Stamp = (Stamp * 33) ^ bmp[i];
+	};
+
+	Offset = *( unsigned long * ) &bmp[10];
+	Size = *( unsigned long * ) &bmp[2];
+
+	// Not beyond the file, when it says its size.
+	for ( i=0; i < 64; i++ )
+	{
+		if ( Size != 0 && (Offset + i) >= Size ){
+			break;
+		}
+
+		Stamp = (Stamp * 33) ^ bmp[Offset + i];
+	};
+
+	if ( Stamp == 0 ){
+		Stamp = 1;
+	}
+
+	return (unsigned long) Stamp;
+}
+
+
+static void bmpcache_free ( struct bmpcache_d *image ){
+
+	// One buddy block. (allocPages)
+	freePage ( (void *) image->buffer );
+
+	bmpcache_pages_used -= image->pages;
+	bmpcache_count--;
+
+	image->used = 0;
+	image->magic = 0;
+	image->address = NULL;
+	image->buffer = NULL;
+}
+
+
+/* The least recently drawn. NULL = empty. */
+
+static struct bmpcache_d *bmpcache_lru (void){
+
+	struct bmpcache_d *Image = NULL;
+	int i;
+
+	for ( i=0; i < BMPCACHE_MAX; i++ )
+	{
+		if ( bmpcache_valid ( &bmpcache_list[i] ) == 0 ){
+			continue;
+		}
+
+		if ( (void *) Image == NULL ||
+		     bmpcache_list[i].last_use < Image->last_use )
+		{
+			Image = &bmpcache_list[i];
+		}
+	};
+
+	return (struct bmpcache_d *) Image;
+}
+
+
+/*
+ * bmpcache_load:
+ *     Decode into a new entry. With the lock.
+ *
+ *     bmpDecode writes 0x00RRGGBB in the buffer, then each pixel is
+ * packed in place into the backbuffer format. A packed pixel never
+ * goes beyond the bytes of the ones already read.
+ */
+
+static struct bmpcache_d *bmpcache_load ( char *address, unsigned long stamp ){
+
+	struct bmpcache_d *Image = NULL;
+	unsigned char *bmp = (unsigned char *) address;
+	unsigned char *p;
+	unsigned long *Pixels;
+	unsigned long W, H;
+	unsigned long Color;
+	unsigned long Size;
+	unsigned long i;
+	long SignedHeight;
+	int Pages;
+
+	W = *( unsigned long * ) &bmp[18];
+	SignedHeight = *( long * ) &bmp[22];
+
+	if ( SignedHeight < 0 ){
+		H = (unsigned long) ( -SignedHeight );
+	}else{
+		H = (unsigned long) SignedHeight;
+	};
+
+	if ( W == 0 || H == 0 || W > SavedX || H > SavedY ){
+		return NULL;
+	}
+
+	Size = (W * H) * 4;
+	Pages = (int) ( (Size + PAGE_SIZE -1) / PAGE_SIZE );
+
+	if ( Pages > BMPCACHE_PAGES_MAX ){
+		return NULL;
+	}
+
+	// Room in the budget and in the list.
+	while ( bmpcache_pages_used + Pages > BMPCACHE_TOTAL_PAGES_MAX ||
+	        bmpcache_count >= BMPCACHE_MAX )
+	{
+		Image = bmpcache_lru ();
+
+		if ( (void *) Image == NULL ){
+			return NULL;
+		}
+
+		bmpcache_free (Image);
+		bmpcache_evictions++;
+	};
+
+	Image = NULL;
+
+	for ( i=0; i < BMPCACHE_MAX; i++ )
+	{
+		if ( bmpcache_list[i].used == 0 ){
+			Image = &bmpcache_list[i];
+			break;
+		}
+	};
+
+	if ( (void *) Image == NULL ){
+		return NULL;
+	}
+
+	Image->buffer = (unsigned char *) allocPages (Pages);
+
+	if ( (void *) Image->buffer == NULL ){
+		return NULL;
+	}
+
+	Pixels = (unsigned long *) Image->buffer;
+
+	if ( bmpDecode ( address, Pixels, (W * H), &W, &H ) != 0 )
+	{
+		freePage ( (void *) Image->buffer );
+		Image->buffer = NULL;
+		return NULL;
+	}
+
+	Image->bytes_per_pixel = bmpcache_bytes_per_pixel ();
+
+	for ( i=0; i < (W * H); i++ )
+	{
+		Color = Pixels[i];
+
+		p = &Image->buffer[i * Image->bytes_per_pixel];
+
+		p[0] = (Color & 0xFF);
+		p[1] = (Color >> 8) & 0xFF;
+		p[2] = (Color >> 16) & 0xFF;
+
+		if ( Image->bytes_per_pixel == 4 ){
+			p[3] = (Color >> 24) + 1;
+		}
+	};
+
+	Image->address = address;
+	Image->stamp = stamp;
+	Image->width = W;
+	Image->height = H;
+	Image->pitch = W * Image->bytes_per_pixel;
+	Image->pages = Pages;
+
+	Image->used = 1;
+	Image->magic = 1234;
+
+	bmpcache_pages_used += Pages;
+	bmpcache_count++;
+
+	return (struct bmpcache_d *) Image;
+}
+
+
+static void bmpcache_target ( struct bmpcache_target_d *t ){
+
+	struct surface_d *s = draw_surface;
+
+	if ( (void *) s != NULL )
+	{
+		t->buffer = s->buffer;
+		t->pitch = s->pitch;
+		t->width = s->width;
+		t->height = s->height;
+		t->left = draw_surface_left;
+		t->top = draw_surface_top;
+		return;
+	}
+
+	t->buffer = (unsigned char *) BACKBUFFER_VA;
+	t->pitch = SavedX * bmpcache_bytes_per_pixel ();
+	t->width = SavedX;
+	t->height = SavedY;
+	t->left = 0;
+	t->top = 0;
+}
+
+
+/*
+ * bmpcache_blit_rect:
+ *     The part of the image inside the clip rectangle. (screen)
+ */
+
+static void
+bmpcache_blit_rect ( struct bmpcache_d *image,
+                     struct bmpcache_target_d *t,
+                     unsigned long x,
+                     unsigned long y,
+                     unsigned long clip_left,
+                     unsigned long clip_top,
+                     unsigned long clip_right,
+                     unsigned long clip_bottom,
+                     int mode,
+                     unsigned char *key,
+                     unsigned char *substitute )
+{
+	unsigned char *Src;
+	unsigned char *Dst;
+	unsigned long Left, Top, Right, Bottom;
+	unsigned long Bpp = image->bytes_per_pixel;
+	unsigned long Line;
+	unsigned long i, j;
+
+	// The target, in screen coordinates.
+	Left = t->left;
+	Top = t->top;
+	Right = t->left + t->width;
+	Bottom = t->top + t->height;
+
+	if ( clip_left > Left ){ Left = clip_left; }
+	if ( clip_top > Top ){ Top = clip_top; }
+	if ( clip_right < Right ){ Right = clip_right; }
+	if ( clip_bottom < Bottom ){ Bottom = clip_bottom; }
+
+	// The image.
+	if ( x > Left ){ Left = x; }
+	if ( y > Top ){ Top = y; }
+	if ( x + image->width < Right ){ Right = x + image->width; }
+	if ( y + image->height < Bottom ){ Bottom = y + image->height; }
+
+	if ( Left >= Right || Top >= Bottom ){
+		return;
+	}
+
+	Line = (Right - Left) * Bpp;
+
+	for ( i = Top; i < Bottom; i++ )
+	{
+		Src = image->buffer + ( (i - y) * image->pitch ) + ( (Left - x) * Bpp );
+		Dst = t->buffer + ( (i - t->top) * t->pitch ) + ( (Left - t->left) * Bpp );
+
+		if ( mode == BMP_CHANGE_COLOR_NULL )
+		{
+			memcpy ( (void *) Dst, (const void *) Src, Line );
+			continue;
+		}
+
+		for ( j=0; j < Line; j += Bpp )
+		{
+			if ( Src[j] == key[0] && Src[j+1] == key[1] && Src[j+2] == key[2] )
+			{
+				if ( mode == BMP_CHANGE_COLOR_TRANSPARENT ){
+					continue;
+				}
+
+				Dst[j] = substitute[0];
+				Dst[j+1] = substitute[1];
+				Dst[j+2] = substitute[2];
+
+				if ( Bpp == 4 ){
+					Dst[j+3] = substitute[3];
+				}
+
+				continue;
+			}
+
+			Dst[j] = Src[j];
+			Dst[j+1] = Src[j+1];
+			Dst[j+2] = Src[j+2];
+
+			if ( Bpp == 4 ){
+				Dst[j+3] = Src[j+3];
+			}
+		};
+	};
+}
+
+
+void bmpCacheInit (void){
+
+	int i;
+
+	for ( i=0; i < BMPCACHE_MAX; i++ )
+	{
+		bmpcache_list[i].used = 0;
+		bmpcache_list[i].magic = 0;
+		bmpcache_list[i].address = NULL;
+		bmpcache_list[i].buffer = NULL;
+	};
+
+	spinLockInit (&bmpcache_spinlock);
+
+	bmpcache_clock = 0;
+
+	bmpcache_count = 0;
+	bmpcache_pages_used = 0;
+	bmpcache_hits = 0;
+	bmpcache_misses = 0;
+	bmpcache_evictions = 0;
+}
+
+
+/*
+ * bmpcache_lookup:
+ *     With the lock.
+ */
+
+static struct bmpcache_d *bmpcache_lookup ( char *address ){
+
+	struct bmpcache_d *Image;
+	unsigned long Stamp;
+	int i;
+
+	Stamp = bmpcache_stamp (address);
+
+	if ( Stamp == 0 ){
+		return NULL;
+	}
+
+	for ( i=0; i < BMPCACHE_MAX; i++ )
+	{
+		Image = &bmpcache_list[i];
+
+		if ( bmpcache_valid (Image) == 0 || Image->address != address ){
+			continue;
+		}
+
+		// Another image in the same buffer.
+		// Another video mode. (bytes per pixel)
+		if ( Image->stamp != Stamp ||
+		     Image->bytes_per_pixel != bmpcache_bytes_per_pixel () )
+		{
+			bmpcache_free (Image);
+			break;
+		}
+
+		Image->last_use = ++bmpcache_clock;
+		bmpcache_hits++;
+
+		return (struct bmpcache_d *) Image;
+	};
+
+	bmpcache_misses++;
+
+	Image = bmpcache_load ( address, Stamp );
+
+	if ( (void *) Image != NULL ){
+		Image->last_use = ++bmpcache_clock;
+	}
+
+	return (struct bmpcache_d *) Image;
+}
+
+
+static void
+bmpcache_blit ( struct bmpcache_d *image,
+                 unsigned long x,
+                 unsigned long y,
+                 int mode,
+                 unsigned long key,
+                 unsigned long substitute )
+{
+	struct bmpcache_target_d Target;
+	struct region_rect_d *r;
+	unsigned char Key[4];
+	unsigned char Substitute[4];
+	int i;
+
+	if ( bmpcache_valid (image) == 0 ){
+		return;
+	}
+
+	// Any other flag is a plain draw, as in bmpDisplayBMP.
+	if ( mode != BMP_CHANGE_COLOR_TRANSPARENT &&
+	     mode != BMP_CHANGE_COLOR_SUBSTITUTE )
+	{
+		mode = BMP_CHANGE_COLOR_NULL;
+	}
+
+	Key[0] = (key & 0xFF);
+	Key[1] = (key >> 8) & 0xFF;
+	Key[2] = (key >> 16) & 0xFF;
+	Key[3] = 0;
+
+	Substitute[0] = (substitute & 0xFF);
+	Substitute[1] = (substitute >> 8) & 0xFF;
+	Substitute[2] = (substitute >> 16) & 0xFF;
+	Substitute[3] = (substitute >> 24) + 1;
+
+	bmpcache_target (&Target);
+
+	// Only inside the visible region, like the rectangles. (region.h)
+	if ( (void *) clip_region != NULL && (void *) draw_surface == NULL )
+	{
+		for ( i=0; i < clip_region->count; i++ )
+		{
+			r = &clip_region->rects[i];
+
+			bmpcache_blit_rect ( image, &Target, x, y,
+			    r->left, r->top, r->right, r->bottom,
+			    mode, Key, Substitute );
+		};
+
+		return;
+	}
+
+	bmpcache_blit_rect ( image, &Target, x, y,
+	    0, 0, 0xFFFFFFFF, 0xFFFFFFFF, mode, Key, Substitute );
+}
+
+
+/*
+ * bmpCacheDraw:
+ *     The lock covers the lookup and the blit, so the entry is not
+ * evicted in between.
+ */
+
+int
+bmpCacheDraw ( char *address,
+               unsigned long x,
+               unsigned long y,
+               int mode,
+               unsigned long key,
+               unsigned long substitute )
+{
+	struct bmpcache_d *Image;
+	unsigned long Flags;
+
+	Flags = spinLockIrqSave (&bmpcache_spinlock);
+
+	Image = bmpcache_lookup (address);
+
+	if ( (void *) Image == NULL )
+	{
+		spinUnlockIrqRestore ( &bmpcache_spinlock, Flags );
+		return (int) 1;
+	}
+
+	bmpcache_blit ( Image, x, y, mode, key, substitute );
+
+	spinUnlockIrqRestore ( &bmpcache_spinlock, Flags );
+
+	return 0;
+}
+
+
+/*
+ * bmpCacheInvalidate:
+ *     The buffer was loaded again. (fsLoadFile)
+ */
+
+void bmpCacheInvalidate ( char *address ){
+
+	unsigned long Flags;
+	int i;
+
+	Flags = spinLockIrqSave (&bmpcache_spinlock);
+
+	for ( i=0; i < BMPCACHE_MAX; i++ )
+	{
+		if ( bmpcache_valid ( &bmpcache_list[i] ) == 1 &&
+		     bmpcache_list[i].address == address )
+		{
+			bmpcache_free ( &bmpcache_list[i] );
+		}
+	};
+
+	spinUnlockIrqRestore ( &bmpcache_spinlock, Flags );
+}
+
+
+void bmpCacheShowInfo (void){
+
+	printf ("bmpcache: images={%d} pages={%d}/{%d} hits={%d} misses={%d} evictions={%d}\n",
+	    bmpcache_count, bmpcache_pages_used, BMPCACHE_TOTAL_PAGES_MAX,
+	    bmpcache_hits, bmpcache_misses, bmpcache_evictions );
+}
+
+
+//
+// End.
+//
+
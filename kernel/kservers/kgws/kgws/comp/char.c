@@ -83,6 +83,8 @@ drawchar_transparent ( unsigned long x,
 	
     unsigned char bit_mask = 0x80;	
     
+	int Clip;
+	
 	struct window_d *hWindow;			
 	  
     //
@@ -191,6 +193,35 @@ drawchar_transparent ( unsigned long x,
 	
 	work_char = (void *) gws_currentfont_address + (c * gcharHeight);
 
+	// Clip. (region.h)
+	// Fora da regio no pinta nada. Em parte dentro, pixel por pixel.
+	
+	Clip = REGION_IN;
+	
+	if ( (void *) clip_region != NULL )
+	{
+		Clip = regionTestRect ( clip_region, x, y, 
+		           x + gcharWidth, y + gcharHeight );
+		
+		if ( Clip == REGION_OUT ){
+			return;
+		}
+	}
+
+	damageAdd ( x, y, gcharWidth, gcharHeight );
+
+	// Linhas inteiras, com a tabela de spans. (glyph.h)
+	// Em parte fora da regio ou da tela, pixel por pixel.
+	
+	if ( Clip == REGION_IN &&
+	     glyphDrawTransparent ( x, y, (unsigned char *) work_char, 
+	         gcharWidth, gcharHeight, color ) == 0 )
+	{
+		return;
+	}
+
+	glyph_slow++;
+
 	//
 	// Draw.
 	//
@@ -204,7 +235,11 @@ drawchar_transparent ( unsigned long x,
 	        //Put pixel. 
             if ( ( *work_char & bit_mask ) )
 			{ 
-                backbuffer_putpixel ( color, x + x2, y, 0 );  				
+				if ( Clip == REGION_IN || 
+				     regionContains ( clip_region, x + x2, y ) == 1 )
+				{
+                    backbuffer_putpixel ( color, x + x2, y, 0 );
+				}
 			}
             
 			//Rotate bitmask.
@@ -241,6 +276,8 @@ draw_char ( unsigned long x,
 	
     unsigned char bit_mask = 0x80;	
     
+	int Clip;
+	
 	struct window_d *hWindow;
 
 	  
@@ -343,6 +380,35 @@ draw_char ( unsigned long x,
 	
 	work_char = (void *) gws_currentfont_address + (c * gcharHeight);
 
+	// Clip. (region.h)
+	// Fora da regio no pinta nada. Em parte dentro, pixel por pixel.
+	
+	Clip = REGION_IN;
+	
+	if ( (void *) clip_region != NULL )
+	{
+		Clip = regionTestRect ( clip_region, x, y, 
+		           x + gcharWidth, y + gcharHeight );
+		
+		if ( Clip == REGION_OUT ){
+			return;
+		}
+	}
+
+	damageAdd ( x, y, gcharWidth, gcharHeight );
+
+	// Uma cpia de 8 pixels por linha, da tabela do par fg/bg. (glyph.h)
+	// Em parte fora da regio ou da tela, pixel por pixel.
+	
+	if ( Clip == REGION_IN &&
+	     glyphDrawChar ( x, y, (unsigned char *) work_char, 
+	         gcharWidth, gcharHeight, fgcolor, bgcolor ) == 0 )
+	{
+		return;
+	}
+
+	glyph_slow++;
+
 	//
 	// Draw.
 	//
@@ -355,8 +421,12 @@ draw_char ( unsigned long x,
         {
 				
 			//Put pixel.				
-			backbuffer_putpixel ( *work_char & bit_mask ? fgcolor: bgcolor, 
-			    x + x2, y, 0 );
+			if ( Clip == REGION_IN || 
+			     regionContains ( clip_region, x + x2, y ) == 1 )
+			{
+			    backbuffer_putpixel ( *work_char & bit_mask ? fgcolor: bgcolor, 
+			        x + x2, y, 0 );
+			}
 				
 			
             bit_mask = (bit_mask >> 1); 								 
@@ -358,7 +358,7 @@ void *CreateWindow ( unsigned long type,
 
 	//Alocando memria para a estrutura da janela.
 
-	window = (void *) malloc ( sizeof(struct window_d) );
+	window = (void *) slabAllocate (window_cache);
 
 	if ( (void *) window == NULL )
 	{
@@ -565,6 +565,11 @@ void *CreateWindow ( unsigned long type,
 
 		//window->DedicatedBuffer = (void*) windowCreateDedicatedBuffer(window);
 		window->DedicatedBuffer = NULL;
+		window->surface = NULL;
+		
+		window->hit_indexed = 0;
+		window->hit_controls = NULL;
+		window->hit_next = NULL;
 
 		// backbuffer and front buffer.
 		window->BackBuffer = (void *) g_backbuffer_va;
@@ -1762,8 +1767,24 @@ void *CreateWindow ( unsigned long type,
 	if( z >= 0 && z < ZORDER_COUNT_MAX )
 	{
 	    zorderList[z] = (unsigned long) window;
+	    
+		// A posio na zorder. (redraw_screen, CloseWindow e 
+		// o clculo da regio visvel usam isso)
+		window->zIndex = z;
+		
+		// Hit test do mouse. (hit.h)
+		hitInsert (window);
 	};
 	
+	// Surface. (surface.h)
+	// S as overlapped. Sem memria, a janela  pintada direto 
+	// no backbuffer.
+	
+	if ( window->type == WT_OVERLAPPED )
+	{
+		windowCreateDedicatedBuffer (window);
+	}
+	
 	//@todo: z-order de elementos grficos dentro da janela me.
  
 // done.
@@ -32,6 +32,23 @@ draw_text ( struct window_d *window,
 		draw_string ( gui->main->left +x, gui->main->top +y, color, string );
         return;
     }else{
+		
+		// Com surface, pinta nele e copia só a parte suja e visível.
+		if ( (void *) window->surface != NULL && (void *) draw_surface == NULL )
+		{
+			// O fundo do texto vem do surface.
+			if ( window->surface->valid != 1 ){
+				surfacePaint (window);
+			}
+			
+			surfaceBegin (window);
+			draw_string ( window->left +x, window->top +y, color, string );
+			surfaceEnd ();
+			
+			surfaceFlush (window);
+			return;
+		}
+		
         draw_string ( window->left +x, window->top +y, color, string );
     };
 }
@@ -58,6 +75,12 @@ draw_string ( unsigned long x,
 		printf("gws-dtext-draw_string: fail w ");
 		die();
 	}
+
+	// A string inteira de uma vez, linha por linha. (glyph.h)
+	// Em parte fora da região ou da tela, caractere por caractere.
+	if ( glyphDrawString ( x, y, color, string ) == 0 ){
+		return;
+	}
       
     for ( Index=0; string[Index] != 0; Index++ )
 	{
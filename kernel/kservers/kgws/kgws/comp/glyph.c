@@ -0,0 +1,657 @@
+/*
+ * File: kgws/comp/glyph.c
+ *
+ *     Glyph cache and string blitter. (see glyph.h)
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+extern unsigned long SavedBPP;
+
+
+static struct glyph_span_d glyph_spans[256];
+
+static struct glyph_pair_d glyph_pairs[GLYPH_PAIRS_MAX];
+
+static spinlock_t glyph_spinlock;
+
+// LRU clock.
+static unsigned long glyph_clock = 0;
+
+
+// Where the glyph goes: the backbuffer or the surface being painted.
+
+struct glyph_target_d
+{
+	unsigned char *buffer;
+	unsigned long pitch;
+	unsigned long width;
+	unsigned long height;
+	unsigned long left;
+	unsigned long top;
+	unsigned long bytes_per_pixel;
+};
+
+
+static unsigned long glyph_bytes_per_pixel (void){
+
+	if ( SavedBPP == 32 ){
+		return 4;
+	}
+
+	return 3;
+}
+
+
+static void glyph_target ( struct glyph_target_d *t ){
+
+	struct surface_d *s = draw_surface;
+
+	t->bytes_per_pixel = glyph_bytes_per_pixel ();
+
+	if ( (void *) s != NULL )
+	{
+		t->buffer = s->buffer;
+		t->pitch = s->pitch;
+		t->width = s->width;
+		t->height = s->height;
+		t->left = draw_surface_left;
+		t->top = draw_surface_top;
+		return;
+	}
+
+	t->buffer = (unsigned char *) BACKBUFFER_VA;
+	t->pitch = SavedX * t->bytes_per_pixel;
+	t->width = SavedX;
+	t->height = SavedY;
+	t->left = 0;
+	t->top = 0;
+}
+
+
+/* The rectangle is entirely inside the target. (screen) */
+
+static int
+glyph_inside ( struct glyph_target_d *t,
+               unsigned long x,
+               unsigned long y,
+               unsigned long width,
+               unsigned long height )
+{
+	if ( x < t->left || y < t->top ){
+		return 0;
+	}
+
+	if ( x - t->left + width > t->width ||
+	     y - t->top + height > t->height )
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+
+static unsigned char *
+glyph_where ( struct glyph_target_d *t,
+              unsigned long x,
+              unsigned long y )
+{
+	return (unsigned char *) t->buffer + ( (y - t->top) * t->pitch ) +
+	       ( (x - t->left) * t->bytes_per_pixel );
+}
+
+
+/* One line of a transparent glyph. The runs of set bits. */
+
+static void
+glyph_row_transparent ( unsigned char *dst,
+                        unsigned char bits,
+                        unsigned long bpp,
+                        unsigned long pixel )
+{
+	struct glyph_span_d *s = &glyph_spans[bits];
+	unsigned long *w;
+	unsigned char *p;
+	int n;
+	int i;
+
+	for ( i=0; i < s->count; i++ )
+	{
+		n = s->len[i];
+
+		if ( bpp == 4 )
+		{
+			w = (unsigned long *) ( dst + (s->start[i] * 4) );
+
+			while ( n-- ){
+				*w++ = pixel;
+			};
+
+		}else{
+
+			p = dst + (s->start[i] * 3);
+
+			while ( n-- )
+			{
+				p[0] = (pixel & 0xFF);
+				p[1] = (pixel >> 8) & 0xFF;
+				p[2] = (pixel >> 16) & 0xFF;
+				p += 3;
+			};
+		};
+	};
+}
+
+
+/* One line of an opaque glyph. 8 pixels from the table. */
+
+static void
+glyph_row_opaque ( unsigned char *dst,
+                   unsigned char *row,
+                   unsigned long bpp )
+{
+	unsigned long *d;
+	unsigned long *s;
+
+	if ( bpp == 4 )
+	{
+		d = (unsigned long *) dst;
+		s = (unsigned long *) row;
+
+		d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+		d[4] = s[4]; d[5] = s[5]; d[6] = s[6]; d[7] = s[7];
+		return;
+	}
+
+	memcpy ( (void *) dst, (const void *) row, 24 );
+}
+
+
+static void glyph_pixel ( unsigned char *p, unsigned long color, unsigned long bpp ){
+
+	p[0] = (color & 0xFF);
+	p[1] = (color >> 8) & 0xFF;
+	p[2] = (color >> 16) & 0xFF;
+
+	if ( bpp == 4 ){
+		p[3] = (color >> 24) + 1;
+	}
+}
+
+
+/*
+ * glyph_pair:
+ *     The table of the fg/bg pair, built on the first use.
+ *     With the lock. NULL = no memory.
+ */
+
+static struct glyph_pair_d *glyph_pair ( unsigned long fg, unsigned long bg ){
+
+	struct glyph_pair_d *Pair = NULL;
+	unsigned long Bpp = glyph_bytes_per_pixel ();
+	unsigned char *p;
+	int b, k;
+	int i;
+
+	for ( i=0; i < GLYPH_PAIRS_MAX; i++ )
+	{
+		if ( glyph_pairs[i].used == 1 &&
+		     glyph_pairs[i].fg == fg &&
+		     glyph_pairs[i].bg == bg &&
+		     glyph_pairs[i].bytes_per_pixel == Bpp )
+		{
+			glyph_pairs[i].last_use = ++glyph_clock;
+			glyph_hits++;
+			return (struct glyph_pair_d *) &glyph_pairs[i];
+		}
+	};
+
+	glyph_misses++;
+
+	// A free one, or the least recently used.
+	for ( i=0; i < GLYPH_PAIRS_MAX; i++ )
+	{
+		if ( glyph_pairs[i].used == 0 ){
+			Pair = &glyph_pairs[i];
+			break;
+		}
+
+		if ( (void *) Pair == NULL ||
+		     glyph_pairs[i].last_use < Pair->last_use )
+		{
+			Pair = &glyph_pairs[i];
+		}
+	};
+
+	// 256 * 8 * 4 = 8KB, kept when the pair is reused.
+	if ( (void *) Pair->rows == NULL )
+	{
+		Pair->rows = (unsigned char *) allocPages (2);
+
+		if ( (void *) Pair->rows == NULL ){
+			return NULL;
+		}
+	}
+
+	for ( b=0; b < 256; b++ )
+	{
+		p = Pair->rows + (b * 8 * Bpp);
+
+		for ( k=0; k < 8; k++ )
+		{
+			if ( b & (0x80 >> k) ){
+				glyph_pixel ( p, fg, Bpp );
+			}else{
+				glyph_pixel ( p, bg, Bpp );
+			};
+
+			p += Bpp;
+		};
+	};
+
+	Pair->fg = fg;
+	Pair->bg = bg;
+	Pair->bytes_per_pixel = Bpp;
+	Pair->last_use = ++glyph_clock;
+
+	Pair->used = 1;
+	Pair->magic = 1234;
+
+	return (struct glyph_pair_d *) Pair;
+}
+
+
+void glyphInit (void){
+
+	struct glyph_span_d *s;
+	int b, k;
+	int i;
+
+	// The runs of set bits of each byte, bit 7 is the first pixel.
+	for ( b=0; b < 256; b++ )
+	{
+		s = &glyph_spans[b];
+		s->count = 0;
+
+		for ( k=0; k < 8; k++ )
+		{
+			if ( ( b & (0x80 >> k) ) == 0 ){
+				continue;
+			}
+
+			if ( s->count > 0 &&
+			     s->start[s->count -1] + s->len[s->count -1] == k )
+			{
+				s->len[s->count -1]++;
+				continue;
+			}
+
+			s->start[s->count] = k;
+			s->len[s->count] = 1;
+			s->count++;
+		};
+	};
+
+	for ( i=0; i < GLYPH_PAIRS_MAX; i++ )
+	{
+		glyph_pairs[i].used = 0;
+		glyph_pairs[i].magic = 0;
+		glyph_pairs[i].rows = NULL;
+		glyph_pairs[i].last_use = 0;
+	};
+
+	spinLockInit (&glyph_spinlock);
+
+	glyph_clock = 0;
+
+	glyph_hits = 0;
+	glyph_misses = 0;
+	glyph_fast = 0;
+	glyph_slow = 0;
+
+	glyph_cache_enabled = 1;
+}
+
+
+/*
+ * glyphDrawChar:
+ *     Opaque glyph. The caller did the clip. (REGION_IN)
+ */
+
+int
+glyphDrawChar ( unsigned long x,
+                unsigned long y,
+                unsigned char *bitmap,
+                int width,
+                int height,
+                unsigned long fgcolor,
+                unsigned long bgcolor )
+{
+	struct glyph_target_d Target;
+	struct glyph_pair_d *Pair;
+	unsigned char *Dst;
+	unsigned long Flags;
+	unsigned long RowSize;
+	int i;
+
+	if ( glyph_cache_enabled != 1 || width != 8 || height <= 0 ){
+		return (int) 1;
+	}
+
+	glyph_target (&Target);
+
+	if ( glyph_inside ( &Target, x, y, width, height ) == 0 ){
+		return (int) 1;
+	}
+
+	Flags = spinLockIrqSave (&glyph_spinlock);
+
+	Pair = glyph_pair ( fgcolor, bgcolor );
+
+	if ( (void *) Pair == NULL )
+	{
+		spinUnlockIrqRestore ( &glyph_spinlock, Flags );
+		return (int) 1;
+	}
+
+	RowSize = 8 * Target.bytes_per_pixel;
+	Dst = glyph_where ( &Target, x, y );
+
+	for ( i=0; i < height; i++ )
+	{
+		glyph_row_opaque ( Dst, Pair->rows + (bitmap[i] * RowSize),
+		    Target.bytes_per_pixel );
+
+		Dst += Target.pitch;
+	};
+
+	spinUnlockIrqRestore ( &glyph_spinlock, Flags );
+
+	glyph_fast++;
+
+	return 0;
+}
+
+
+/*
+ * glyphDrawTransparent:
+ *     Transparent glyph. The caller did the clip. (REGION_IN)
+ */
+
+int
+glyphDrawTransparent ( unsigned long x,
+                       unsigned long y,
+                       unsigned char *bitmap,
+                       int width,
+                       int height,
+                       unsigned long color )
+{
+	struct glyph_target_d Target;
+	unsigned char *Dst;
+	unsigned long Pixel;
+	int i;
+
+	if ( glyph_cache_enabled != 1 || width != 8 || height <= 0 ){
+		return (int) 1;
+	}
+
+	glyph_target (&Target);
+
+	if ( glyph_inside ( &Target, x, y, width, height ) == 0 ){
+		return (int) 1;
+	}
+
+	// The bytes in memory: b, g, r, a.
+	Pixel = (color & 0x00FFFFFF) | ( ( (color >> 24) + 1 ) << 24 );
+
+	Dst = glyph_where ( &Target, x, y );
+
+	for ( i=0; i < height; i++ )
+	{
+		if ( bitmap[i] != 0 ){
+			glyph_row_transparent ( Dst, bitmap[i], Target.bytes_per_pixel, Pixel );
+		}
+
+		Dst += Target.pitch;
+	};
+
+	glyph_fast++;
+
+	return 0;
+}
+
+
+/*
+ * glyphDrawString:
+ *     One clip test, one bounds test and one damaged rectangle for the
+ * whole string, then the glyphs line by line.
+ *     1 = the caller draws it char by char.
+ */
+
+int
+glyphDrawString ( unsigned long x,
+                  unsigned long y,
+                  unsigned long color,
+                  unsigned char *string )
+{
+	struct glyph_target_d Target;
+	unsigned char *Font;
+	unsigned char *Bitmap;
+	unsigned char *Dst;
+	unsigned long Pixel;
+	unsigned long Width;
+	int Height;
+	int Count;
+	int Index;
+	int i;
+
+	if ( glyph_cache_enabled != 1 || (void *) string == NULL ){
+		return (int) 1;
+	}
+
+	// The font of drawchar_transparent.
+	if ( gws_currentfont_address == 0 || gcharWidth != 8 ){
+		return (int) 1;
+	}
+
+	if ( !( gfontSize == FONT8X8 && gcharHeight == 8 ) &&
+	     !( gfontSize == FONT8X16 && gcharHeight == 16 ) )
+	{
+		return (int) 1;
+	}
+
+	Font = (unsigned char *) gws_currentfont_address;
+	Height = gcharHeight;
+
+	for ( Count=0; string[Count] != 0; Count++ ){
+	};
+
+	if ( Count == 0 ){
+		return 0;
+	}
+
+	Width = (unsigned long) Count * 8;
+
+	if ( (void *) clip_region != NULL )
+	{
+		switch ( regionTestRect ( clip_region, x, y, x + Width, y + Height ) )
+		{
+			case REGION_OUT:
+				return 0;
+
+			case REGION_IN:
+				break;
+
+			default:
+				return (int) 1;
+		};
+	}
+
+	glyph_target (&Target);
+
+	if ( glyph_inside ( &Target, x, y, Width, Height ) == 0 ){
+		return (int) 1;
+	}
+
+	damageAdd ( x, y, Width, Height );
+
+	Pixel = (color & 0x00FFFFFF) | ( ( (color >> 24) + 1 ) << 24 );
+
+	for ( Index=0; Index < Count; Index++ )
+	{
+		Bitmap = Font + (string[Index] * Height);
+		Dst = glyph_where ( &Target, x + (Index * 8), y );
+
+		for ( i=0; i < Height; i++ )
+		{
+			if ( Bitmap[i] != 0 ){
+				glyph_row_transparent ( Dst, Bitmap[i], Target.bytes_per_pixel, Pixel );
+			}
+
+			Dst += Target.pitch;
+		};
+	};
+
+	glyph_fast += Count;
+
+	return 0;
+}
+
+
+/* glyphs/s of a run. */
+
+static unsigned long glyph_rate ( unsigned long glyphs, unsigned long us ){
+
+	if ( us == 0 ){
+		us = 1;
+	}
+
+	// Short runs in us, long runs in ms. No overflow in 32 bits.
+	if ( us < 1000000 ){
+		return (unsigned long) ( ( (glyphs * 1000) / us ) * 1000 );
+	}
+
+	return (unsigned long) ( (glyphs * 1000) / (us / 1000) );
+}
+
+
+/*
+ * glyphBenchmark:
+ *     Draws GLYPH_BENCH_GLYPHS glyphs with each routine, with the
+ * pixel by pixel path and with the cache, on the top of the screen.
+ *     (SYS_GLYPHBENCH)
+ */
+
+void glyphBenchmark (void){
+
+	struct region_d *SavedClip;
+	struct surface_d *SavedSurface;
+	unsigned char Line[65];
+	unsigned long Start;
+	unsigned long Time[2][3];
+	unsigned long x, y;
+	int Saved;
+	int Mode;
+	int i;
+
+	int cWidth = get_char_width ();
+	int cHeight = get_char_height ();
+
+	if ( cWidth <= 0 || cHeight <= 0 ){
+		printf ("glyphBenchmark: font\n");
+		return;
+	}
+
+	for ( i=0; i < 64; i++ ){
+		Line[i] = (unsigned char) ( 'A' + (i % 26) );
+	};
+	Line[64] = 0;
+
+	SavedClip = clip_region;
+	SavedSurface = draw_surface;
+	Saved = glyph_cache_enabled;
+
+	clip_region = NULL;
+	draw_surface = NULL;
+
+	// 0 = pixel by pixel, 1 = cache.
+	for ( Mode=0; Mode < 2; Mode++ )
+	{
+		glyph_cache_enabled = Mode;
+
+		// draw_char.
+		Start = timerGetMonotonicUS ();
+
+		for ( i=0; i < GLYPH_BENCH_GLYPHS; i++ )
+		{
+			x = (i % 64) * cWidth;
+			y = ( (i / 64) % 8 ) * cHeight;
+			draw_char ( x, y, 'A' + (i % 26), COLOR_WHITE, COLOR_BLACK );
+		};
+
+		Time[Mode][0] = timerGetMonotonicUS () - Start;
+
+		// drawchar_transparent.
+		Start = timerGetMonotonicUS ();
+
+		for ( i=0; i < GLYPH_BENCH_GLYPHS; i++ )
+		{
+			x = (i % 64) * cWidth;
+			y = ( (i / 64) % 8 ) * cHeight;
+			drawchar_transparent ( x, y, COLOR_BLACK, 'A' + (i % 26) );
+		};
+
+		Time[Mode][1] = timerGetMonotonicUS () - Start;
+
+		// draw_string, 64 glyphs each.
+		Start = timerGetMonotonicUS ();
+
+		for ( i=0; i < (GLYPH_BENCH_GLYPHS / 64); i++ ){
+			draw_string ( 0, (i % 8) * cHeight, COLOR_BLACK, Line );
+		};
+
+		Time[Mode][2] = timerGetMonotonicUS () - Start;
+	};
+
+	glyph_cache_enabled = Saved;
+	clip_region = SavedClip;
+	draw_surface = SavedSurface;
+
+	printf ("glyph: %d glyphs per run, glyphs/s old -> cache\n",
+	    GLYPH_BENCH_GLYPHS );
+
+	printf ("draw_char:            %d -> %d\n",
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[0][0] ),
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[1][0] ) );
+
+	printf ("drawchar_transparent: %d -> %d\n",
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[0][1] ),
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[1][1] ) );
+
+	printf ("draw_string:          %d -> %d\n",
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[0][2] ),
+	    glyph_rate ( GLYPH_BENCH_GLYPHS, Time[1][2] ) );
+
+	glyphShowInfo ();
+}
+
+
+void glyphShowInfo (void){
+
+	printf ("glyph: fast={%d} slow={%d} pair hits={%d} misses={%d}\n",
+	    glyph_fast, glyph_slow, glyph_hits, glyph_misses );
+}
+
+
+//
+// End.
+//
+
@@ -49,9 +49,34 @@ void lineDrawHorizontalLineWindowBuffer(struct window_d *window,
 */
 
 
+/*
+ * line_span:
+ *     Pinta um pedao da linha, sem clip.
+ */
+
+static void 
+line_span ( unsigned long x1,
+            unsigned long y, 
+            unsigned long x2,  
+            unsigned long color )
+{
+    if ( x1 < x2 ){
+        damageAdd ( x1, y, x2 - x1, 1 );
+    }
+
+    while (x1 < x2){
+
+        backbuffer_putpixel ( color, x1, y, 0 );
+        x1++;  
+    }
+}
+
+
 /* 
  * my_buffer_horizontal_line:
  *     Draw a horizontal line on backbuffer. 
+ *     Com clip_region, s os pedaos que esto dentro da regio. 
+ * (region.h)
  */
 
 void 
@@ -60,11 +85,29 @@ my_buffer_horizontal_line ( unsigned long x1,
                             unsigned long x2,  
                             unsigned long color )
 {
-    while (x1 < x2){
-
-        backbuffer_putpixel ( color, x1, y, 0 );
-        x1++;  
-    }
+	struct region_rect_d *r;
+	unsigned long Left, Right;
+	int i;
+	
+	if ( (void *) clip_region == NULL )
+	{
+		line_span ( x1, y, x2, color );
+		return;
+	}
+	
+	for ( i=0; i < clip_region->count; i++ )
+	{
+		r = &clip_region->rects[i];
+		
+		if ( y < r->top || y >= r->bottom ){
+			continue;
+		}
+		
+		Left = ( x1 > r->left ) ? x1 : r->left;
+		Right = ( x2 < r->right ) ? x2 : r->right;
+		
+		line_span ( Left, y, Right, color );
+	};
 }
 
 
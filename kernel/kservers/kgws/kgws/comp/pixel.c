@@ -106,83 +106,38 @@ pixelPutPixelDedicatedWindowBuffer( struct window_d *window,
 									unsigned long y, 
 									unsigned long color )
 {
+	struct surface_d *Saved;
+	unsigned long SavedLeft, SavedTop;
 	
-	//#suspensa.
+	// O buffer dedicado agora  o surface da janela. (surface.h)
+	// x e y so relativos  janela.
 	
-	/*
-	//O buffer ser selecionado por essa rotina ficar aqui
-	void *buff;
-	
-	//Se temos uma estrutura de janela, essa estrutura pode
-	//conter um ponteiro para um buffer dedicado de janela.
 	if ( (void *) window == NULL )
 	{
-		buff = NULL;
-		goto useDefaultBuffer;
-		
-	}else{
-		
-		//Se o ponteiro para buffer dedicado indicado na estrutura
-		//for invlido.
-		
-		if ( (void *) window->DedicatedBuffer == NULL )
-		{
-			goto useDefaultBuffer;
-		}
-		
-		//Ok.
-		//O ponteiro para o buffer dedicado parece vlido.
-		//@todo: A rotina de criao de estrutura de janela
-		//tem que alocar dinmicamente memria para o buffer corretamente.
-		//e no pode admitir falha nesse requesito.
-		
-		buff = (void *) window->DedicatedBuffer;
-		goto useDedicatedBuffer;
-	};
+		return;
+	}
 	
-	//Nothing.
+	if ( (void *) window->surface == NULL )
+	{
+		return;
+	}
 	
-// Somos obrigados a usar o buffer dedicado da janela principal.	
-//@por enquanto isso no ser considerado uma falha.
-useDefaultBuffer:
-
-	//@todo: pegar o buffer default.
-	buff = (void *) gui->defaultWindowDedicatedBuffer1;
+	Saved = draw_surface;
+	SavedLeft = draw_surface_left;
+	SavedTop = draw_surface_top;
 	
-	if ( (void *) buff == NULL )
-	{
-		//@todo: Alocamos memria par a o buffer
-		
-		//buff = (void*) malloc(SIZE??);
-		
-		printf("pixelPutPixelDedicatedWindowBuffer:");
-		die();
-		//refresh_screen();
-		//while(1){}
-	};
-	
-	//...pinta asm_putpixel()
-//Aqui conseguimos encontrar o buffer dedicado da janela em questo.	
-//O buffer selecionad foi o buffer dedicado da janela. temos que checar.
-useDedicatedBuffer:	
-
-	if ( (void *) buff == NULL )
+	surfaceBegin (window);
+	
+	if ( draw_surface == window->surface )
 	{
-		//@todo: Alocamos memria par a o buffer
-		
-		//buff = (void*) malloc(SIZE??);
-		
-		printf("pixelPutPixelDedicatedWindowBuffer:");
-		die();
-		
-		//refresh_screen();
-		//while(1){}
+		surfacePutPixel ( color, window->left + x, window->top + y );
+		surfaceDamage ( window->left + x, window->top + y, 1, 1 );
 	}
-	//pinta. asm_putpixel()
 	
-	*/
-    return;	
-};
+	draw_surface = Saved;
+	draw_surface_left = SavedLeft;
+	draw_surface_top = SavedTop;
+}
 
 
 /*
@@ -199,6 +154,13 @@ backbuffer_putpixel ( unsigned long ax,
                       unsigned long cx, 
                       unsigned long dx )
 {
+	// Pintando no surface de uma janela. (surface.h)
+	if ( (void *) draw_surface != NULL )
+	{
+		surfacePutPixel ( ax, bx, cx );
+		return;
+	}
+	
 	// #importante
 	// Esse  o origina. Isso funciona.
 	// No usar.
@@ -42,12 +42,10 @@ void *rectStrCopyMemory32 ( unsigned long *dest, unsigned long *src, int count )
 		return dest;
 	}
 	
-	// GCC should optimize this for us :)
+	// rep movsd. (klibc)
 	
-	int i;
-	for ( i=0; i < count; i++ ) 
-	{
-		dest[i] = src[i];
+	if ( count > 0 ){
+		memcpy32 ( (void *) dest, (const void *) src, (unsigned long) count );
 	}
 	
 	return dest;
@@ -180,6 +178,9 @@ drawDataRectangle ( unsigned long x,
                     unsigned long color )
 {
 	struct rect_d rect;
+	struct region_rect_d *r;
+	unsigned long Left, Top, Right, Bottom;
+	int i;
 	
     rect.bg_color = color;
 
@@ -215,7 +216,37 @@ drawDataRectangle ( unsigned long x,
         rect.bottom = SavedY;
 	}
     	
+	// Clip. (region.h)
+	// S as partes do retngulo que esto na regio.
+	
+	if ( (void *) clip_region != NULL )
+	{
+		for ( i=0; i < clip_region->count; i++ )
+		{
+			r = &clip_region->rects[i];
+			
+			Left = ( rect.left > r->left ) ? rect.left : r->left;
+			Top = ( rect.top > r->top ) ? rect.top : r->top;
+			Right = ( rect.right < r->right ) ? rect.right : r->right;
+			Bottom = ( rect.bottom < r->bottom ) ? rect.bottom : r->bottom;
+			
+			if ( Left >= Right || Top >= Bottom ){
+				continue;
+			}
+			
+			damageAdd ( Left, Top, Right - Left, Bottom - Top );
+			
+			for ( ; Top < Bottom; Top++ ){
+				my_buffer_horizontal_line ( Left, Top, Right, rect.bg_color );
+			};
+		};
+		
+		return;
+	}
   	
+	damageAdd ( rect.left, rect.top, 
+	    rect.right - rect.left, rect.bottom - rect.top );
+
     // Draw lines on backbuffer.
 	
 	while (height--)
@@ -295,10 +326,10 @@ setClientAreaRect ( unsigned long x,
 // bem mais rpido com mltiplos de 4.
  
 void 
-refresh_rectangle ( unsigned long x, 
-                    unsigned long y, 
-                    unsigned long width, 
-                    unsigned long height )
+refresh_rectangle_nosync ( unsigned long x, 
+                           unsigned long y, 
+                           unsigned long width, 
+                           unsigned long height )
 {
 	void *p = (void *) FRONTBUFFER_ADDRESS;
 	const void *q = (const void*) BACKBUFFER_ADDRESS;
@@ -342,16 +373,16 @@ refresh_rectangle ( unsigned long x,
 	p = (void *) (p + offset);    
 	q = (const void *) (q + offset);    
 	 
-	// #bugbug
-	// Isso pode nos dar problemas.
-	// ?? Isso ainda  necessrio nos dias de hoje ??
-	
-	vsync ();	
+	// A vsync  feita por quem chama.
+	// (refresh_rectangle e damageFlush)
 		
 	//(line_size * bytes_count)  o nmero de bytes por linha. 
 	
 	int count; 
 
+	// Os sprites neste retngulo saem da frente. (sprite.h)
+	spriteBeginCopy ( x, y, width, height );
+
 	//#importante
 	// bem mais rpido com mltiplos de 4.	
 	
@@ -381,6 +412,29 @@ refresh_rectangle ( unsigned long x,
 		    p += (Width * bytes_count);
 	    };	
 	}
+
+	spriteEndCopy ();
+}
+
+
+/*
+ * refresh_rectangle:
+ *     vsync e cpia do retngulo para o frontbuffer.
+ */
+
+void 
+refresh_rectangle ( unsigned long x, 
+                    unsigned long y, 
+                    unsigned long width, 
+                    unsigned long height )
+{
+	// #bugbug
+	// Isso pode nos dar problemas.
+	// ?? Isso ainda  necessrio nos dias de hoje ??
+	
+	vsync ();
+	
+	refresh_rectangle_nosync ( x, y, width, height );
 }
 
 
@@ -741,6 +795,8 @@ show_saved_rect ( unsigned long x,
 	// No precisa de sincronizao pois no estamos enviando para o LFB.
 	// vsync ();		
 	
+	damageAdd ( x, y, width, height );
+	
 	//(line_size * 3)  o nmero de bytes por linha. 
 	
 	//se for divisvel por 4.
@@ -0,0 +1,307 @@
+/*
+ * File: kgws/comp/region.c
+ *
+ *     Regions: short lists of rectangles. (see region.h)
+ *     Used for the visible region of the windows and for the clip
+ * of the drawing routines.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+
+
+static int region_overlap ( struct region_rect_d *a, struct region_rect_d *b ){
+
+	if ( a->left >= b->right || b->left >= a->right ||
+	     a->top >= b->bottom || b->top >= a->bottom )
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/*
+ * region_put:
+ *     Append a rectangle. When the list is full the rectangle is
+ * merged with the last one. (bigger, never smaller)
+ */
+
+static void region_put ( struct region_d *region, struct region_rect_d *r ){
+
+	struct region_rect_d *Last;
+
+	if ( r->left >= r->right || r->top >= r->bottom ){
+		return;
+	}
+
+	if ( region->count < REGION_RECT_MAX )
+	{
+		region->rects[region->count] = *r;
+		region->count++;
+		return;
+	}
+
+	Last = &region->rects[REGION_RECT_MAX -1];
+
+	if ( r->left < Last->left ){ Last->left = r->left; }
+	if ( r->top < Last->top ){ Last->top = r->top; }
+	if ( r->right > Last->right ){ Last->right = r->right; }
+	if ( r->bottom > Last->bottom ){ Last->bottom = r->bottom; }
+}
+
+
+void regionClear ( struct region_d *region ){
+
+	region->count = 0;
+}
+
+
+void
+regionSetRect ( struct region_d *region,
+                unsigned long left,
+                unsigned long top,
+                unsigned long width,
+                unsigned long height )
+{
+	struct region_rect_d r;
+
+	region->count = 0;
+
+	if ( width == 0 || height == 0 || left >= SavedX || top >= SavedY ){
+		return;
+	}
+
+	r.left = left;
+	r.top = top;
+	r.right = left + width;
+	r.bottom = top + height;
+
+	if ( r.right > SavedX || r.right < left ){ r.right = SavedX; }
+	if ( r.bottom > SavedY || r.bottom < top ){ r.bottom = SavedY; }
+
+	region_put ( region, &r );
+}
+
+
+int regionIsEmpty ( struct region_d *region ){
+
+	return (int) ( region->count == 0 );
+}
+
+
+/*
+ * regionSubtractRect:
+ *     Each rectangle that overlaps the cut becomes up to four pieces:
+ * the band above, the band below, and the parts at the left and at
+ * the right of the cut.
+ */
+
+void regionSubtractRect ( struct region_d *region, struct region_rect_d *rect ){
+
+	struct region_rect_d Old[REGION_RECT_MAX];
+	struct region_rect_d Piece[4];
+	struct region_rect_d *r;
+	unsigned long Top, Bottom;
+	int Count;
+	int n;
+	int i, j;
+
+	Count = region->count;
+
+	for ( i=0; i < Count; i++ ){
+		Old[i] = region->rects[i];
+	};
+
+	region->count = 0;
+
+	for ( i=0; i < Count; i++ )
+	{
+		r = &Old[i];
+
+		if ( region_overlap ( r, rect ) == 0 )
+		{
+			region_put ( region, r );
+			continue;
+		}
+
+		n = 0;
+
+		Top = ( rect->top > r->top ) ? rect->top : r->top;
+		Bottom = ( rect->bottom < r->bottom ) ? rect->bottom : r->bottom;
+
+		if ( rect->top > r->top )
+		{
+			Piece[n] = *r;
+			Piece[n].bottom = rect->top;
+			n++;
+		}
+
+		if ( rect->bottom < r->bottom )
+		{
+			Piece[n] = *r;
+			Piece[n].top = rect->bottom;
+			n++;
+		}
+
+		if ( rect->left > r->left )
+		{
+			Piece[n].left = r->left;
+			Piece[n].right = rect->left;
+			Piece[n].top = Top;
+			Piece[n].bottom = Bottom;
+			n++;
+		}
+
+		if ( rect->right < r->right )
+		{
+			Piece[n].left = rect->right;
+			Piece[n].right = r->right;
+			Piece[n].top = Top;
+			Piece[n].bottom = Bottom;
+			n++;
+		}
+
+		// No room for the pieces, keep the rectangle.
+		if ( region->count + n > REGION_RECT_MAX )
+		{
+			region_put ( region, r );
+			continue;
+		}
+
+		for ( j=0; j < n; j++ ){
+			region_put ( region, &Piece[j] );
+		};
+	};
+}
+
+
+void regionIntersectRect ( struct region_d *region, struct region_rect_d *rect ){
+
+	struct region_rect_d *r;
+	int Count;
+	int i;
+
+	Count = region->count;
+	region->count = 0;
+
+	for ( i=0; i < Count; i++ )
+	{
+		r = &region->rects[i];
+
+		if ( region_overlap ( r, rect ) == 0 ){
+			continue;
+		}
+
+		if ( rect->left > r->left ){ r->left = rect->left; }
+		if ( rect->top > r->top ){ r->top = rect->top; }
+		if ( rect->right < r->right ){ r->right = rect->right; }
+		if ( rect->bottom < r->bottom ){ r->bottom = rect->bottom; }
+
+		// i >= count, the slot is free.
+		region->rects[region->count] = *r;
+		region->count++;
+	};
+}
+
+
+void regionIntersect ( struct region_d *region, struct region_d *with ){
+
+	struct region_d Old;
+	struct region_d Tmp;
+	int i, j;
+
+	Old = *region;
+	region->count = 0;
+
+	for ( i=0; i < with->count; i++ )
+	{
+		Tmp = Old;
+		regionIntersectRect ( &Tmp, &with->rects[i] );
+
+		for ( j=0; j < Tmp.count; j++ ){
+			region_put ( region, &Tmp.rects[j] );
+		};
+	};
+}
+
+
+/*
+ * regionTestRect:
+ *     REGION_IN when one rectangle of the region has the whole
+ * rectangle, REGION_OUT when no rectangle touches it.
+ */
+
+int
+regionTestRect ( struct region_d *region,
+                 unsigned long left,
+                 unsigned long top,
+                 unsigned long right,
+                 unsigned long bottom )
+{
+	struct region_rect_d r;
+	struct region_rect_d *p;
+	int Result = REGION_OUT;
+	int i;
+
+	r.left = left;
+	r.top = top;
+	r.right = right;
+	r.bottom = bottom;
+
+	for ( i=0; i < region->count; i++ )
+	{
+		p = &region->rects[i];
+
+		if ( region_overlap ( p, &r ) == 0 ){
+			continue;
+		}
+
+		if ( left >= p->left && right <= p->right &&
+		     top >= p->top && bottom <= p->bottom )
+		{
+			return (int) REGION_IN;
+		}
+
+		Result = REGION_PARTIAL;
+	};
+
+	return (int) Result;
+}
+
+
+int
+regionContains ( struct region_d *region,
+                 unsigned long x,
+                 unsigned long y )
+{
+	struct region_rect_d *p;
+	int i;
+
+	for ( i=0; i < region->count; i++ )
+	{
+		p = &region->rects[i];
+
+		if ( x >= p->left && x < p->right &&
+		     y >= p->top && y < p->bottom )
+		{
+			return 1;
+		}
+	};
+
+	return 0;
+}
+
+
+//
+// End.
+//
+
@@ -0,0 +1,424 @@
+/*
+ * File: kgws/comp/surface.c
+ *
+ *     Window surfaces and the compositor. (see surface.h)
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+extern unsigned long SavedBPP;
+
+
+static unsigned long surface_bytes_per_pixel (void){
+
+	if ( SavedBPP == 32 ){
+		return 4;
+	}
+
+	return 3;
+}
+
+
+static int surface_valid ( struct surface_d *surface ){
+
+	if ( (void *) surface == NULL ){
+		return 0;
+	}
+
+	if ( surface->used != 1 || surface->magic != 1234 ){
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/*
+ * surfaceCreate:
+ *     The window gets a surface with its size, if it fits in the
+ * budget. 0 = ok.
+ */
+
+int surfaceCreate ( struct window_d *window ){
+
+	struct surface_d *s;
+	unsigned long Size;
+	int Pages;
+
+	if ( (void *) window == NULL ){
+		return (int) 1;
+	}
+
+	if ( (void *) window->surface != NULL ){
+		return 0;
+	}
+
+	if ( window->width == 0 || window->height == 0 ||
+	     window->width > SavedX || window->height > SavedY )
+	{
+		return (int) 1;
+	}
+
+	s = (void *) malloc ( sizeof(struct surface_d) );
+
+	if ( (void *) s == NULL ){
+		return (int) 1;
+	}
+
+	s->width = window->width +2;
+	s->height = window->height +2;
+	s->bytes_per_pixel = surface_bytes_per_pixel ();
+	s->pitch = s->width * s->bytes_per_pixel;
+
+	Size = s->pitch * s->height;
+	Pages = (int) ( (Size + PAGE_SIZE -1) / PAGE_SIZE );
+
+	if ( Pages > SURFACE_PAGES_MAX ||
+	     surface_pages_used + Pages > SURFACE_TOTAL_PAGES_MAX )
+	{
+		free (s);
+		return (int) 1;
+	}
+
+	s->buffer = (unsigned char *) allocHighPages (Pages);
+
+	if ( (void *) s->buffer == NULL )
+	{
+		free (s);
+		return (int) 1;
+	}
+
+	s->pages = Pages;
+	s->window = window;
+	s->valid = 0;
+	s->dirty = 0;
+
+	s->used = 1;
+	s->magic = 1234;
+
+	surface_pages_used += Pages;
+	surface_count++;
+
+	window->surface = s;
+	window->DedicatedBuffer = (void *) s->buffer;
+
+	return 0;
+}
+
+
+void surfaceDestroy ( struct window_d *window ){
+
+	struct surface_d *s;
+
+	if ( (void *) window == NULL ){
+		return;
+	}
+
+	s = window->surface;
+
+	window->surface = NULL;
+	window->DedicatedBuffer = NULL;
+
+	if ( surface_valid (s) == 0 ){
+		return;
+	}
+
+	if ( draw_surface == s ){
+		draw_surface = NULL;
+	}
+
+	// High frames in the kmap window. (allocHighPages)
+	freeHighPages ( (void *) s->buffer );
+
+	surface_pages_used -= s->pages;
+	surface_count--;
+
+	s->used = 0;
+	s->magic = 0;
+
+	free (s);
+}
+
+
+/*
+ * surfaceBegin:
+ *     The drawing routines paint into the surface of the window.
+ *     Without a surface they keep painting in the backbuffer.
+ */
+
+void surfaceBegin ( struct window_d *window ){
+
+	if ( (void *) window == NULL ){
+		return;
+	}
+
+	if ( surface_valid (window->surface) == 0 ){
+		return;
+	}
+
+	draw_surface_left = window->left;
+	draw_surface_top = window->top;
+
+	draw_surface = window->surface;
+}
+
+
+void surfaceEnd (void){
+
+	draw_surface = NULL;
+}
+
+
+void
+surfacePutPixel ( unsigned long color,
+                  unsigned long x,
+                  unsigned long y )
+{
+	struct surface_d *s = draw_surface;
+	unsigned char *p;
+
+	// Wraps when x < left.
+	x = x - draw_surface_left;
+	y = y - draw_surface_top;
+
+	if ( x >= s->width || y >= s->height ){
+		return;
+	}
+
+	p = s->buffer + (y * s->pitch) + (x * s->bytes_per_pixel);
+
+	p[0] = (color & 0xFF);
+	p[1] = (color >> 8) & 0xFF;
+	p[2] = (color >> 16) & 0xFF;
+
+	if ( s->bytes_per_pixel == 4 ){
+		p[3] = (color >> 24) + 1;
+	}
+}
+
+
+void
+surfaceDamage ( unsigned long x,
+                unsigned long y,
+                unsigned long width,
+                unsigned long height )
+{
+	struct surface_d *s = draw_surface;
+	unsigned long Left, Top, Right, Bottom;
+
+	if ( width == 0 || height == 0 ){
+		return;
+	}
+
+	if ( x < draw_surface_left ){
+		if ( x + width <= draw_surface_left ){ return; }
+		width -= (draw_surface_left - x);
+		x = draw_surface_left;
+	}
+
+	if ( y < draw_surface_top ){
+		if ( y + height <= draw_surface_top ){ return; }
+		height -= (draw_surface_top - y);
+		y = draw_surface_top;
+	}
+
+	Left = x - draw_surface_left;
+	Top = y - draw_surface_top;
+
+	if ( Left >= s->width || Top >= s->height ){
+		return;
+	}
+
+	Right = Left + width;
+	Bottom = Top + height;
+
+	if ( Right > s->width ){ Right = s->width; }
+	if ( Bottom > s->height ){ Bottom = s->height; }
+
+	if ( s->dirty == 0 )
+	{
+		s->dirty_left = Left;
+		s->dirty_top = Top;
+		s->dirty_right = Right;
+		s->dirty_bottom = Bottom;
+		s->dirty = 1;
+		return;
+	}
+
+	if ( Left < s->dirty_left ){ s->dirty_left = Left; }
+	if ( Top < s->dirty_top ){ s->dirty_top = Top; }
+	if ( Right > s->dirty_right ){ s->dirty_right = Right; }
+	if ( Bottom > s->dirty_bottom ){ s->dirty_bottom = Bottom; }
+}
+
+
+/*
+ * surfacePaint:
+ *     The owner paints the whole window into the surface.
+ *     No clip here, the clip is done when we copy.
+ */
+
+int surfacePaint ( struct window_d *window ){
+
+	struct region_d *SavedClip;
+	int Status;
+
+	if ( surface_valid (window->surface) == 0 ){
+		return (int) 1;
+	}
+
+	SavedClip = clip_region;
+	clip_region = NULL;
+
+	surfaceBegin (window);
+
+	Status = (int) redraw_window ( window, 0 );
+
+	surfaceEnd ();
+
+	clip_region = SavedClip;
+
+	if ( Status == 0 ){
+		window->surface->valid = 1;
+	}
+
+	surface_paints++;
+
+	return (int) Status;
+}
+
+
+/*
+ * surface_copy:
+ *     One rectangle of the screen, from the surface to the backbuffer.
+ */
+
+static void
+surface_copy ( struct window_d *window,
+               unsigned long left,
+               unsigned long top,
+               unsigned long right,
+               unsigned long bottom )
+{
+	struct surface_d *s = window->surface;
+	unsigned char *Src;
+	unsigned char *Dst;
+	unsigned long Bpp = s->bytes_per_pixel;
+	unsigned long Pitch = SavedX * Bpp;
+	unsigned long Count;
+
+	// The surface on the screen.
+	if ( left < window->left ){ left = window->left; }
+	if ( top < window->top ){ top = window->top; }
+	if ( right > window->left + s->width ){ right = window->left + s->width; }
+	if ( bottom > window->top + s->height ){ bottom = window->top + s->height; }
+	if ( right > SavedX ){ right = SavedX; }
+	if ( bottom > SavedY ){ bottom = SavedY; }
+
+	if ( left >= right || top >= bottom ){
+		return;
+	}
+
+	damageAdd ( left, top, right - left, bottom - top );
+
+	Src = s->buffer + ( (top - window->top) * s->pitch ) + ( (left - window->left) * Bpp );
+	Dst = (unsigned char *) BACKBUFFER_VA + (top * Pitch) + (left * Bpp);
+	Count = (right - left) * Bpp;
+
+	for ( ; top < bottom; top++ )
+	{
+		memcpy ( (void *) Dst, (const void *) Src, Count );
+
+		Src += s->pitch;
+		Dst += Pitch;
+	};
+}
+
+
+/*
+ * surfaceBlit:
+ *     Copy the surface of the window to the backbuffer, only inside
+ * the region. (screen coordinates)
+ */
+
+void surfaceBlit ( struct window_d *window, struct region_d *region ){
+
+	struct region_rect_d *r;
+	int i;
+
+	if ( (void *) window == NULL || (void *) region == NULL ){
+		return;
+	}
+
+	if ( surface_valid (window->surface) == 0 ){
+		return;
+	}
+
+	for ( i=0; i < region->count; i++ )
+	{
+		r = &region->rects[i];
+		surface_copy ( window, r->left, r->top, r->right, r->bottom );
+	};
+
+	surface_blits++;
+}
+
+
+/*
+ * surfaceFlush:
+ *     Copy the dirty rectangle of the surface, where the window is
+ * visible.
+ */
+
+void surfaceFlush ( struct window_d *window ){
+
+	struct surface_d *s;
+	struct region_d Region;
+	struct region_rect_d Dirty;
+
+	if ( (void *) window == NULL ){
+		return;
+	}
+
+	s = window->surface;
+
+	if ( surface_valid (s) == 0 || s->dirty == 0 ){
+		return;
+	}
+
+	s->dirty = 0;
+
+	if ( windowVisibleRegion ( window, &Region ) == 0 ){
+		return;
+	}
+
+	Dirty.left = window->left + s->dirty_left;
+	Dirty.top = window->top + s->dirty_top;
+	Dirty.right = window->left + s->dirty_right;
+	Dirty.bottom = window->top + s->dirty_bottom;
+
+	regionIntersectRect ( &Region, &Dirty );
+
+	surfaceBlit ( window, &Region );
+}
+
+
+void surfaceShowInfo (void){
+
+	printf ("surfaces={%d} pages={%d}/{%d} paints={%d} blits={%d}\n",
+	    surface_count, surface_pages_used, SURFACE_TOTAL_PAGES_MAX,
+	    surface_paints, surface_blits );
+}
+
+
+//
+// End.
+//
+
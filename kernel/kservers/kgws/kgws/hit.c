@@ -0,0 +1,525 @@
+/*
+ * File: kgws/hit.c
+ *
+ *     Spatial index for the mouse hit test. (see hit.h)
+ *
+ *     A control is visible at a point when it is above the top window
+ * that has the point. So we visit the windows of the cell that have
+ * the point, the top first, and take the control with the highest
+ * zIndex among their controls, if it is above the top window.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+static struct hit_cell_d hit_grid[HIT_GRID_ROWS][HIT_GRID_COLS];
+
+static spinlock_t hit_spinlock;
+
+
+static int hit_is_control ( struct window_d *window ){
+
+	if ( window->type == WT_BUTTON || window->type == WT_EDITBOX ){
+		return 1;
+	}
+
+	return 0;
+}
+
+
+static int hit_valid ( struct window_d *window ){
+
+	if ( (void *) window == NULL ){
+		return 0;
+	}
+
+	if ( window->used != 1 || window->magic != 1234 ){
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/* A window of the grid that has the point. */
+
+static int hit_window_has ( struct window_d *window, unsigned long x, unsigned long y ){
+
+	if ( hit_valid (window) == 0 || window->view == VIEW_MINIMIZED ){
+		return 0;
+	}
+
+	if ( x >= window->left && x < window->left + window->width &&
+	     y >= window->top && y < window->top + window->height )
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/* A control has the point. Relative to the parent, as windowScan did. */
+
+static int hit_control_has ( struct window_d *control, unsigned long x, unsigned long y ){
+
+	struct window_d *p;
+
+	if ( hit_valid (control) == 0 ){
+		return 0;
+	}
+
+	p = control->parent;
+
+	if ( hit_valid (p) == 0 ){
+		return 0;
+	}
+
+	if ( x > (p->left + control->left) &&
+	     x < (p->left + control->left + control->width) &&
+	     y > (p->top + control->top) &&
+	     y < (p->top + control->top + control->height) )
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * hit_cells:
+ *     The cells of the rectangle indexed for the window.
+ *     Returns 0 when it is out of the grid.
+ */
+
+static int
+hit_cells ( struct window_d *window,
+            int *col0, int *row0, int *col1, int *row1 )
+{
+	if ( window->hit_right <= window->hit_left ||
+	     window->hit_bottom <= window->hit_top )
+	{
+		return 0;
+	}
+
+	if ( (window->hit_left >> HIT_CELL_SHIFT) >= HIT_GRID_COLS ||
+	     (window->hit_top >> HIT_CELL_SHIFT) >= HIT_GRID_ROWS )
+	{
+		return 0;
+	}
+
+	*col0 = (int) (window->hit_left >> HIT_CELL_SHIFT);
+	*row0 = (int) (window->hit_top >> HIT_CELL_SHIFT);
+	*col1 = (int) ( (window->hit_right -1) >> HIT_CELL_SHIFT );
+	*row1 = (int) ( (window->hit_bottom -1) >> HIT_CELL_SHIFT );
+
+	if ( *col1 >= HIT_GRID_COLS ){ *col1 = HIT_GRID_COLS -1; }
+	if ( *row1 >= HIT_GRID_ROWS ){ *row1 = HIT_GRID_ROWS -1; }
+
+	return 1;
+}
+
+
+/* The top first. */
+
+static void hit_cell_insert ( struct hit_cell_d *cell, struct window_d *window ){
+
+	int i, j;
+
+	if ( cell->count >= HIT_CELL_MAX )
+	{
+		cell->overflow = 1;
+		return;
+	}
+
+	for ( i=0; i < cell->count; i++ )
+	{
+		if ( cell->windows[i]->zIndex < window->zIndex ){
+			break;
+		}
+	};
+
+	for ( j = cell->count; j > i; j-- ){
+		cell->windows[j] = cell->windows[j -1];
+	};
+
+	cell->windows[i] = window;
+	cell->count++;
+}
+
+
+/*
+ * hit_cell_rescan:
+ *     A cell that overflowed lost a window. The windows that did not
+ * fit can fit now, so the cell is built again from the zorderList[],
+ * without the window that is going out.
+ */
+
+static void
+hit_cell_rescan ( struct hit_cell_d *cell,
+                  int row,
+                  int col,
+                  struct window_d *window )
+{
+	struct window_d *w;
+	int col0, row0, col1, row1;
+	int i;
+
+	cell->count = 0;
+	cell->overflow = 0;
+
+	for ( i=0; i < ZORDER_COUNT_MAX; i++ )
+	{
+		w = (struct window_d *) zorderList[i];
+
+		if ( (void *) w == NULL || w == window || w->hit_indexed != 1 ){
+			continue;
+		}
+
+		if ( hit_is_control (w) == 1 ){
+			continue;
+		}
+
+		if ( hit_cells ( w, &col0, &row0, &col1, &row1 ) == 0 ){
+			continue;
+		}
+
+		if ( row >= row0 && row <= row1 && col >= col0 && col <= col1 ){
+			hit_cell_insert ( cell, w );
+		}
+	};
+}
+
+
+static void
+hit_cell_remove ( struct hit_cell_d *cell,
+                  int row,
+                  int col,
+                  struct window_d *window )
+{
+	int i;
+
+	if ( cell->overflow == 1 )
+	{
+		hit_cell_rescan ( cell, row, col, window );
+		return;
+	}
+
+	for ( i=0; i < cell->count; i++ )
+	{
+		if ( cell->windows[i] != window ){
+			continue;
+		}
+
+		cell->count--;
+
+		for ( ; i < cell->count; i++ ){
+			cell->windows[i] = cell->windows[i +1];
+		};
+
+		return;
+	};
+}
+
+
+static void hit_grid_insert ( struct window_d *window ){
+
+	int col0, row0, col1, row1;
+	int r, c;
+
+	window->hit_left = window->left;
+	window->hit_top = window->top;
+	window->hit_right = window->left + window->width;
+	window->hit_bottom = window->top + window->height;
+
+	if ( hit_cells ( window, &col0, &row0, &col1, &row1 ) == 0 ){
+		return;
+	}
+
+	for ( r = row0; r <= row1; r++ )
+	{
+		for ( c = col0; c <= col1; c++ ){
+			hit_cell_insert ( &hit_grid[r][c], window );
+		};
+	};
+}
+
+
+static void hit_grid_remove ( struct window_d *window ){
+
+	int col0, row0, col1, row1;
+	int r, c;
+
+	if ( hit_cells ( window, &col0, &row0, &col1, &row1 ) == 0 ){
+		return;
+	}
+
+	for ( r = row0; r <= row1; r++ )
+	{
+		for ( c = col0; c <= col1; c++ ){
+			hit_cell_remove ( &hit_grid[r][c], r, c, window );
+		};
+	};
+}
+
+
+void hitInit (void){
+
+	int r, c;
+
+	for ( r=0; r < HIT_GRID_ROWS; r++ )
+	{
+		for ( c=0; c < HIT_GRID_COLS; c++ )
+		{
+			hit_grid[r][c].count = 0;
+			hit_grid[r][c].overflow = 0;
+		};
+	};
+
+	spinLockInit (&hit_spinlock);
+
+	hit_tests = 0;
+	hit_fallbacks = 0;
+}
+
+
+/*
+ * hitInsert:
+ *     Called by createw after the window gets its zIndex.
+ */
+
+void hitInsert ( struct window_d *window ){
+
+	struct window_d *p;
+	struct window_d **Link;
+	unsigned long Flags;
+
+	if ( hit_valid (window) == 0 ){
+		return;
+	}
+
+	window->hit_indexed = 0;
+	window->hit_controls = NULL;
+	window->hit_next = NULL;
+
+	Flags = spinLockIrqSave (&hit_spinlock);
+
+	if ( hit_is_control (window) == 1 )
+	{
+		p = window->parent;
+
+		if ( hit_valid (p) == 1 )
+		{
+			Link = &p->hit_controls;
+
+			while ( (void *) *Link != NULL && (*Link)->zIndex > window->zIndex ){
+				Link = &(*Link)->hit_next;
+			};
+
+			window->hit_next = *Link;
+			*Link = window;
+
+			window->hit_indexed = 1;
+		}
+
+	}else{
+
+		hit_grid_insert (window);
+		window->hit_indexed = 1;
+	};
+
+	spinUnlockIrqRestore ( &hit_spinlock, Flags );
+}
+
+
+void hitRemove ( struct window_d *window ){
+
+	struct window_d *c;
+	struct window_d **Link;
+	unsigned long Flags;
+
+	if ( (void *) window == NULL || window->hit_indexed != 1 ){
+		return;
+	}
+
+	Flags = spinLockIrqSave (&hit_spinlock);
+
+	if ( hit_is_control (window) == 1 )
+	{
+		// The parent can be gone already. Its list went with it.
+		if ( hit_valid (window->parent) == 1 )
+		{
+			Link = &window->parent->hit_controls;
+
+			while ( (void *) *Link != NULL && *Link != window ){
+				Link = &(*Link)->hit_next;
+			};
+
+			if ( *Link == window ){
+				*Link = window->hit_next;
+			}
+		}
+
+	}else{
+
+		hit_grid_remove (window);
+
+		// The controls go out with the window.
+		while ( (void *) window->hit_controls != NULL )
+		{
+			c = window->hit_controls;
+			window->hit_controls = c->hit_next;
+
+			c->hit_next = NULL;
+			c->hit_indexed = 0;
+		};
+	};
+
+	window->hit_next = NULL;
+	window->hit_indexed = 0;
+
+	spinUnlockIrqRestore ( &hit_spinlock, Flags );
+}
+
+
+/*
+ * hitUpdate:
+ *     The controls are relative to the parent, only the windows of
+ * the grid move.
+ */
+
+void hitUpdate ( struct window_d *window ){
+
+	unsigned long Flags;
+
+	if ( (void *) window == NULL || window->hit_indexed != 1 ){
+		return;
+	}
+
+	if ( hit_is_control (window) == 1 ){
+		return;
+	}
+
+	Flags = spinLockIrqSave (&hit_spinlock);
+
+	hit_grid_remove (window);
+	hit_grid_insert (window);
+
+	spinUnlockIrqRestore ( &hit_spinlock, Flags );
+}
+
+
+/*
+ * hit_visit:
+ *     A window that has the point. The first one is the top.
+ *     Its first control with the point is its highest.
+ */
+
+static void
+hit_visit ( struct window_d *window,
+            unsigned long x,
+            unsigned long y,
+            struct window_d **top,
+            struct window_d **best )
+{
+	struct window_d *c;
+
+	if ( (void *) *top == NULL ){
+		*top = window;
+	}
+
+	for ( c = window->hit_controls; (void *) c != NULL; c = c->hit_next )
+	{
+		// The list is in the zorder, nothing better below.
+		if ( (void *) *best != NULL && c->zIndex <= (*best)->zIndex ){
+			return;
+		}
+
+		if ( c->zIndex <= (*top)->zIndex ){
+			return;
+		}
+
+		if ( hit_control_has ( c, x, y ) == 1 )
+		{
+			*best = c;
+			return;
+		}
+	};
+}
+
+
+/*
+ * hitTest:
+ *     Called by the mouse irq. (windowScan)
+ */
+
+int hitTest ( unsigned long x, unsigned long y ){
+
+	struct hit_cell_d *cell;
+	struct window_d *w;
+	struct window_d *Top = NULL;
+	struct window_d *Best = NULL;
+	unsigned long Flags;
+	int Result = -1;
+	int i;
+
+	if ( (x >> HIT_CELL_SHIFT) >= HIT_GRID_COLS ||
+	     (y >> HIT_CELL_SHIFT) >= HIT_GRID_ROWS )
+	{
+		return (int) -1;
+	}
+
+	cell = &hit_grid[y >> HIT_CELL_SHIFT][x >> HIT_CELL_SHIFT];
+
+	Flags = spinLockIrqSave (&hit_spinlock);
+
+	hit_tests++;
+
+	if ( cell->overflow == 0 )
+	{
+		for ( i=0; i < cell->count; i++ )
+		{
+			w = cell->windows[i];
+
+			if ( hit_window_has ( w, x, y ) == 1 ){
+				hit_visit ( w, x, y, &Top, &Best );
+			}
+		};
+
+	}else{
+
+		hit_fallbacks++;
+
+		for ( i = ZORDER_COUNT_MAX -1; i >= 0; i-- )
+		{
+			w = (struct window_d *) zorderList[i];
+
+			if ( (void *) w == NULL || w->hit_indexed != 1 ){
+				continue;
+			}
+
+			if ( hit_is_control (w) == 0 && hit_window_has ( w, x, y ) == 1 ){
+				hit_visit ( w, x, y, &Top, &Best );
+			}
+		};
+	};
+
+	if ( (void *) Best != NULL ){
+		Result = (int) Best->id;
+	}
+
+	spinUnlockIrqRestore ( &hit_spinlock, Flags );
+
+	return (int) Result;
+}
+
+
+//
+// End.
+//
+
@@ -44,6 +44,9 @@ extern unsigned long kArg2;	   //LFB - Linear Frame Buffer.
 extern unsigned long kArg3;	   //??.
 extern unsigned long kArg4;	   //??.	
 
+extern unsigned long SavedX;
+extern unsigned long SavedY;
+
 
 
 /*
@@ -1156,52 +1159,19 @@ done:
 /*
  * windowCreateDedicatedBuffer: 
  *     Cria um buffer dedicado de acordo com as dimenses da janela.
+ *     O buffer dedicado  o surface da janela, com o formato de pixel 
+ * do backbuffer. (surface.h)
  */
 
-// #bugbug
-// Essas rotinas de buffer dedicado precisam serem revistas. 
- 
 int windowCreateDedicatedBuffer (struct window_d *window){
 
-	size_t bufferSize;
-	
 	//Check;
 	if ((void *) window == NULL )
 	{ 
 	    return (int) 1;  //Fail. 
 	};
 	
-    //
-    // Buffer size.
-    //
-	
-	//@todo: Usar varivel para quantidade de bytes por pixel.
-	bufferSize = (size_t) (window->width * 3) + (window->height * 3);
-	
-	//
-	// Alocando memria no Heap do kernel.
-	//
-	
-	if(bufferSize == 0){
-	    return (int) 1;    //Fail.	
-	}
-	else
-	{
-	    window->DedicatedBuffer = (void *) malloc (bufferSize);	
-	    
-	    if( (void *) window->DedicatedBuffer == NULL )
-	    {
-		    return (int) 1;    //Fail.	
-		}
-		goto done;
-	};
-	//Nothing
-	
-	//Success.
-	
-done:
-
-	return 0;
+	return (int) surfaceCreate (window);
 }
 
 
@@ -1492,6 +1462,8 @@ void windowShowWindowList (void){
 		
 		show_active_window();
         show_window_with_focus();
+		surfaceShowInfo ();
+		bmpCacheShowInfo ();
         SetFocus(hWindow);
 	
 		
@@ -1618,6 +1590,27 @@ int redraw_window (struct window_d *window, unsigned long flags ){
 	    goto done;
 	}	
 	
+	// Surface. (surface.h)
+	// A janela  pintada no seu surface e s a parte visvel 
+	//  copiada para o backbuffer.
+	
+	if ( (void *) window->surface != NULL && 
+	     (void *) draw_surface == NULL && 
+		 (void *) clip_region == NULL )
+	{
+		if ( surfacePaint (window) == 0 )
+		{
+			surfaceFlush (window);
+			
+			if ( flags == 1 ){
+				refresh_rectangle ( window->left, window->top, 
+				    window->width, window->height );
+			}
+			
+			goto done;
+		}
+	}
+	
 	//E se ela estiver travada ??
 	//O que significa travada?? no pode se mover??
 	// ?? travada pra quem ??
@@ -2167,12 +2160,295 @@ fail:
 }
 
 
+//
+// ## Regio visvel ##
+//
+
+/*
+ * window_bounds:
+ *     O retngulo que redraw_window pinta.
+ *     A sombra e a barra de ttulos vo at width +2 e height +2.
+ */
+
+static void window_bounds ( struct window_d *window, struct region_rect_d *r ){
+	
+	r->left = window->left;
+	r->top = window->top;
+	r->right = window->left + window->width +2;
+	r->bottom = window->top + window->height +2;
+}
+
+
+/*
+ * window_shown:
+ *     A janela est na zorder e aparece na tela.
+ */
+
+static int window_shown ( struct window_d *window ){
+	
+	if ( (void *) window == NULL ){
+		return 0;
+	}
+	
+	if ( window->used != 1 || window->magic != 1234 ){
+		return 0;
+	}
+	
+	if ( window->zIndex < 0 || window->zIndex >= ZORDER_COUNT_MAX ){
+		return 0;
+	}
+	
+	if ( zorderList[window->zIndex] != (unsigned long) window ){
+		return 0;
+	}
+	
+	if ( window->view == VIEW_NULL || window->view == VIEW_MINIMIZED ){
+		return 0;
+	}
+	
+	return 1;
+}
+
+
+/*
+ * window_opaque:
+ *     O retngulo que a janela cobre por inteiro.
+ *     Janelas sem background nem barra de ttulos no escondem 
+ * o que est atrs delas.
+ */
+
+static int window_opaque ( struct window_d *window, struct region_rect_d *r ){
+	
+	if ( window->backgroundUsed != 1 && window->titlebarUsed != 1 ){
+		return 0;
+	}
+	
+	r->left = window->left;
+	r->top = window->top;
+	r->right = window->left + window->width;
+	r->bottom = window->top + window->height;
+	
+	return 1;
+}
+
+
+/* Podemos pintar. */
+
+static int window_paint_ok (void){
+	
+	if ( VideoBlock.useGui != 1 ){
+		return 0;
+	}
+	
+	if ( (void *) CurrentColorScheme == NULL ){
+		return 0;
+	}
+	
+	if ( CurrentColorScheme->used != 1 || CurrentColorScheme->magic != 1234 ){
+		return 0;
+	}
+	
+	return 1;
+}
+
+
+/* 
+ * window_redraw_clipped:
+ *     redraw_window s dentro da regio. 
+ *     Com surface  s uma cpia, o dono s pinta quando o 
+ * surface ainda no tem a janela.
+ */
+
+static int window_redraw_clipped ( struct window_d *window, struct region_d *region ){
+	
+	int Status;
+	
+	if ( (void *) window->surface != NULL )
+	{
+		Status = 0;
+		
+		if ( window->surface->valid != 1 ){
+			Status = (int) surfacePaint (window);
+		}
+		
+		if ( Status == 0 )
+		{
+			window->surface->dirty = 0;
+			surfaceBlit ( window, region );
+			return 0;
+		}
+	}
+	
+	clip_region = region;
+	
+	Status = (int) redraw_window ( window, 0 );
+	
+	clip_region = NULL;
+	
+	return (int) Status;
+}
+
+
+/*
+ * windowVisibleRegion:
+ *     O retngulo da janela menos os retngulos das janelas que 
+ * esto acima dela na zorder.
+ *     Retorna o nmero de retngulos, 0 = a janela est escondida.
+ */
+
+int windowVisibleRegion ( struct window_d *window, struct region_d *region ){
+	
+	struct window_d *Above;
+	struct region_rect_d r;
+	int z;
+	
+	regionClear (region);
+	
+	if ( window_shown (window) == 0 ){
+		return 0;
+	}
+	
+	window_bounds ( window, &r );
+	
+	regionSetRect ( region, r.left, r.top, 
+	    r.right - r.left, r.bottom - r.top );
+	
+	for ( z = window->zIndex +1; z < ZORDER_COUNT_MAX; z++ )
+	{
+		if ( region->count == 0 ){
+			break;
+		}
+		
+		Above = (struct window_d *) zorderList[z];
+		
+		if ( window_shown (Above) == 0 ){
+			continue;
+		}
+		
+		if ( window_opaque ( Above, &r ) == 1 ){
+			regionSubtractRect ( region, &r );
+		}
+	};
+	
+	return (int) region->count;
+}
+
+
+/*
+ * windowInvalidateRegion:
+ *     Repinta uma rea da tela que foi exposta.
+ *     Cada janela pinta s a parte da sua regio visvel que est na 
+ * rea, e o que nenhuma janela cobre recebe a cor do desktop.
+ *     Marca o damage. Quem chama faz o refresh_screen.
+ */
+
+int windowInvalidateRegion ( struct region_d *exposed ){
+	
+	struct region_d Region;
+	struct region_d Desktop;
+	struct region_rect_d r;
+	struct window_d *zWindow;
+	int z;
+	
+	if ( (void *) exposed == NULL ){
+		return 1;
+	}
+	
+	if ( regionIsEmpty (exposed) == 1 || window_paint_ok () == 0 ){
+		return 0;
+	}
+	
+	// Desktop.
+	
+	Desktop = *exposed;
+	
+	for ( z=0; z < ZORDER_COUNT_MAX; z++ )
+	{
+		if ( Desktop.count == 0 ){
+			break;
+		}
+		
+		zWindow = (struct window_d *) zorderList[z];
+		
+		if ( window_shown (zWindow) == 1 && window_opaque ( zWindow, &r ) == 1 ){
+			regionSubtractRect ( &Desktop, &r );
+		}
+	};
+	
+	if ( Desktop.count != 0 )
+	{
+		clip_region = &Desktop;
+		
+		drawDataRectangle ( 0, 0, SavedX, SavedY, 
+		    CurrentColorScheme->elements[csiDesktop] );
+		
+		clip_region = NULL;
+	}
+	
+	// Janelas, de trs para frente.
+	
+	for ( z=0; z < ZORDER_COUNT_MAX; z++ )
+	{
+		zWindow = (struct window_d *) zorderList[z];
+		
+		if ( windowVisibleRegion ( zWindow, &Region ) == 0 ){
+			continue;
+		}
+		
+		regionIntersect ( &Region, exposed );
+		
+		if ( Region.count == 0 ){
+			continue;
+		}
+		
+		window_redraw_clipped ( zWindow, &Region );
+	};
+	
+	return 0;
+}
+
+
+int 
+windowInvalidateRect ( unsigned long left, 
+                       unsigned long top, 
+                       unsigned long width, 
+                       unsigned long height )
+{
+	struct region_d Region;
+	
+	regionSetRect ( &Region, left, top, width, height );
+	
+	return (int) windowInvalidateRegion ( &Region );
+}
+
+
+/* Repinta a parte visvel de uma janela. */
+
+static void window_repaint ( struct window_d *window ){
+	
+	struct region_d Region;
+	
+	if ( window_paint_ok () == 0 ){
+		return;
+	}
+	
+	if ( windowVisibleRegion ( window, &Region ) == 0 ){
+		return;
+	}
+	
+	window_redraw_clipped ( window, &Region );
+}
+
+
 /*
  ******************************
  * redraw_screen:
  *
  *     Repinta todas as janelas com base na zorder.
- *     @todo: 
+ *     Cada janela pinta s a sua regio visvel, ento cada pixel  
+ * pintado uma vez. (windowVisibleRegion)
+ *     A janela de cima recebe o foco antes, assim no precisamos 
+ * pint-la de novo.
  * Obs: Ao repintar cada janela a rotina redraw_window dever 
  * incluir todos os elementos da janela. 
  * Do mesmo jeito que o usurio modificou de acordo com suas preferncias.
@@ -2186,6 +2462,32 @@ int redraw_screen (void){
     int RedrawStatus;	
 	
 	struct window_d *zWindow;
+	struct region_d Region;
+	
+	// Todas as janelas sero pintadas de novo pelos donos.
+	
+	for ( z=0; z < ZORDER_COUNT_MAX; z++ )
+	{
+		zWindow = (void *) zorderList[z];
+		
+		if ( window_shown (zWindow) == 1 && (void *) zWindow->surface != NULL ){
+			zWindow->surface->valid = 0;
+		}
+	};
+	
+	// A janela de cima, com foco de entrada.
+	
+	for ( z = ZORDER_COUNT_MAX -1; z >= 0; z-- )
+	{
+		zWindow = (void *) zorderList[z];
+		
+		if ( window_shown (zWindow) == 1 )
+		{
+            set_active_window (zWindow);	
+            SetFocus (zWindow);
+			break;
+		}
+	};
 	
 	// Vamos procurar na lista por ponteiros vlidos.
 	// Repintaremos todas as janelas com ponteiros vlidos.
@@ -2206,46 +2508,26 @@ int redraw_screen (void){
 					goto fail;
 				};
 				
-				//retira o foco.
-				//KillFocus(zWindow);
+				// Escondida.
+				if ( windowVisibleRegion ( zWindow, &Region ) == 0 ){
+					continue;
+				}
 				
 				//Repinta uma janela.
-				RedrawStatus = (int) redraw_window (zWindow, 1);
+				RedrawStatus = (int) window_redraw_clipped ( zWindow, &Region );
 				
 				if (RedrawStatus == 1)
 				{	
 					printf ("redraw_screen: redraw error\n");
 					goto fail;
 				};
-				//Nothing.
 			};
-        //Nothing.			
 		};
-       //nothing.
 	};	
-
-	//#bugbug ?? Repintaremos duas vezes a ltima janela.
-    // Repintaremos novamente a ltima janela.
-    //Agora com foco de entrada.	
-
-    if ( (void *) zWindow != NULL )
-	{
-		if ( zWindow->used == 1 && zWindow->magic == 1234 )
-		{
-            set_active_window(zWindow);	
-            
-            SetFocus(zWindow);
-
-	        //Repinta uma janela.
-	        RedrawStatus = (int) redraw_window (zWindow, 1);
-			
-	        if (RedrawStatus == 1)
-	        {	
-		        printf ("redraw_screen: redraw error\n");
-		        goto fail;
-	        };
-		};
-	};
+	
+	// Um refresh para todas as janelas. (damage)
+	
+	refresh_screen ();
 	
 	// #obs
     // Se for terminar corretamente  porque repintamos tudo o que foi possvel.	
@@ -2273,6 +2555,10 @@ resize_window ( struct window_d *window,
                unsigned long cx, 
                unsigned long cy )
 {
+	struct region_rect_d Old;
+	struct region_rect_d New;
+	struct region_d Exposed;
+	int Shown;
  
 	if ( (void *) window == NULL )
 	{
@@ -2282,8 +2568,33 @@ resize_window ( struct window_d *window,
 	    
 		//@todo: Checar limites.
 	
+		Shown = window_shown (window);
+		window_bounds ( window, &Old );
+	
         window->width = (unsigned long) cx;
         window->height = (unsigned long) cy;	
+		
+		hitUpdate (window);
+		
+		// Um surface novo, do tamanho novo. O dono pinta de novo.
+		if ( (void *) window->surface != NULL )
+		{
+			surfaceDestroy (window);
+			windowCreateDedicatedBuffer (window);
+		}
+		
+		// Repinta s o que ficou exposto, e a janela.
+		if ( Shown == 1 )
+		{
+			window_bounds ( window, &New );
+			
+			regionSetRect ( &Exposed, Old.left, Old.top, 
+			    Old.right - Old.left, Old.bottom - Old.top );
+			regionSubtractRect ( &Exposed, &New );
+			
+			windowInvalidateRegion ( &Exposed );
+			window_repaint (window);
+		}
 	};
 
     return 0;
@@ -2303,6 +2614,11 @@ replace_window ( struct window_d *window,
 				 unsigned long x, 
 				 unsigned long y )
 {
+	struct region_rect_d Old;
+	struct region_rect_d New;
+	struct region_d Exposed;
+	int Shown;
+	
     if ( (void *) window == NULL ){
 		return 1;
 	
@@ -2310,8 +2626,27 @@ replace_window ( struct window_d *window,
 		
         //@todo: Checar limites.
 	
+		Shown = window_shown (window);
+		window_bounds ( window, &Old );
+	
         window->left = (unsigned long) x;
         window->top = (unsigned long) y;
+		
+		hitUpdate (window);
+		
+		// Repinta s o que ficou exposto no lugar antigo, 
+		// e a janela no lugar novo.
+		if ( Shown == 1 )
+		{
+			window_bounds ( window, &New );
+			
+			regionSetRect ( &Exposed, Old.left, Old.top, 
+			    Old.right - Old.left, Old.bottom - Old.top );
+			regionSubtractRect ( &Exposed, &New );
+			
+			windowInvalidateRegion ( &Exposed );
+			window_repaint (window);
+		}
 	};
 
     return 0;
@@ -2423,6 +2758,7 @@ int is_window_minimized (struct window_d *window){
  
 void CloseWindow ( struct window_d *window ){
 	
+	struct region_d Exposed;
 	int Offset;
 	int z;
 	
@@ -2441,6 +2777,9 @@ void CloseWindow ( struct window_d *window ){
 	
 		//...
 		
+		// O que estava visvel fica exposto quando ela sai.
+		windowVisibleRegion ( window, &Exposed );
+		
 	    // Focus.
 	    KillFocus(window);
 		
@@ -2462,10 +2801,14 @@ void CloseWindow ( struct window_d *window ){
 		
 		
 	    // devemos retirar a janela da zorder list 
+		// e do hit test do mouse.
+		
+		hitRemove (window);
 	
 	    z = (int) window->zIndex;
 	
-	    if ( z >= 0 && z < ZORDER_COUNT_MAX )
+	    if ( z >= 0 && z < ZORDER_COUNT_MAX && 
+		     zorderList[z] == (unsigned long) window )
 	    {
 	        zorderList[z] = (unsigned long) 0;	
 	    
@@ -2483,6 +2826,10 @@ void CloseWindow ( struct window_d *window ){
 		window->used = WINDOW_GC;       //216;
 	    window->magic = WINDOW_CLOSED;  //4321;		
 		
+		surfaceDestroy (window);
+		
+		windowInvalidateRegion ( &Exposed );
+		
 		//...
 	};
 	
@@ -3253,6 +3600,7 @@ fail:
  
 void MinimizeWindow (struct window_d *window){
 	
+	struct region_d Exposed;
 	int Status;
 	
     if( (void *) window == NULL )
@@ -3272,8 +3620,12 @@ void MinimizeWindow (struct window_d *window){
 			//goto fail; 
 	    };	
 		
+		windowVisibleRegion ( window, &Exposed );
+		
         KillFocus (window);
 	    window->view = (int) VIEW_MINIMIZED;		
+		
+		windowInvalidateRegion ( &Exposed );
 	};
 }
 
@@ -3313,6 +3665,8 @@ void MaximizeWindow (struct window_d *window){
 	    
 		window->width = gui->main->width;             
         window->height = gui->main->height;
+		
+		hitUpdate (window);
 	}; 	
 
 	// todo: 
@@ -3840,6 +4194,9 @@ int windowLoadGramadoIcons (void){
 		panic ("init_windows: CURSOR.BMP\n");
 	}
 
+	// O cursor de texto  um sprite. (sprite.h)
+	spriteLoadBMP ( SPRITE_TEXT_CURSOR, cursorIconBuffer, COLOR_WHITE );
+
 	// More ?
 
     return 0;
@@ -3868,100 +4225,18 @@ int windowLoadGramadoIcons (void){
  
 int windowScan ( unsigned long x, unsigned long y ){
 
-	struct window_d *w;
-	
-	//register int i;
-	int i = 0;
 	int WID;
 	
-	// #bugbug
-	// Vamos sondar toda a lista de janelas.
-	// pois pode haver fragmentao na lista de janelas.
-	// Ento mesmo com uma contagem baixa de janelas pode haver 
-	// janelas vlidas em posies altas.
-	// Ento vamos sondar por toda a lista.
-	
-	// #BUGBUG
-	// O problema nessa tcnica so as sobreposio de janelas.
-	// Quando uma janela est dentro da outr, ento duas janelas
-	// esto ptas a serem selecionadas.
-	// Talvez devamos filtrar e s aceitarmos sondar procurando 
-	// por controles.
-	
-	for ( i=0; i < WINDOW_COUNT_MAX; i++ )	
-	{
-		w = (struct window_d *) windowList[i];
-		
-		// se o ponteiro for vlido.
-		if ( (void *) w != NULL )
-		{
-			// validation
-			if ( w->used == 1 && w->magic == 1234 )
-			{
-				// #bugbug
-				// Precisamos considerar o deslocamento da janela me
-				// para sabermso seu posicionamaento em relao  tela.
-				
-				// Para o botao vamos considerar o deslocamento
-				// da janela mae.
-				// Dentro da rea da janela.
-				if ( w->type == WT_BUTTON || w->type == WT_EDITBOX )
-				{
-					if ( (void *) w->parent == NULL )
-					{
-						panic ("windowScan: parent\n");
-					}
-					
-				    if ( x > (w->parent->left + w->left)    && 
-					     x < (w->parent->left + w->left + w->width)  && 
-				         y > (w->parent->top + w->top)      &&
-				         y < (w->parent->top + w->top + w->height)  )			         
-					{
-						WID = w->id;
-					    window_mouse_over = w->id;    
-						return (int) WID;											
-					}
-				}
-				
-				
-				// Dentro da rea da janela.
-				/*
-				if ( x > w->left   && 
-					 x < w->right  && 
-				     y > w->top    &&
-				     y < w->bottom )
-				{
-					
-					// #todo
-					// Aqui precisamos de um tratamento diferenciado para cada um dos tipos.
-					// Vamos comear com os botes.
-					// Nesse momento cada um pode ter um compotamento diferente.
-					// Pega o ID.
-					
-					if ( w->type == WT_BUTTON )
-					{    
-						WID = w->id;
-					    window_mouse_over = w->id;    
-						return (int) WID;					
-					}
-					
-					if ( w->type == WT_EDITBOX )
-					{    
-						WID = w->id;
-					    window_mouse_over = w->id;    
-						return (int) WID;					
-					}	
-					
-					// ...	
-				}; 
-				*/
-				
-				
-			};		
-		};	
-	};
-
-    return (int) -1;
+	// O grid de hit.c. S as janelas sob o ponteiro so testadas, 
+	// do topo para baixo, e um controle coberto no  selecionado.
+	
+	WID = (int) hitTest ( x, y );
+	
+	if ( WID != -1 ){
+		window_mouse_over = WID;
+	}
+	
+	return (int) WID;
 }
 
 
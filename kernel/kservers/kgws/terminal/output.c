@@ -52,6 +52,47 @@ void kgws_terminal_putchar ( int c ){
 }
 
 
+// Máximo de bytes por chamada.
+#define TERMINAL_WRITE_MAX  4096
+
+
+/*
+ * kgws_terminal_write:
+ *     Coloca vários caracteres na tela do terminal.
+ *     Desenha todos no backbuffer e depois faz um refresh só,
+ * com um vsync só. (Os retângulos sujos vêm do draw_char.)
+ *     Usado pelo stdio da libc02, que manda um buffer inteiro
+ * por system call.
+ *     Retorna quantos caracteres foram escritos.
+ */
+
+int kgws_terminal_write ( const char *buffer, int len ){
+	
+	int i;
+	
+	if ( (void *) buffer == NULL || len <= 0 )
+		return 0;
+	
+	if ( len > TERMINAL_WRITE_MAX ){
+		len = TERMINAL_WRITE_MAX;
+	}
+	
+	// flag on.
+	stdio_terminalmode_flag = 1;
+	
+	for ( i=0; i < len; i++ ){
+		kgws_outbyte ( (int) buffer[i] );
+	};
+	
+	// flag off.
+	stdio_terminalmode_flag = 0;
+	
+	refresh_screen ();
+	
+	return (int) len;
+}
+
+
 void kgws_outbyte ( int c ){
 	
 	// cedge.c
@@ -59,6 +59,19 @@ int kernel_main (void){
 
     zorderCounter = 0;
 
+	// Hit test do mouse. (hit.h)
+    hitInit ();
+
+	// Trabalho adiado das irqs. (defer.h)
+    deferInit ();
+    spriteInit ();
+
+	// BMPs decodificados. (bmpcache.h)
+    bmpCacheInit ();
+
+	// Tabelas dos glyphs. (glyph.h)
+    glyphInit ();
+
 	//
 	// Set system window procedure.
 	//
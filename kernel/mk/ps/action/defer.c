@@ -0,0 +1,195 @@
+/*
+ * File: action/defer.c
+ *
+ *     Deferred work. (see defer.h)
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+// Work raised while we run is done in the same run, a few times.
+#define DEFER_ROUNDS_MAX  4
+
+
+static struct defer_d defer_list[DEFER_MAX];
+
+// Register.
+static spinlock_t defer_spinlock;
+
+// Only one runner.
+static spinlock_t defer_run_lock;
+
+
+void deferInit (void){
+
+	int i;
+
+	for ( i=0; i < DEFER_MAX; i++ )
+	{
+		defer_list[i].used = 0;
+		defer_list[i].magic = 0;
+		defer_list[i].name = NULL;
+		defer_list[i].handler = NULL;
+		defer_list[i].raised = 0;
+		defer_list[i].runs = 0;
+	};
+
+	spinLockInit (&defer_spinlock);
+	spinLockInit (&defer_run_lock);
+
+	defer_pending = 0;
+	defer_idle_runs = 0;
+	defer_tick_runs = 0;
+}
+
+
+int deferRegister ( char *name, void (*handler) (void) ){
+
+	struct defer_d *d;
+	unsigned long Flags;
+	int ID = -1;
+	int i;
+
+	if ( (void *) handler == NULL ){
+		return (int) -1;
+	}
+
+	Flags = spinLockIrqSave (&defer_spinlock);
+
+	for ( i=0; i < DEFER_MAX; i++ )
+	{
+		d = &defer_list[i];
+
+		if ( d->used == 1 ){
+			continue;
+		}
+
+		d->name = name;
+		d->handler = handler;
+		d->raised = 0;
+		d->runs = 0;
+
+		d->used = 1;
+		d->magic = 1234;
+
+		ID = i;
+		break;
+	};
+
+	spinUnlockIrqRestore ( &defer_spinlock, Flags );
+
+	return (int) ID;
+}
+
+
+/*
+ * deferRaise:
+ *     Called by the irq handlers. Only sets the bit.
+ */
+
+void deferRaise ( int id ){
+
+	if ( id < 0 || id >= DEFER_MAX ){
+		return;
+	}
+
+	defer_list[id].raised++;
+
+	__asm__ __volatile__ ( "lock; orl %1, %0"
+	    : "+m" (defer_pending) : "r" (1UL << id) : "memory" );
+}
+
+
+int deferIsPending (void){
+
+	return (int) ( defer_pending != 0 );
+}
+
+
+/*
+ * deferRun:
+ *     Takes all the pending bits at once, and calls the handlers.
+ *     If another cpu, or an interrupted run, has the work, we go back.
+ */
+
+void deferRun ( int idle ){
+
+	struct defer_d *d;
+	unsigned long Pending;
+	int Round;
+	int i;
+
+	if ( defer_pending == 0 ){
+		return;
+	}
+
+	if ( spinTryLock (&defer_run_lock) == 0 ){
+		return;
+	}
+
+	if ( idle == 1 ){
+		defer_idle_runs++;
+	}else{
+		defer_tick_runs++;
+	};
+
+	for ( Round=0; Round < DEFER_ROUNDS_MAX; Round++ )
+	{
+		Pending = 0;
+
+		__asm__ __volatile__ ( "xchgl %0, %1"
+		    : "+r" (Pending), "+m" (defer_pending) : : "memory" );
+
+		if ( Pending == 0 ){
+			break;
+		}
+
+		for ( i=0; i < DEFER_MAX; i++ )
+		{
+			if ( ( Pending & (1UL << i) ) == 0 ){
+				continue;
+			}
+
+			d = &defer_list[i];
+
+			if ( d->used == 1 && d->magic == 1234 )
+			{
+				d->runs++;
+				d->handler ();
+			}
+		};
+	};
+
+	spinUnlock (&defer_run_lock);
+}
+
+
+void deferShowInfo (void){
+
+	struct defer_d *d;
+	int i;
+
+	printf ("defer: idle runs={%d} tick runs={%d}\n",
+	    defer_idle_runs, defer_tick_runs );
+
+	for ( i=0; i < DEFER_MAX; i++ )
+	{
+		d = &defer_list[i];
+
+		if ( d->used == 1 && d->magic == 1234 )
+		{
+			printf ("%d: %s raised={%d} runs={%d}\n",
+			    i, d->name, d->raised, d->runs );
+		}
+	};
+}
+
+
+//
+// End.
+//
+
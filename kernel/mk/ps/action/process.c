@@ -358,6 +358,7 @@ do_clone:
 		Current->control->quantum = 100;		
 		//block_for_a_reason ( Current->control->tid, WAIT_REASON_BLOCKED );	
 		Current->control->state = READY;
+		readyq_insert (Current->control);
 
 			
 		// [filho]
@@ -759,6 +760,7 @@ os processo anteriores deram certo pois os endere
 		Current->control->quantum = 100;		
 		//Current->control->saved = 0;
 		Current->control->state = READY;
+		readyq_insert (Current->control);
         //SelectForExecution (Current->control);
 			
 		// [filho]
@@ -821,6 +823,11 @@ pid_t do_fork_process (void){
 	unsigned long *dir;
 	unsigned long old_dir_entry1; 
 	
+	// Latncia do fork. (TSC)
+	unsigned long ForkStart;
+	
+	ForkStart = (unsigned long) cowTimestamp ();
+	
  
 	//unsigned long old_image_pa; //usado para salvamento.
 	
@@ -913,9 +920,12 @@ do_clone:
 		// ## clone  ##
 		//
 		
-		// Copia a memria usada pela imagem do processo.
+		// #importante
+		// A imagem no  mais copiada aqui. (copy-on-write)
+		// O filho usa os frames do pai e s as pginas escritas 
+		// so copiadas, na hora da escrita. (#PF) (cow.c)
 		
-		processCopyMemory ( Current );	
+		//processCopyMemory ( Current );	
 		
 		//
 		// Debug messages.
@@ -950,8 +960,18 @@ do_clone:
 		    //goto fail;	
 	    }
 		
-        CreatePageTable ( (unsigned long) Clone->DirectoryVA, ENTRY_USERMODE_PAGES, 
-		    Current->childImage_PA );		
+        //CreatePageTable ( (unsigned long) Clone->DirectoryVA, ENTRY_USERMODE_PAGES, 
+		//    Current->childImage_PA );		
+		
+		// A page table da imagem do filho aponta para os frames do pai.
+		
+		Ret = cowSharePageTable ( (unsigned long) Current->DirectoryVA, 
+		          (unsigned long) Clone->DirectoryVA, ENTRY_USERMODE_PAGES );
+		
+	    if ( Ret != 0 )
+	    {
+		    panic ("do_fork_process: cowSharePageTable fail\n");
+	    }
 		
 		
 		//#test
@@ -1082,7 +1102,8 @@ os processo anteriores deram certo pois os endere
 		
 		//#test - Clonando manualmente a thread de controle.
 		//s a imagem ... falta a pilha.
-		memcpy ( (void *) Clone->Image, (const void *) Current->Image, ( 0x50000 ) ); 
+		// #obs: Com copy-on-write o filho j v a imagem do pai.
+		//memcpy ( (void *) Clone->Image, (const void *) Current->Image, ( 0x50000 ) ); 
 		//====
 		Clone->control->type  = Current->control->type; 
 		Clone->control->plane = Current->control->plane;
@@ -1157,6 +1178,7 @@ os processo anteriores deram certo pois os endere
 		Current->control->quantum = 100;		
 		//Current->control->saved = 0;
 		Current->control->state = READY;
+		readyq_insert (Current->control);
         //SelectForExecution (Current->control);
 			
 		// [filho]
@@ -1175,6 +1197,9 @@ os processo anteriores deram certo pois os endere
 		//pai
 		current_thread = Current->control->tid;	
 		current_process = Current->pid;
+		
+		cowForkDone (ForkStart);
+		
         return (pid_t) Clone->pid;
 		
 		//filho
@@ -1203,7 +1228,7 @@ struct process_d *processObject (void){
 	
 	struct process_d *p;
 	
-	p = (void *) malloc ( sizeof(struct process_d) );
+	p = (void *) slabAllocate (process_cache);
 	
 	if ( (void *) p == NULL )
 	{
@@ -1562,6 +1587,16 @@ int processCopyProcess ( pid_t p1, pid_t p2 ){
 	Process2->childImage = 0;
 	Process2->childImage_PA = 0;
 	
+	// Copy-on-write. O filho usa a mesma imagem do pai.
+	if ( Process2->Image == 0 ){
+		Process2->Image = Process1->Image;
+		Process2->ImagePA = Process1->ImagePA;
+	}
+	
+	// As pginas sob demanda do pai tambm so do filho. (elf.c)
+	Process2->elf_image = Process1->elf_image;
+	elfImageGet ( Process2->elf_image );
+	
     //heap
 	Process2->Heap = Process1->Heap;    
 	Process2->HeapEnd = Process1->HeapEnd; 
@@ -1738,7 +1773,7 @@ struct process_d *create_process ( struct room_d *room,
 	
 	PID = (int) processNewPID;
 	
-	Process = (void *) malloc ( sizeof(struct process_d) );
+	Process = (void *) slabAllocate (process_cache);
 	
 	if ( (void *) Process == NULL )
 	{
@@ -1966,6 +2001,7 @@ get_next:
 		
 		//#todo: estrutura com informaes sobre a imagem do processo.
 		Process->image_info = NULL;
+		Process->elf_image = NULL;
 		
 		// Heap e Stack:
 		//
@@ -2785,6 +2821,20 @@ void exit_process ( pid_t pid, int code ){
 		
 		Process->exit_code = (int) code;    
 		Process->state = PROCESS_TERMINATED; 
+		
+		// Os frames privados da imagem, antes do put. (elf.c)
+		elfReleasePages (Process);
+		
+		// A imagem fica no cache do loader, sem esse usurio.
+		elfImagePut ( Process->elf_image );
+		Process->elf_image = NULL;
+		
+		// Os frames compartilhados pelo fork. (cow.c)
+		cowReleasePageTable ( (unsigned long) Process->DirectoryVA, 
+		    ENTRY_USERMODE_PAGES );
+		
+		// Os semforos e mutexes que ele criou. (sem.c)
+		semExitProcess ( (int) pid );
 		//...
 	};
 		
@@ -410,7 +410,7 @@ struct thread_d *create_thread ( struct room_d *room,
 	//Alocando memria para a estrutura da thread.
 	//Obs: Estamos alocando memria dentro do heap do kernel.
 	
-	Thread = (void *) malloc ( sizeof(struct thread_d) );	
+	Thread = (void *) slabAllocate (thread_cache);	
 	
 	if ( (void *) Thread == NULL )
 	{
@@ -662,6 +662,16 @@ get_next:
 		//Prxima thread da lista.
 		Thread->Next = NULL;
 		
+		//Not in a ready queue yet.
+		Thread->rq_next = NULL;
+		Thread->rq_prev = NULL;
+		Thread->rq_queued = 0;
+		
+		// Fila de mensagens vazia.
+		msgqInit (Thread);
+		semInitThread (Thread);
+		timerInitThread (Thread);
+		
 		//Coloca na lista.
 		threadList[i] = (unsigned long) Thread;	
 	};
@@ -945,7 +955,6 @@ int init_threads (void){
 
 int thread_getchar (void){
 	
-	unsigned char SC;
 	int save;
 	
 	// #bugbug
@@ -956,6 +965,8 @@ int thread_getchar (void){
 	
 	struct thread_d *t;
 	
+	struct thread_msg_d m;
+	
 	//
 	// Bloqueia pra que nenhum aplicativo pegue mensagens 
 	// na estrutura de janela at que window_getch termine.
@@ -966,11 +977,10 @@ int thread_getchar (void){
 	//pega o char em current_stdin.
 	//isso est em kdrivers/x/i8042/keyboard.c
 	
-	SC = (unsigned char) get_scancode ();
-	
-	// Isso coloca a mensagem na thread de controle da janela com o foco de entrada.
+	// Isso coloca as mensagens na thread de controle da janela com o foco de entrada.
+	// ipc/msgq.c
 	
-	KEYBOARD_SEND_MESSAGE ( SC );	
+	msgqPumpKeyboard ();
 	
 	
 	// #importante
@@ -1010,29 +1020,21 @@ int thread_getchar (void){
 	     goto fail;
 	}	
 	
-	if ( t->newmessageFlag != 1 )
-	{
-	    goto fail;
-	}
+	// #importante:
+	// As mensagens que no so de tecla pressionada so consumidas
+	// aqui tambm, quem usa getchar no espera por elas.
 	
-	if ( t->msg != MSG_KEYDOWN )
-	{
-	    goto fail;	
-	}	
+	do {
+		
+	    if ( msgqGet ( t, &m ) != 1 )
+	    {
+	        goto fail;
+	    }
+	
+	} while ( m.msg != MSG_KEYDOWN );
 	
 	//salva s o char.
-	save = (int) t->long1;
-		
-	// #importante:
-	// >Limpa.
-	// >Sinaliza que a mensagem foi consumida, e que no 
-	// temos nova mensagem.
-	
-	t->window = 0;
-	t->msg = 0;
-	t->long1 = 0;
-	t->long2 = 0;
-	t->newmessageFlag = 0;
+	save = (int) m.long1;
 	
 	//===============
 	// Retorna o char.
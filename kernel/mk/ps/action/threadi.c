@@ -77,6 +77,28 @@ Loop:
 	
 	dead_thread_collector_flag = 0;
 	
+	// Trabalho adiado das irqs. (defer.c)
+	// Com as interrupes habilitadas, mas sem troca de tarefa no meio.
+	
+	if ( deferIsPending () == 1 )
+	{
+		taskswitch_lock ();
+		deferRun (1);
+		taskswitch_unlock ();
+	}
+	
+	// Tickless. 
+	// Se s ns podemos rodar, a cpu dorme at o prximo timer 
+	// sem as irq0 no meio. (kdrivers/timer.c)
+	
+	asm ("cli");
+	if ( timerTicklessIdle () == 1 )
+	{
+		asm ("sti");
+		goto Loop;
+	}
+	asm ("sti");
+	
 	asm ("hlt");
     goto Loop;
 	
@@ -109,7 +131,7 @@ void *KiCreateRing0Idle (void){
 
     //Thread.
 	//Alocando memria para a estrutura da thread.
-	t = (void *) malloc( sizeof(struct thread_d) );	
+	t = (void *) slabAllocate (thread_cache);	
 	
 	if ( (void *) t == NULL )
 	{
@@ -264,6 +286,15 @@ void *KiCreateRing0Idle (void){
 	
 	t->Next = NULL;
 	
+	t->rq_next = NULL;
+	t->rq_prev = NULL;
+	t->rq_queued = 0;
+	
+	// Fila de mensagens vazia.
+	msgqInit (t);
+	semInitThread (t);
+	timerInitThread (t);
+	
 	//
 	// Running tasks.
 	//
@@ -730,6 +761,11 @@ void set_thread_priority ( struct thread_d *t, unsigned long priority ){
 		//Muda a prioridade.
         t->priority = priority;
 		
+		// If it is queued, move it to the queue of the new priority.
+		if ( t->rq_queued == 1 ){
+			readyq_requeue (t);
+		}
+		
 		/*
 		switch(t->state) 
 		{
@@ -874,6 +910,7 @@ void release ( int tid ){
 		//executar.
 		
 		Thread->state = READY; 
+		readyq_insert (Thread);
 	};	
 }
 
@@ -919,6 +956,9 @@ void exit_thread (int tid){
 		//deadthread collector vai destruir a estrutura.
 		
 		Thread->state = ZOMBIE; 
+		readyq_remove (Thread);
+		timerCancelSleep (Thread);
+		semExitThread (Thread);
 	};
 		
 	
@@ -989,6 +1029,9 @@ void kill_thread (int tid){
         Thread->used = 0;
         Thread->magic = 0; 		
 		Thread->state = DEAD; 
+		readyq_remove (Thread);
+		timerCancelSleep (Thread);
+		semExitThread (Thread);
 		//...
 		
 		ProcessorBlock.threads_counter--;
@@ -1053,6 +1096,8 @@ void dead_thread_collector (void){
 				Thread->used = 0;
 				Thread->magic = 0;
 				Thread->state = DEAD; // Por enquanto apenas fecha.
+				readyq_remove (Thread);
+				timerCancelSleep (Thread);
 				//...
 			    
 				// #importante:
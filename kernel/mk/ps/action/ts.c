@@ -22,6 +22,9 @@
 //
   
 int lock_taskswitch;  
+
+// Pedido de troca de thread no retorno da syscall. (sw.asm)
+int taskswitch_yield_request;
 //int __taskswitch_lock;
 //...
 
@@ -255,6 +258,9 @@ void task_switch (void){
 				// MOVEMENT 3 (running >> ready)  
 				
 				Current->state = READY;    
+				
+				// Round robin: back to the tail of its ready queue.
+				readyq_requeue (Current);
 
 				if ( Current->preempted == PREEMPTABLE )
 				{
@@ -749,6 +755,19 @@ void taskswitch_unlock (void){
 }
 
 
+/*
+ * taskswitch_yield:
+ *     A thread atual bloqueou dentro da syscall.
+ *     O retorno da int 0x80 (sw.asm) no volta para ela, salva o 
+ * contexto e troca de thread como o irq0, sem esperar o prximo tick.
+ */
+
+void taskswitch_yield (void){
+	
+	taskswitch_yield_request = 1;
+}
+
+
 //
 // End.
 //
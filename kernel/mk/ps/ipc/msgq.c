@@ -0,0 +1,456 @@
+/*
+ * File: ps/ipc/msgq.c
+ *
+ *     Fila de mensagens das threads.
+ *
+ *     Each thread has a ring buffer of THREAD_MSG_QUEUE_SIZE messages.
+ * The producers (keyboard, mouse, timer, pty, window server) write at
+ * msg_tail and the thread reads at msg_head. The counters only grow,
+ * the slot is the counter masked by the size of the queue.
+ *
+ *     The producers can run in the interrupt handlers, so they post with
+ * the interrupts disabled. The consumer is always the thread itself,
+ * it only moves msg_head, after the message was copied.
+ *
+ *     A thread with nothing to do calls msgqWait(). It is blocked for
+ * the reason WAIT_REASON_LOOP, leaves the processor on the return of the
+ * syscall and the next post makes it ready again.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+// Mascara para o indice dentro da fila.
+#define MSGQ_MASK  (THREAD_MSG_QUEUE_SIZE -1)
+
+
+static spinlock_t msgq_spinlock;
+
+
+static unsigned long msgq_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &msgq_spinlock );
+}
+
+
+static void msgq_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &msgq_spinlock, flags );
+}
+
+
+/* A thread valida. */
+
+static int msgq_valid ( struct thread_d *t ){
+
+	if ( (void *) t == NULL ){
+		return (int) 0;
+	}
+
+	if ( t->used != 1 || t->magic != 1234 ){
+		return (int) 0;
+	}
+
+	return (int) 1;
+}
+
+
+/*
+ * msgq_wakeup:
+ *     A thread estava dormindo esperando mensagem.
+ *     Chamado com as interrupcoes desabilitadas.
+ */
+
+static void msgq_wakeup ( struct thread_d *t ){
+
+	if ( t->msg_waiting != 1 ){
+		return;
+	}
+
+	t->msg_waiting = 0;
+	t->wait_reason[WAIT_REASON_LOOP] = 0;
+
+	if ( t->state == BLOCKED )
+	{
+		do_thread_ready (t->tid);
+		msgqWakeups++;
+	}
+}
+
+
+/*
+ * msgqInit:
+ *     Fila vazia. Chamado na criacao da thread.
+ */
+
+void msgqInit ( struct thread_d *t ){
+
+	if ( (void *) t == NULL ){
+		return;
+	}
+
+	t->window = NULL;
+	t->msg = 0;
+	t->long1 = 0;
+	t->long2 = 0;
+
+	t->msg_head = 0;
+	t->msg_tail = 0;
+	t->msg_dropped = 0;
+	t->msg_waiting = 0;
+}
+
+
+/*
+ ***********************************************
+ * msgqPost:
+ *     Coloca uma mensagem no fim da fila da thread.
+ *     Mensagens MSG_MOUSEMOVE seguidas sao juntadas na ultima,
+ * o aplicativo so precisa da posicao mais nova.
+ *     Retorna 0 se a mensagem foi colocada na fila.
+ */
+
+int msgqPost ( struct thread_d *t, struct thread_msg_d *m ){
+
+	struct thread_msg_d *Last;
+	unsigned long Flags;
+
+	if ( msgq_valid (t) == 0 || (void *) m == NULL ){
+		return (int) -1;
+	}
+
+	Flags = msgq_lock ();
+
+	// Coalesce.
+	// A mensagem mais nova ainda nao foi pega se tiver outra antes dela.
+	if ( m->msg == MSG_MOUSEMOVE && (t->msg_tail - t->msg_head) >= 2 )
+	{
+		Last = &t->msg_queue[ (t->msg_tail -1) & MSGQ_MASK ];
+
+		if ( Last->msg == MSG_MOUSEMOVE && Last->window == m->window )
+		{
+			*Last = *m;
+			msgqCoalesced++;
+
+			msgq_unlock (Flags);
+			return (int) 0;
+		}
+	}
+
+	// Cheia.
+	if ( (t->msg_tail - t->msg_head) >= THREAD_MSG_QUEUE_SIZE )
+	{
+		t->msg_dropped++;
+		msgqDropped++;
+
+		msgq_wakeup (t);
+
+		msgq_unlock (Flags);
+		return (int) 1;
+	}
+
+	t->msg_queue[ t->msg_tail & MSGQ_MASK ] = *m;
+	t->msg_tail++;
+
+	msgqPosted++;
+
+	msgq_wakeup (t);
+
+	msgq_unlock (Flags);
+
+	return (int) 0;
+}
+
+
+/*
+ * msgqPostMessage:
+ *     Mensagem padrao. (window, msg, long1, long2)
+ */
+
+int
+msgqPostMessage ( struct thread_d *t,
+                  struct window_d *window,
+                  int msg,
+                  unsigned long long1,
+                  unsigned long long2 )
+{
+	struct thread_msg_d m;
+
+	m.window = window;
+	m.msg = msg;
+	m.long1 = long1;
+	m.long2 = long2;
+	m.long3 = 0;
+	m.long4 = 0;
+	m.long5 = 0;
+	m.long6 = 0;
+
+	return (int) msgqPost ( t, &m );
+}
+
+
+/* Quantas mensagens estao na fila. */
+
+int msgqCount ( struct thread_d *t ){
+
+	if ( msgq_valid (t) == 0 ){
+		return (int) 0;
+	}
+
+	return (int) (t->msg_tail - t->msg_head);
+}
+
+
+/*
+ * msgqPeek:
+ *     Copia a primeira mensagem sem tirar da fila.
+ *     Retorna 1 se tem mensagem.
+ */
+
+int msgqPeek ( struct thread_d *t, struct thread_msg_d *m ){
+
+	if ( msgq_valid (t) == 0 || (void *) m == NULL ){
+		return (int) 0;
+	}
+
+	if ( t->msg_head == t->msg_tail ){
+		return (int) 0;
+	}
+
+	*m = t->msg_queue[ t->msg_head & MSGQ_MASK ];
+
+	return (int) 1;
+}
+
+
+/*
+ ***********************************************
+ * msgqGet:
+ *     Tira a primeira mensagem da fila.
+ *     Ela tambem fica nos campos window, msg, long1 ... da thread,
+ * para as rotinas que ainda leem a mensagem por la.
+ *     Retorna 1 se tem mensagem.
+ */
+
+int msgqGet ( struct thread_d *t, struct thread_msg_d *m ){
+
+	struct thread_msg_d *Slot;
+
+	if ( msgq_valid (t) == 0 ){
+		return (int) 0;
+	}
+
+	if ( t->msg_head == t->msg_tail ){
+		return (int) 0;
+	}
+
+	Slot = &t->msg_queue[ t->msg_head & MSGQ_MASK ];
+
+	t->window = Slot->window;
+	t->msg = Slot->msg;
+	t->long1 = Slot->long1;
+	t->long2 = Slot->long2;
+	t->long3 = Slot->long3;
+	t->long4 = Slot->long4;
+	t->long5 = Slot->long5;
+	t->long6 = Slot->long6;
+
+	if ( (void *) m != NULL ){
+		*m = *Slot;
+	}
+
+	// O slot esta livre so depois da copia.
+	__asm__ __volatile__ ( "" : : : "memory" );
+	t->msg_head++;
+
+	return (int) 1;
+}
+
+
+/*
+ ***********************************************
+ * msgqGetMany:
+ *     Tira ate 'max' mensagens da fila e coloca no buffer,
+ * MSGQ_MESSAGE_WORDS longs por mensagem.
+ *     Retorna quantas mensagens foram copiadas.
+ */
+
+int
+msgqGetMany ( struct thread_d *t,
+              unsigned long *buffer,
+              int max )
+{
+	struct thread_msg_d m;
+	int Count = 0;
+
+	if ( msgq_valid (t) == 0 || (void *) buffer == NULL ){
+		return (int) 0;
+	}
+
+	while ( Count < max )
+	{
+		if ( msgqGet ( t, &m ) != 1 ){
+			break;
+		}
+
+		buffer[0] = (unsigned long) m.window;
+		buffer[1] = (unsigned long) m.msg;
+		buffer[2] = (unsigned long) m.long1;
+		buffer[3] = (unsigned long) m.long2;
+		buffer[4] = (unsigned long) m.long3;
+		buffer[5] = (unsigned long) m.long4;
+		buffer[6] = (unsigned long) m.long5;
+		buffer[7] = (unsigned long) m.long6;
+
+		buffer = buffer + MSGQ_MESSAGE_WORDS;
+		Count++;
+	};
+
+	return (int) Count;
+}
+
+
+/*
+ ***********************************************
+ * msgqPumpKeyboard:
+ *     Transforma os scancodes do buffer de teclado em mensagens
+ * para a thread da janela com o foco de entrada.
+ *     O prefixo (0xE0 e 0xE1) fica em ke0 para o proximo scancode.
+ *     Retorna quantas mensagens foram enviadas.
+ */
+
+int msgqPumpKeyboard (void){
+
+	unsigned char SC;
+	int Count = 0;
+
+	while (1)
+	{
+		SC = (unsigned char) get_scancode ();
+
+		if ( SC == 0 ){
+			break;
+		}
+
+		// Teclas do teclado extendido.
+
+		if ( SC == 0xE0 ){
+			ke0 = 1;
+			continue;
+		}
+
+		if ( SC == 0xE1 ){
+			ke0 = 2;
+			continue;
+		}
+
+		KEYBOARD_SEND_MESSAGE (SC);
+
+		ke0 = 0;
+		Count++;
+	};
+
+	return (int) Count;
+}
+
+
+/*
+ ***********************************************
+ * msgqWait:
+ *     A thread nao tem mensagem e vai dormir ate chegar alguma.
+ *     A thread e' bloqueada e o retorno da int 0x80 ja troca de thread,
+ * (taskswitch_yield) ela so volta a rodar quando alguem postar.
+ *     Retorna 1 se ja tem mensagem, 0 se a thread foi bloqueada.
+ */
+
+int msgqWait ( struct thread_d *t ){
+
+	unsigned long Flags;
+
+	if ( msgq_valid (t) == 0 ){
+		return (int) 1;
+	}
+
+	msgqPumpKeyboard ();
+
+	Flags = msgq_lock ();
+
+	if ( t->msg_head != t->msg_tail ||
+	     keybuffer_head != keybuffer_tail )
+	{
+		msgq_unlock (Flags);
+		return (int) 1;
+	}
+
+	t->msg_waiting = 1;
+
+	block_for_a_reason ( t->tid, WAIT_REASON_LOOP );
+
+	t->runningCount = t->quantum;
+
+	msgq_unlock (Flags);
+
+	// Nao volta para o loop do aplicativo. (ts.c)
+	taskswitch_yield ();
+
+	return (int) 0;
+}
+
+
+/*
+ * msgqWakeupFocus:
+ *     Chegou input de teclado.
+ *     Acorda a thread da janela com o foco de entrada, se ela estiver
+ * esperando. Chamado pelo handler de teclado.
+ */
+
+void msgqWakeupFocus (void){
+
+	struct window_d *w;
+	struct thread_d *t;
+
+	if ( window_with_focus < 0 || window_with_focus >= WINDOW_COUNT_MAX ){
+		return;
+	}
+
+	w = (struct window_d *) windowList[window_with_focus];
+
+	if ( (void *) w == NULL ){
+		return;
+	}
+
+	if ( w->used != 1 || w->magic != 1234 ){
+		return;
+	}
+
+	t = (struct thread_d *) w->control;
+
+	if ( msgq_valid (t) == 0 ){
+		return;
+	}
+
+	msgq_wakeup (t);
+}
+
+
+/*
+ * msgqShowInfo:
+ *     Mostra os contadores.
+ */
+
+void msgqShowInfo (void){
+
+	printf ("\n[Message queues:]\n");
+	printf ("posted={%d} dropped={%d} coalesced={%d} wakeups={%d}\n",
+	    msgqPosted, msgqDropped, msgqCoalesced, msgqWakeups );
+}
+
+
+//
+// End.
+//
+
@@ -11,15 +11,369 @@
  * tem que ter em mo um ponteiro para uma estrutura vlida. Ento atravs de
  * de uma system call ele consegue utilizar os mtodos down e up. 
  *
+ *     Os semforos do kernel tm uma fila de espera. Quando o recurso 
+ * no est livre a thread entra na fila e  bloqueada, (WAIT_REASON_SEMAPHORE)
+ * e no fica gastando o quantum num loop. O Up entrega o recurso 
+ * direto para a primeira thread da fila e acorda s ela.
+ *     A syscall no dorme dentro do kernel. Down retorna 1, mas o retorno
+ * da int 0x80 j troca de thread, (taskswitch_yield) e ela s volta a 
+ * rodar quando o Up acordar ela. Ento chama de novo e j  a dona do 
+ * recurso.
+ *     O handle s vale no processo que criou o semforo. Quando a thread 
+ * morre ela sai da fila e os mutexes dela so liberados. Quando o processo
+ * morre os semforos dele so destrudos.
+ *
  * History:
  *      2015 - Created by Fred Nora.
  *      2016 - Revision.
+ *      2019 - Wait queues.
  */		
  
 
 #include <kernel.h>
 
 
+// Os semforos das syscalls.
+static struct semaphore_d sem_table[SEMAPHORE_COUNT_MAX];
+
+
+// A tabela de semforos  compartilhada pelas cpus. (smp.h)
+static spinlock_t sem_spinlock;
+
+
+static unsigned long sem_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &sem_spinlock );
+}
+
+
+static void sem_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &sem_spinlock, flags );
+}
+
+
+/* Um semforo do kernel, com fila. */
+
+static int sem_valid ( struct semaphore_d *s ){
+
+	if ( (void *) s == NULL ){
+		return (int) 0;
+	}
+
+	if ( s->used != 1 || s->magic != 1234 ){
+		return (int) 0;
+	}
+
+	return (int) 1;
+}
+
+
+static int sem_thread_valid ( struct thread_d *t ){
+
+	if ( (void *) t == NULL ){
+		return (int) 0;
+	}
+
+	if ( t->used != 1 || t->magic != 1234 ){
+		return (int) 0;
+	}
+
+	return (int) 1;
+}
+
+
+static struct thread_d *sem_current_thread (void){
+
+	struct thread_d *t;
+
+	if ( current_thread < 0 || current_thread >= THREAD_COUNT_MAX ){
+		return NULL;
+	}
+
+	t = (struct thread_d *) threadList[current_thread];
+
+	if ( sem_thread_valid (t) == 0 ){
+		return NULL;
+	}
+
+	return (struct thread_d *) t;
+}
+
+
+static void sem_enqueue ( struct semaphore_d *s, struct thread_d *t ){
+
+	t->sem_next = NULL;
+
+	if ( (void *) s->wait_tail == NULL ){
+		s->wait_head = t;
+	}else{
+		s->wait_tail->sem_next = t;
+	};
+
+	s->wait_tail = t;
+	s->waiters++;
+
+	if ( s->waiters > s->max_waiters ){
+		s->max_waiters = s->waiters;
+	}
+}
+
+
+/*
+ * sem_dequeue:
+ *     Tira a primeira thread da fila.
+ *     As threads que morreram ou saram da fila so puladas.
+ */
+
+static struct thread_d *sem_dequeue ( struct semaphore_d *s ){
+
+	struct thread_d *t;
+
+	while ( (void *) s->wait_head != NULL )
+	{
+		t = s->wait_head;
+
+		s->wait_head = t->sem_next;
+
+		if ( (void *) s->wait_head == NULL ){
+			s->wait_tail = NULL;
+		}
+
+		s->waiters--;
+		t->sem_next = NULL;
+
+		if ( sem_thread_valid (t) == 1 && t->sem_wait == s ){
+			return (struct thread_d *) t;
+		}
+	};
+
+	return NULL;
+}
+
+
+/* Tira uma thread do meio da fila. */
+
+static void sem_unqueue ( struct semaphore_d *s, struct thread_d *t ){
+
+	struct thread_d *p;
+	struct thread_d *Prev = NULL;
+
+	for ( p = s->wait_head; (void *) p != NULL; p = p->sem_next )
+	{
+		if ( p == t )
+		{
+			if ( (void *) Prev == NULL ){
+				s->wait_head = t->sem_next;
+			}else{
+				Prev->sem_next = t->sem_next;
+			};
+
+			if ( s->wait_tail == t ){
+				s->wait_tail = Prev;
+			}
+
+			s->waiters--;
+			t->sem_next = NULL;
+			return;
+		}
+
+		Prev = p;
+	};
+}
+
+
+/* A thread pega o recurso. */
+
+static void sem_acquired ( struct semaphore_d *s, struct thread_d *t ){
+
+	s->acquires++;
+
+	if ( s->type == SEMAPHORE_TYPE_MUTEX )
+	{
+		if ( (void *) t != NULL ){
+			s->owner = t->tid;
+		}else{
+			s->owner = -1;
+		};
+	}
+}
+
+
+/*
+ * sem_block:
+ *     Bloqueia a thread na fila do semforo e termina o quantum.
+ */
+
+static void sem_block ( struct thread_d *t ){
+
+	block_for_a_reason ( t->tid, WAIT_REASON_SEMAPHORE );
+
+	t->runningCount = t->quantum;
+
+	// No volta para o loop do aplicativo. (ts.c)
+	taskswitch_yield ();
+}
+
+
+/*
+ * sem_down:
+ *     Retorna 0 se pegou o recurso, 1 se tem que chamar de novo, 
+ * (a thread est bloqueada na fila) e -1 se falhou.
+ */
+
+static int sem_down ( struct semaphore_d *s, int flags ){
+
+	struct thread_d *t;
+	unsigned long Flags;
+
+	t = sem_current_thread ();
+
+	Flags = sem_lock ();
+
+	if ( sem_valid (s) == 0 )
+	{
+		sem_unlock (Flags);
+		return (int) -1;
+	}
+
+	if ( (void *) t != NULL && t->sem_wait == s )
+	{
+		// O Up entregou o recurso para ns.
+		if ( t->sem_granted == 1 )
+		{
+			t->sem_wait = NULL;
+			t->sem_granted = 0;
+
+			sem_acquired ( s, t );
+
+			sem_unlock (Flags);
+			return 0;
+		}
+
+		// Ainda na fila.
+		sem_block (t);
+
+		sem_unlock (Flags);
+		return (int) 1;
+	}
+
+	if ( s->count > 0 )
+	{
+		s->count--;
+		sem_acquired ( s, t );
+
+		sem_unlock (Flags);
+		return 0;
+	}
+
+	if ( flags & SEMAPHORE_TRY )
+	{
+		sem_unlock (Flags);
+		return (int) 1;
+	}
+
+	// Sem thread no tem fila, quem chamou tenta de novo.
+	if ( (void *) t == NULL )
+	{
+		sem_unlock (Flags);
+		return (int) 1;
+	}
+
+	// O dono do mutex pedindo de novo. Nunca vai acordar.
+	if ( s->type == SEMAPHORE_TYPE_MUTEX && s->owner == t->tid )
+	{
+		sem_unlock (Flags);
+		return (int) -1;
+	}
+
+	t->sem_wait = s;
+	t->sem_granted = 0;
+
+	sem_enqueue ( s, t );
+
+	s->contended++;
+	semaphoreContended++;
+
+	sem_block (t);
+
+	sem_unlock (Flags);
+
+	return (int) 1;
+}
+
+
+/*
+ * sem_release:
+ *     Entrega o recurso para a primeira thread da fila e acorda s ela.
+ *     Se a fila est vazia o contador sobe.
+ *     Com o lock.
+ */
+
+static void sem_release ( struct semaphore_d *s ){
+
+	struct thread_d *w;
+
+	w = sem_dequeue (s);
+
+	if ( (void *) w != NULL )
+	{
+		w->sem_granted = 1;
+
+		if ( s->type == SEMAPHORE_TYPE_MUTEX ){
+			s->owner = w->tid;
+		}
+
+		s->wakeups++;
+		semaphoreWakeups++;
+
+		wakeup_thread_reason ( w->tid, WAIT_REASON_SEMAPHORE );
+		return;
+	}
+
+	if ( s->type == SEMAPHORE_TYPE_MUTEX )
+	{
+		s->owner = -1;
+		s->count = 1;
+	}else{
+		s->count++;
+	};
+}
+
+
+static int sem_up ( struct semaphore_d *s ){
+
+	struct thread_d *t;
+	unsigned long Flags;
+
+	t = sem_current_thread ();
+
+	Flags = sem_lock ();
+
+	if ( sem_valid (s) == 0 )
+	{
+		sem_unlock (Flags);
+		return (int) -1;
+	}
+
+	// S o dono libera o mutex.
+	if ( s->type == SEMAPHORE_TYPE_MUTEX && (void *) t != NULL )
+	{
+		if ( s->owner != t->tid )
+		{
+			sem_unlock (Flags);
+			return (int) 1;
+		}
+	}
+
+	sem_release (s);
+
+	sem_unlock (Flags);
+
+	return 0;
+}
+
+
 /*
  **************************************************************
  * init_semaphore:
@@ -41,6 +395,21 @@ int init_semaphore ( struct semaphore_d *s, unsigned int count ){
 	
 	//1.
 	s->count = (unsigned int) count;    
+	
+	s->type = SEMAPHORE_TYPE_COUNTING;
+	s->owner = -1;
+	
+	s->wait_head = NULL;
+	s->wait_tail = NULL;
+	s->waiters = 0;
+	
+	s->acquires = 0;
+	s->contended = 0;
+	s->wakeups = 0;
+	s->max_waiters = 0;
+	
+	s->used = 1;
+	s->magic = 1234;
     
 	return (int) 0;
 }
@@ -54,12 +423,12 @@ int init_semaphore ( struct semaphore_d *s, unsigned int count ){
  *     o recurso j est bloqueado por outro processo 
  *     ento o processo que est tentando utilizar o recurso
  *     deve esperar, mudando o estado para waiting.
- *		
- * O processo deve esperar.
- *		 Opes:
- *		 +Retornamos um valor que indique que o processo deve esperar
- *		  em um loop.
- *       +Bloquamos o processo at que o semforo esteja liberado.
+ *
+ *     A thread entra na fila do semforo e  bloqueada. 
+ *     Retorna 1, e a thread chama de novo quando acordar.
+ *
+ *     Uma estrutura que no foi inicializada pelo kernel (syscall 87 
+ * com um ponteiro do aplicativo) continua com o flag antigo, sem fila.
  */ 
 
 int Down (struct semaphore_d *s){
@@ -72,11 +441,18 @@ int Down (struct semaphore_d *s){
 	if ( (void *) s ==  NULL)
 	{
 		return (int) 1;     
-	}else{
+	}
+	
+	if ( sem_valid (s) == 1 )
+	{
+		if ( sem_down ( s, 0 ) == 0 ){
+			return 0;
+		}
 		
-	    Flag = (int) s->count;	
-	};
+		return (int) 1;
+	}
 	
+	Flag = (int) s->count;	
 	
 	switch (Flag)
 	{
@@ -108,6 +484,7 @@ int Down (struct semaphore_d *s){
  *     Quando um processo sai da sua regio crtica
  *     ele d um Up no semforo, mudando seu valor pra 1.
  *     Isso libera o recurso pra outro processo.
+ *     Se tem thread na fila, a primeira recebe o recurso e acorda.
  */ 
 
 int Up (struct semaphore_d *s){
@@ -122,10 +499,18 @@ int Up (struct semaphore_d *s){
 	if ( (void *) s == NULL)
 	{
 		return (int) 1;       
-	}else{
+	}
+	
+	if ( sem_valid (s) == 1 )
+	{
+		if ( sem_up (s) == 0 ){
+			return 0;
+		}
 		
-		 Flag = (int) s->count;	
-	};
+		return (int) 1;
+	}
+	
+	Flag = (int) s->count;	
 
 	switch (Flag)
 	{
@@ -141,9 +526,6 @@ int Up (struct semaphore_d *s){
 			return (int) 0;
 		    break;
 	};
-	
-fail:
-    return (int) 1;
 };
 
 
@@ -159,19 +541,79 @@ void semaphore_up (struct semaphore_d *s){
 }
 
 
-void *create_semaphore (void)
-{
-	//@todo:
+/*
+ * create_semaphore:
+ *     Pega um semforo livre da tabela. 
+ *     O ndice na tabela  o handle das syscalls.
+ */
+
+void *create_semaphore (void){
+	
+	struct semaphore_d *s;
+	unsigned long Flags;
+	int i;
+	
+	Flags = sem_lock ();
+	
+	for ( i=0; i < SEMAPHORE_COUNT_MAX; i++ )
+	{
+		s = &sem_table[i];
+		
+		if ( s->used != 1 )
+		{
+			init_semaphore ( s, 0 );
+			
+			s->id = i;
+			s->taskId = current_process;
+			
+			semaphoreList[i] = (unsigned long) s;
+			
+			sem_unlock (Flags);
+			return (void *) s;
+		}
+	};
+	
+	sem_unlock (Flags);
+	
     return NULL;
 }
 
 
-void delete_semaphore(struct semaphore_d *s)
-{
-	//@todo:
+/*
+ * delete_semaphore:
+ *     As threads que ainda esto na fila acordam e o prximo Down 
+ * delas falha.
+ */
+
+void delete_semaphore (struct semaphore_d *s){
+	
+	struct thread_d *t;
+	unsigned long Flags;
+	
+	Flags = sem_lock ();
+	
+	if ( sem_valid (s) == 0 )
+	{
+		sem_unlock (Flags);
+		return;
+	}
+	
+	while ( (t = sem_dequeue (s)) != NULL )
+	{
+		t->sem_wait = NULL;
+		t->sem_granted = 0;
+		
+		wakeup_thread_reason ( t->tid, WAIT_REASON_SEMAPHORE );
+	};
+	
+	s->used = 0;
+	s->magic = 0;
+	
+	if ( s >= &sem_table[0] && s < &sem_table[SEMAPHORE_COUNT_MAX] ){
+		semaphoreList[s->id] = 0;
+	}
 	
-	//s = NULL;
-    return;
+	sem_unlock (Flags);
 };
 
 
@@ -189,6 +631,219 @@ void close_semaphore(struct semaphore_d *s)
 };
 
 
+/* Campos da thread. Chamado na criao da thread. */
+
+void semInitThread ( struct thread_d *t ){
+	
+	if ( (void *) t == NULL ){
+		return;
+	}
+	
+	t->sem_wait = NULL;
+	t->sem_next = NULL;
+	t->sem_granted = 0;
+}
+
+
+/*
+ * semExitThread:
+ *     A thread morreu. Sai da fila, e o que ela tinha vai para a 
+ * prxima. (o recurso que o Up j entregou e os mutexes dela)
+ */
+
+void semExitThread ( struct thread_d *t ){
+	
+	struct semaphore_d *s;
+	unsigned long Flags;
+	int i;
+	
+	if ( (void *) t == NULL ){
+		return;
+	}
+	
+	Flags = sem_lock ();
+	
+	s = t->sem_wait;
+	
+	if ( sem_valid (s) == 1 )
+	{
+		if ( t->sem_granted == 1 ){
+			sem_release (s);
+		}else{
+			sem_unqueue ( s, t );
+		};
+	}
+	
+	t->sem_wait = NULL;
+	t->sem_next = NULL;
+	t->sem_granted = 0;
+	
+	for ( i=0; i < SEMAPHORE_COUNT_MAX; i++ )
+	{
+		s = &sem_table[i];
+		
+		if ( sem_valid (s) == 1 && s->type == SEMAPHORE_TYPE_MUTEX && 
+		     s->owner == t->tid )
+		{
+			sem_release (s);
+		}
+	};
+	
+	sem_unlock (Flags);
+}
+
+
+/* O processo morreu. Os semforos que ele criou. */
+
+void semExitProcess ( int pid ){
+	
+	struct semaphore_d *s;
+	int i;
+	
+	for ( i=0; i < SEMAPHORE_COUNT_MAX; i++ )
+	{
+		s = &sem_table[i];
+		
+		if ( sem_valid (s) == 1 && s->taskId == pid ){
+			delete_semaphore (s);
+		}
+	};
+}
+
+
+static struct semaphore_d *sem_get ( int handle ){
+	
+	struct semaphore_d *s;
+	
+	if ( handle < 0 || handle >= SEMAPHORE_COUNT_MAX ){
+		return NULL;
+	}
+	
+	s = (struct semaphore_d *) semaphoreList[handle];
+	
+	if ( sem_valid (s) == 0 ){
+		return NULL;
+	}
+	
+	// S o processo que criou.
+	if ( s->taskId != current_process ){
+		return NULL;
+	}
+	
+	return (struct semaphore_d *) s;
+}
+
+
+/*
+ * semCreate:
+ *     Syscall. Retorna o handle ou -1.
+ *     O mutex comea livre, o count  ignorado.
+ */
+
+int semCreate ( unsigned int count, int type ){
+	
+	struct semaphore_d *s;
+	
+	if ( type != SEMAPHORE_TYPE_COUNTING && type != SEMAPHORE_TYPE_MUTEX ){
+		return (int) -1;
+	}
+	
+	s = (struct semaphore_d *) create_semaphore ();
+	
+	if ( (void *) s == NULL ){
+		return (int) -1;
+	}
+	
+	s->type = type;
+	
+	if ( type == SEMAPHORE_TYPE_MUTEX ){
+		s->count = 1;
+	}else{
+		s->count = count;
+	};
+	
+	return (int) s->id;
+}
+
+
+int semDestroy ( int handle ){
+	
+	struct semaphore_d *s;
+	
+	s = sem_get (handle);
+	
+	if ( (void *) s == NULL ){
+		return (int) -1;
+	}
+	
+	delete_semaphore (s);
+	
+	return 0;
+}
+
+
+/* Syscall. 0 = pegou, 1 = chamar de novo, -1 = falhou. */
+
+int semDown ( int handle, int flags ){
+	
+	struct semaphore_d *s;
+	
+	s = sem_get (handle);
+	
+	if ( (void *) s == NULL ){
+		return (int) -1;
+	}
+	
+	return (int) sem_down ( s, flags );
+}
+
+
+int semUp ( int handle ){
+	
+	struct semaphore_d *s;
+	
+	s = sem_get (handle);
+	
+	if ( (void *) s == NULL ){
+		return (int) -1;
+	}
+	
+	return (int) sem_up (s);
+}
+
+
+/*
+ * semShowInfo:
+ *     Os contadores de cada semforo. Quem tem muito 'contended' 
+ *  um lock quente.
+ */
+
+void semShowInfo (void){
+	
+	struct semaphore_d *s;
+	int i;
+	
+	printf ("\n[Semaphores:] contended={%d} wakeups={%d}\n", 
+	    semaphoreContended, semaphoreWakeups );
+	
+	for ( i=0; i < SEMAPHORE_COUNT_MAX; i++ )
+	{
+		s = &sem_table[i];
+		
+		if ( s->used != 1 || s->magic != 1234 ){
+			continue;
+		}
+		
+		printf ("%d: %s pid={%d} count={%d} owner={%d} waiters={%d} ", 
+		    i, ( s->type == SEMAPHORE_TYPE_MUTEX ? "mutex" : "sem" ),
+		    s->taskId, s->count, s->owner, s->waiters );
+		
+		printf ("acquires={%d} contended={%d} wakeups={%d} max={%d}\n",
+		    s->acquires, s->contended, s->wakeups, s->max_waiters );
+	};
+}
+
+
 //
 // End.
 //
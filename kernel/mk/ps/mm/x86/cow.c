@@ -0,0 +1,415 @@
+/*
+ * File: mm/x86/cow.c
+ *
+ *     Copy-on-write for fork().
+ *
+ *     do_fork_process() used to allocate 200KB and copy the image of
+ * the parent before the child even runs. Now the child shares the
+ * frames of the parent and only the pages that are written are copied,
+ * one at a time, in the #PF handler.
+ *
+ *     The reference count of a shared frame is frameTable[].ref_count.
+ * (frameGet/framePut) The frames that the allocator does not count
+ * (boot images) start with one reference when they are shared for the
+ * first time, and are never freed.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+extern unsigned long get_page_fault_adr (void);
+
+
+static int cow_wp_enabled;
+
+
+static spinlock_t cow_spinlock;
+
+
+static unsigned long cow_lock (void){
+
+	return (unsigned long) spinLockIrqSave ( &cow_spinlock );
+}
+
+
+static void cow_unlock ( unsigned long flags ){
+
+	spinUnlockIrqRestore ( &cow_spinlock, flags );
+}
+
+
+static void cow_invlpg ( unsigned long address ){
+
+	__asm__ __volatile__ ( "invlpg (%0)" : : "r" (address) : "memory" );
+}
+
+
+/* Reload cr3. The whole TLB of the current directory. */
+
+static void cow_flush_tlb (void){
+
+	unsigned long Value;
+
+	__asm__ __volatile__ ( "movl %%cr3, %0" : "=r" (Value) );
+	__asm__ __volatile__ ( "movl %0, %%cr3" : : "r" (Value) : "memory" );
+}
+
+
+/*
+ * cow_enable_wp:
+ *     CR0.WP. Without it the kernel writes to read-only pages
+ * and a syscall would change the frame of the other process.
+ */
+
+static void cow_enable_wp (void){
+
+	unsigned long Value;
+
+	if ( cow_wp_enabled == 1 ){
+		return;
+	}
+
+	__asm__ __volatile__ ( "movl %%cr0, %0" : "=r" (Value) );
+	Value |= 0x00010000;
+	__asm__ __volatile__ ( "movl %0, %%cr0" : : "r" (Value) : "memory" );
+
+	cow_wp_enabled = 1;
+}
+
+
+// The directories and the page tables are below 4MB, where the
+// physical and virtual addresses are the same.
+
+static unsigned long *cow_current_directory (void){
+
+	unsigned long Value;
+
+	__asm__ __volatile__ ( "movl %%cr3, %0" : "=r" (Value) );
+
+	return (unsigned long *) ( Value & COW_PTE_FRAME );
+}
+
+
+static void cow_frame_get ( unsigned long pa ){
+
+	frameGet ( pa / PAGE_SIZE );
+}
+
+
+/* The frame goes back to the allocator with the last reference. */
+
+static void cow_frame_put ( unsigned long pa ){
+
+	framePut ( pa / PAGE_SIZE );
+}
+
+
+/* Frames out of the table are always copied. */
+
+static int cow_frame_shared ( unsigned long pa ){
+
+	unsigned long f = (pa / PAGE_SIZE);
+
+	if ( (void *) frameTable == NULL || f >= frameTableCount ){
+		return (int) 1;
+	}
+
+	if ( frameTable[f].ref_count > 1 ){
+		return (int) 1;
+	}
+
+	return (int) 0;
+}
+
+
+/*
+ * cowSharePageTable:
+ *     Cria a page table do filho com os frames do pai.
+ *     As páginas com escrita ficam read-only e COW nas duas tabelas.
+ *
+ *     Se o pai ainda usa a page table do kernel, (compartilhada por
+ * vários processos) ele ganha uma cópia dela antes, para que as outras
+ * entradas não mudem.
+ */
+
+int
+cowSharePageTable ( unsigned long parent_dir_va,
+                    unsigned long child_dir_va,
+                    int dir_index )
+{
+	unsigned long *KernelDir = (unsigned long *) gKernelPageDirectoryAddress;
+	unsigned long *ParentDir = (unsigned long *) parent_dir_va;
+	unsigned long *ChildDir = (unsigned long *) child_dir_va;
+	unsigned long *ParentPT;
+	unsigned long *ChildPT;
+	unsigned long *PrivatePT;
+	unsigned long PhysicalAddress;
+	unsigned long Entry;
+	unsigned long Flags;
+	int i;
+
+	if ( parent_dir_va == 0 || child_dir_va == 0 ){
+		return (int) -1;
+	}
+
+	if ( dir_index < 0 || dir_index >= 1024 ){
+		return (int) -1;
+	}
+
+	if ( (ParentDir[dir_index] & COW_PTE_PRESENT) == 0 ){
+		return (int) -1;
+	}
+
+	ParentPT = (unsigned long *) ( ParentDir[dir_index] & COW_PTE_FRAME );
+
+	ChildPT = (unsigned long *) get_table_pointer ();
+
+	Flags = cow_lock ();
+
+	if ( ParentDir[dir_index] == KernelDir[dir_index] )
+	{
+		PrivatePT = (unsigned long *) get_table_pointer ();
+
+		for ( i=0; i < 1024; i++ ){
+			PrivatePT[i] = ParentPT[i];
+		};
+
+		PhysicalAddress = (unsigned long) virtual_to_physical ( (unsigned long) PrivatePT,
+		                                      gKernelPageDirectoryAddress );
+
+		ParentDir[dir_index] = ( PhysicalAddress | (ParentDir[dir_index] & 0xFFF) );
+		ParentPT = PrivatePT;
+	}
+
+	for ( i=0; i < 1024; i++ )
+	{
+		Entry = ParentPT[i];
+
+		// As páginas que o loader ainda não trouxe continuam 
+		// sob demanda no filho. (elf.c)
+		if ( (Entry & COW_PTE_PRESENT) == 0 )
+		{
+			ChildPT[i] = ( Entry & ELF_PTE_DEMAND );
+			continue;
+		}
+
+		if ( Entry & (COW_PTE_WRITE | COW_PTE_COW) )
+		{
+			Entry = ( (Entry & ~COW_PTE_WRITE) | COW_PTE_COW );
+			ParentPT[i] = Entry;
+
+			cow_frame_get ( Entry & COW_PTE_FRAME );
+			cow_pages_shared++;
+		}
+
+		ChildPT[i] = Entry;
+	};
+
+	PhysicalAddress = (unsigned long) virtual_to_physical ( (unsigned long) ChildPT,
+	                                      gKernelPageDirectoryAddress );
+
+	ChildDir[dir_index] = ( PhysicalAddress | 7 );
+
+	// As entradas do pai mudaram.
+	cow_flush_tlb ();
+
+	cow_enable_wp ();
+
+	cow_unlock (Flags);
+
+	return 0;
+}
+
+
+/*
+ * cowPageFault:
+ *     Escrita numa página COW.
+ *     Copia a página para um frame novo, ou só libera a escrita se o
+ * frame não é mais compartilhado.
+ *     Retorna 1 se a thread pode continuar.
+ */
+
+int cowPageFault ( unsigned long error_code ){
+
+	unsigned long *Dir;
+	unsigned long *PT;
+	unsigned long Address;
+	unsigned long Page;
+	unsigned long Entry;
+	unsigned long OldFrame;
+	unsigned long NewPA;
+	void *New;
+	int d;
+	int t;
+
+	// Not present. Maybe a page of the ELF loader. (elf.c)
+	if ( (error_code & 1) == 0 ){
+		return (int) elfPageFault (error_code);
+	}
+
+	// Present and write.
+	if ( (error_code & 3) != 3 ){
+		return 0;
+	}
+
+	Address = (unsigned long) get_page_fault_adr ();
+	Page = ( Address & COW_PTE_FRAME );
+
+	Dir = cow_current_directory ();
+
+	d = (int) ( (Address >> 22) & 0x3FF );
+	t = (int) ( (Address >> 12) & 0x3FF );
+
+	if ( (Dir[d] & COW_PTE_PRESENT) == 0 ){
+		return 0;
+	}
+
+	PT = (unsigned long *) ( Dir[d] & COW_PTE_FRAME );
+
+	Entry = PT[t];
+
+	if ( (Entry & COW_PTE_PRESENT) == 0 || (Entry & COW_PTE_COW) == 0 ){
+		return 0;
+	}
+
+	cow_fault_count++;
+
+	OldFrame = ( Entry & COW_PTE_FRAME );
+
+	// Só nós usamos o frame.
+	if ( cow_frame_shared (OldFrame) == 0 )
+	{
+		PT[t] = ( (Entry | COW_PTE_WRITE) & ~COW_PTE_COW );
+		cow_invlpg (Page);
+
+		cow_pages_reused++;
+		return (int) 1;
+	}
+
+	// Um frame da memória alta, mapeado na janela kmap só para a cópia.
+	New = (void *) allocHighPages (1);
+
+	if ( (void *) New == NULL )
+	{
+		cow_fail_count++;
+		return 0;
+	}
+
+	// A página ainda está mapeada no diretório atual.
+	memcpy ( New, (const void *) Page, PAGE_SIZE );
+
+	NewPA = (unsigned long) unmapPhysicalFrames (New);
+
+	cow_frame_put (OldFrame);
+
+	// A cópia é um frame só nosso, como os do loader. (elf.c)
+	PT[t] = ( NewPA | (Entry & 0xFFF & ~COW_PTE_COW) | COW_PTE_WRITE | ELF_PTE_DEMAND );
+	cow_invlpg (Page);
+
+	cow_pages_copied++;
+
+	return (int) 1;
+}
+
+
+/*
+ * cowReleasePageTable:
+ *     O processo terminou.
+ *     Solta as referências dos frames COW da page table. O frame vai
+ * para o alocador se era a última, e quem ainda usa ele não precisa
+ * mais copiar quando escrever.
+ *     A page table do kernel não é tocada.
+ */
+
+void cowReleasePageTable ( unsigned long dir_va, int dir_index ){
+
+	unsigned long *KernelDir = (unsigned long *) gKernelPageDirectoryAddress;
+	unsigned long *Dir = (unsigned long *) dir_va;
+	unsigned long *PT;
+	unsigned long Entry;
+	unsigned long Flags;
+	int i;
+
+	if ( dir_va == 0 || dir_index < 0 || dir_index >= 1024 ){
+		return;
+	}
+
+	if ( (Dir[dir_index] & COW_PTE_PRESENT) == 0 ||
+	     Dir[dir_index] == KernelDir[dir_index] )
+	{
+		return;
+	}
+
+	PT = (unsigned long *) ( Dir[dir_index] & COW_PTE_FRAME );
+
+	Flags = cow_lock ();
+
+	for ( i=0; i < 1024; i++ )
+	{
+		Entry = PT[i];
+
+		if ( (Entry & COW_PTE_PRESENT) == 0 || (Entry & COW_PTE_COW) == 0 ){
+			continue;
+		}
+
+		cow_frame_put ( Entry & COW_PTE_FRAME );
+		PT[i] = 0;
+
+		cow_pages_released++;
+	};
+
+	cow_flush_tlb ();
+
+	cow_unlock (Flags);
+}
+
+
+unsigned long cowTimestamp (void){
+
+	unsigned long Low;
+	unsigned long High;
+
+	__asm__ __volatile__ ( "rdtsc" : "=a" (Low), "=d" (High) );
+
+	return (unsigned long) Low;
+}
+
+
+void cowForkDone ( unsigned long start ){
+
+	unsigned long Cycles;
+
+	Cycles = ( cowTimestamp () - start );
+
+	cow_fork_count++;
+	cow_fork_last_cycles = Cycles;
+	cow_fork_total_cycles += Cycles;
+
+	if ( Cycles > cow_fork_max_cycles ){
+		cow_fork_max_cycles = Cycles;
+	}
+}
+
+
+void cowShowInfo (void){
+
+	printf ("\n[Fork (COW):]\n");
+
+	printf ("forks={%d} last={%d} max={%d} avg={%d} cycles\n",
+	    cow_fork_count, cow_fork_last_cycles, cow_fork_max_cycles,
+	    ( cow_fork_count ? (cow_fork_total_cycles / cow_fork_count) : 0 ) );
+
+	printf ("shared={%d} faults={%d} copied={%d} reused={%d} released={%d} fails={%d}\n",
+	    cow_pages_shared, cow_fault_count, cow_pages_copied,
+		cow_pages_reused, cow_pages_released, cow_fail_count );
+}
+
+
+//
+// End.
+//
+
@@ -96,6 +96,10 @@ unsigned long last_valid;         //
 unsigned long last_size;          //ltimo tamanho alocado.
 unsigned long mm_prev_pointer;    //Endereo da ntima estrutura alocada.
 
+// Free large blocks, ready to be reused by heapAllocateMemory.
+// Linked through the Next/Prev fields of their own mmblock_d header.
+static struct mmblock_d *mmblock_free_list;
+
 
 
 /*
@@ -439,6 +443,53 @@ unsigned long heapAllocateMemory ( unsigned long size ){
     };
     
 	
+    // Small sizes are served by the slab caches. (slab.c)
+	// Falling back to the heap if the slab has no more pages.
+
+    if ( slab_initialized == 1 && size <= SLAB_SIZE_MAX )
+    {
+        Current = (void *) slabAllocateSize (size);
+		
+        if ( (void *) Current != NULL ){
+            return (unsigned long) Current;
+        }
+    };
+
+    // Reuse a free block, first fit.
+	// The block keeps its size, the unused bytes stay with it.
+
+    Current = mmblock_free_list;
+
+    while ( (void *) Current != NULL )
+    {
+        if ( (Current->Footer - Current->userArea) >= size )
+        {
+            if ( (void *) Current->Prev != NULL ){
+                Current->Prev->Next = Current->Next;
+            }else{
+                mmblock_free_list = Current->Next;
+            };
+
+            if ( (void *) Current->Next != NULL ){
+                Current->Next->Prev = Current->Prev;
+            }
+
+            Current->Prev = NULL;
+            Current->Next = NULL;
+
+            Current->Used = 1;
+            Current->Magic = 1234;
+            Current->Free = 0;
+
+            heapFreeBlocks--;
+            heapRecycledBlocks++;
+
+            return (unsigned long) Current->userArea;
+        }
+
+        Current = Current->Next;
+    };
+	
     //Salvando o tamanho desejado.
     last_size = (unsigned long) size;
     
@@ -553,6 +604,8 @@ try_again:
         Current->Used = 1;                
         Current->Magic = 1234;            
         Current->Free = 0;                
+        Current->Prev = NULL;
+        Current->Next = NULL;
         //Continua...
 
         //
@@ -696,6 +749,14 @@ void FreeHeap (void *ptr){
 		return;
 	}
 	
+	// Objects of the slab caches.
+	
+	if ( slabOwns (ptr) == 1 )
+	{
+		slabFree (ptr);
+		return;
+	}
+	
 	
 	// Header
 	// Encontrando o endereo do header.
@@ -716,19 +777,44 @@ void FreeHeap (void *ptr){
 			return;
 		}
 		
-		//Checa
-		if ( mmblockList[mmblockCount] == (unsigned long) Header && 
-			 Header->Id == mmblockCount )
+		// The last block of the heap.
+		// Only in this case we can move the heap pointer back.
+		
+		if ( Header->Footer == g_heap_pointer )
 		{
-			mmblockList[mmblockCount] = 0;
-			mmblockCount--;
+		    //Checa
+		    if ( mmblockList[mmblockCount] == (unsigned long) Header && 
+			     Header->Id == mmblockCount )
+		    {
+			    mmblockList[mmblockCount] = 0;
+			    mmblockCount--;
+		    }
+		
+		    g_available_heap = (unsigned long) g_available_heap + (Header->Footer - Header->Header);
+		
+		    //Isso invalida a estrutura, para evitar mal uso.
+		    Header->Used = 0;
+		    Header->Magic = 0;
+		
+		    g_heap_pointer = (unsigned long) Header;
+			
+			return;
 		}
 		
-		//Isso invalida a estrutura, para evitar mal uso.
+		// Any other block goes to the free list.
+		// The magic stays valid, so the block can be reused.
+		
 		Header->Used = 0;
-		Header->Magic = 0;
+		Header->Free = 1;
+		
+		Header->Prev = NULL;
+		Header->Next = mmblock_free_list;
+		if ( (void *) mmblock_free_list != NULL ){
+		    mmblock_free_list->Prev = Header;
+		}
+		mmblock_free_list = Header;
 		
-		g_heap_pointer = (unsigned long) Header;
+		heapFreeBlocks++;
 	}    
 }
 
@@ -815,6 +901,19 @@ int init_heap (void){
 	
 	//KernelHeap = (void*) x??;
 	
+	mmblock_free_list = NULL;
+	heapFreeBlocks = 0;
+	heapRecycledBlocks = 0;
+	
+	// Slab caches. (slab.c)
+	// Os caches usam o heap, que j est pronto.
+	
+	if ( slabInit () != 0 )
+	{
+	    printf("init_heap fail: slab\n");
+		goto fail;
+	}
+	
 	//More?!
 	
 // Done.
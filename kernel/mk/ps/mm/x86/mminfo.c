@@ -173,6 +173,20 @@ void memoryShowMemoryInfo (void){
 	    kernel_heap_start, kernel_heap_end, HeapTotal );
 			
     printf("AvailableHeap={%d KB}\n", (g_available_heap/1024) );
+    printf("FreeBlocks={%d} RecycledBlocks={%d}\n", 
+        heapFreeBlocks, heapRecycledBlocks );
+	
+	// Slab caches.
+	slabShowInfo ();
+	
+	// Frames.
+	frameShowInfo ();
+	
+	// Fork.
+	cowShowInfo ();
+	
+	// Loader. (demand paging)
+	elfShowInfo ();
 	    
 		// @todo:
 		// Mostrar o tamanho da pilha..
@@ -263,9 +277,6 @@ void show_memory_structs (void){
 
 void testingPageAlloc (void){
 	
-	int Index;
-    struct page_d *p;
-	
 	void *RetAddress;
 	unsigned long fileret;
 	
@@ -296,21 +307,7 @@ void testingPageAlloc (void){
     
 	// show info.	
 	
-	for ( Index=0; Index < 32; Index++ )   	
-	{  
-        p = (void *) pageAllocList[Index]; 
-		
-		if ( (void *) p == NULL )
-		{
-		    printf("null\n");	 
-		}
-	    
-		if ( (void *) p != NULL )
-		{
-		    printf ("id={%d} used={%d} magic={%d} free={%d} handle={%x} next={%x}\n", 
-				p->id, p->used, p->magic, p->free, p, p->next ); 	
-		}
-	};
+	showFreepagedMemory (32);
 	
     //===================================
 	 
@@ -348,28 +345,30 @@ fail:
 //mostra as estruturas de pagina usadas para paginação no pagedpool.
 void showFreepagedMemory ( int max ){
 
+	struct frame_zone_d *z;
+	unsigned long f;
 	int Index;
-	struct page_d *p;
 	
-    if (max < 0 || max >= 1024 )
+    if (max < 0 || max >= PAGE_COUNT_MAX )
+		return;
+	
+	z = &frameZones[FRAME_ZONE_POOL];
+	
+	if ( (void *) frameTable == NULL || z->used != 1 || z->magic != 1234 )
 		return;
 
 	for ( Index=0; Index < max; Index++ )   	
 	{  
-        p = (void *) pageAllocList[Index]; 
+        f = (z->base + Index);
 		
-		//if ( (void *) p == NULL )
-		//{
-		//    printf("null\n");	 
-		//}
-	    
-		if ( (void *) p != NULL )
+		if ( frameTable[f].flags != 0 )
 		{
-		    printf ("id=%d free=%d frameno=%d ref=%d \n", 
-				p->id, 
-				p->free, 
-				p->frame_number,
-				p->ref_count ); 	
+		    printf ("id=%d flags=%d order=%d count=%d ref=%d \n", 
+				Index, 
+				frameTable[f].flags, 
+				frameTable[f].order,
+				frameTable[f].count,
+				frameTable[f].ref_count ); 	
 		}
 	};
 	
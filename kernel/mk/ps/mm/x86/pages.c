@@ -102,6 +102,12 @@ extern void set_page_dir (void);
 //...
 
 
+// Janela kmap. (mapPhysicalFrames)
+// Nmero de pginas de cada mapeamento, na posio da primeira.
+static unsigned short kmap_count[KMAP_PAGES];
+static spinlock_t kmap_spinlock;
+
+
 
 //Usar alguma rotina de hal_ pra isso;
 //extern unsigned long _get_page_dir();
@@ -650,6 +656,42 @@ unsigned long mapping_nic1_device_address ( unsigned long address ){
 };
 
 
+/*
+ * mapping_lapic_device_address:
+ *     Mapeando os registradores do local APIC. (0xFEE00000)
+ *     S a primeira pgina da tabela  usada.
+ *     Tem que ser antes dos processos, eles copiam o diretrio 
+ * do kernel.
+ */
+
+unsigned long mapping_lapic_device_address ( unsigned long address ){
+	
+    unsigned long *page_directory = (unsigned long *) gKernelPageDirectoryAddress;      
+	
+	unsigned long *lapic_page_table = (unsigned long *) PAGETABLE_LAPIC; //0x00082000 
+	
+	int i;
+	
+	for ( i=0; i < 1024; i++ ){
+		lapic_page_table[i] = 0;
+	};
+	
+	// 10=cache desable 8= Write-Through 0x002 = Writeable 0x001 = Present
+	lapic_page_table[0] = (unsigned long) (address & 0xFFFFF000) | 0x1B; // 0001 1011
+	
+	//f0800000      962
+	
+    page_directory[ENTRY_LAPIC_PAGES] = (unsigned long) &lapic_page_table[0];
+    page_directory[ENTRY_LAPIC_PAGES] = (unsigned long) page_directory[ENTRY_LAPIC_PAGES] | 0x1B; // 0001 1011   		
+	
+	// Pode ter sido usada antes.
+	asm volatile ( "invlpg (%0)" : : "r" (LAPIC_VA) : "memory" );
+	
+	//(virtual)
+	return (unsigned long) LAPIC_VA;
+}
+
+
 /*
  *************************************************************
  * SetUpPaging:
@@ -873,6 +915,9 @@ int SetUpPaging (void){
     //pagetable para o pagedpool
 	unsigned long *pagedpool_page_table = (unsigned long *) PAGETABLE_PAGEDPOOL; //0x00089000;  
 	
+	//pagetable para a janela kmap. (memria alta)
+	unsigned long *kmap_page_table = (unsigned long *) PAGETABLE_KMAP; //0x00080000;  
+	
 	//um endereo fsico para a pagetable que mapear os buffers.
 	unsigned long *heappool_page_table = (unsigned long *) PAGETABLE_HEAPPOOL; 
 	
@@ -1329,6 +1374,26 @@ int SetUpPaging (void){
     page_directory[ENTRY_GRAMADOCORE_TASKMAN_PAGES] = (unsigned long) page_directory[ENTRY_GRAMADOCORE_TASKMAN_PAGES] | 7;  		
 
 	
+	//+++++++
+	// kmap.
+	// Janela para os frames da memria alta. (mapPhysicalFrames)
+	// Comea vazia. S o kernel acessa.
+	
+	for ( i=0; i < KMAP_PAGES; i++ ){
+		kmap_page_table[i] = 0;
+		kmap_count[i] = 0;
+	};
+	
+	spinLockInit (&kmap_spinlock);
+	kmap_pages_used = 0;
+	kmap_fail_count = 0;
+	
+	//f0c00000      963
+	
+    page_directory[ENTRY_KMAP_PAGES] = (unsigned long) &kmap_page_table[0];      
+    page_directory[ENTRY_KMAP_PAGES] = (unsigned long) page_directory[ENTRY_KMAP_PAGES] | 3;  		
+
+	
 	
     //...
 	
@@ -1642,287 +1707,793 @@ int SetUpPaging (void){
 }
 
 
+//
+// ## Frame allocator ##
+//
+
+// Buddy allocator. 
+// frameTable[] tem um descritor por frame da memria fsica e cada zona
+// tem uma lista de blocos livres por ordem. Um bloco de ordem N tem 2^N
+// frames contguos, e seu 'buddy'  o bloco vizinho de mesmo tamanho.
+// Alocar e liberar custa O(log n), no mximo FRAME_ORDER_COUNT passos.
+
+
+/* Put a free block at the head of the list of its order. */
+
+static void 
+frame_zone_push ( struct frame_zone_d *z, unsigned long i, int order ){
+	
+	struct frame_d *f;
+	
+	f = &frameTable[i];
+	
+	f->flags = FRAME_FREE;
+	f->order = (unsigned char) order;
+	f->count = 0;
+	f->ref_count = 0;
+	
+	f->prev = FRAME_NULL;
+	f->next = z->free_list[order];
+	
+	if ( z->free_list[order] != FRAME_NULL ){
+		frameTable[ z->free_list[order] ].prev = (unsigned short) i;
+	}
+	
+	z->free_list[order] = (unsigned short) i;
+}
+
+
+/* Take a free block out of its list. */
+
+static void 
+frame_zone_unlink ( struct frame_zone_d *z, unsigned long i ){
+	
+	struct frame_d *f;
+	
+	f = &frameTable[i];
+	
+	if ( f->prev != FRAME_NULL ){
+		frameTable[f->prev].next = f->next;
+	}else{
+		z->free_list[f->order] = f->next;
+	};
+	
+	if ( f->next != FRAME_NULL ){
+		frameTable[f->next].prev = f->prev;
+	}
+	
+	f->flags = 0;
+	f->next = FRAME_NULL;
+	f->prev = FRAME_NULL;
+}
+
+
+/*
+ * frame_zone_free_block:
+ *     Libera um bloco, juntando ele com o seu buddy enquanto
+ * o buddy tambm estiver livre.
+ */
+
+static void 
+frame_zone_free_block ( struct frame_zone_d *z, unsigned long i, int order ){
+	
+	unsigned long Buddy;
+	
+	while ( order < (FRAME_ORDER_COUNT -1) )
+	{
+		Buddy = z->base + ( (i - z->base) ^ (1 << order) );
+		
+		if ( Buddy + (1 << order) > z->base + z->count ){
+			break;
+		}
+		
+		if ( frameTable[Buddy].flags != FRAME_FREE || 
+		     frameTable[Buddy].order != order )
+		{
+			break;
+		}
+		
+		frame_zone_unlink ( z, Buddy );
+		
+		if ( Buddy < i ){
+			i = Buddy;
+		}
+		
+		order++;
+	};
+	
+	frame_zone_push ( z, i, order );
+}
+
+
+/*
+ * frame_zone_free_range:
+ *     Libera uma sequncia de frames, usando os maiores blocos 
+ * alinhados que cabem nela.
+ */
+
+static void 
+frame_zone_free_range ( struct frame_zone_d *z, 
+                        unsigned long first, 
+                        unsigned long count )
+{
+	unsigned long End = (first + count);
+	int order;
+	
+	while ( first < End )
+	{
+		order = (FRAME_ORDER_COUNT -1);
+		
+		while ( order > 0 )
+		{
+			if ( ( (first - z->base) & ((1 << order) -1) ) == 0 && 
+			     ( first + (1 << order) ) <= End )
+			{
+				break;
+			}
+			
+			order--;
+		};
+		
+		frame_zone_free_block ( z, first, order );
+		
+		z->free_count += (1 << order);
+		first += (1 << order);
+	};
+}
+
+
+static void 
+frame_zone_init ( int zone, 
+                  char *name, 
+                  unsigned long base, 
+                  unsigned long count, 
+                  unsigned long va )
+{
+	struct frame_zone_d *z;
+	unsigned long i;
+	int o;
+	
+	z = &frameZones[zone];
+	
+	z->used = 1;
+	z->magic = 1234;
+	z->name = name;
+	
+	z->base = base;
+	z->count = count;
+	z->va = va;
+	
+	for ( o=0; o < FRAME_ORDER_COUNT; o++ ){
+		z->free_list[o] = FRAME_NULL;
+	};
+	
+	z->free_count = 0;
+	z->alloc_count = 0;
+	z->fail_count = 0;
+	
+	if ( count == 0 ){
+		return;
+	}
+	
+	for ( i=base; i < (base + count); i++ ){
+		frameTable[i].flags = 0;
+	};
+	
+	frame_zone_free_range ( z, base, count );
+}
+
+
 /*
  * initializeFramesAlloc:
- *     Inicializa o framepool. */
+ *     Inicializa o alocador de frames.
+ *     Cria um descritor para cada frame da memria fsica e entrega 
+ * ao alocador os frames do paged pool e os frames acima de 32MB. 
+ */
 
 void initializeFramesAlloc (void){
 	
-	int Index;
-	struct page_d *p;
+	unsigned long Total;
+	unsigned long Pool;
+	unsigned long High;
+	unsigned long i;
 	
-	//
-	// Inicializando a lista de pages.
-	//
+	frameTable = NULL;
+	frameTableCount = 0;
 	
-	for ( Index=0; Index < PAGE_COUNT_MAX; Index++ )
-	{	
-	    pageAllocList[Index] = (unsigned long) 0;
-	};
+	// 'memorysizeTotal' est em KB.
+	Total = (unsigned long) (memorysizeTotal / 4);
 	
+	// O paged pool sempre existe.
+	// Os trs tipos de sistema usam o mesmo endereo fsico.
+	Pool = (unsigned long) (SMALLSYSTEM_PAGEDPOLL_START / PAGE_SIZE);
 	
-	//
-	// Criando o primeiro para testes.
-	//
+	if ( Total < (Pool + PAGE_COUNT_MAX) ){
+		Total = (Pool + PAGE_COUNT_MAX);
+	}
+	
+	if ( Total > FRAME_COUNT_MAX ){
+		Total = FRAME_COUNT_MAX;
+	}
 	
-	p = (void *) malloc ( sizeof( struct page_d ) );
+	frameTable = (void *) malloc ( Total * sizeof(struct frame_d) );
 	
-	if ( p == NULL )
+	if ( (void *) frameTable == NULL )
 	{
-		printf("initializeFramesAlloc:\n");
+		printf ("initializeFramesAlloc: frameTable\n");
 		return;
-		//goto done;
-	}else{
-		
-	    p->id = 0;
+	}
 	
-	    p->used = 1;
-	    p->magic = 1234;
+	frameTableCount = Total;
 	
-	    p->free = 0;  //not free
-	    p->next = NULL; 
-	    //...	
+	for ( i=0; i < Total; i++ )
+	{
+		frameTable[i].next = FRAME_NULL;
+		frameTable[i].prev = FRAME_NULL;
+		frameTable[i].order = 0;
+		frameTable[i].flags = FRAME_RESERVED;
+		frameTable[i].count = 0;
+		frameTable[i].ref_count = 0;
+	};
+	
+	// Paged pool. 
+	// Mapeado em XXXPAGEDPOOL_VA por SetUpPaging.
+	frame_zone_init ( FRAME_ZONE_POOL, "pool", Pool, PAGE_COUNT_MAX, 
+	    (unsigned long) XXXPAGEDPOOL_VA );
+	
+	// High memory.
+	High = (unsigned long) (FRAME_HIGH_START / PAGE_SIZE);
 	
-	    pageAllocList[0] = ( unsigned long ) p; 		
-	};	
+	if ( Total > High ){
+		frame_zone_init ( FRAME_ZONE_HIGH, "high", High, (Total - High), 0 );
+	}else{
+		frame_zone_init ( FRAME_ZONE_HIGH, "high", High, 0, 0 );
+	};
 }
 
 
-
 /*
  ***********************************************
- * allocPages:
- *
- * @param nmero de pginas contguas.
- * Obs: Pode ser que os pageframes no sejam 
- * contguos mas as pginas sero.
- * estamos usando uma page table toda j mapeada. 4MB.
- * @TODO: ESSA ROTINA EST INCOMPLETA ... REVISAR. #bugbug
- *
- * #bugbug: se estamos lidando com o endereo base vitual, ento estamos 
- * lidando com pginas pre alocadas e no pageframes.
+ * frameAllocate:
+ *     Aloca 'count' frames contguos de uma zona.
+ *     Pega o menor bloco livre de ordem suficiente, divide ele ao meio
+ * at chegar na ordem pedida e devolve os frames que sobram no fim.
+ *     Retorna o ndice do primeiro frame ou -1.
  */
 
-void *allocPages ( int size ){
+long frameAllocate ( int zone, int count ){
 	
-	int Index;
+	struct frame_zone_d *z;
+	unsigned long i;
+	int order;
+	int o;
 	
-	//pgina inicial da lista
-	struct page_d *Ret;   
+	if ( (void *) frameTable == NULL ){
+		return (long) -1;
+	}
 	
-	struct page_d *Conductor;
-	struct page_d *p;
+	if ( zone < 0 || zone >= FRAME_ZONE_COUNT ){
+		return (long) -1;
+	}
 	
-	//Esse  o endereo virtual do incio do pool de pageframes.
-	unsigned long base = (unsigned long) g_pagedpool_va;
+	z = &frameZones[zone];
 	
-	unsigned long va;
-    unsigned long pa;
+	if ( z->used != 1 || z->magic != 1234 ){
+		return (long) -1;
+	}
 	
-	int Count = 0;
+	if ( count <= 0 || count > (1 << (FRAME_ORDER_COUNT -1)) ){
+		return (long) -1;
+	}
 	
-	//
-	// Checando limites.
-	//
+	order = 0;
+	while ( (1 << order) < count ){
+		order++;
+	};
 	
-#ifdef MK_VERBOSE
-    printf("allocPageFrames: Initializing ...\n");	
-#endif
-
-	//problemas com o size.
-	if(size <= 0)
+	for ( o=order; o < FRAME_ORDER_COUNT; o++ )
 	{
-		//if debug
-		printf("allocPageFrames: size 0\n");
-		return NULL;
+		if ( z->free_list[o] != FRAME_NULL ){
+			break;
+		}
 	};
-			
-    //Se  pra alocar apenas uma pgina.
-	if (size == 1)
-	{		
-		return (void *) newPage ();	
-	}	
 	
-	//se o size for maior que o limite.
-    if ( size > PAGE_COUNT_MAX )
+	if ( o >= FRAME_ORDER_COUNT )
 	{
-		//if debug
-		printf("allocPageFrames: size limits\n");
-		goto fail;
+		z->fail_count++;
+		return (long) -1;
 	}
 	
+	i = z->free_list[o];
+	frame_zone_unlink ( z, i );
 	
-	//
-	// Isso encontra slots o suficiente para alocarmos tudo o que queremos.
-	//
+	// Split. 
+	// As metades de cima voltam para as listas.
+	while ( o > order )
+	{
+		o--;
+		frame_zone_push ( z, i + (1 << o), o );
+	};
 	
-	int Base;
+	z->free_count -= (1 << order);
 	
-	Base = firstSlotForAList (size);
+	// Devolve o que no foi pedido.
+	if ( count < (1 << order) ){
+		frame_zone_free_range ( z, i + count, (1 << order) - count );
+	}
 	
-	if ( Base == -1 )
+	// Uma referncia em cada frame. (framePut)
+	for ( o=1; o < count; o++ )
 	{
-		printf("Base = -1 \n");
-		goto fail;
-	}
+		frameTable[i + o].flags = FRAME_TAIL;
+		frameTable[i + o].prev = (unsigned short) i;
+		frameTable[i + o].ref_count = 1;
+	};
 	
-#ifdef MK_VERBOSE	
-    printf("allocPageFrames: for ...\n");		
-#endif 
- 
-	//comeamos a contar do frame logo aps o condutor.
+	frameTable[i].flags = FRAME_HEAD;
+	frameTable[i].order = (unsigned char) order;
+	frameTable[i].count = (unsigned short) count;
+	frameTable[i].prev = (unsigned short) i;
+	frameTable[i].next = (unsigned short) count;
+	frameTable[i].ref_count = 1;
 	
-	for (Index = Base; Index < (Base+size+1); Index++ )
+	z->alloc_count++;
+	
+	return (long) i;
+}
+
+
+/* 
+ * frame_release:
+ *     Devolve o bloco  sua zona.
+ *     Nenhum frame dele tem referncia.
+ */
+
+static void frame_release ( unsigned long head ){
+	
+	struct frame_zone_d *z;
+	unsigned long Count = frameTable[head].count;
+	unsigned long j;
+	int i;
+	
+	for ( i=0; i < FRAME_ZONE_COUNT; i++ )
 	{
-	    p = (void *) pageAllocList[Index];
-				
-		//Slot livre
-		if ( p == NULL )
+		z = &frameZones[i];
+		
+		if ( head >= z->base && head < (z->base + z->count) )
 		{
-			//#bugbug
-			//Isso pode esgotar o heap do kernel
-			
-			p = (void *) malloc ( sizeof( struct page_d ) );
-			
-			if ( p == NULL )
-			{
-				printf("allocPageFrames: 2\n");
-				goto fail;
+			for ( j=0; j < Count; j++ ){
+				frameTable[head + j].flags = 0;
 			};
 			
-			//printf("#");
-			p->id = Index;
-			
-			p->used = 1;
-			p->magic = 1234;
-			
-			//not free
-			p->free = 0;  
+			frame_zone_free_range ( z, head, Count );
+			return;
+		}
+	};
+}
 
-			//----
-			
-			p->locked = 0;
-			
-			//contador de referncias
-			p->ref_count = 1;	
-			
-			//pegando o endereo virtual.
-			va = (unsigned long) ( base + (p->id * 4096) );    
-			pa = (unsigned long) virtual_to_physical ( va, gKernelPageDirectoryAddress ); 
-			
+
+/*
+ * frameGet:
+ *     Mais uma referncia para o frame. (COW)
+ *     Um frame que o alocador no controla (imagens do boot) tem 
+ * uma referncia, a do seu dono, quando  compartilhado pela 
+ * primeira vez.
+ */
+
+void frameGet ( unsigned long frame ){
 	
-			if ( ( pa % PAGE_SIZE) != 0 ) 
-			{		
-			    pa = pa - ( pa % PAGE_SIZE);			
-			}	 	
-			
-			p->frame_number = (pa / PAGE_SIZE);
-			
-			if ( pa == 0 )
-			{
-			    p->frame_number = 0;
-			}
-			
-			//---
-			
-			pageAllocList[Index] = ( unsigned long ) p; 
-			
-			Conductor->next = (void *) p;
-			Conductor = (void *) Conductor->next;
-			
-			Count++;
-			if( Count >= size )
-			{
-				Ret = (void *) pageAllocList[Base];
-			    goto done;	
-			}	
-		};
+	struct frame_d *f;
+	
+	if ( (void *) frameTable == NULL || frame >= frameTableCount ){
+		return;
+	}
+	
+	f = &frameTable[frame];
+	
+	if ( f->flags == FRAME_HEAD || f->flags == FRAME_TAIL )
+	{
+		// J liberado pelo dono.
+		if ( f->ref_count == 0 ){
+			return;
+		}
+		
+	}else{
+		
+		if ( f->ref_count == 0 ){
+			f->ref_count = 1;
+		}
 	};
 	
-fail:
-    printf("allocPageFrames: fail \n");		
-    return NULL;	
-done:
-    //printf("allocPageFrames: done ...\n");	
-    
-	//*Importante:
-	//retornaremos o endereo virtual inicial do primeiro pageframe da lista.
-	return (void *) ( base + (Ret->id * 4096) );
+	f->ref_count++;
 }
 
 
-//checar se a estrutura de p'agina  nula
-int pEmpty (struct page_d *p){
+/*
+ * framePut:
+ *     Uma referncia a menos.
+ *     O bloco volta para a zona quando todos os seus frames chegam 
+ * a zero. Os frames que o alocador no controla nunca so liberados.
+ */
+
+void framePut ( unsigned long frame ){
 	
-    return p == NULL ? 1 : 0;
-};
+	struct frame_d *f;
+	unsigned long Head;
+	
+	if ( (void *) frameTable == NULL || frame >= frameTableCount ){
+		return;
+	}
+	
+	f = &frameTable[frame];
+	
+	if ( f->ref_count == 0 ){
+		return;
+	}
+	
+	f->ref_count--;
+	
+	if ( f->ref_count > 0 ){
+		return;
+	}
+	
+	if ( f->flags != FRAME_HEAD && f->flags != FRAME_TAIL ){
+		return;
+	}
+	
+	Head = (unsigned long) f->prev;
+	
+	frameTable[Head].next--;
+	
+	if ( frameTable[Head].next == 0 ){
+		frame_release (Head);
+	}
+}
 
 
-//selecionar a pgina como livre.
-void freePage (struct page_d *p){
+/*
+ * frameFree:
+ *     Libera os frames alocados por frameAllocate.
+ *     'frame'  o primeiro frame da alocao.
+ *      uma referncia a menos em cada frame, os que ainda so 
+ * compartilhados (COW) seguram o bloco. (framePut)
+ */
+
+void frameFree ( unsigned long frame ){
 	
-	if (p == NULL){
-		return;  //fail	
+	unsigned long Count;
+	unsigned long i;
+	
+	if ( (void *) frameTable == NULL || frame >= frameTableCount ){
+		return;
 	}
-	    
-    if( p->used == 1 && p->magic == 1234 )
+	
+	if ( frameTable[frame].flags != FRAME_HEAD ){
+		return;
+	}
+	
+	Count = frameTable[frame].count;
+	
+	for ( i=0; i < Count; i++ ){
+		framePut ( frame + i );
+	};
+}
+
+
+/*
+ * allocPhysicalFrames:
+ *     Aloca frames contguos para uso fora do kernel. (page tables, 
+ * imagens de processos ...)
+ *     Usa a memria alta primeiro, e o paged pool se ela acabar.
+ *     Retorna o endereo fsico ou 0.
+ */
+
+unsigned long allocPhysicalFrames ( int count ){
+	
+	long Frame;
+	
+	Frame = frameAllocate ( FRAME_ZONE_HIGH, count );
+	
+	if ( Frame == -1 ){
+		Frame = frameAllocate ( FRAME_ZONE_POOL, count );
+	}
+	
+	if ( Frame == -1 ){
+		return (unsigned long) 0;
+	}
+	
+	return (unsigned long) (Frame * PAGE_SIZE);
+}
+
+
+void freePhysicalFrames ( unsigned long pa ){
+	
+	frameFree ( pa / PAGE_SIZE );
+}
+
+
+/*
+ * mapPhysicalFrames:
+ *     Mapeia frames contguos na janela KMAP_VA, para o kernel 
+ * acessar a memria alta. (preencher uma pgina, copiar, surfaces)
+ *     Uma entrada livre da tabela vale 0.
+ *     Retorna o endereo virtual ou NULL se a janela est cheia.
+ */
+
+void *mapPhysicalFrames ( unsigned long pa, int count ){
+	
+	unsigned long *kmap_page_table = (unsigned long *) PAGETABLE_KMAP; //0x00080000
+	unsigned long Flags;
+	int First = -1;
+	int Free = 0;
+	int i;
+	
+	if ( pa == 0 || (pa % PAGE_SIZE) != 0 ){
+		return NULL;
+	}
+	
+	if ( count <= 0 || count > KMAP_PAGES ){
+		return NULL;
+	}
+	
+	Flags = spinLockIrqSave (&kmap_spinlock);
+	
+	for ( i=0; i < KMAP_PAGES; i++ )
+	{
+		if ( kmap_page_table[i] != 0 )
+		{
+			Free = 0;
+			continue;
+		}
+		
+		Free++;
+		
+		if ( Free == count )
+		{
+			First = (i - count +1);
+			break;
+		}
+	};
+	
+	if ( First == -1 )
+	{
+		kmap_fail_count++;
+		spinUnlockIrqRestore ( &kmap_spinlock, Flags );
+		return NULL;
+	}
+	
+	for ( i=0; i < count; i++ ){
+		kmap_page_table[First + i] = (unsigned long) ( pa + (i * PAGE_SIZE) ) | 3;
+	};
+	
+	kmap_count[First] = (unsigned short) count;
+	kmap_pages_used += count;
+	
+	spinUnlockIrqRestore ( &kmap_spinlock, Flags );
+	
+	return (void *) ( KMAP_VA + (First * PAGE_SIZE) );
+}
+
+
+/*
+ * unmapPhysicalFrames:
+ *     Desfaz o mapeamento feito por mapPhysicalFrames.
+ *     Os frames no so liberados.
+ *     Retorna o endereo fsico do primeiro frame ou 0.
+ */
+
+unsigned long unmapPhysicalFrames ( void *va ){
+	
+	unsigned long *kmap_page_table = (unsigned long *) PAGETABLE_KMAP; //0x00080000
+	unsigned long Address = (unsigned long) va;
+	unsigned long PhysicalAddress;
+	unsigned long Flags;
+	int First;
+	int Count;
+	int i;
+	
+	if ( Address < KMAP_VA || Address >= ( KMAP_VA + (KMAP_PAGES * PAGE_SIZE) ) ){
+		return (unsigned long) 0;
+	}
+	
+	if ( (Address % PAGE_SIZE) != 0 ){
+		return (unsigned long) 0;
+	}
+	
+	First = (int) ( (Address - KMAP_VA) / PAGE_SIZE );
+	
+	Flags = spinLockIrqSave (&kmap_spinlock);
+	
+	Count = (int) kmap_count[First];
+	
+	if ( Count == 0 || (kmap_page_table[First] & 1) == 0 )
 	{
-	    p->free = 1;
-	}		
+		spinUnlockIrqRestore ( &kmap_spinlock, Flags );
+		return (unsigned long) 0;
+	}
+	
+	PhysicalAddress = (kmap_page_table[First] & 0xFFFFF000);
+	
+	for ( i=0; i < Count; i++ )
+	{
+		kmap_page_table[First + i] = 0;
+		asm volatile ( "invlpg (%0)" : : "r" (Address + (i * PAGE_SIZE)) : "memory" );
+	};
+	
+	kmap_count[First] = 0;
+	kmap_pages_used -= Count;
+	
+	spinUnlockIrqRestore ( &kmap_spinlock, Flags );
+	
+	return (unsigned long) PhysicalAddress;
+}
+
+
+/*
+ * allocHighPages:
+ *     Pginas contguas da memria alta, mapeadas na janela.
+ *     (allocPhysicalFrames + mapPhysicalFrames)
+ *     Retorna o endereo virtual ou NULL.
+ */
+
+void *allocHighPages ( int count ){
+	
+	unsigned long PhysicalAddress;
+	void *Address;
+	
+	PhysicalAddress = (unsigned long) allocPhysicalFrames (count);
+	
+	if ( PhysicalAddress == 0 ){
+		return NULL;
+	}
+	
+	Address = (void *) mapPhysicalFrames ( PhysicalAddress, count );
+	
+	if ( (void *) Address == NULL ){
+		freePhysicalFrames (PhysicalAddress);
+		return NULL;
+	}
+	
+	return (void *) Address;
 }
 
 
-//selecionar a pgina como no livre.
-void notfreePage (struct page_d *p){
+/* Libera as pginas alocadas por allocHighPages. */
+
+void freeHighPages ( void *va ){
 	
-	if(p == NULL){
-		return;  //fail	
+	unsigned long PhysicalAddress;
+	
+	PhysicalAddress = (unsigned long) unmapPhysicalFrames (va);
+	
+	if ( PhysicalAddress != 0 ){
+		freePhysicalFrames (PhysicalAddress);
 	}
-	    
-	//check
-    if( p->used == 1 && p->magic == 1234 )
+}
+
+
+/*
+ ***********************************************
+ * allocPages:
+ *
+ * @param nmero de pginas contguas.
+ *     As pginas vem do paged pool, que est todo mapeado no kernel.
+ *     Os frames tambm so contguos. 
+ *     Retorna o endereo virtual da primeira pgina.
+ */
+
+void *allocPages ( int size ){
+	
+	struct frame_zone_d *z;
+	long Frame;
+	
+	//problemas com o size.
+	if ( size <= 0 )
 	{
-	    p->free = 0;
-	}		
+		printf ("allocPages: size 0\n");
+		return NULL;
+	};
+	
+	//se o size for maior que o limite.
+	if ( size > PAGE_COUNT_MAX )
+	{
+		printf ("allocPages: size limits\n");
+		return NULL;
+	}
+	
+	z = &frameZones[FRAME_ZONE_POOL];
+	
+	Frame = frameAllocate ( FRAME_ZONE_POOL, size );
+	
+	if ( Frame == -1 )
+	{
+		printf ("allocPages: fail\n");
+		return NULL;
+	}
+	
+	//*Importante:
+	//retornaremos o endereo virtual inicial da primeira pgina.
+	return (void *) ( z->va + ( (Frame - z->base) * PAGE_SIZE ) );
 }
 
 
 /*
- ***************************************************************
- * firstSlotForAList:
- *     Retorna o primeiro ndice de uma sequncia de slots livres 
- * em pageAllocList[].
+ * freePage:
+ *     Libera as pginas alocadas por allocPages ou newPage.
+ *     'va'  o endereo retornado por eles.
  */
 
-int firstSlotForAList ( int size ){
+void freePage (void *va){
 	
-	int Index;
-	int Base = 0;
-	int Count = 0;
-    void *slot;
+	struct frame_zone_d *z;
+	unsigned long Address = (unsigned long) va;
+	
+	z = &frameZones[FRAME_ZONE_POOL];
+	
+	if ( z->used != 1 || z->magic != 1234 ){
+		return;
+	}
 	
-tryAgain:
+	if ( Address < z->va || Address >= ( z->va + (z->count * PAGE_SIZE) ) ){
+		return;
+	}
 	
-	for ( Index=Base; Index < 1024; Index++ )
+	if ( (Address % PAGE_SIZE) != 0 ){
+		return;
+	}
+	
+	frameFree ( z->base + ( (Address - z->va) / PAGE_SIZE ) );
+}
+
+
+/*
+ * frameShowInfo:
+ *     Mostra as zonas e os blocos livres de cada ordem.
+ */
+
+void frameShowInfo (void){
+	
+	struct frame_zone_d *z;
+	unsigned short f;
+	int Blocks;
+	int i;
+	int o;
+	
+	printf ("\n[Frames:] total={%d} \n", frameTableCount );
+	
+	for ( i=0; i < FRAME_ZONE_COUNT; i++ )
 	{
-	    slot = (void *) pageAllocList[Index];
+		z = &frameZones[i];
 		
-		if ( (void *) slot != NULL )
-		{
-			Base = Base+Count;
-			Base++;
-			Count = 0;
-			goto tryAgain;			
+		if ( z->used != 1 || z->magic != 1234 ){
+			continue;
 		}
 		
-		Count++; 
+		printf ("%s: pa={%x} frames={%d} free={%d} allocs={%d} fails={%d}\n", 
+		    z->name, (z->base * PAGE_SIZE), z->count, z->free_count, 
+			z->alloc_count, z->fail_count );
 		
-		if (Count >= size){
-			return (int) Base;
-		}
+		printf ("free blocks:");
+		
+		for ( o=0; o < FRAME_ORDER_COUNT; o++ )
+		{
+			Blocks = 0;
+			f = z->free_list[o];
+			
+			while ( f != FRAME_NULL )
+			{
+				Blocks++;
+				f = frameTable[f].next;
+			};
+			
+			printf (" %d", Blocks );
+		};
+		
+		printf ("\n");
 	};
 	
-    return (int) -1;		
+	printf ("kmap: va={%x} pages={%d} used={%d} fails={%d}\n", 
+	    KMAP_VA, KMAP_PAGES, kmap_pages_used, kmap_fail_count );
 }
 
 
@@ -0,0 +1,491 @@
+/*
+ * File: mm/x86/slab.c
+ *
+ *     Slab allocator for the kernel heap.
+ *
+ *     Each cache hands out objects of a single size. The objects live in
+ * 4KB pages taken from the kernel heap, SLAB_GROW_PAGES at a time, and a
+ * free object is linked in the free list of its page using its own first
+ * word. Freeing an object puts it back in its page, and a page with no
+ * objects in use goes back to the list of free pages, where any cache can
+ * take it again.
+ *
+ *     malloc() uses the size caches for requests up to SLAB_SIZE_MAX.
+ * The kernel structures have their own caches.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+static unsigned long slab_size_classes[SLAB_SIZE_CLASS_COUNT] = {
+    16, 32, 64, 128, 256, 512, 1024, 2048
+};
+
+static char *slab_size_names[SLAB_SIZE_CLASS_COUNT] = {
+    "size-16", "size-32", "size-64", "size-128",
+	"size-256", "size-512", "size-1024", "size-2048"
+};
+
+
+/*
+ * slab_page_of:
+ *     The descriptor of the page that contains the address.
+ *     Return NULL if the address is not in the kernel heap.
+ */
+
+static struct slab_page_d *slab_page_of ( unsigned long address ){
+
+	unsigned long Index;
+
+	if ( address < KERNEL_HEAP_START || address >= KERNEL_HEAP_END ){
+		return NULL;
+	}
+
+	Index = (address - KERNEL_HEAP_START) / SLAB_PAGE_SIZE;
+
+	if ( Index >= SLAB_PAGE_COUNT_MAX ){
+		return NULL;
+	}
+
+	return (struct slab_page_d *) &slabPageTable[Index];
+}
+
+
+/*
+ * slab_grow:
+ *     Take SLAB_GROW_PAGES pages from the kernel heap and put them
+ * in the list of free pages.
+ *     The area is aligned to 4KB, so each page has its own descriptor.
+ */
+
+static int slab_grow (void){
+
+	unsigned long Area;
+	unsigned long Page;
+	struct slab_page_d *p;
+	int i;
+
+	Area = (unsigned long) heapAllocateMemory ( (SLAB_GROW_PAGES +1) * SLAB_PAGE_SIZE );
+
+	if ( Area == 0 ){
+		return (int) 1;
+	}
+
+	// Align.
+	Page = (Area + (SLAB_PAGE_SIZE -1)) & ~(SLAB_PAGE_SIZE -1);
+
+	for ( i=0; i < SLAB_GROW_PAGES; i++ )
+	{
+		p = slab_page_of (Page);
+
+		if ( (void *) p != NULL )
+		{
+			p->cache = NULL;
+			p->va = Page;
+			p->freelist = NULL;
+			p->inuse = 0;
+
+			p->prev = NULL;
+			p->next = slabFreePages;
+			slabFreePages = p;
+			slabFreePagesCount++;
+		}
+
+		Page = Page + SLAB_PAGE_SIZE;
+	};
+
+	return (int) 0;
+}
+
+
+/*
+ * slab_page_attach:
+ *     Give a free page to a cache and build the free list of objects.
+ */
+
+static struct slab_page_d *slab_page_attach ( struct slab_cache_d *cache ){
+
+	struct slab_page_d *p;
+	unsigned long Object;
+	int i;
+
+	if ( (void *) slabFreePages == NULL )
+	{
+		if ( slab_grow () != 0 ){
+			return NULL;
+		}
+	}
+
+	p = slabFreePages;
+	slabFreePages = p->next;
+	slabFreePagesCount--;
+
+	p->cache = cache;
+	p->inuse = 0;
+	p->freelist = NULL;
+
+	// Link the objects, the first one at the head of the list.
+	Object = p->va + ( (cache->objs_per_page -1) * cache->objsize );
+
+	for ( i=0; i < cache->objs_per_page; i++ )
+	{
+		*(unsigned long *) Object = (unsigned long) p->freelist;
+		p->freelist = (void *) Object;
+		Object = Object - cache->objsize;
+	};
+
+	// Partial list.
+	p->prev = NULL;
+	p->next = cache->partial;
+	if ( (void *) cache->partial != NULL ){
+		cache->partial->prev = p;
+	}
+	cache->partial = p;
+
+	cache->pages++;
+
+	return (struct slab_page_d *) p;
+}
+
+
+/* Take the page out of the partial list of its cache. */
+
+static void slab_partial_remove ( struct slab_page_d *p ){
+
+	if ( (void *) p->prev != NULL ){
+		p->prev->next = p->next;
+	}else{
+		p->cache->partial = p->next;
+	};
+
+	if ( (void *) p->next != NULL ){
+		p->next->prev = p->prev;
+	}
+
+	p->prev = NULL;
+	p->next = NULL;
+}
+
+
+/*
+ **************************************************
+ * slabCreateCache:
+ *     Create a cache for objects of the given size.
+ */
+
+struct slab_cache_d *slabCreateCache ( char *name, unsigned long size ){
+
+	struct slab_cache_d *c;
+	int i;
+
+	if ( size == 0 || size > SLAB_SIZE_MAX ){
+		return NULL;
+	}
+
+	for ( i=0; i < SLAB_CACHE_COUNT_MAX; i++ )
+	{
+		if ( slabCacheList[i] == 0 )
+		{
+			c = (void *) heapAllocateMemory ( sizeof(struct slab_cache_d) );
+
+			if ( (void *) c == NULL ){
+				return NULL;
+			}
+
+			c->used = 1;
+			c->magic = 1234;
+			c->name = name;
+
+			// Room for the free list link and 4 byte alignment.
+			if ( size < sizeof(unsigned long) ){
+				size = sizeof(unsigned long);
+			}
+			c->objsize = (size + 3) & ~3;
+			c->objs_per_page = (int) (SLAB_PAGE_SIZE / c->objsize);
+
+			c->partial = NULL;
+
+			c->pages = 0;
+			c->inuse = 0;
+			c->alloc_count = 0;
+			c->free_count = 0;
+			c->grow_count = 0;
+
+			slabCacheList[i] = (unsigned long) c;
+
+			return (struct slab_cache_d *) c;
+		}
+	};
+
+	return NULL;
+}
+
+
+/*
+ **************************************************
+ * slabAllocate:
+ *     Get an object from the cache.
+ *     Return NULL if the cache is not valid or if there is no more heap
+ * for a new page.
+ */
+
+void *slabAllocate ( struct slab_cache_d *cache ){
+
+	struct slab_page_d *p;
+	void *Object;
+
+	if ( (void *) cache == NULL || slab_initialized != 1 ){
+		return NULL;
+	}
+
+	if ( cache->used != 1 || cache->magic != 1234 ){
+		return NULL;
+	}
+
+	p = cache->partial;
+
+	if ( (void *) p == NULL )
+	{
+		cache->grow_count++;
+
+		p = slab_page_attach (cache);
+
+		if ( (void *) p == NULL ){
+			return NULL;
+		}
+	}
+
+	Object = p->freelist;
+	p->freelist = (void *) *(unsigned long *) Object;
+	p->inuse++;
+
+	// Full page, it leaves the partial list.
+	if ( (void *) p->freelist == NULL ){
+		slab_partial_remove (p);
+	}
+
+	cache->inuse++;
+	cache->alloc_count++;
+
+	return (void *) Object;
+}
+
+
+/*
+ **************************************************
+ * slabAllocateSize:
+ *     Get an object from the smallest size class that fits.
+ *     Return NULL if the size is too big for the slab.
+ */
+
+void *slabAllocateSize ( unsigned long size ){
+
+	int i;
+
+	if ( slab_initialized != 1 ){
+		return NULL;
+	}
+
+	for ( i=0; i < SLAB_SIZE_CLASS_COUNT; i++ )
+	{
+		if ( size <= slab_size_classes[i] ){
+			return (void *) slabAllocate ( slabSizeCache[i] );
+		}
+	};
+
+	return NULL;
+}
+
+
+/*
+ * slabOwns:
+ *     1 if the address is an object of some cache.
+ */
+
+int slabOwns ( void *ptr ){
+
+	struct slab_page_d *p;
+
+	if ( slab_initialized != 1 ){
+		return (int) 0;
+	}
+
+	p = slab_page_of ( (unsigned long) ptr );
+
+	if ( (void *) p == NULL || (void *) p->cache == NULL ){
+		return (int) 0;
+	}
+
+	return (int) 1;
+}
+
+
+/*
+ **************************************************
+ * slabFree:
+ *     Give the object back to its cache.
+ *     A page with no objects in use goes back to the free pages.
+ */
+
+void slabFree ( void *ptr ){
+
+	struct slab_page_d *p;
+	struct slab_cache_d *c;
+
+	p = slab_page_of ( (unsigned long) ptr );
+
+	if ( (void *) p == NULL || (void *) p->cache == NULL ){
+		return;
+	}
+
+	c = p->cache;
+
+	// The address needs to be the start of an object.
+	if ( ( ((unsigned long) ptr - p->va) % c->objsize ) != 0 ){
+		return;
+	}
+
+	if ( p->inuse <= 0 ){
+		return;
+	}
+
+	// It was full, so it is not in the partial list.
+	if ( (void *) p->freelist == NULL )
+	{
+		p->prev = NULL;
+		p->next = c->partial;
+		if ( (void *) c->partial != NULL ){
+			c->partial->prev = p;
+		}
+		c->partial = p;
+	}
+
+	*(unsigned long *) ptr = (unsigned long) p->freelist;
+	p->freelist = ptr;
+	p->inuse--;
+
+	c->inuse--;
+	c->free_count++;
+
+	// Empty page. Give it back.
+	if ( p->inuse == 0 )
+	{
+		slab_partial_remove (p);
+
+		p->cache = NULL;
+		p->freelist = NULL;
+
+		p->next = slabFreePages;
+		slabFreePages = p;
+		slabFreePagesCount++;
+
+		c->pages--;
+	}
+}
+
+
+/*
+ **************************************************
+ * slabShowInfo:
+ *     Show the counters of all the caches.
+ *     'hit' is the percentage of allocations served without a new page.
+ *     'waste' is the space of the pages not used by objects.
+ */
+
+void slabShowInfo (void){
+
+	struct slab_cache_d *c;
+	unsigned long Hit;
+	unsigned long Waste;
+	int i;
+
+	printf ("\n[Slab caches:]\n");
+	printf ("name       objsize pages inuse allocs frees hit%% waste\n");
+
+	for ( i=0; i < SLAB_CACHE_COUNT_MAX; i++ )
+	{
+		c = (void *) slabCacheList[i];
+
+		if ( (void *) c == NULL ){
+			continue;
+		}
+
+		if ( c->used != 1 || c->magic != 1234 ){
+			continue;
+		}
+
+		Hit = 0;
+		if ( c->alloc_count != 0 ){
+			Hit = ( (c->alloc_count - c->grow_count) * 100 ) / c->alloc_count;
+		}
+
+		Waste = (c->pages * SLAB_PAGE_SIZE) - (c->inuse * c->objsize);
+
+		printf ("%s %d %d %d %d %d %d %dB\n", c->name, c->objsize,
+		    c->pages, c->inuse, c->alloc_count, c->free_count,
+			Hit, Waste );
+	};
+
+	printf ("Free slab pages={%d} \n", slabFreePagesCount );
+}
+
+
+/*
+ **************************************************
+ * slabInit:
+ *     Create the size caches and the caches of the kernel structures.
+ *     Called by init_heap.
+ */
+
+int slabInit (void){
+
+	int i;
+
+	slab_initialized = 0;
+
+	slabFreePages = NULL;
+	slabFreePagesCount = 0;
+
+	for ( i=0; i < SLAB_PAGE_COUNT_MAX; i++ )
+	{
+		slabPageTable[i].cache = NULL;
+		slabPageTable[i].va = 0;
+		slabPageTable[i].freelist = NULL;
+		slabPageTable[i].inuse = 0;
+		slabPageTable[i].prev = NULL;
+		slabPageTable[i].next = NULL;
+	};
+
+	for ( i=0; i < SLAB_CACHE_COUNT_MAX; i++ ){
+		slabCacheList[i] = (unsigned long) 0;
+	};
+
+	for ( i=0; i < SLAB_SIZE_CLASS_COUNT; i++ )
+	{
+		slabSizeCache[i] = slabCreateCache ( slab_size_names[i],
+		                       slab_size_classes[i] );
+
+		if ( (void *) slabSizeCache[i] == NULL ){
+			printf ("slabInit: size cache\n");
+			return (int) 1;
+		}
+	};
+
+	thread_cache = slabCreateCache ( "thread_d", sizeof(struct thread_d) );
+	process_cache = slabCreateCache ( "process_d", sizeof(struct process_d) );
+	window_cache = slabCreateCache ( "window_d", sizeof(struct window_d) );
+
+	slab_initialized = 1;
+
+	return (int) 0;
+}
+
+
+//
+// End.
+//
+
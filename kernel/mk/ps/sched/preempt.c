@@ -64,6 +64,7 @@ void preempt (void){
 			if ( t->tid != 0 && t->priority == PRIORITY_LOW )
 			{
 		        t->state = READY;  
+				readyq_insert (t);
             }
             //Nothing.			
 	    };
@@ -64,7 +64,6 @@
 
 struct thread_d *pick_next_thread (void){
 	
-	int i;    //id da fila selecionada
 	int old;  //salva id da current thread
 	
 	struct thread_d *t;
@@ -75,50 +74,14 @@ struct thread_d *pick_next_thread (void){
 	old = next_thread;	
 	
 	
-	//se temos um ponteiro para fila de drivers.
+	// The first READY thread of the highest priority ready queue.
+	// If all the queues are empty we use the idle thread, until some
+	// thread wakes up and goes to a queue. (schedi.c)
 	
-    if ( QUEUES[0] != 0 ){
+	t = readyq_highest ();
 	
-		i = 0;
-		
-	//se temos um ponteiro para a fila de servidores.
-		
-	} else if ( QUEUES[1] != 0 ){
-	
-		i = 1;
-		
-		//nos resta a fila de apps de usurio.	
-	}else{
-	
-	    i = 2;
-	};
-	
-
-	
-	//
-	// # Checando o conductor. #
-	//
-	
-	//se o elemento tem um valor no nulo..
-    if (QUEUES[i] != 0)
+	if ( (void *) t == NULL )
 	{
-	    //Ok temos uma fila.
-		//vamos pegar a primeira thread da fila.
-		
-		t = (void *) QUEUES[i];
-				
-	}else{
-	
-		// nenhuma thread est'a no estado de READY ... entao nenhuma das
-		// filas foi construida.
-		// nos reata usarmos a thread idle. 
-		
-		//podemos fica nessa condi~ao at'e que uma thread seja acordada ...
-		//talvez ela esteja esperando alguma recurso,.
-		//quando ela acordar ir'a pra alguma fila.
-		
-		//selecionamos a idle.
-		
 		t = IdleThread;
 	};
 	
@@ -220,7 +183,9 @@ struct thread_d *pick_next_thread (void){
 int scheduler (void){
 	
 	int Index;
+	unsigned long bits;
 	struct thread_d *Thread;
+	unsigned long Flags;
 	
 #ifdef SERIAL_DEBUG_VERBOSE		
 	debug_print(" [*SCHEDULER*] ");
@@ -335,11 +300,20 @@ int scheduler (void){
  // printf ("scheduler: 5\n");
 	
 	//READY.
-	for ( Index=0; Index < THREAD_COUNT_MAX; Index++ )
+	// Walk only the ready queues, from the highest priority level 
+	// down, instead of all the slots in threadList[].
+	
+	Flags = readyq_lock ();
+	
+	bits = readyq.bitmap;
+	
+	while ( bits != 0 )
 	{
-		Thread = (void *) threadList[Index];
+		asm ("bsrl %1, %0" : "=r" (Index) : "rm" (bits) );
+		
+		Thread = readyq.head[Index];
 		
-		if ( (void *) Thread != NULL )
+		while ( (void *) Thread != NULL )
 		{
 			if ( Thread->used == 1 && 
 			     Thread->magic == 1234 && 
@@ -348,10 +322,14 @@ int scheduler (void){
 			    Conductor2 = (void *) Conductor2->Next; 
 				Conductor2->Next = (void *) Thread;
 			};
-		    //Nothing.
+			
+			Thread = Thread->rq_next;
 		};
-		//Nothing.
-	};	
+		
+		bits &= ~( (unsigned long) (1 << Index) );
+	};
+	
+	readyq_unlock (Flags);
 
 
 	//
@@ -445,6 +423,8 @@ void init_scheduler (void)
 	// @todo: Implementar inicializao de variaveis do scheduler.
 	//        O nome poderia ser schedulerInit().
 	//        Formato de classes.Init  um mtodo. 
+
+	readyq_init ();
 };
 
 
@@ -187,6 +187,23 @@ int wakeup_thread_reason ( int tid, int reason ){
 					    KiDoThreadRunning (tid);
 					}
 					break;
+				
+				// O Up de um semforo entregou o recurso para ela,
+				// ou o semforo foi destrudo. (ipc/sem.c)
+				case WAIT_REASON_SEMAPHORE:
+				    t->wait_reason[reason] = 0;
+					if ( t->state == BLOCKED ){
+					    do_thread_ready (tid);
+					}
+					break;
+				
+				// O deadline passou. (timer.c)
+				case WAIT_REASON_SLEEP:
+				    t->wait_reason[reason] = 0;
+					if ( t->state == BLOCKED ){
+					    do_thread_ready (tid);
+					}
+					break;
 			    
                 // ...				
 			}
@@ -493,6 +510,7 @@ void do_thread_ready (int id){
 		//if ( t->used == 1 && t->magic == 1234 )
 			
 	    t->state = READY;
+		readyq_insert (t);
 	}
 };
 
@@ -513,6 +531,7 @@ void do_thread_running (int id){
 		if ( t->used == 1 && t->magic == 1234 )
 		{
 		    t->state = RUNNING;	
+			readyq_insert (t);
 		}
 	};
 };
@@ -537,6 +556,7 @@ void do_thread_sleeping (int id){
 	
 	if ( (void *) t != NULL){
 	    t->state = BLOCKED;
+		readyq_remove (t);
     }	
 };
 
@@ -560,6 +580,7 @@ void do_thread_zombie (int id){
 		if ( id != IDLE )
 		{
             t->state = ZOMBIE;
+			readyq_remove (t);
         }
     };
 };
@@ -579,6 +600,7 @@ void do_thread_dead (int id){
 	if ( (void *) t != NULL )
 	{
 	    t->state = DEAD;
+		readyq_remove (t);
 	}
 };
 
@@ -847,6 +869,242 @@ int check_quantum (void){
 };
 
 
+
+//
+// ## Ready queues ##
+//
+
+// Ready queues, one per priority level.
+// Each thread carries its own links (rq_next/rq_prev), so inserting,
+// removing and picking the next thread do not depend on how many
+// threads exist. The bitmap says which queues are not empty.
+// Only the BSP runs threads, (smp.h) there is one set of queues,
+// protected by readyq_spinlock.
+
+
+static spinlock_t readyq_spinlock;
+
+
+unsigned long readyq_lock (void){
+	
+	return (unsigned long) spinLockIrqSave ( &readyq_spinlock );
+};
+
+
+void readyq_unlock ( unsigned long flags ){
+	
+	spinUnlockIrqRestore ( &readyq_spinlock, flags );
+};
+
+
+/*
+ * readyq_init:
+ *     Empty all the queues. Called by init_scheduler().
+ */
+
+void readyq_init (void){
+	
+	int i;
+	
+	for ( i=0; i < READYQ_COUNT; i++ )
+	{
+		readyq.head[i] = NULL;
+		readyq.tail[i] = NULL;
+	};
+	
+	readyq.bitmap = 0;
+	readyq.count = 0;
+	
+	spinLockInit (&readyq_spinlock);
+};
+
+
+/*
+ * readyq_level:
+ *     Queue level for the thread's dynamic priority.
+ */
+
+static int readyq_level (struct thread_d *t){
+	
+	if ( t->priority >= READYQ_COUNT ){
+		return (int) (READYQ_COUNT -1);
+	}
+	
+	return (int) t->priority;
+};
+
+
+/* Link/unlink. The caller holds the lock. */
+
+static void readyq_link (struct thread_d *t){
+	
+	int level;
+	
+	level = readyq_level (t);
+	
+	t->rq_priority = level;
+	t->rq_next = NULL;
+	t->rq_prev = readyq.tail[level];
+	
+	if ( (void *) readyq.tail[level] != NULL )
+	{
+		readyq.tail[level]->rq_next = t;
+	}else{
+		readyq.head[level] = t;
+	};
+	
+	readyq.tail[level] = t;
+	
+	readyq.bitmap |= (unsigned long) (1 << level);
+	
+	t->rq_queued = 1;
+	readyq.count++;
+};
+
+
+static void readyq_unlink (struct thread_d *t){
+	
+	int level;
+	
+	level = t->rq_priority;
+	
+	if ( (void *) t->rq_prev != NULL )
+	{
+		t->rq_prev->rq_next = t->rq_next;
+	}else{
+		readyq.head[level] = t->rq_next;
+	};
+	
+	if ( (void *) t->rq_next != NULL )
+	{
+		t->rq_next->rq_prev = t->rq_prev;
+	}else{
+		readyq.tail[level] = t->rq_prev;
+	};
+	
+	if ( (void *) readyq.head[level] == NULL )
+	{
+		readyq.bitmap &= ~( (unsigned long) (1 << level) );
+	}
+	
+	t->rq_next = NULL;
+	t->rq_prev = NULL;
+	t->rq_queued = 0;
+	readyq.count--;
+};
+
+
+/*
+ * readyq_insert:
+ *     Put the thread at the tail of its priority queue.
+ *     Do nothing if it is already queued.
+ */
+
+void readyq_insert (struct thread_d *t){
+	
+	unsigned long Flags;
+	
+	if ( (void *) t == NULL ){
+		return;
+	}
+	
+	if ( t->used != 1 || t->magic != 1234 ){
+		return;
+	}
+	
+	Flags = readyq_lock ();
+	
+	if ( t->rq_queued != 1 ){
+		readyq_link (t);
+	}
+	
+	readyq_unlock (Flags);
+};
+
+
+/*
+ * readyq_remove:
+ *     Take the thread out of its queue.
+ */
+
+void readyq_remove (struct thread_d *t){
+	
+	unsigned long Flags;
+	
+	if ( (void *) t == NULL ){
+		return;
+	}
+	
+	Flags = readyq_lock ();
+	
+	if ( t->rq_queued == 1 ){
+		readyq_unlink (t);
+	}
+	
+	readyq_unlock (Flags);
+};
+
+
+/*
+ * readyq_requeue:
+ *     Move the thread to the tail of its queue.
+ *     Used on preemption (round robin inside the same level) and when 
+ * the priority changes.
+ */
+
+void readyq_requeue (struct thread_d *t){
+	
+	readyq_remove (t);
+	readyq_insert (t);
+};
+
+
+/*
+ * readyq_highest:
+ *     The first READY thread of the highest priority queue.
+ *     The running thread stays in its queue until it is preempted, 
+ * so we skip it.
+ *     Return NULL if there is none, then the caller uses the idle thread.
+ */
+
+struct thread_d *readyq_highest (void){
+	
+	struct thread_d *t;
+	unsigned long bits;
+	unsigned long Flags;
+	int level;
+	
+	Flags = readyq_lock ();
+	
+	bits = readyq.bitmap;
+	
+	while ( bits != 0 )
+	{
+		// The highest bit is the highest priority queue.
+		asm ("bsrl %1, %0" : "=r" (level) : "rm" (bits) );
+		
+		t = readyq.head[level];
+		
+		while ( (void *) t != NULL )
+		{
+			if ( t->state == READY )
+			{
+				readyq_unlock (Flags);
+				return (struct thread_d *) t;
+			}
+			
+			t = t->rq_next;
+		};
+		
+		bits &= ~( (unsigned long) (1 << level) );
+	};
+	
+	readyq_unlock (Flags);
+	
+	return NULL;
+};
+
+
 //
 // End.
 //
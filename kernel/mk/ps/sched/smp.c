@@ -0,0 +1,471 @@
+/*
+ * File: sched/smp.c
+ *
+ *     Multiprocessor bring-up and the cpu list. (smp info)
+ *
+ *     smpInit() reads the MP table of the BIOS and starts each AP with
+ * INIT + SIPI + SIPI. The AP runs the trampoline (hwlib.asm), enables
+ * paging with the kernel's cr3, and calls smpApMain() with its own
+ * stack. Then it stays halted in its idle loop. Only the BSP runs
+ * threads. (see smp.h)
+ *
+ *     Without the MP table or the local APIC we have only the BSP,
+ * cpuList[0], and nothing changes for the scheduler.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <kernel.h>
+
+
+// hwlib.asm
+extern unsigned char smp_trampoline_start[];
+extern unsigned char smp_trampoline_end[];
+extern unsigned char smp_trampoline_data[];
+
+
+// The trampoline data. (smp_trampoline_data in hwlib.asm)
+struct smp_trampoline_data_d
+{
+	unsigned long cr0;
+	unsigned long cr3;
+	unsigned long cr4;
+	unsigned long esp;
+};
+
+
+// The AP being started. It writes its index here.
+static volatile int smp_booting_cpu;
+
+
+//
+// ## Spinlocks ##
+//
+
+void spinLockInit ( spinlock_t *lock ){
+
+	lock->locked = 0;
+}
+
+
+int spinTryLock ( spinlock_t *lock ){
+
+	unsigned long Old = 1;
+
+	__asm__ __volatile__ ( "xchgl %0, %1"
+	    : "+r" (Old), "+m" (lock->locked) : : "memory" );
+
+	return (int) ( Old == 0 );
+}
+
+
+void spinLock ( spinlock_t *lock ){
+
+	while ( spinTryLock (lock) == 0 )
+	{
+		while ( lock->locked != 0 ){
+			asm ("pause");
+		};
+	};
+}
+
+
+void spinUnlock ( spinlock_t *lock ){
+
+	__asm__ __volatile__ ( "" : : : "memory" );
+
+	lock->locked = 0;
+}
+
+
+unsigned long spinLockIrqSave ( spinlock_t *lock ){
+
+	unsigned long Flags;
+
+	__asm__ __volatile__ ( "pushfl; popl %0; cli" : "=r" (Flags) : : "memory" );
+
+	spinLock (lock);
+
+	return (unsigned long) Flags;
+}
+
+
+void spinUnlockIrqRestore ( spinlock_t *lock, unsigned long flags ){
+
+	spinUnlock (lock);
+
+	__asm__ __volatile__ ( "pushl %0; popfl" : : "r" (flags) : "memory", "cc" );
+}
+
+
+//
+// ## Delay ##
+//
+
+static void smp_delay_us ( unsigned long us ){
+
+	unsigned long long End;
+
+	if ( tsc_khz == 0 )
+	{
+		// ~1us por acesso à porta 0x80.
+		while (us--){ outb ( 0x80, 0 ); };
+		return;
+	}
+
+	End = timerReadTSC () + ( (unsigned long long) us * (tsc_khz / 1000) );
+
+	while ( timerReadTSC () < End ){
+		asm ("pause");
+	};
+}
+
+
+//
+// ## MP table ##
+//
+
+static int smp_checksum ( unsigned char *p, unsigned long size ){
+
+	unsigned char Sum = 0;
+
+	while (size--){ Sum += *p++; };
+
+	return (int) ( Sum == 0 );
+}
+
+
+/* "_MP_" alinhado em 16 bytes. */
+
+static unsigned long smp_scan ( unsigned long base, unsigned long size ){
+
+	unsigned char *p;
+
+	for ( p = (unsigned char *) base;
+	      p < (unsigned char *) (base + size);
+		  p += 16 )
+	{
+		if ( p[0] == '_' && p[1] == 'M' && p[2] == 'P' && p[3] == '_' &&
+		     smp_checksum ( p, 16 ) == 1 )
+		{
+			return (unsigned long) p;
+		}
+	};
+
+	return 0;
+}
+
+
+/*
+ * smp_find_mp:
+ *     EBDA, last KB of the base memory, and the BIOS ROM.
+ *     The low 4MB are identity mapped.
+ */
+
+static unsigned long smp_find_mp (void){
+
+	volatile unsigned short *EbdaPointer = (volatile unsigned short *) 0x40E;
+	unsigned long Ebda;
+	unsigned long Found;
+
+	// Segment of the EBDA, in the BIOS data area.
+	Ebda = (unsigned long) (*EbdaPointer) << 4;
+
+	if ( Ebda != 0 )
+	{
+		Found = smp_scan ( Ebda, 1024 );
+
+		if ( Found != 0 ){
+			return (unsigned long) Found;
+		}
+	}
+
+	Found = smp_scan ( 0x9FC00, 1024 );
+
+	if ( Found != 0 ){
+		return (unsigned long) Found;
+	}
+
+	return (unsigned long) smp_scan ( 0xF0000, 0x10000 );
+}
+
+
+static void smp_add_cpu ( unsigned long apic_id, int bsp ){
+
+	struct cpu_d *cpu;
+
+	if ( smp_cpu_count >= SMP_CPU_MAX ){
+		return;
+	}
+
+	cpu = &cpuList[smp_cpu_count];
+
+	cpu->used = 1;
+	cpu->magic = 1234;
+	cpu->id = smp_cpu_count;
+	cpu->apic_id = apic_id;
+	cpu->bsp = bsp;
+	cpu->state = CPU_STATE_NONE;
+	cpu->idle_halts = 0;
+	cpu->stack = 0;
+
+	smp_cpu_count++;
+}
+
+
+/*
+ * smp_parse_mp:
+ *     The processor entries of the configuration table. (PCMP)
+ *     The BSP is always cpuList[0].
+ */
+
+static void smp_parse_mp ( unsigned long mp, unsigned long bsp_apic_id ){
+
+	unsigned char *Table;
+	unsigned char *Entry;
+	unsigned long Config;
+	unsigned short Count;
+	int i;
+
+	Config = *( (unsigned long *) (mp + 4) );
+
+	// Default configurations (no table) and tables above 4MB.
+	if ( Config == 0 || Config >= 0x400000 ){
+		return;
+	}
+
+	Table = (unsigned char *) Config;
+
+	if ( Table[0] != 'P' || Table[1] != 'C' || Table[2] != 'M' || Table[3] != 'P' ){
+		return;
+	}
+
+	if ( smp_checksum ( Table, *( (unsigned short *) (Table + 4) ) ) != 1 ){
+		return;
+	}
+
+	Count = *( (unsigned short *) (Table + 34) );
+
+	// After the 44 bytes of the header.
+	Entry = (Table + 44);
+
+	for ( i=0; i < Count; i++ )
+	{
+		// Processor.
+		if ( Entry[0] == 0 )
+		{
+			// Enabled, and not the BSP.
+			if ( (Entry[3] & 1) != 0 && Entry[1] != bsp_apic_id ){
+				smp_add_cpu ( Entry[1], 0 );
+			}
+
+			Entry += 20;
+			continue;
+		}
+
+		Entry += 8;
+	};
+}
+
+
+//
+// ## AP startup ##
+//
+
+static void smp_setup_trampoline ( struct cpu_d *cpu ){
+
+	struct smp_trampoline_data_d *Data;
+	unsigned long Value;
+
+	memcpy ( (void *) SMP_TRAMPOLINE_PA, (const void *) smp_trampoline_start,
+	    (unsigned long) (smp_trampoline_end - smp_trampoline_start) );
+
+	Data = (struct smp_trampoline_data_d *)
+	    ( SMP_TRAMPOLINE_PA + (unsigned long) (smp_trampoline_data - smp_trampoline_start) );
+
+	__asm__ __volatile__ ( "movl %%cr0, %0" : "=r" (Value) );
+	Data->cr0 = Value;
+	__asm__ __volatile__ ( "movl %%cr3, %0" : "=r" (Value) );
+	Data->cr3 = Value;
+	__asm__ __volatile__ ( "movl %%cr4, %0" : "=r" (Value) );
+	Data->cr4 = Value;
+
+	Data->esp = cpu->stack;
+}
+
+
+/*
+ * smp_start_ap:
+ *     INIT, 10ms, SIPI, 200us, SIPI. Then wait the AP for 100ms.
+ */
+
+static int smp_start_ap ( struct cpu_d *cpu ){
+
+	void *Stack;
+	int i;
+
+	Stack = (void *) allocPages (SMP_AP_STACK_PAGES);
+
+	if ( (void *) Stack == NULL )
+	{
+		cpu->state = CPU_STATE_FAILED;
+		return (int) -1;
+	}
+
+	cpu->stack = (unsigned long) Stack + (SMP_AP_STACK_PAGES * PAGE_SIZE);
+	cpu->state = CPU_STATE_STARTING;
+
+	smp_booting_cpu = cpu->id;
+
+	smp_setup_trampoline (cpu);
+
+	lapicSendIPI ( cpu->apic_id, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL );
+	smp_delay_us (10000);
+
+	for ( i=0; i < 2; i++ )
+	{
+		lapicSendIPI ( cpu->apic_id,
+		    LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_PA >> 12) );
+
+		smp_delay_us (200);
+	};
+
+	for ( i=0; i < 1000; i++ )
+	{
+		if ( cpu->state == CPU_STATE_ONLINE ){
+			return 0;
+		}
+
+		smp_delay_us (100);
+	};
+
+	cpu->state = CPU_STATE_FAILED;
+
+	return (int) -1;
+}
+
+
+/*
+ * smpInit:
+ *     Finds the cpus and starts the APs.
+ *     The BSP is cpuList[0], even without the local APIC.
+ */
+
+int smpInit (void){
+
+	int BspApicId;
+	int i;
+
+	smp_cpu_count = 0;
+	smp_cpu_online = 1;
+	smp_mp_table = 0;
+
+	BspApicId = lapicId ();
+
+	smp_add_cpu ( (BspApicId < 0) ? 0 : BspApicId, 1 );
+	cpuList[0].state = CPU_STATE_ONLINE;
+
+	if ( BspApicId < 0 ){
+		return 0;
+	}
+
+	smp_mp_table = smp_find_mp ();
+
+	if ( smp_mp_table == 0 ){
+		return 0;
+	}
+
+	smp_parse_mp ( smp_mp_table, (unsigned long) BspApicId );
+
+	for ( i=1; i < smp_cpu_count; i++ )
+	{
+		if ( smp_start_ap ( &cpuList[i] ) == 0 ){
+			smp_cpu_online++;
+		}
+	};
+
+	return (int) smp_cpu_online;
+}
+
+
+/*
+ * smpApMain:
+ *     The AP is in protected mode, with paging, the kernel's GDT
+ * and IDT and its own stack. (hwlib.asm)
+ *     It does not run threads. (see smp.h)
+ */
+
+void smpApMain (void){
+
+	struct cpu_d *cpu;
+
+	cpu = &cpuList[smp_booting_cpu];
+
+	lapicApInit ();
+
+	cpu->state = CPU_STATE_ONLINE;
+
+	while (1)
+	{
+		asm ("sti; hlt");
+		cpu->idle_halts++;
+	};
+}
+
+
+/*
+ * smpCurrentCPU:
+ *     Without the local APIC there is only the BSP.
+ */
+
+int smpCurrentCPU (void){
+
+	int ApicId;
+	int i;
+
+	ApicId = lapicId ();
+
+	if ( ApicId < 0 ){
+		return 0;
+	}
+
+	for ( i=0; i < smp_cpu_count; i++ )
+	{
+		if ( cpuList[i].apic_id == (unsigned long) ApicId ){
+			return (int) i;
+		}
+	};
+
+	return 0;
+}
+
+
+void smpShowInfo (void){
+
+	struct cpu_d *cpu;
+	int i;
+
+	printf ("\n[SMP:]\n");
+
+	printf ("cpus={%d} online={%d} mp={%x} current={%d}\n",
+	    smp_cpu_count, smp_cpu_online, smp_mp_table, smpCurrentCPU () );
+
+	printf ("ready queues: queued={%d}\n", readyq.count );
+
+	for ( i=0; i < smp_cpu_count; i++ )
+	{
+		cpu = &cpuList[i];
+
+		printf ("cpu%d: apic={%d} %s state={%d} halts={%d}\n",
+		    cpu->id, cpu->apic_id, ( cpu->bsp ? "BSP" : "AP" ),
+			cpu->state, cpu->idle_halts );
+	};
+}
+
+
+//
+// End.
+//
+
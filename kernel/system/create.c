@@ -52,7 +52,7 @@ void *KiCreateIdle (void){
 	
 	//struct.
 	
-	IdleThread = (void *) malloc ( sizeof(struct thread_d) );	
+	IdleThread = (void *) slabAllocate (thread_cache);	
 	
 	if ( (void *) IdleThread == NULL )
 	{
@@ -272,6 +272,15 @@ void *KiCreateIdle (void){
 	
 	//Prxima thread.
 	IdleThread->Next = NULL;
+	
+	IdleThread->rq_next = NULL;
+	IdleThread->rq_prev = NULL;
+	IdleThread->rq_queued = 0;
+	
+	// Fila de mensagens vazia.
+	msgqInit (IdleThread);
+	semInitThread (IdleThread);
+	timerInitThread (IdleThread);
 	//IdleThread->Next = (void*) IdleThread;    //Opo.
 	
 	// #importante
@@ -330,7 +339,7 @@ void *KiCreateShell (void){
 	};	
 	
 	//Thread.
-	t = (void *) malloc ( sizeof(struct thread_d) );
+	t = (void *) slabAllocate (thread_cache);
 	
 	if ( (void *) t == NULL ){
 	    printf("pc-create-KiCreateShell: t \n");
@@ -467,6 +476,15 @@ void *KiCreateShell (void){
 	threadList[1] = (unsigned long) t;
 	
 	t->Next = NULL;
+	
+	t->rq_next = NULL;
+	t->rq_prev = NULL;
+	t->rq_queued = 0;
+	
+	// Fila de mensagens vazia.
+	msgqInit (t);
+	semInitThread (t);
+	timerInitThread (t);
 
 
 	//
@@ -514,7 +532,7 @@ void *KiCreateTaskManager (void){
     //Thread.
 	//Alocando memria para a estrutura da thread.
 	
-	t = (void *) malloc ( sizeof(struct thread_d) );	
+	t = (void *) slabAllocate (thread_cache);	
 	
 	if( (void *) t == NULL )
 	{
@@ -655,6 +673,15 @@ void *KiCreateTaskManager (void){
 	
 	t->Next = NULL;
 	
+	t->rq_next = NULL;
+	t->rq_prev = NULL;
+	t->rq_queued = 0;
+	
+	// Fila de mensagens vazia.
+	msgqInit (t);
+	semInitThread (t);
+	timerInitThread (t);
+	
 	//
 	// Running tasks.
 	//
@@ -3188,6 +3188,26 @@ unsigned long apiGetSysTimeInfo ( int n ){
 }
 
 
+// Pega até max mensagens da fila da thread.
+// MESSAGE_WORDS longs por mensagem. Retorna quantas pegou.
+int apiGetMessages ( unsigned long *buffer, int max ){
+	
+	if ( (void *) buffer == NULL || max <= 0 )
+	    return (int) 0;
+	
+	return (int) system_call ( SYSTEMCALL_GETMESSAGES, (unsigned long) buffer, 
+	                 (unsigned long) max, (unsigned long) max );
+}
+
+
+// Dorme até chegar uma mensagem na fila da thread.
+// Retorna 1 se já tinha mensagem.
+int apiWaitMessage (void){
+	
+	return (int) system_call ( SYSTEMCALL_WAITMESSAGE, 0, 0, 0 );
+}
+
+
 //mostra uma janela na tela. backbuffer ---> frontbuffer
 void apiShowWindow (struct window_d *window){
 	
@@ -732,6 +732,20 @@
 #define	SYSTEMCALL_SHOWPCIINFO       254
 #define	SYSTEMCALL_SHOWKERNELINFO    255
 
+// Fila de mensagens da thread.
+#define	SYSTEMCALL_GETMESSAGES       256
+#define	SYSTEMCALL_WAITMESSAGE       257
+
+// Mostra as cpus e as filas de cada uma.
+#define	SYSTEMCALL_SMPINFO           267
+
+// glyphs/s do texto no kernel, com e sem o cache.
+#define	SYSTEMCALL_GLYPHBENCH        268
+
+// Longs por mensagem no buffer de apiGetMessages.
+// window, msg, long1, long2, long3, long4, long5, long6.
+#define MESSAGE_WORDS  8
+
 
 //
 // Process and threads priorities.
@@ -3680,6 +3694,17 @@ struct timer_d *apiCreateTimer ( struct window_d *window,
 unsigned long apiGetSysTimeInfo ( int n );
 #define gde_get_sys_time_info apiGetSysTimeInfo
 
+
+// Pega até max mensagens da fila da thread.
+// MESSAGE_WORDS longs por mensagem. Retorna quantas pegou.
+int apiGetMessages ( unsigned long *buffer, int max );
+#define gde_get_messages apiGetMessages
+
+
+// Dorme até chegar uma mensagem na fila da thread.
+int apiWaitMessage (void);
+#define gde_wait_message apiWaitMessage
+
 //
 // End.
 //
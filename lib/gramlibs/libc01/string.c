@@ -17,6 +17,177 @@
 #include <inttypes.h>
 
 
+//
+// Rotinas rápidas de memória.
+//
+//     memcpy/memset usam rep movsd/stosd com o destino alinhado.
+// Se o processador tem ERMS, (Enhanced REP MOVSB/STOSB, cpuid 7) 
+// usamos rep movsb/stosb direto, que nesses modelos é o mais rápido.
+// Pedaços pequenos vão byte a byte.
+//     memcmp, strlen e strcmp comparam 4 bytes por vez.
+//     Obs: Não usamos SSE. O kernel não liga o OSFXSR no cr4, 
+// então instruções sse geram #UD em user mode.
+//     Obs: Nunca usar std aqui. As rotinas de interrupção não 
+// fazem cld.
+//
+
+#define STRING_SMALL  16
+
+// Leitura de 4 bytes sem problema de aliasing.
+typedef unsigned long __attribute__((__may_alias__)) string_word_t;
+
+// Algum byte da palavra é zero.
+#define STRING_HAS_ZERO(w)  ( ( (w) - 0x01010101UL ) & ~(w) & 0x80808080UL )
+
+static int string_cpu_checked;
+static int string_cpu_erms;
+
+
+static void string_check_cpu (void){
+	
+	unsigned long a, b, c, d;
+	unsigned long Max;
+
+	__asm__ __volatile__ ( "cpuid" 
+	    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0), "c" (0) );
+	
+	Max = a;
+	
+	if ( Max >= 7 )
+	{
+		__asm__ __volatile__ ( "cpuid" 
+		    : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (7), "c" (0) );
+		
+		// ebx bit 9 = ERMS.
+		if ( b & (1 << 9) ){
+			string_cpu_erms = 1;
+		}
+	}
+	
+	string_cpu_checked = 1;
+}
+
+
+static void 
+string_copy_forward ( unsigned char *dst, 
+                      const unsigned char *src, 
+                      unsigned long n )
+{
+	unsigned long d0, d1, d2;
+
+	if ( n < STRING_SMALL )
+	{
+		while (n--){ *dst++ = *src++; };
+		return;
+	}
+
+	if ( string_cpu_checked == 0 ){
+		string_check_cpu ();
+	}
+
+	if ( string_cpu_erms == 1 )
+	{
+		__asm__ __volatile__ ( "cld\n\t" 
+		                       "rep movsb"
+		    : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+		    : "0" (n), "1" (dst), "2" (src)
+		    : "memory" );
+		return;
+	}
+
+	// Alinha o destino.
+	while ( ( (unsigned long) dst & 3 ) != 0 )
+	{
+		*dst++ = *src++;
+		n--;
+	};
+
+	__asm__ __volatile__ ( "cld\n\t"
+	                       "rep movsl\n\t"
+	                       "movl %3, %%ecx\n\t"
+	                       "rep movsb"
+	    : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+	    : "g" (n & 3), "0" (n >> 2), "1" (dst), "2" (src)
+	    : "memory" );
+}
+
+
+// Para memmove com o destino depois da origem.
+// Palavra por palavra, do fim para o começo.
+
+static void 
+string_copy_backward ( unsigned char *dst, 
+                       const unsigned char *src, 
+                       unsigned long n )
+{
+	string_word_t *dw;
+	const string_word_t *sw;
+
+	dst += n;
+	src += n;
+
+	while ( (n & 3) != 0 )
+	{
+		*--dst = *--src;
+		n--;
+	};
+
+	dw = (string_word_t *) dst;
+	sw = (const string_word_t *) src;
+
+	n = (n >> 2);
+
+	while (n--){ *--dw = *--sw; };
+}
+
+
+static void 
+string_fill ( unsigned char *dst, 
+              int value, 
+              unsigned long n )
+{
+	unsigned long v;
+	unsigned long d0, d1;
+
+	if ( n < STRING_SMALL )
+	{
+		while (n--){ *dst++ = (unsigned char) value; };
+		return;
+	}
+
+	if ( string_cpu_checked == 0 ){
+		string_check_cpu ();
+	}
+
+	if ( string_cpu_erms == 1 )
+	{
+		__asm__ __volatile__ ( "cld\n\t" 
+		                       "rep stosb"
+		    : "=&c" (d0), "=&D" (d1)
+		    : "a" (value), "0" (n), "1" (dst)
+		    : "memory" );
+		return;
+	}
+
+	while ( ( (unsigned long) dst & 3 ) != 0 )
+	{
+		*dst++ = (unsigned char) value;
+		n--;
+	};
+
+	v = (unsigned long) ( value & 0xFF ) * 0x01010101UL;
+
+	__asm__ __volatile__ ( "cld\n\t"
+	                       "rep stosl\n\t"
+	                       "movl %3, %%ecx\n\t"
+	                       "rep stosb"
+	    : "=&c" (d0), "=&D" (d1)
+	    : "a" (v), "g" (n & 3), "0" (n >> 2), "1" (dst)
+	    : "memory" );
+}
+
+
+
 /*
  #todo
  
@@ -36,19 +207,31 @@ void *memsetw (void *dst, int val, size_t count){
  * Compare memory regions.
  */
 
-int memcmp (const void *s1, const void *s2, size_t n){
+int memcmp ( const void *s1, const void *s2, size_t n ){
 	
-	if (n != 0) 
+	const unsigned char *p1 = s1;
+	const unsigned char *p2 = s2;
+
+	while ( n >= 4 && 
+	        *(const string_word_t *) p1 == *(const string_word_t *) p2 )
 	{
-		const unsigned char *p1 = s1, *p2 = s2;
+		p1 += 4;
+		p2 += 4;
+		n -= 4;
+	};
 
-		do {
-			if (*p1++ != *p2++)
-				return (*--p1 - *--p2);
-		} while (--n != 0);
-	}
+	while ( n > 0 )
+	{
+		if ( *p1 != *p2 ){
+			return (int) ( *p1 - *p2 );
+		}
+		
+		p1++;
+		p2++;
+		n--;
+	};
 	
-	return (0);
+	return (int) 0;
 }
 
 
@@ -190,18 +373,44 @@ char *strncpy(char *s1, const char *s2, size_t n){
 
 int strcmp (char * s1, char * s2){
 	
-	int i;
-	
-	for ( i=0; s1[i] == s2[i]; i++ ){
-		
-		if ( s1[i] == '\0' ){ 
-		
-		    return (int) 0; 
+	const unsigned char *p1 = (const unsigned char *) s1;
+	const unsigned char *p2 = (const unsigned char *) s2;
+	const string_word_t *w1;
+	const string_word_t *w2;
+
+	while ( ( (unsigned long) p1 & 3 ) != 0 )
+	{
+		if ( *p1 != *p2 || *p1 == '\0' ){
+			return (int) ( *p1 - *p2 );
 		}
+		p1++;
+		p2++;
 	};
-	
-	return ( (int) ( s1[i] - s2[i] ) );
-};
+
+	// As duas alinhadas, 4 bytes por vez.
+	if ( ( (unsigned long) p2 & 3 ) == 0 )
+	{
+		w1 = (const string_word_t *) p1;
+		w2 = (const string_word_t *) p2;
+
+		while ( *w1 == *w2 && STRING_HAS_ZERO (*w1) == 0 )
+		{
+			w1++;
+			w2++;
+		};
+
+		p1 = (const unsigned char *) w1;
+		p2 = (const unsigned char *) w2;
+	}
+
+	while ( *p1 == *p2 && *p1 != '\0' )
+	{
+		p1++;
+		p2++;
+	};
+
+	return (int) ( *p1 - *p2 );
+}
 
 
 /*
@@ -253,20 +462,12 @@ void *memset(void *s, int c, size_t count)
 
 void *memset ( void *ptr, int value, int size ){
 	
-    if ( ptr != NULL && size > 0 )
-    {
-        unsigned char *temp = ptr;
-
-        int i = 0;
-
-        for ( i = 0; i < size; i++ )
-        {
-            *temp++ = (unsigned char) value;
-        }
-
-    };
-		
-    return (void *) ptr;
+	if ( ptr != NULL && size > 0 )
+	{
+		string_fill ( (unsigned char *) ptr, value, (unsigned long) size );
+	};
+	
+	return (void *) ptr;
 }
 
 
@@ -294,16 +495,9 @@ void *memoryZeroMemory ( void* ptr, size_t cnt ){
 
 void *memcpy ( void *v_dst, const void *v_src, unsigned long c ){
 	
-	const char *src = v_src;
-	char *dst = v_dst;
+	string_copy_forward ( (unsigned char *) v_dst, 
+	    (const unsigned char *) v_src, c );
 
-	// Simple, byte oriented memcpy. 
-	while (c--){
-		
-        *dst++ = *src++; 
-	};
-	
-	//#todo: Tipar o retorno.
 	return v_dst;
 }
 
@@ -447,15 +641,29 @@ void  bzero ( char *cp, int len ){
  */ 
 size_t strlen ( const char *s ){
 	
-    size_t i = 0;
-	
-	for ( i=0; s[i] != '\0'; i++ )
-	{ 
-        ; 
+	const char *p = s;
+	const string_word_t *w;
+
+	// Até alinhar. Uma leitura alinhada de 4 bytes nunca 
+	// passa do fim da página.
+	while ( ( (unsigned long) p & 3 ) != 0 )
+	{
+		if ( *p == '\0' ){
+			return (size_t) ( p - s );
+		}
+		p++;
 	};
 
-	return (size_t) i;
-};
+	w = (const string_word_t *) p;
+
+	while ( STRING_HAS_ZERO (*w) == 0 ){ w++; };
+
+	p = (const char *) w;
+
+	while ( *p != '\0' ){ p++; };
+
+	return (size_t) ( p - s );
+}
 
 
 /*
@@ -701,28 +909,30 @@ char *strchr (const char *s, int c){
 
 
 
-/*linux style
-void *memmove(void *dest, const void *src, size_t count)
-{
-	char *tmp;
-	const char *s;
-
-	if (dest <= src) {
-		tmp = dest;
-		s = src;
-		while (count--)
-			*tmp++ = *s++;
-	} else {
-		tmp = dest;
-		tmp += count;
-		s = src;
-		s += count;
-		while (count--)
-			*--tmp = *--s;
+/*
+ * memmove:
+ *     Copia com sobreposição.
+ */
+
+void *memmove ( void *dest, const void *src, size_t count ){
+	
+	unsigned char *d = (unsigned char *) dest;
+	const unsigned char *s = (const unsigned char *) src;
+
+	if ( d == s || count == 0 ){
+		return dest;
 	}
+
+	// Destino antes da origem, ou sem sobreposição.
+	if ( d < s || d >= s + count )
+	{
+		string_copy_forward ( d, s, count );
+	}else{
+		string_copy_backward ( d, s, count );
+	};
+
 	return dest;
 }
-*/
 
 
 
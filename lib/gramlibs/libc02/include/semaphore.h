@@ -0,0 +1,57 @@
+/*
+ * File: semaphore.h
+ *
+ *     Semáforos e mutexes do kernel. (syscalls 260~264)
+ *     A thread que não consegue o recurso dorme na fila do semáforo
+ * e não fica num loop gastando o quantum.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#ifndef __SEMAPHORE_H
+#define __SEMAPHORE_H
+
+
+// O kernel só dá um handle.
+typedef struct sem_d
+{
+    int handle;
+
+} sem_t;
+
+
+typedef struct mutex_d
+{
+    int handle;
+
+} mutex_t;
+
+
+// In semaphore.c
+
+// pshared é ignorado, o semáforo é do kernel.
+int sem_init ( sem_t *sem, int pshared, unsigned int value );
+int sem_destroy ( sem_t *sem );
+int sem_wait ( sem_t *sem );
+int sem_trywait ( sem_t *sem );
+int sem_post ( sem_t *sem );
+
+int mutex_init ( mutex_t *mutex );
+int mutex_destroy ( mutex_t *mutex );
+int mutex_lock ( mutex_t *mutex );
+int mutex_trylock ( mutex_t *mutex );
+int mutex_unlock ( mutex_t *mutex );
+
+// Mostra os contadores dos semáforos. (locks quentes)
+void sem_showinfo (void);
+
+
+#endif
+
+
+//
+// End.
+//
+
@@ -335,6 +335,12 @@ int fileno ( FILE *stream );
 FILE *fopen( const char *filename, const char *mode ); 
 int fflush( FILE *stream ); 
 int fclose(FILE *stream); 
+
+// Buffer do stream. (_IOFBF, _IOLBF, _IONBF)
+int setvbuf ( FILE *stream, char *buf, int mode, size_t size );
+void setbuf ( FILE *stream, char *buf );
+void setbuffer ( FILE *stream, char *buf, size_t size );
+void setlinebuf ( FILE *stream );
 //#define fileno(p)   ((p)->fd)
  
  
@@ -38,6 +38,7 @@ int strncmp(char *s1, char *s2, int len);
 void *memset ( void *ptr, int value, int size );
 void *memoryZeroMemory(void* ptr, size_t cnt);
 void *memcpy(void *v_dst, const void *v_src, unsigned long c);
+void *memmove(void *dest, const void *src, size_t count);
 //@todo: void *memcpy(void *dst, const void *src, size_t c); 
 char *strcpy(char *to, const char *from);
 char *strcat(char *to, const char *from);
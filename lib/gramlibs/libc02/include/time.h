@@ -31,6 +31,32 @@ typedef	long clock_t;
 time_t time(time_t *timer);
 
 
+#ifndef __TIMESPEC
+#define __TIMESPEC
+struct timespec
+{
+	time_t tv_sec;     /* Seconds. */
+	long   tv_nsec;    /* Nanoseconds: 0-999999999 */
+};
+#endif
+
+
+// Relogios. (kernel)
+typedef int clockid_t;
+
+#define CLOCK_REALTIME   0  // #todo
+#define CLOCK_MONOTONIC  1  // TSC, em ns.
+
+// POSIX.1-2001. 
+// Nao precisa de interrupcao, o kernel le o TSC.
+int clock_gettime ( clockid_t clk_id, struct timespec *tp );
+
+
+// POSIX.1-2001. (unistd.c)
+// A thread dorme no kernel, a resolucao e o tick.
+int nanosleep ( const struct timespec *req, struct timespec *rem );
+
+
 //#endif	/* Not _TIME_H_ */
 
 
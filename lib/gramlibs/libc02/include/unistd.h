@@ -141,6 +141,11 @@ int nice(int inc);
 
 int pause(void);
 
+// A thread dorme no kernel até o deadline. (nanosleep)
+// POSIX.1-2001.
+unsigned int sleep ( unsigned int seconds );
+int usleep ( unsigned long usec );
+
 
 //SVr4, BSD, POSIX.1-2001.
 int mkdir(const char *pathname, mode_t mode);
@@ -0,0 +1,237 @@
+/*
+ * File: semaphore.c
+ *
+ *     Semáforos e mutexes do kernel.
+ *
+ *     Quando o recurso não está livre o kernel coloca a thread na fila
+ * do semáforo, bloqueia ela e troca de thread no retorno da syscall.
+ * Ela só volta, com o retorno 1, quando um sem_post entregar o recurso
+ * para ela. Então a chamada seguinte retorna 0.
+ *
+ * History:
+ *     2019 - Created.
+ */
+
+
+#include <stddef.h>
+#include <semaphore.h>
+
+//system calls.
+#include <stubs/gramado.h>
+
+
+#define SEMAPHORE_SYSTEMCALL_CREATE   260
+#define SEMAPHORE_SYSTEMCALL_DOWN     261
+#define SEMAPHORE_SYSTEMCALL_UP       262
+#define SEMAPHORE_SYSTEMCALL_DESTROY  263
+#define SEMAPHORE_SYSTEMCALL_INFO     264
+
+// Tipos. (kernel)
+#define SEMAPHORE_TYPE_COUNTING  1
+#define SEMAPHORE_TYPE_MUTEX     2
+
+#define SEMAPHORE_TRY  1
+
+
+static int semaphore_create ( unsigned int value, int type ){
+
+	return (int) gramado_system_call ( SEMAPHORE_SYSTEMCALL_CREATE,
+	                 (unsigned long) value, (unsigned long) type, 0 );
+}
+
+
+static int semaphore_destroy ( int handle ){
+
+	return (int) gramado_system_call ( SEMAPHORE_SYSTEMCALL_DESTROY,
+	                 (unsigned long) handle, 0, 0 );
+}
+
+
+/*
+ * semaphore_down:
+ *     1 = a thread estava na fila e foi acordada. Chama de novo.
+ */
+
+static int semaphore_down ( int handle ){
+
+	int Status;
+
+	while (1)
+	{
+		Status = (int) gramado_system_call ( SEMAPHORE_SYSTEMCALL_DOWN,
+		                   (unsigned long) handle, 0, 0 );
+
+		if ( Status != 1 ){
+			break;
+		}
+	};
+
+	if ( Status == 0 ){
+		return 0;
+	}
+
+	return (int) -1;
+}
+
+
+static int semaphore_trydown ( int handle ){
+
+	int Status;
+
+	Status = (int) gramado_system_call ( SEMAPHORE_SYSTEMCALL_DOWN,
+	                   (unsigned long) handle, (unsigned long) SEMAPHORE_TRY, 0 );
+
+	if ( Status == 0 ){
+		return 0;
+	}
+
+	return (int) -1;
+}
+
+
+static int semaphore_up ( int handle ){
+
+	int Status;
+
+	Status = (int) gramado_system_call ( SEMAPHORE_SYSTEMCALL_UP,
+	                   (unsigned long) handle, 0, 0 );
+
+	if ( Status == 0 ){
+		return 0;
+	}
+
+	return (int) -1;
+}
+
+
+//
+// Semáforos.
+//
+
+int sem_init ( sem_t *sem, int pshared, unsigned int value ){
+
+	if ( (void *) sem == NULL ){
+		return (int) -1;
+	}
+
+	sem->handle = semaphore_create ( value, SEMAPHORE_TYPE_COUNTING );
+
+	if ( sem->handle < 0 ){
+		return (int) -1;
+	}
+
+	return 0;
+}
+
+
+int sem_destroy ( sem_t *sem ){
+
+	if ( (void *) sem == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_destroy ( sem->handle );
+}
+
+
+int sem_wait ( sem_t *sem ){
+
+	if ( (void *) sem == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_down ( sem->handle );
+}
+
+
+int sem_trywait ( sem_t *sem ){
+
+	if ( (void *) sem == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_trydown ( sem->handle );
+}
+
+
+int sem_post ( sem_t *sem ){
+
+	if ( (void *) sem == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_up ( sem->handle );
+}
+
+
+//
+// Mutexes.
+// Só a thread que pegou o mutex pode liberar.
+//
+
+int mutex_init ( mutex_t *mutex ){
+
+	if ( (void *) mutex == NULL ){
+		return (int) -1;
+	}
+
+	mutex->handle = semaphore_create ( 1, SEMAPHORE_TYPE_MUTEX );
+
+	if ( mutex->handle < 0 ){
+		return (int) -1;
+	}
+
+	return 0;
+}
+
+
+int mutex_destroy ( mutex_t *mutex ){
+
+	if ( (void *) mutex == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_destroy ( mutex->handle );
+}
+
+
+int mutex_lock ( mutex_t *mutex ){
+
+	if ( (void *) mutex == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_down ( mutex->handle );
+}
+
+
+int mutex_trylock ( mutex_t *mutex ){
+
+	if ( (void *) mutex == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_trydown ( mutex->handle );
+}
+
+
+int mutex_unlock ( mutex_t *mutex ){
+
+	if ( (void *) mutex == NULL ){
+		return (int) -1;
+	}
+
+	return (int) semaphore_up ( mutex->handle );
+}
+
+
+void sem_showinfo (void){
+
+	gramado_system_call ( SEMAPHORE_SYSTEMCALL_INFO, 0, 0, 0 );
+}
+
+
+//
+// End.
+//
+
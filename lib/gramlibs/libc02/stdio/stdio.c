@@ -25,9 +25,11 @@
 #include <stdarg.h> 
 
 #include <stddef.h>
-//#include <stdlib.h> 
+#include <stdlib.h> 
+#include <string.h> 
 
 #include <ctype.h>
+#include <errno.h>
 
 //system calls.
 #include <stubs/gramado.h> 
@@ -41,6 +43,9 @@
 #define	SYSTEMCALL_READ_FILE   3
 #define	SYSTEMCALL_WRITE_FILE  4
 
+// Dorme até chegar uma mensagem. (fread no stdin)
+#define	SYSTEMCALL_WAITMESSAGE  257
+
 #define VK_RETURN      0x1C 
 #define VK_BACKSPACE   0x0E 
 #define VK_BACK	       0x0E  
@@ -58,6 +63,14 @@ unsigned long stdioGetCursorY();
 //interna; Mudar o nome
 static size_t stdio_strlen (const char *s);
 
+// Definida mais abaixo. (printf, fprintf)
+int 
+kvprintf ( char const *fmt, 
+           void (*func)( int, void* ), 
+		   void *arg, 
+		   int radix, 
+		   va_list ap );
+
 
 //atoi. # talvez isso possa ir para o topo do 
 //arquivo para servir mais funções.
@@ -164,6 +177,339 @@ void stdio_fntos (char *name){
 };
 
 
+//
+// Buffers do stdio.
+//
+//     Antes cada char era uma system call. (65)
+//     Agora os streams têm buffer e a libc manda o buffer inteiro
+// para o kernel numa chamada só. (258)
+//
+//     stdout = line buffered, stderr = unbuffered,
+//     arquivos abertos com fopen = fully buffered.
+//
+//     O FILE dos arquivos abertos com fopen pertence ao kernel,
+// então o buffer fica nessa tabela e não na estrutura.
+//
+
+#define STDIO_WRITEBUFFER  258
+#define STDIO_READBUFFER   259
+
+struct stdio_buffer_d
+{
+	int used;
+	
+	FILE *stream;
+	
+	// 1 = arquivo do kernel (fopen). 0 = terminal.
+	int kernel;
+	
+	// _IOFBF, _IOLBF ou _IONBF.
+	int mode;
+	
+	char *base;
+	int size;
+	
+	// Bytes esperando o flush.
+	int len;
+	
+	// base veio do malloc.
+	int mbuf;
+};
+
+static struct stdio_buffer_d stdio_buffers[FOPEN_MAX];
+
+// Estruturas do fluxo padrão.
+static FILE stdio_stdin;
+static FILE stdio_stdout;
+static FILE stdio_stderr;
+
+// Buffer do stdout. (prompt_out é do stream, não do buffer)
+static char stdio_stdout_buffer[BUFSIZ];
+
+
+static void stdio_raw_write ( struct stdio_buffer_d *b, const char *data, int len ){
+
+	if ( len <= 0 )
+		return;
+
+	if ( b->kernel == 1 )
+	{
+		gramado_system_call ( STDIO_WRITEBUFFER, (unsigned long) b->stream, 
+		    (unsigned long) data, (unsigned long) len );
+	}else{
+		gramado_system_call ( STDIO_WRITEBUFFER, (unsigned long) NULL, 
+		    (unsigned long) data, (unsigned long) len );
+	};
+}
+
+
+static void stdio_buffer_flush ( struct stdio_buffer_d *b ){
+
+	if ( b->len > 0 )
+	{
+		stdio_raw_write ( b, b->base, b->len );
+		b->len = 0;
+	}
+}
+
+
+/*
+ * stdio_buffer_get:
+ *     Pega o buffer de um stream.
+ *     create = 1 só no fopen, o arquivo do kernel ganha o buffer
+ * quando é aberto. Um stream que não está na tabela não é nosso.
+ */
+
+static struct stdio_buffer_d *stdio_buffer_get ( FILE *stream, int create ){
+
+	struct stdio_buffer_d *b;
+	int i;
+
+	if ( (void *) stream == NULL )
+		return NULL;
+
+	for ( i=0; i < FOPEN_MAX; i++ )
+	{
+		if ( stdio_buffers[i].used == 1 && stdio_buffers[i].stream == stream )
+		{
+			return (struct stdio_buffer_d *) &stdio_buffers[i];
+		}
+	};
+
+	if ( create == 0 )
+		return NULL;
+
+	for ( i=0; i < FOPEN_MAX; i++ )
+	{
+		b = &stdio_buffers[i];
+
+		if ( b->used == 0 )
+		{
+			b->stream = stream;
+			b->kernel = 1;
+			b->mode = _IOFBF;
+			b->len = 0;
+			b->mbuf = 0;
+			b->size = BUFSIZ;
+			b->base = (char *) malloc (BUFSIZ);
+
+			if ( (void *) b->base == NULL )
+			{
+				b->mode = _IONBF;
+				b->size = 0;
+			}else{
+				b->mbuf = 1;
+			};
+
+			b->used = 1;
+
+			return (struct stdio_buffer_d *) b;
+		}
+	};
+
+	return NULL;
+}
+
+
+static void stdio_buffer_release ( struct stdio_buffer_d *b ){
+
+	stdio_buffer_flush (b);
+
+	if ( b->mbuf == 1 ){
+		free ( b->base );
+	}
+
+	b->base = NULL;
+	b->size = 0;
+	b->mbuf = 0;
+	b->stream = NULL;
+	b->used = 0;
+}
+
+
+/*
+ * stdio_buffer_write:
+ *     Coloca bytes no buffer do stream.
+ *     O flush acontece quando o buffer enche, em '\n' se for
+ * line buffered, ou direto se for unbuffered.
+ */
+
+static int stdio_buffer_write ( FILE *stream, const char *data, int len ){
+
+	struct stdio_buffer_d *b;
+	int newline = 0;
+	int n;
+	int i;
+
+	if ( len <= 0 )
+		return 0;
+
+	b = stdio_buffer_get ( stream, 0 );
+
+	if ( (void *) b == NULL )
+		return -1;
+
+	if ( b->mode == _IONBF || b->size == 0 )
+	{
+		stdio_buffer_flush (b);
+		stdio_raw_write ( b, data, len );
+		return len;
+	}
+
+	// Maior que o buffer. Vai direto.
+	if ( len >= b->size )
+	{
+		stdio_buffer_flush (b);
+		stdio_raw_write ( b, data, len );
+		return len;
+	}
+
+	i = 0;
+
+	while ( i < len )
+	{
+		n = b->size - b->len;
+
+		if ( n > (len - i) ){
+			n = (len - i);
+		}
+
+		memcpy ( b->base + b->len, data + i, n );
+		b->len += n;
+		i += n;
+
+		if ( b->len == b->size ){
+			stdio_buffer_flush (b);
+		}
+	};
+
+	if ( b->mode == _IOLBF )
+	{
+		for ( i=0; i < len; i++ )
+		{
+			if ( data[i] == '\n' ){
+				newline = 1;
+				break;
+			}
+		};
+
+		if ( newline == 1 ){
+			stdio_buffer_flush (b);
+		}
+	}
+
+	return len;
+}
+
+
+static void stdio_buffer_putc ( int c, void *arg ){
+
+	char ch = (char) c;
+
+	stdio_buffer_write ( (FILE *) arg, &ch, 1 );
+}
+
+
+// Antes de ler do teclado ou mexer no cursor, 
+// o que está no stdout precisa estar na tela.
+
+static void stdio_flush_stdout (void){
+
+	struct stdio_buffer_d *b;
+
+	b = stdio_buffer_get ( stdout, 0 );
+
+	if ( (void *) b != NULL ){
+		stdio_buffer_flush (b);
+	}
+}
+
+
+/*
+ * setvbuf:
+ *     Muda o buffer e o modo de um stream.
+ *     buf = NULL, a libc aloca.
+ */
+
+int setvbuf ( FILE *stream, char *buf, int mode, size_t size ){
+
+	struct stdio_buffer_d *b;
+
+	if ( mode != _IOFBF && mode != _IOLBF && mode != _IONBF )
+		return (int) -1;
+
+	b = stdio_buffer_get ( stream, 0 );
+
+	if ( (void *) b == NULL )
+		return (int) -1;
+
+	stdio_buffer_flush (b);
+
+	if ( b->mbuf == 1 )
+	{
+		free ( b->base );
+		b->mbuf = 0;
+	}
+
+	b->base = NULL;
+	b->size = 0;
+	b->mode = mode;
+
+	if ( mode == _IONBF )
+		return 0;
+
+	if ( size == 0 ){
+		size = BUFSIZ;
+	}
+
+	if ( (void *) buf == NULL )
+	{
+		buf = (char *) malloc (size);
+
+		if ( (void *) buf == NULL )
+		{
+			b->mode = _IONBF;
+			return (int) -1;
+		}
+
+		b->mbuf = 1;
+	}
+
+	b->base = buf;
+	b->size = (int) size;
+
+	return 0;
+}
+
+
+void setbuf ( FILE *stream, char *buf ){
+
+	if ( (void *) buf == NULL )
+	{
+		setvbuf ( stream, NULL, _IONBF, 0 );
+	}else{
+		setvbuf ( stream, buf, _IOFBF, BUFSIZ );
+	};
+}
+
+
+void setbuffer ( FILE *stream, char *buf, size_t size ){
+
+	if ( (void *) buf == NULL )
+	{
+		setvbuf ( stream, NULL, _IONBF, 0 );
+	}else{
+		setvbuf ( stream, buf, _IOFBF, size );
+	};
+}
+
+
+void setlinebuf ( FILE *stream ){
+
+	setvbuf ( stream, NULL, _IOLBF, 0 );
+}
+
+
 /*
  *
  * stdio_system_call:
@@ -198,6 +544,14 @@ void *stdio_system_call ( unsigned long ax,
 
 int fclose (FILE *stream){
  
+	struct stdio_buffer_d *b;
+	
+	b = stdio_buffer_get ( stream, 0 );
+	
+	if ( (void *) b != NULL && b->kernel == 1 ){
+		stdio_buffer_release (b);
+	}
+	
     //return (int) stdio_system_call ( 232, (unsigned long) stream, 
 	//				 (unsigned long) stream, (unsigned long) stream ); 
 
@@ -222,14 +576,30 @@ int fclose (FILE *stream){
 
 FILE *fopen ( const char *filename, const char *mode ){
 	
+	FILE *stream;
+	
 	//salvando. isso funciona.
     //return (FILE *) stdio_system_call ( 246, (unsigned long) filename, 
 	//				 (unsigned long) mode, (unsigned long) mode ); 
 	
 	//#teste
 	//tentando esse.
-    return (FILE *) gramado_system_call ( 246, (unsigned long) filename, 
-					 (unsigned long) mode, (unsigned long) mode ); 
+    stream = (FILE *) gramado_system_call ( 246, (unsigned long) filename, 
+					      (unsigned long) mode, (unsigned long) mode ); 
+	
+	if ( (void *) stream == NULL )
+		return NULL;
+	
+	// O buffer do arquivo.
+	// Sem lugar na tabela o arquivo é fechado. (FOPEN_MAX)
+	if ( (void *) stdio_buffer_get ( stream, 1 ) == NULL )
+	{
+		gramado_system_call ( 232, (unsigned long) stream, 
+		    (unsigned long) stream, (unsigned long) stream ); 
+		return NULL;
+	}
+	
+	return (FILE *) stream;
 }
 
 
@@ -327,16 +697,116 @@ int puts ( const char *str ){
 };
 
 
-//#todo
-size_t fread(void *ptr, size_t size, size_t n, FILE *fp)
-{
-    return -1;
+/*
+ * stdio_read_stdin:
+ *     O stdin é o teclado, como no getchar.
+ *     Espera pela primeira tecla e para no fim da linha ou quando não
+ * tem mais teclas. Retorna o número de bytes.
+ */
+
+static int stdio_read_stdin ( char *buffer, int len ){
+	
+	int count = 0;
+	int ch;
+	
+	stdio_flush_stdout ();
+	
+	while ( count < len )
+	{
+		ch = (int) gramado_system_call ( 137, 0, 0, 0 );
+		
+		if ( ch == -1 )
+		{
+			if ( count > 0 )
+				break;
+			
+			gramado_system_call ( SYSTEMCALL_WAITMESSAGE, 0, 0, 0 );
+			continue;
+		}
+		
+		if ( ch == VK_RETURN )
+			ch = '\n';
+		
+		buffer[count] = (char) ch;
+		count++;
+		
+		if ( ch == '\n' )
+			break;
+	};
+	
+	return (int) count;
 }
 
 
-size_t fwrite(const void *ptr, size_t size, size_t n, FILE *fp)
-{
-	return -1;
+/*
+ * fread:
+ *     Os arquivos abertos com fopen: 
+ * uma system call para o bloco todo.
+ *     O stdin: o teclado. (stdio_read_stdin)
+ *     Retorna o número de itens lidos.
+ */
+
+size_t fread ( void *ptr, size_t size, size_t n, FILE *fp ){
+	
+	struct stdio_buffer_d *b;
+	int total;
+	int ret;
+	
+	if ( (void *) ptr == NULL || (void *) fp == NULL || size == 0 || n == 0 )
+		return (size_t) 0;
+	
+	// Não são de leitura.
+	if ( fp == stdout || fp == stderr )
+	{
+		errno = EBADF;
+		return (size_t) 0;
+	}
+	
+	total = (int) (size * n);
+	
+	if ( fp == stdin )
+	{
+		ret = stdio_read_stdin ( (char *) ptr, total );
+		
+		return (size_t) ( ret / size );
+	}
+	
+	// O que foi escrito antes vai primeiro.
+	b = stdio_buffer_get ( fp, 0 );
+	
+	if ( (void *) b != NULL ){
+		stdio_buffer_flush (b);
+	}
+	
+	ret = (int) gramado_system_call ( STDIO_READBUFFER, (unsigned long) fp, 
+	                (unsigned long) ptr, (unsigned long) total );
+	
+	if ( ret <= 0 )
+		return (size_t) 0;
+	
+	return (size_t) ( ret / size );
+}
+
+
+/*
+ * fwrite:
+ *     Coloca no buffer do stream.
+ *     Retorna o número de itens escritos.
+ */
+
+size_t fwrite ( const void *ptr, size_t size, size_t n, FILE *fp ){
+	
+	int total;
+	
+	if ( (void *) ptr == NULL || (void *) fp == NULL || size == 0 || n == 0 )
+		return (size_t) 0;
+	
+	total = (int) (size * n);
+	
+	if ( stdio_buffer_write ( fp, (const char *) ptr, total ) < 0 )
+		return (size_t) 0;
+	
+	return (size_t) n;
 }
 
 
@@ -799,8 +1269,18 @@ int putchar (int ch){
 	//stdio_system_call ( 65, (unsigned long) ch, (unsigned long) ch, 
 	//	(unsigned long) ch );
 	
-	gramado_system_call ( 65, (unsigned long) ch, (unsigned long) ch, 
-		(unsigned long) ch );
+	// #importante
+	// Agora vai para o buffer do stdout, e o buffer vai inteiro 
+	// para o kernel no '\n'. (258)
+	// Antes do stdioInitialize ainda é um char por chamada.
+	
+	char c = (char) ch;
+	
+	if ( stdio_buffer_write ( stdout, &c, 1 ) < 0 )
+	{
+	    gramado_system_call ( 65, (unsigned long) ch, (unsigned long) ch, 
+		    (unsigned long) ch );
+	}
 	
 	return (int) ch;    
 };
@@ -1142,6 +1622,8 @@ int input_file_buffer_size(void)
 
 int getchar (void){
 	
+	stdio_flush_stdout ();
+	
 	//return (int) stdio_system_call ( 137, 0, 0, 0 ); 
 	return (int) gramado_system_call ( 137, 0, 0, 0 ); 
 }
@@ -1158,60 +1640,36 @@ void stdioInitialize (){
 	//register int i;
 	int i;
 	
-	// Buffers para as estruturas.
-	unsigned char buffer0[BUFSIZ];
-	unsigned char buffer1[BUFSIZ];
-	unsigned char buffer2[BUFSIZ];
-	
-	
-	// Alocando espaço para as estruturas.
-	stdin = (FILE *) &buffer0[0];	
-	stdout = (FILE *) &buffer1[0];	
-	stderr = (FILE *) &buffer2[0];
+	// As estruturas ficam na libc.
+	// (Antes ficavam na pilha dessa função.)
+	stdin = (FILE *) &stdio_stdin;	
+	stdout = (FILE *) &stdio_stdout;	
+	stderr = (FILE *) &stdio_stderr;
 
     // A biblioteca tem 3 pequenos buffers,
 	// que serão usados como base para os stream.
-	// ?? Podemos almentar esses buffers ?? @todo: testar.
 
 	//stdin - Usando o buffer 'prompt[.]' como arquivo.
 	stdin->_base = &prompt[0];
-	stdin->_ptr = stdin->_base;
-	stdin->_bufsiz = PROMPT_MAX_DEFAULT; 
-	stdin->_cnt = stdin->_bufsiz;
 	stdin->_file = 0;
+	stdin->_flag = _IOREAD;
 	stdin->_tmpfname = "stdin";
 	//...
 	
 	//stdout - Usando o buffer 'prompt_out[.]' como arquivo.
 	stdout->_base = &prompt_out[0];
-	stdout->_ptr = stdout->_base;
-	stdout->_bufsiz = PROMPT_MAX_DEFAULT; 
-	stdin->_cnt = stdout->_bufsiz;
 	stdout->_file = 1;
+	stdout->_flag = _IOWRT;
 	stdout->_tmpfname = "stdout";
 	//...
 	
 	//stderr - Usando o buffer 'prompt_err[.]' como arquivo.
 	stderr->_base = &prompt_err[0];
-	stderr->_ptr = stderr->_base;
-	stderr->_bufsiz = PROMPT_MAX_DEFAULT; 
-	stdin->_cnt = stderr->_bufsiz;
 	stderr->_file = 2;
+	stderr->_flag = _IOWRT;
 	stderr->_tmpfname = "stderr";	
 	//...
 	
-	// Limpando os buffers.
-	
-	//#bugbug: Cuidado com o tamanho.
-	/*
-	for ( i=0; i<PROMPT_MAX_DEFAULT; i++ ){
-		
-		prompt[i] = (char) '\0';
-		prompt_out[i] = (char) '\0';
-		prompt_err[i] = (char) '\0';
-	}
-	*/
-    
 	for ( i=0; i < BUFSIZ; i++ )
 	{
 	    stdin->_base[i] = (char) '\0';			
@@ -1229,7 +1687,45 @@ void stdioInitialize (){
 
     stderr->_ptr = stderr->_base;	
     stderr->_bufsiz = BUFSIZ; 		
-	stderr->_cnt = stderr->_bufsiz;			
+	stderr->_cnt = stderr->_bufsiz;
+	
+	//
+	// Buffers.
+	//
+	
+	for ( i=0; i < FOPEN_MAX; i++ ){
+		stdio_buffers[i].used = 0;
+	};
+	
+	// stdin, só leitura pelo teclado.
+	stdio_buffers[0].stream = stdin;
+	stdio_buffers[0].kernel = 0;
+	stdio_buffers[0].mode = _IONBF;
+	stdio_buffers[0].base = NULL;
+	stdio_buffers[0].size = 0;
+	stdio_buffers[0].len = 0;
+	stdio_buffers[0].mbuf = 0;
+	stdio_buffers[0].used = 1;
+	
+	// stdout, line buffered.
+	stdio_buffers[1].stream = stdout;
+	stdio_buffers[1].kernel = 0;
+	stdio_buffers[1].mode = _IOLBF;
+	stdio_buffers[1].base = &stdio_stdout_buffer[0];
+	stdio_buffers[1].size = BUFSIZ;
+	stdio_buffers[1].len = 0;
+	stdio_buffers[1].mbuf = 0;
+	stdio_buffers[1].used = 1;
+	
+	// stderr, unbuffered.
+	stdio_buffers[2].stream = stderr;
+	stdio_buffers[2].kernel = 0;
+	stdio_buffers[2].mode = _IONBF;
+	stdio_buffers[2].base = NULL;
+	stdio_buffers[2].size = 0;
+	stdio_buffers[2].len = 0;
+	stdio_buffers[2].mbuf = 0;
+	stdio_buffers[2].used = 1;
 };
 
 
@@ -1244,6 +1740,33 @@ void stdioInitialize (){
 
 int fflush ( FILE *stream ){
 	
+	struct stdio_buffer_d *b;
+	int i;
+	
+	// Todos os streams.
+	if ( (void *) stream == NULL )
+	{
+		for ( i=0; i < FOPEN_MAX; i++ )
+		{
+			if ( stdio_buffers[i].used == 1 ){
+				stdio_buffer_flush ( &stdio_buffers[i] );
+			}
+		};
+		
+		return 0;
+	}
+	
+	b = stdio_buffer_get ( stream, 0 );
+	
+	if ( (void *) b != NULL )
+	{
+		stdio_buffer_flush (b);
+		
+		// O fluxo padrão é da libc, o kernel não conhece.
+		if ( b->kernel == 0 )
+			return 0;
+	}
+	
     //return (int) stdio_system_call ( 233, (unsigned long) stream, 
 	//				 (unsigned long) stream, (unsigned long) stream ); 
 	
@@ -1259,11 +1782,20 @@ int fflush ( FILE *stream ){
 
 int fprintf ( FILE *stream, const char *format, ... ){
 	
-    //return (int) stdio_system_call ( 234, (unsigned long) stream, 
-	//				 (unsigned long) format, (unsigned long) format ); 
+	va_list ap;
+	int ret;
+	
+	if ( (void *) stream == NULL )
+		return (int) (-1);
 	
-    return (int) gramado_system_call ( 234, (unsigned long) stream, 
-					 (unsigned long) format, (unsigned long) format ); 
+	// Formata direto no buffer do stream.
+	// (A system call 234 não recebia os argumentos.)
+	
+	va_start (ap, format);
+	ret = (int) kvprintf ( format, stdio_buffer_putc, stream, 10, ap );
+	va_end (ap);
+	
+	return (int) ret;
 }
 
 
@@ -1273,10 +1805,13 @@ int fprintf ( FILE *stream, const char *format, ... ){
  */
 int fputs ( const char *str, FILE *stream ){
 	
-    //return (int) stdio_system_call ( 235, (unsigned long) str, 
-	//				 (unsigned long) stream, (unsigned long) stream ); 
-    return (int) gramado_system_call ( 235, (unsigned long) str, 
-					 (unsigned long) stream, (unsigned long) stream ); 
+	if ( (void *) str == NULL || (void *) stream == NULL )
+		return (int) EOF;
+	
+	if ( stdio_buffer_write ( stream, str, (int) stdio_strlen (str) ) < 0 )
+		return (int) EOF;
+	
+	return 0;
 }
 
 
@@ -1444,10 +1979,12 @@ int fseek ( FILE *stream, long offset, int whence ){
 
 int fputc ( int ch, FILE *stream ){
     
-     //return (int) stdio_system_call ( 196, (unsigned long) ch,  
-	 //				 (unsigned long) stream,  (unsigned long) stream );    
-     return (int) gramado_system_call ( 196, (unsigned long) ch,  
-					 (unsigned long) stream,  (unsigned long) stream );    
+	char c = (char) ch;
+	
+	if ( stdio_buffer_write ( stream, &c, 1 ) < 0 )
+		return (int) EOF;
+	
+	return (int) (unsigned char) c;
 }
 
 
@@ -1459,6 +1996,8 @@ int fputc ( int ch, FILE *stream ){
  */
 void stdioSetCursor ( unsigned long x, unsigned long y ){
 	
+	stdio_flush_stdout ();
+	
 	//34 - set cursor.
     //stdio_system_call ( 34, x, y, 0 );	
     gramado_system_call ( 34, x, y, 0 );	
@@ -1473,6 +2012,8 @@ void stdioSetCursor ( unsigned long x, unsigned long y ){
  */  
 unsigned long stdioGetCursorX (){
 	
+	stdio_flush_stdout ();
+	
     //return (unsigned long) stdio_system_call ( 240, 0, 0, 0 );
     return (unsigned long) gramado_system_call ( 240, 0, 0, 0 );
 };
@@ -1486,6 +2027,8 @@ unsigned long stdioGetCursorX (){
  */
 unsigned long stdioGetCursorY (){
 	
+	stdio_flush_stdout ();
+	
     //return (unsigned long) stdio_system_call ( 241, 0, 0, 0 );
     return (unsigned long) gramado_system_call ( 241, 0, 0, 0 );
 };
@@ -2277,43 +2820,12 @@ int printf ( const char *fmt, ... ){
 
 int vfprintf ( FILE *stream, const char *format, stdio_va_list argptr ){
  	
-	//#suspenso.
-	//return (int) kvprintf ( format, NULL, stream->_ptr, 10, argptr );
-	
-	int size;
-	
 	if ( (void *) stream == NULL )
-	{
 		return (int) (-1);
-		
-	} else {
-		
-		size = (int) stdio_strlen (format);
-		
-		//Se a string for maior que o tanto de bytes
-		//disponíveis no arquivo
-		if ( size > stream->_cnt )
-		{
-			return (int) (-1);
-		}
-		
-		//recalcula o tanto de bytes disponíveis
-		stream->_cnt = (int) (stream->_cnt - size);
-		
-		//coloca no buffer, usando o ponteiro atual.
-		//#obs: isso provavelmente funcione, 
-		//mas vamos tentar o segundo método.
-		//sprintf ( stream->_ptr, format );
-		kvprintf ( format, NULL, stream->_ptr, 10, argptr );
-		
-		//atualiza o ponteiro atual.
-		stream->_ptr = stream->_ptr + size;
-        
-		return (int) 0;		
-	};
- 
-	return (int) (-1);	
-};  
+	
+	// Vai para o buffer do stream.
+	return (int) kvprintf ( format, stdio_buffer_putc, stream, 10, argptr );
+}  
 
 
 /*
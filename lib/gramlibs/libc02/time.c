@@ -30,3 +30,18 @@ time_t time (time_t *timer){
     return (time_t) Ret;	
 }
 
+
+// clock_gettime
+// system call. (266) SYS_CLOCKGETTIME
+// O kernel preenche sec e nsec.
+
+int clock_gettime ( clockid_t clk_id, struct timespec *tp ){
+	
+	if ( (void *) tp == (void *) 0 ){
+		return (int) -1;
+	}
+	
+	return (int) gramado_system_call ( 266, (unsigned long) clk_id, 
+	                 (unsigned long) tp, 0 );
+}
+
@@ -14,6 +14,8 @@
 //#include <sys/stat.h>   
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdio.h>
+#include <time.h>
 
 
 //system calls.
@@ -25,6 +27,8 @@
 #define	UNISTD_SYSTEMCALL_EXIT     70
 #define	UNISTD_SYSTEMCALL_GETPID   85
 #define	UNISTD_SYSTEMCALL_GETPPID  81
+#define	UNISTD_SYSTEMCALL_SYSTIME  223
+#define	UNISTD_SYSTEMCALL_SLEEP    265  // SYS_NANOSLEEP
 
 
 //
@@ -266,6 +270,8 @@ void exit (int status){
     //     @todo: se o status for (1) devemos imprimir o conteúdo 
     // de stderr na tela.
 
+	// O que ainda está nos buffers da stdio.
+	fflush (NULL);
  
     //stdlib_system_call ( UNISTD_SYSTEMCALL_EXIT, (unsigned long) status, 
 	//    (unsigned long) status, (unsigned long) status );
@@ -369,6 +375,119 @@ int pause(void)
 };
 
 
+
+/*
+ * unistd_sleep_ticks:
+ *     Dorme até now + ticks.
+ *     O kernel bloqueia a thread e acorda ela no deadline. 
+ * 1 = a thread acordou antes do deadline, chama de novo.
+ */
+
+static int unistd_sleep_ticks ( unsigned long ticks ){
+
+	unsigned long Deadline;
+	int Status;
+
+	Deadline = (unsigned long) gramado_system_call ( UNISTD_SYSTEMCALL_SYSTIME, 3, 0, 0 );
+	Deadline += ticks;
+
+	while (1)
+	{
+		Status = (int) gramado_system_call ( UNISTD_SYSTEMCALL_SLEEP,
+		                   (unsigned long) Deadline, 0, 0 );
+
+		if ( Status != 1 ){
+			break;
+		}
+	};
+
+	if ( Status == 0 ){
+		return 0;
+	}
+
+	return (int) -1;
+}
+
+
+// Arredonda para cima, dormir menos não pode.
+// Segundos e resto separados, ms * hz estoura 32 bits.
+
+static unsigned long unistd_ms_to_ticks ( unsigned long ms ){
+
+	unsigned long hz;
+
+	hz = (unsigned long) gramado_system_call ( UNISTD_SYSTEMCALL_SYSTIME, 1, 0, 0 );
+
+	if ( hz == 0 ){
+		hz = 100;
+	}
+
+	return (unsigned long) ( ( (ms / 1000) * hz ) + 
+	                         ( ( ( (ms % 1000) * hz ) + 999 ) / 1000 ) );
+}
+
+
+int nanosleep ( const struct timespec *req, struct timespec *rem ){
+
+	unsigned long ms;
+
+	if ( (void *) req == NULL ){
+		return (int) -1;
+	}
+
+	if ( req->tv_sec < 0 || req->tv_nsec < 0 || req->tv_nsec > 999999999 ){
+		return (int) -1;
+	}
+
+	// Mais de 49 dias não cabe em ms, dorme o máximo.
+	if ( (unsigned long) req->tv_sec >= (0xFFFFFFFF / 1000) ){
+		ms = 0xFFFFFFFF;
+	}else{
+		ms = ( (unsigned long) req->tv_sec * 1000 ) + 
+		     ( ( (unsigned long) req->tv_nsec + 999999 ) / 1000000 );
+	};
+
+	if ( unistd_sleep_ticks ( unistd_ms_to_ticks (ms) ) != 0 ){
+		return (int) -1;
+	}
+
+	// Não temos sinais, o sono não é interrompido.
+	if ( (void *) rem != NULL )
+	{
+		rem->tv_sec = 0;
+		rem->tv_nsec = 0;
+	}
+
+	return 0;
+}
+
+
+unsigned int sleep ( unsigned int seconds ){
+
+	struct timespec req;
+
+	req.tv_sec = (time_t) seconds;
+	req.tv_nsec = 0;
+
+	if ( nanosleep ( &req, NULL ) != 0 ){
+		return (unsigned int) seconds;
+	}
+
+	return 0;
+}
+
+
+int usleep ( unsigned long usec ){
+
+	struct timespec req;
+
+	req.tv_sec = (time_t) ( usec / 1000000 );
+	req.tv_nsec = (long) ( (usec % 1000000) * 1000 );
+
+	return (int) nanosleep ( &req, NULL );
+}
+
+
 int mkdir(const char *pathname, mode_t mode)
 {
 	return -1; //#todo